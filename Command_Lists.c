@@ -28,13 +28,27 @@
 #include "atheros_driver_includes.h"
 
 const SHELL_COMMAND_STRUCT Shell_commands[] = {
+   { "boot",      Shell_boot },
+   { "config",    Shell_config },
    { "exit",      Shell_exit },      
    { "fan",       Shell_fan },
    { "help",      Shell_help }, 
    { "hvac",      Shell_hvac },
    { "info",      Shell_info },
+   { "lock",      Shell_lock },
+   { "notify",    Shell_notify },
    { "scale",     Shell_scale },
    { "temp",      Shell_temp },       
+   { "top",       Shell_top },
+   { "trace",     Shell_trace },
+   { "validate",  Shell_validate },
+   { "journal",   Shell_journal },
+   { "control",   Shell_control },
+   { "plant",     Shell_plant },
+   { "zones",     Shell_zones },
+   { "schedule",  Shell_schedule },
+   { "failover",  Shell_failover },
+   { "tune",      Shell_tune },
 
    { "netstat",   Shell_netstat },  
    { "ipconfig",  Shell_ipconfig },
@@ -51,11 +65,15 @@ const SHELL_COMMAND_STRUCT Shell_commands[] = {
 };
 
 const SHELL_COMMAND_STRUCT Telnet_commands[] = {
+   { "boot",      Shell_boot },
+   { "config",    Shell_config },
    { "exit",      Shell_exit },      
    { "fan",       Shell_fan },
    { "help",      Shell_help }, 
    { "hvac",      Shell_hvac },
    { "info",      Shell_info },
+   { "lock",      Shell_lock },
+   { "notify",    Shell_notify },
 
 #if RTCSCFG_ENABLE_ICMP
    { "ping",      Shell_ping },      
@@ -63,6 +81,16 @@ const SHELL_COMMAND_STRUCT Telnet_commands[] = {
 
    { "scale",     Shell_scale },
    { "temp",      Shell_temp },
+   { "top",       Shell_top },
+   { "trace",     Shell_trace },
+   { "validate",  Shell_validate },
+   { "journal",   Shell_journal },
+   { "control",   Shell_control },
+   { "plant",     Shell_plant },
+   { "zones",     Shell_zones },
+   { "schedule",  Shell_schedule },
+   { "failover",  Shell_failover },
+   { "tune",      Shell_tune },
    { "?",         Shell_command_list },     
    
    { NULL,        NULL } 
@@ -0,0 +1,295 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : Control_Task.c
+
+PURPOSE   : This task runs the relay control engine, see relay_control.h,
+            and the analog output PI controller, see analog_control.h,
+            once per sample cycle. By default a pass is started by the
+            Sensor_Task as soon as it has published a cycle, so that the
+            outputs act on values that are a few milliseconds old rather
+            than up to a second old; see CONTROL_TRIGGER_xxx.
+
+            The time from the end of the sample cycle to the end of the
+            pass is measured for every pass, see CONTROL_LATENCY.
+
+            The sensor values are read from the live status without the
+            mutex. mutexCore is only tried for, to store the state of the
+            outputs in coreDB and to pick up a changed setup; if it is
+            busy, that is done on the next control event and the engines
+            carry on with the tables they have.
+
+            Each output is run from the sensor the failover stage picks
+            for it, see sensor_failover.h; its setup sensor while that is
+            healthy, otherwise a backup.
+
+            An analog output being auto-tuned is driven by the relay test
+            instead of its PI controller, see analog_tune.h. A result
+            applied from the shell is written into the setup here. It,
+            and the state of the outputs, are saved to flash by
+            Flash_Task items; this task never writes the flash.
+
+            The outputs on expansion modules are then sent by the output
+            commit stage, see output_commit.h; one frame per module whose
+            outputs changed.
+
+            When CONTROL_LOCAL_RELAY is set up with a sensor, the engine
+            drives gRelayState, and so the fan relay on this board, through
+            the RControl_Task.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "periodic_events.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+#include "core_lock.h"
+#include "live_status.h"
+#include "db_notify.h"
+#include "warm_restart.h"
+#include "journal.h"
+#include "relay_control.h"
+#include "analog_control.h"
+#include "output_commit.h"
+#include "sensor_failover.h"
+#include "analog_tune.h"
+#include "config_image.h"
+#include "Control_Task.h"
+#include "Sensor_Task.h"
+
+uint8_t            ControlTrigger = CONTROL_TRIGGER_SENSOR;
+uint32_t           ControlLatencyLimitUs = CONTROL_LATENCY_LIMIT_US;
+CONTROL_LATENCY    ControlLatency;
+
+const char *       ControlTriggerName[ NUM_CONTROL_TRIGGERS ] =
+{
+    "sensor",             // CONTROL_TRIGGER_SENSOR
+    "phase"               // CONTROL_TRIGGER_PHASE
+};
+
+// Upper limit of each CONTROL_LATENCY bucket, the last one has none.
+//
+const uint32_t     ControlLatencyBucketUs[ CONTROL_LATENCY_BUCKETS - 1 ] =
+{
+    1000, 10000, 100000, 1000000
+};
+
+
+// Function Prototypes - used by this module only
+//
+void      control_setup( bool restore );
+void      control_local_relay( void );
+void      control_latency( uint32_t stamp );
+
+
+//
+//  Control_Task() -
+//
+void
+Control_Task( uint32_t data )
+{
+    LIVE_STATUS  status;
+    _mqx_uint    result;
+    _mqx_uint    mask;
+    uint32_t     now;
+    uint32_t     stamp;
+    uint32_t     used_stamp = 0;
+    uint16_t     on_mask;
+    uint16_t     stored_mask = 0;
+    bool         built = FALSE;
+
+    // Build the tables, and carry on from the state of the outputs as
+    //    restored after a warm reset. If mutexCore cannot be locked, the
+    //    empty tables drive nothing and nothing is stored in coreDB
+    //    until a pass that does lock it has built them.
+    //
+    if( core_lock( CORE_SITE_CONTROL ) == MQX_OK )
+    {
+        control_setup( TRUE );
+        core_unlock( CORE_SITE_CONTROL );
+
+        stored_mask = RelayEngine.on_mask;
+        built       = TRUE;
+    }
+
+    while( TRUE )
+    {
+        if( ControlTrigger == CONTROL_TRIGGER_SENSOR )
+        {
+            mask   = CTRL_SENSOR_CYCLE_EVENT;
+            result = _lwevent_wait_ticks( &eventControlTask, mask, FALSE, CONTROL_SENSOR_TIMEOUT );
+        }
+        else
+        {
+            mask   = CTRL_ALGORITHM_EVENT;
+            result = _lwevent_wait_ticks( &eventControlTask, mask, FALSE, 0 );
+        }
+
+        TRACE_EVENT_WAIT( TRACE_EVENT_CONTROL, mask );
+
+        // Both events are set in either mode; clear both, so that a change
+        //    of trigger does not start with an old event.
+        //
+        _lwevent_clear( &eventControlTask, (_mqx_uint)(CTRL_ALGORITHM_EVENT | CTRL_SENSOR_CYCLE_EVENT) );
+
+        TRACE_BEGIN( TRACE_MARK_CONTROL_PASS );
+
+        stamp = SensorCycleStamp;
+        live_status_read( &status );
+        now     = SecCounter;
+        sensor_failover_run( &SensorFailover, &status, now );
+        on_mask = relay_control_run( &RelayEngine, SensorFailover.input, now );
+        analog_control_run( &AnalogEngine, SensorFailover.input, now );
+        analog_tune_run( &AnalogTune, &AnalogEngine, SensorFailover.input, now );
+        output_commit_run( &OutputCommit, &RelayEngine, &AnalogEngine );
+
+        TRACE_END( TRACE_MARK_CONTROL_PASS );
+
+        // If the mutex is succesfully locked, store the outputs in coreDB
+        //    and pick up the setup if it has changed. The new setup is
+        //    used from the next control event on.
+        //
+        if( core_try_lock( CORE_SITE_CONTROL ) == MQX_OK )
+        {
+            if( !built )
+            {
+                control_setup( TRUE );
+                stored_mask = RelayEngine.on_mask;
+                built       = TRUE;
+            }
+            else
+            {
+                relay_control_store( &RelayEngine, &coreDB, now );
+                analog_control_store( &AnalogEngine, &coreDB, now );
+                output_commit_store( &OutputCommit, &coreDB );
+                analog_tune_store( &AnalogTune, &coreDB );
+
+                if( SensorFailover.rebuild || (RelayEngine.config_version != coreDB.config_version) )
+                    control_setup( FALSE );
+            }
+
+            core_unlock( CORE_SITE_CONTROL );
+
+            // Keep the output states in flash when one of them switched,
+            //    to be restored after a power cycle. The flash is written
+            //    by the Flash_Task; a request that could not be queued is
+            //    made again on the next pass.
+            //
+            if( (on_mask != stored_mask) && warm_restart_request_control() )
+                stored_mask = on_mask;
+
+            // Save a setup written by the auto-tuner. The Flash_Task copies
+            //    it with mutexCore locked and writes the flash.
+            //
+            if( AnalogTune.save && cfg_image_request_save() )
+                AnalogTune.save = FALSE;
+        }
+
+        control_local_relay();
+
+        if( result == LWEVENT_WAIT_TIMEOUT )
+            ControlLatency.timeouts++;
+        else if( stamp == used_stamp )
+            ControlLatency.stale++;
+        else
+            control_latency( stamp );
+
+        used_stamp = stamp;
+    }
+}
+
+
+//
+//  control_setup() - Build the tables of every stage from coreDB, and when
+//                    "restore" is set carry on from the state of the
+//                    outputs in it. Called with mutexCore locked.
+//
+void
+control_setup( bool restore )
+{
+    sensor_failover_setup( &SensorFailover, &coreDB );
+    relay_control_setup( &RelayEngine, &coreDB );
+
+    if( restore )
+        relay_control_restore( &RelayEngine, &coreDB, SecCounter );
+
+    analog_control_setup( &AnalogEngine, &coreDB );
+
+    if( restore )
+        analog_control_restore( &AnalogEngine, &coreDB, SecCounter );
+
+    output_commit_setup( &OutputCommit, &coreDB );
+}
+
+
+//
+//  control_local_relay() - Drive the relay on this board from the engine,
+//                          if its output is set up with a sensor.
+//
+void
+control_local_relay( void )
+{
+    int  state;
+
+    if( RelayEngine.relay[ CONTROL_LOCAL_RELAY ].mode == RELAY_MODE_NONE )
+        return;
+
+    state = RELAY_OUTPUT( RelayEngine.relay[ CONTROL_LOCAL_RELAY ].state );
+
+    if( gRelayState != state )
+    {
+        gRelayState = state;
+        journal_record( JOURNAL_RELAY_REQUEST, JOURNAL_SOURCE_CONTROL, state );
+        db_publish( DB_BIT( DB_GROUP_RELAY ) );
+    }
+}
+
+
+//
+//  control_latency() - Measure the pass just run, from "stamp", the end
+//                      of the sample cycle it used.
+//
+void
+control_latency( uint32_t stamp )
+{
+    uint32_t  us;
+    int       k;
+
+    us = core_lock_cycles_to_us( TMON_CYCLE_COUNT() - stamp );
+
+    ControlLatency.passes++;
+    ControlLatency.total_us += us;
+
+    if( us > ControlLatency.max_us )
+        ControlLatency.max_us = us;
+
+    if( us > ControlLatencyLimitUs )
+        ControlLatency.misses++;
+
+    for( k=0; k<CONTROL_LATENCY_BUCKETS-1; k++ )
+    {
+        if( us < ControlLatencyBucketUs[k] )
+            break;
+    }
+
+    ControlLatency.bucket[k]++;
+}
+
+
+//
+//  control_latency_clear() - Start the latency measurement again.
+//
+void
+control_latency_clear( void )
+{
+    memset( &ControlLatency, 0, sizeof( ControlLatency ) );
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : Control_Task.h
+
+PURPOSE   : Function prototypes for "Control_Task.c" module.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __control_task_inc
+#define  __control_task_inc
+
+#include <mqx.h>
+
+// The output that drives the fan relay on this board (gRelayState) when it
+//   is set up with a sensor. Otherwise the relay is left to the button and
+//   the web page.
+//
+#define  CONTROL_LOCAL_RELAY     0
+
+// What starts a control pass. With CONTROL_TRIGGER_SENSOR the pass runs
+//   as soon as the Sensor_Task has published a sample cycle; if no cycle
+//   is published within CONTROL_SENSOR_TIMEOUT ticks the pass runs anyway,
+//   so that the timers keep going. With CONTROL_TRIGGER_PHASE it runs in
+//   the EVENT_CONTROL slot of pit_0_isr(), as before.
+//
+enum{  CONTROL_TRIGGER_SENSOR,
+       CONTROL_TRIGGER_PHASE,
+       NUM_CONTROL_TRIGGERS  };
+
+#define  CONTROL_SENSOR_TIMEOUT       150    // Ticks, 1.5 seconds
+#define  CONTROL_LATENCY_LIMIT_US   20000    // Default deadline, sample
+                                             //   cycle to outputs
+#define  CONTROL_LATENCY_BUCKETS        5    // < 1, 10, 100, 1000 ms, more
+
+// CONTROL_LATENCY - Time from the end of the sample cycle whose values a
+//   pass used to the end of the pass, when the outputs have been decided.
+//   Cleared when the trigger is changed, shown by "control".
+//
+typedef struct
+{
+    uint32_t  passes;          // Passes measured
+    uint32_t  timeouts;        // Passes run without a new sample cycle
+    uint32_t  stale;           // Passes that used a cycle already used
+    uint32_t  total_us;
+    uint32_t  max_us;
+    uint32_t  misses;          // Passes later than ControlLatencyLimitUs
+    uint32_t  bucket[ CONTROL_LATENCY_BUCKETS ];
+
+}  CONTROL_LATENCY;
+
+extern uint8_t           ControlTrigger;       // CONTROL_TRIGGER_xxx
+extern uint32_t          ControlLatencyLimitUs;
+extern CONTROL_LATENCY   ControlLatency;
+extern const char *      ControlTriggerName[ NUM_CONTROL_TRIGGERS ];
+
+
+void Control_Task( uint32_t data );
+void control_latency_clear( void );
+
+
+#endif
@@ -29,6 +29,7 @@
 #include "hvac.h"
 #include "hvac_public.h"
 #include "hvac_private.h"
+#include "HVAC_Plant.h"
 #include <lwgpio.h>
 
 #if defined BSP_BUTTON1 
@@ -103,6 +104,10 @@ void HVAC_ResetOutputs(void)
 
 void HVAC_SetOutput(HVAC_Output_t signal,bool state) 
 {    
+   // Only the state is kept, it drives the zone model; the outputs are
+   //    not wired to LEDs on this board.
+   HVAC_OutputState[signal] = state;
+
    /*if (HVAC_OutputState[signal] != state) {
       HVAC_OutputState[signal] = state;
       if (output_port) {
@@ -170,26 +175,32 @@ bool HVAC_GetInput(HVAC_Input_t signal)
 
 
 
-static uint32_t    AmbientTemperature = 200; // 20.0 celsius, 68.0 fahrenheit
+static int32_t     AmbientTemperature = 200; // 20.0 celsius, 68.0 fahrenheit
 static TIME_STRUCT LastUpdate  = {0,0};
 
-uint32_t HVAC_GetAmbientTemperature(void)
+// In 1/10 degree C, and below 0 when the zone is.
+int32_t HVAC_GetAmbientTemperature(void)
 {
    return AmbientTemperature;
 }
 
+// The ambient temperature comes from the zone model in HVAC_Plant.c,
+//    stepped in real time with the heat and cool outputs.
 void HVAC_ReadAmbientTemperature(void)
 {
    TIME_STRUCT time;
+   uint32_t    seconds;
    
    _time_get(&time);
    if (time.SECONDS>=(LastUpdate.SECONDS+HVAC_TEMP_UPDATE_RATE)) {
-      LastUpdate=time;
-      if (HVAC_GetOutput(HVAC_HEAT_OUTPUT)) {
-         AmbientTemperature += HVAC_TEMP_UPD_DELTA;
-      } else if (HVAC_GetOutput(HVAC_COOL_OUTPUT)) {
-         AmbientTemperature -= HVAC_TEMP_UPD_DELTA;
+      seconds = time.SECONDS - LastUpdate.SECONDS;
+      if (seconds > HVAC_PLANT_MAX_STEP) {
+         seconds = HVAC_PLANT_MAX_STEP;
       }
+      LastUpdate=time;
+      HVAC_PlantStep(&HVAC_LivePlant, HVAC_GetOutput(HVAC_HEAT_OUTPUT),
+         HVAC_GetOutput(HVAC_COOL_OUTPUT), seconds);
+      AmbientTemperature = HVAC_PlantTemperature(&HVAC_LivePlant);
    }
 }
 
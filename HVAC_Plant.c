@@ -0,0 +1,211 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Plant.c
+
+PURPOSE   : Thermal model of one zone. The zone loses heat to the outdoors
+            with the time constant HVAC_PLANT_ZONE_TAU, and the heating
+            and cooling equipment add or remove heat at their capacity.
+            The equipment output follows its On\Off command with a first
+            order lag, so it takes a few minutes to come up to capacity
+            and to run down again.
+
+            The outdoor temperature follows one of the daily profiles in
+            HvacProfile[][], interpolated between the hours.
+
+            The model is stepped one second at a time. HVAC_PlantRun()
+            closes the loop through HVAC_ZoneEvaluate(), the same engine
+            that HVAC_Task uses, for as long as asked, and measures how well
+            the zone is held at the desired temperature, how long each
+            output ran, and how often the equipment short cycled.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include "hvac.h"
+#include "hvac_public.h"
+#include "hvac_private.h"
+#include "task_monitor.h"
+#include "HVAC_Plant.h"
+#include "HVAC_Zone.h"
+
+#define  SECONDS_PER_HOUR    3600
+#define  SECONDS_PER_DAY     (24 * SECONDS_PER_HOUR)
+
+HVAC_PLANT      HVAC_LivePlant;    // Behind HVAC_ReadAmbientTemperature()
+HVAC_ZONES      HvacPlantZones;    // The one zone of HVAC_PlantRun()
+
+const char *    HVAC_ProfileName[ HVAC_MAX_PROFILE ] =
+{
+    "winter",             // HVAC_PROFILE_WINTER
+    "swing",              // HVAC_PROFILE_SWING
+    "summer"              // HVAC_PROFILE_SUMMER
+};
+
+// Outdoor temperature, in 1/10 degree C, at each hour from midnight.
+//
+const int16_t   HvacProfile[ HVAC_MAX_PROFILE ][ 24 ] =
+{
+    {  -60, -70, -80, -85, -90, -90, -85, -70, -50, -20,  10,  30,     // Winter
+        50,  60,  60,  50,  30,   0, -20, -30, -40, -45, -50, -55 },
+    {   80,  70,  65,  60,  55,  55,  60,  80, 110, 140, 170, 190,     // Swing
+       210, 220, 225, 220, 200, 180, 160, 140, 120, 110, 100,  90 },
+    {  220, 210, 200, 195, 190, 190, 200, 220, 250, 280, 300, 320,     // Summer
+       335, 345, 350, 345, 330, 310, 290, 270, 255, 245, 235, 225 }
+};
+
+
+//
+//  HVAC_PlantInit() - Start a model at midnight, with the zone at
+//                     HVAC_PLANT_START_TEMP and the equipment off.
+//
+void
+HVAC_PlantInit( HVAC_PLANT * plant, uint8_t profile )
+{
+    plant->zone_temp   = HVAC_PLANT_START_TEMP;
+    plant->heat_output = 0.0;
+    plant->cool_output = 0.0;
+    plant->time        = 0;
+    plant->profile     = (profile < HVAC_MAX_PROFILE) ? profile : HVAC_PROFILE_SWING;
+    plant->outdoor     = HVAC_PlantOutdoor( plant );
+}
+
+
+//
+//  HVAC_PlantOutdoor() - The outdoor temperature now, in deg C.
+//
+float
+HVAC_PlantOutdoor( const HVAC_PLANT * plant )
+{
+    const int16_t * profile = HvacProfile[ plant->profile ];
+    uint32_t        t       = plant->time % SECONDS_PER_DAY;
+    uint32_t        hour    = t / SECONDS_PER_HOUR;
+    uint32_t        frac    = t % SECONDS_PER_HOUR;
+    int32_t         now     = profile[ hour ];
+    int32_t         next    = profile[ (hour + 1) % 24 ];
+
+    return( (now + (float)((next - now) * (int32_t)frac) / SECONDS_PER_HOUR) / 10.0 );
+}
+
+
+//
+//  HVAC_PlantStep() - Advance the model by "seconds", with the heating and
+//                     cooling commanded On or Off throughout.
+//
+void
+HVAC_PlantStep( HVAC_PLANT * plant, bool heat, bool cool, uint32_t seconds )
+{
+    float  heat_target = heat ? 1.0 : 0.0;
+    float  cool_target = cool ? 1.0 : 0.0;
+
+    while( seconds-- )
+    {
+        // The outdoor temperature changes slowly; it is worked out once a
+        //    minute of model time.
+        //
+        if( (plant->time % 60) == 0 )
+            plant->outdoor = HVAC_PlantOutdoor( plant );
+
+        plant->heat_output += (heat_target - plant->heat_output) / HVAC_PLANT_EQUIP_TAU;
+        plant->cool_output += (cool_target - plant->cool_output) / HVAC_PLANT_EQUIP_TAU;
+
+        plant->zone_temp += (plant->outdoor - plant->zone_temp) / HVAC_PLANT_ZONE_TAU
+                          + plant->heat_output * HVAC_PLANT_HEAT_RATE
+                          - plant->cool_output * HVAC_PLANT_COOL_RATE;
+        plant->time++;
+    }
+}
+
+
+//
+//  HVAC_PlantTemperature() - The zone temperature, in 1/10 degree C as the
+//                            HVAC_Task uses it, rounded to the nearest.
+//                            It is below 0 when the zone is.
+//
+int32_t
+HVAC_PlantTemperature( const HVAC_PLANT * plant )
+{
+    if( plant->zone_temp < 0.0 )
+        return( (int32_t)(plant->zone_temp * 10.0 - 0.5) );
+
+    return( (int32_t)(plant->zone_temp * 10.0 + 0.5) );
+}
+
+
+//
+//  HVAC_PlantRun() - Run the HVAC logic against a new model for "hours",
+//                    as fast as it will go, with the mode, fan mode and
+//                    desired temperature of zone 0 and the default zone
+//                    policy, but the given temperature tolerance (1/10
+//                    degree).
+//
+void
+HVAC_PlantRun( uint8_t profile, uint32_t hours, uint32_t tolerance, HVAC_PLANT_RESULT * result )
+{
+    HVAC_PLANT    plant;
+    HVAC_ZONES  * zones   = &HvacPlantZones;
+    int32_t       desired = HVAC_Params.DesiredTemperature;
+    int32_t       actual;
+    uint32_t      error, start, s;
+    bool          heat = FALSE, cool = FALSE;
+    uint32_t      heat_since = 0, cool_since = 0;
+
+    memset( result, 0, sizeof( HVAC_PLANT_RESULT ) );
+    HVAC_PlantInit( &plant, profile );
+
+    HVAC_ZoneInit( zones, 1, 0 );
+    zones->tolerance  = tolerance;
+    zones->desired[0] = desired;
+    zones->mode[0]    = HVAC_GetHVACMode();
+    zones->fan[0]     = HVAC_GetFanMode();
+
+    start = TMON_CYCLE_COUNT();
+
+    for( s=0; s<hours*SECONDS_PER_HOUR; s++ )
+    {
+        actual = HVAC_PlantTemperature( &plant );
+        zones->actual[0] = (int16_t) actual;
+        HVAC_ZoneEvaluate( zones, s );
+
+        // Count the starts, and the On and Off times that were too short.
+        //    The time before the first change is not counted.
+        //
+        if( ((zones->outputs[0] & HVAC_ZONE_HEAT) != 0) != heat )
+        {
+            heat = !heat;
+            if( heat )
+                result->heat_starts++;
+            if( heat_since && ((s - heat_since) < HVAC_PLANT_SHORT_CYCLE) )
+                result->short_cycles++;
+            heat_since = s;
+        }
+
+        if( ((zones->outputs[0] & HVAC_ZONE_COOL) != 0) != cool )
+        {
+            cool = !cool;
+            if( cool )
+                result->cool_starts++;
+            if( cool_since && ((s - cool_since) < HVAC_PLANT_SHORT_CYCLE) )
+                result->short_cycles++;
+            cool_since = s;
+        }
+
+        result->heat_seconds += heat;
+        result->cool_seconds += cool;
+        result->fan_seconds  += (zones->outputs[0] & HVAC_ZONE_FAN) != 0;
+
+        error = (actual > desired) ? actual - desired : desired - actual;
+        result->error_sum += error;
+        if( error > result->error_max )
+            result->error_max = error;
+
+        HVAC_PlantStep( &plant, heat, cool, 1 );
+    }
+
+    result->seconds = s;
+    result->cycles  = TMON_CYCLE_COUNT() - start;
+}
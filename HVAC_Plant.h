@@ -0,0 +1,92 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Plant.h
+
+PURPOSE   : Definitions and function prototypes for the "HVAC_Plant.c"
+            module; a thermal model of one zone, its heating and cooling
+            equipment and the outdoor temperature.
+
+            One model runs in real time behind the ambient temperature
+            that HVAC_Task controls. Others are run faster than real time
+            by the "plant run" shell command, to see how the HVAC logic
+            performs over a day or a week.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __hvac_plant_inc
+#define  __hvac_plant_inc
+
+#include <mqx.h>
+#include "hvac_public.h"
+
+#define  HVAC_PLANT_ZONE_TAU       (3.0 * 3600)   // Seconds, zone to outdoors
+#define  HVAC_PLANT_HEAT_RATE      (10.0 / 3600)  // Deg C per second, heat
+#define  HVAC_PLANT_COOL_RATE      (8.0 / 3600)   //   and cool at full output
+#define  HVAC_PLANT_EQUIP_TAU      120.0          // Seconds, equipment lag
+#define  HVAC_PLANT_START_TEMP     20.0           // Deg C
+#define  HVAC_PLANT_SHORT_CYCLE    300            // Seconds, shorter On or
+                                                  //   Off times are counted
+#define  HVAC_PLANT_MAX_STEP       60             // Seconds of real time
+                                                  //   stepped at once
+#define  HVAC_PLANT_MAX_HOURS      168            // Longest "plant run"
+
+// Outdoor temperature profiles, a temperature for each hour of the day.
+//
+typedef enum
+{
+    HVAC_PROFILE_WINTER = 0,
+    HVAC_PROFILE_SWING  = 1,
+    HVAC_PROFILE_SUMMER = 2,
+    HVAC_MAX_PROFILE
+
+}  HVAC_PROFILE;
+
+// HVAC_PLANT - The state of one model.
+//
+typedef struct
+{
+    float     zone_temp;         // Deg C
+    float     heat_output;       // 0..1, after the equipment lag
+    float     cool_output;
+    float     outdoor;           // Deg C, updated once a minute
+    uint32_t  time;              // Seconds from midnight of the first day
+    uint8_t   profile;           // HVAC_PROFILE_xxx
+
+}  HVAC_PLANT;
+
+// HVAC_PLANT_RESULT - What a closed loop run measured. Temperatures are in
+//   1/10 degree C, as HVAC_Params.DesiredTemperature.
+//
+typedef struct
+{
+    uint32_t  seconds;           // Time simulated
+    uint32_t  cycles;            // Core clock cycles taken
+    uint32_t  error_sum;         // Sum over seconds of |actual - desired|
+    uint32_t  error_max;
+    uint32_t  heat_seconds;      // Runtime of each output
+    uint32_t  cool_seconds;
+    uint32_t  fan_seconds;
+    uint32_t  heat_starts;
+    uint32_t  cool_starts;
+    uint32_t  short_cycles;      // On or Off times under HVAC_PLANT_SHORT_CYCLE
+
+}  HVAC_PLANT_RESULT;
+
+extern HVAC_PLANT       HVAC_LivePlant;
+extern const char *     HVAC_ProfileName[ HVAC_MAX_PROFILE ];
+
+//
+//    Function Prototypes
+//
+void      HVAC_PlantInit( HVAC_PLANT * plant, uint8_t profile );
+float     HVAC_PlantOutdoor( const HVAC_PLANT * plant );
+void      HVAC_PlantStep( HVAC_PLANT * plant, bool heat, bool cool, uint32_t seconds );
+int32_t   HVAC_PlantTemperature( const HVAC_PLANT * plant );
+void      HVAC_PlantRun( uint8_t profile, uint32_t hours, uint32_t tolerance, HVAC_PLANT_RESULT * result );
+
+#endif
@@ -76,7 +76,7 @@ typedef struct {
 typedef struct  {
    HVAC_Mode_t    HVACState;
    bool        FanOn;
-   uint32_t        ActualTemperature;
+   int32_t         ActualTemperature;   // 1/10 C, may be below 0
 } HVAC_STATE, * HVAC_STATE_PTR;
 
 
@@ -32,8 +32,7 @@
 #define HVAC_TEMP_TOLERANCE   0    // in 1/10 degree 
 #define HVAC_TEMP_SW_DELTA    5    // in 1/10 degree 
 
-// ambient temperature change emulation
-#define HVAC_TEMP_UPD_DELTA   1    // in 1/10 degree 
+// ambient temperature emulation, see HVAC_Plant.h
 #define HVAC_TEMP_UPDATE_RATE 1    // in seconds
 
 #define HVAC_TEMP_MINIMUM     0    // in Celsius
@@ -92,13 +91,25 @@ extern void HVAC_SetTemperatureScale(Temperature_Scale_t);
 extern Temperature_Scale_t HVAC_GetTemperatureScale(void);
 extern char HVAC_GetTemperatureSymbol(void); 
 
-extern uint32_t HVAC_GetAmbientTemperature(void);
-extern uint32_t HVAC_GetActualTemperature(void);
+extern int32_t HVAC_GetAmbientTemperature(void);
+extern int32_t HVAC_GetActualTemperature(void);
 extern void HVAC_ReadAmbientTemperature(void);
 
 extern bool HVAC_GetOutput(HVAC_Output_t);
 extern char *HVAC_GetOutputName(HVAC_Output_t);
 
+// Zone 0 is the thermostat above, see HVAC_Zone.h
+extern uint32_t HVAC_GetZoneCount(void);
+extern void HVAC_SetZoneCount(uint32_t);
+extern uint32_t HVAC_GetZoneDesiredTemperature(uint32_t zone);
+extern void HVAC_SetZoneDesiredTemperature(uint32_t zone, uint32_t temp);
+extern int32_t HVAC_GetZoneActualTemperature(uint32_t zone);
+extern HVAC_Mode_t HVAC_GetZoneHVACMode(uint32_t zone);
+extern void HVAC_SetZoneHVACMode(uint32_t zone, HVAC_Mode_t mode);
+extern FAN_Mode_t HVAC_GetZoneFanMode(uint32_t zone);
+extern void HVAC_SetZoneFanMode(uint32_t zone, FAN_Mode_t mode);
+extern bool HVAC_GetZoneOutput(uint32_t zone, HVAC_Output_t output);
+
 
 
 
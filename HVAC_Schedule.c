@@ -0,0 +1,452 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Schedule.c
+
+PURPOSE   : Weekly setback schedule of the HVAC demo, run by the HVAC_Task
+            once a second. It sets HVAC_Params.DesiredTemperature when the
+            program, or a holiday, calls for a new set point, so that the
+            thermostat follows its schedule without a server.
+
+            HVAC_ScheduleCompile() turns the entries into transitions
+            sorted by time of week, dropping those that do not change the
+            set point, and fills slot[] with the transition in effect in
+            each SCHEDULE_SLOT of the week. HVAC_ScheduleLookup() is then
+            one index into slot[] for the set point, and the transition
+            after it for the time to the next change.
+
+            Each pass also works out how long before the next change the
+            new set point should be applied, from the learned heating or
+            cooling rate. The rates are learned from each change of set
+            point the schedule makes: the time the zone took to get to the
+            new set point.
+
+            HVAC_ScheduleCheck() compares the lookup with a plain search
+            of the entries, at every minute of the week.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include "hvac.h"
+#include "hvac_public.h"
+#include "hvac_private.h"
+#include "db_notify.h"
+#include "task_monitor.h"
+#include "HVAC_Schedule.h"
+
+#define  WEEKDAYS    0x3E      // Monday to Friday
+#define  WEEKEND     0x41      // Saturday and Sunday
+
+#define  SLOT_OF( hour, min )    ((hour) * 4 + (min) / 15)
+
+HVAC_SCHEDULE   HVAC_Schedule;
+
+// The program a new schedule starts with.
+//
+const SCHEDULE_ENTRY   DefaultSchedule[] =
+{
+    {  WEEKDAYS,  SLOT_OF(  6,  0 ),  210  },
+    {  WEEKDAYS,  SLOT_OF(  8, 30 ),  170  },
+    {  WEEKDAYS,  SLOT_OF( 17,  0 ),  210  },
+    {  WEEKDAYS,  SLOT_OF( 22, 30 ),  170  },
+    {  WEEKEND,   SLOT_OF(  7, 30 ),  210  },
+    {  WEEKEND,   SLOT_OF( 23,  0 ),  170  }
+};
+
+
+// Function Prototypes - used by this module only
+//
+uint16_t  schedule_program( const HVAC_SCHEDULE * s, uint32_t t, uint32_t * next_in,
+                            uint16_t * next_setpoint );
+uint16_t  schedule_search( const HVAC_SCHEDULE * s, uint32_t t );
+void      schedule_learn( HVAC_SCHEDULE * s, uint32_t now, int32_t actual );
+
+
+//
+//  HVAC_ScheduleInit() - Start with the default program, disabled, and
+//                        with the default heating and cooling rates.
+//
+void
+HVAC_ScheduleInit( HVAC_SCHEDULE * s )
+{
+    memset( s, 0, sizeof( HVAC_SCHEDULE ) );
+
+    s->entries = sizeof( DefaultSchedule ) / sizeof( SCHEDULE_ENTRY );
+    memcpy( s->entry, DefaultSchedule, sizeof( DefaultSchedule ) );
+
+    s->heat_rate = SCHEDULE_DEFAULT_RATE;
+    s->cool_rate = SCHEDULE_DEFAULT_RATE;
+
+    HVAC_ScheduleCompile( s );
+}
+
+
+//
+//  HVAC_ScheduleCompile() - Build the transition and slot tables from the
+//                           entries. Where two entries start at the same
+//                           time, the later one wins. Returns FALSE when
+//                           there are no transitions.
+//
+bool
+HVAC_ScheduleCompile( HVAC_SCHEDULE * s )
+{
+    SCHEDULE_TRANSITION  * tr = s->transition;
+    SCHEDULE_TRANSITION    t;
+    int                    k, d, j, n = 0, m = 0, idx;
+
+    for( k=0; k<s->entries; k++ )
+    {
+        for( d=0; d<7; d++ )
+        {
+            if( !(s->entry[k].days & (1 << d)) )
+                continue;
+
+            t.slot     = d * SCHEDULE_SLOTS_PER_DAY + s->entry[k].slot;
+            t.setpoint = s->entry[k].setpoint;
+
+            for( j=n; (j > 0) && (tr[j-1].slot > t.slot); j-- )
+                ;
+
+            if( (j > 0) && (tr[j-1].slot == t.slot) )
+            {
+                tr[j-1].setpoint = t.setpoint;
+            }
+            else
+            {
+                memmove( &tr[j+1], &tr[j], (n - j) * sizeof( SCHEDULE_TRANSITION ) );
+                tr[j] = t;
+                n++;
+            }
+        }
+    }
+
+    // Drop the transitions that do not change the set point, including
+    //    the first when the week ends at its set point.
+    //
+    for( j=0; j<n; j++ )
+    {
+        if( (m == 0) || (tr[j].setpoint != tr[m-1].setpoint) )
+            tr[m++] = tr[j];
+    }
+
+    if( (m > 1) && (tr[0].setpoint == tr[m-1].setpoint) )
+    {
+        memmove( &tr[0], &tr[1], (m - 1) * sizeof( SCHEDULE_TRANSITION ) );
+        m--;
+    }
+
+    // Slots before the first transition of the week carry on from the
+    //    last one.
+    //
+    idx = m - 1;
+    j   = 0;
+    for( k=0; k<SCHEDULE_SLOTS; k++ )
+    {
+        while( (j < m) && (tr[j].slot <= k) )
+            idx = j++;
+
+        s->slot[k] = (idx > 0) ? idx : 0;
+    }
+
+    s->transitions = m;
+    s->applied     = 0;
+
+    return( m > 0 );
+}
+
+
+//
+//  HVAC_ScheduleSetClock() - Set the schedule clock to "week_time" seconds
+//                            from Sunday 00:00. The day numbers of the
+//                            holidays count from that Sunday.
+//
+void
+HVAC_ScheduleSetClock( HVAC_SCHEDULE * s, uint32_t now, uint32_t week_time )
+{
+    s->clock_offset = (int32_t)(week_time - now);
+    s->applied      = 0;
+}
+
+
+//
+//  HVAC_ScheduleClock() - Seconds from Sunday 00:00 of day 0.
+//
+uint32_t
+HVAC_ScheduleClock( const HVAC_SCHEDULE * s, uint32_t now )
+{
+    return( now + s->clock_offset );
+}
+
+
+//
+//  HVAC_ScheduleLookup() - The set point at "now", 0 for none, with the
+//                          time to the next change and the set point it
+//                          changes to.
+//
+uint16_t
+HVAC_ScheduleLookup( const HVAC_SCHEDULE * s, uint32_t now, uint32_t * next_in, uint16_t * next_setpoint )
+{
+    uint32_t                 t   = HVAC_ScheduleClock( s, now );
+    uint32_t                 day = t / SCHEDULE_DAY;
+    uint32_t                 end, in;
+    uint16_t                 sp;
+    const SCHEDULE_HOLIDAY * h;
+    int                      k;
+
+    for( k=0; k<SCHEDULE_MAX_HOLIDAYS; k++ )
+    {
+        h = &s->holiday[k];
+
+        if( h->days && ((day - h->first_day) < h->days) )
+        {
+            end            = (h->first_day + h->days) * SCHEDULE_DAY;
+            *next_in       = end - t;
+            *next_setpoint = schedule_program( s, end, &in, &sp );
+            return( h->setpoint );
+        }
+    }
+
+    return( schedule_program( s, t, next_in, next_setpoint ) );
+}
+
+
+//
+//  HVAC_ScheduleRun() - Apply the set point the schedule calls for, early
+//                       by the time the zone needs to get there. "actual"
+//                       is the zone temperature in 1/10 degree C, and may
+//                       be below 0.
+//
+void
+HVAC_ScheduleRun( HVAC_SCHEDULE * s, uint32_t now, int32_t actual )
+{
+    uint32_t     start;
+    uint32_t     next_in;
+    uint32_t     lead = 0;
+    uint16_t     setpoint, next;
+    HVAC_Mode_t  mode = HVAC_Params.HVACMode;
+
+    if( !s->enabled )
+        return;
+
+    schedule_learn( s, now, actual );
+
+    start    = TMON_CYCLE_COUNT();
+    setpoint = HVAC_ScheduleLookup( s, now, &next_in, &next );
+    start    = TMON_CYCLE_COUNT() - start;
+
+    s->lookups++;
+    if( start > s->lookup_max )
+        s->lookup_max = start;
+
+    s->next_in = next_in;
+
+    if( setpoint == 0 )
+        return;
+
+    // A change applied early holds until its time has come; the lead is
+    //    not worked out again from a zone that is already on its way.
+    //
+    if( s->early_sp && s->applied && ((int32_t)(now - s->early_until) < 0) )
+    {
+        setpoint = s->early_sp;
+    }
+    else
+    {
+        s->early_sp = 0;
+
+        // Only the equipment the mode allows can get the zone there early.
+        //
+        if( (next > setpoint) && ((int32_t) next > actual) && ((mode == HVAC_Heat) || (mode == HVAC_Auto)) )
+            lead = (uint32_t)((int32_t) next - actual) * 3600 / s->heat_rate;
+        else if( (next < setpoint) && ((int32_t) next < actual) && ((mode == HVAC_Cool) || (mode == HVAC_Auto)) )
+            lead = (uint32_t)(actual - (int32_t) next) * 3600 / s->cool_rate;
+
+        if( lead > SCHEDULE_MAX_PRESTART )
+            lead = SCHEDULE_MAX_PRESTART;
+
+        if( lead && (next_in <= lead) )
+        {
+            setpoint          = next;
+            s->early_sp       = next;
+            s->early_until    = now + next_in;
+            s->prestarts++;
+        }
+    }
+
+    if( setpoint == s->applied )
+        return;
+
+    s->applied = setpoint;
+    s->changes++;
+
+    HVAC_Params.DesiredTemperature = setpoint;
+    db_publish( DB_BIT( DB_GROUP_HVAC_PARAMS ) );
+
+    // Learn from this change if the zone has some way to go.
+    //
+    if( (int32_t) setpoint >= actual + SCHEDULE_MIN_RECOVERY )
+        s->recovery = HVAC_Heat;
+    else if( actual >= (int32_t) setpoint + SCHEDULE_MIN_RECOVERY )
+        s->recovery = HVAC_Cool;
+    else
+        s->recovery = 0;
+
+    s->recovery_start = now;
+    s->recovery_from  = (int16_t) actual;
+    s->recovery_to    = setpoint;
+}
+
+
+//
+//  HVAC_ScheduleCheck() - Compare HVAC_ScheduleLookup() of the program with
+//                         a search of the entries, and check the time to
+//                         the next change, at every minute of the week.
+//                         Returns the number of minutes that disagree, and
+//                         the average cycles of the lookup and the search.
+//
+uint32_t
+HVAC_ScheduleCheck( const HVAC_SCHEDULE * s, uint32_t * fast, uint32_t * slow )
+{
+    uint32_t  t, c, next_in;
+    uint32_t  errors = 0, fast_total = 0, slow_total = 0;
+    uint16_t  a, b, next;
+
+    for( t=0; t<SCHEDULE_WEEK; t+=60 )
+    {
+        c = TMON_CYCLE_COUNT();
+        a = schedule_program( s, t, &next_in, &next );
+        fast_total += TMON_CYCLE_COUNT() - c;
+
+        c = TMON_CYCLE_COUNT();
+        b = schedule_search( s, t );
+        slow_total += TMON_CYCLE_COUNT() - c;
+
+        if(    (a != b)
+            || (s->transitions && (schedule_search( s, t + next_in ) != next))
+            || (s->transitions && (next_in > 1) && (schedule_search( s, t + next_in - 1 ) != a)) )
+            errors++;
+    }
+
+    *fast = fast_total / (SCHEDULE_WEEK / 60);
+    *slow = slow_total / (SCHEDULE_WEEK / 60);
+
+    return( errors );
+}
+
+
+//
+//  schedule_program() - The set point of the program at schedule time "t",
+//                       without the holidays.
+//
+uint16_t
+schedule_program( const HVAC_SCHEDULE * s, uint32_t t, uint32_t * next_in, uint16_t * next_setpoint )
+{
+    uint32_t  wt = t % SCHEDULE_WEEK;
+    uint32_t  at;
+    int       i, n;
+
+    if( s->transitions == 0 )
+    {
+        *next_in       = SCHEDULE_WEEK;
+        *next_setpoint = 0;
+        return( 0 );
+    }
+
+    i  = s->slot[ wt / SCHEDULE_SLOT ];
+    n  = (i + 1 < s->transitions) ? i + 1 : 0;
+    at = (uint32_t)s->transition[n].slot * SCHEDULE_SLOT;
+
+    *next_in       = (at > wt) ? at - wt : at + SCHEDULE_WEEK - wt;
+    *next_setpoint = s->transition[n].setpoint;
+
+    return( s->transition[i].setpoint );
+}
+
+
+//
+//  schedule_search() - The set point of the program at schedule time "t",
+//                      found by looking at every entry on every day; the
+//                      one that started last, the later entry if two
+//                      started together. Used only to check the lookup.
+//
+uint16_t
+schedule_search( const HVAC_SCHEDULE * s, uint32_t t )
+{
+    uint32_t  wt   = t % SCHEDULE_WEEK;
+    uint32_t  best = SCHEDULE_WEEK;
+    uint32_t  at, age;
+    uint16_t  setpoint = 0;
+    int       k, d;
+
+    for( k=0; k<s->entries; k++ )
+    {
+        for( d=0; d<7; d++ )
+        {
+            if( !(s->entry[k].days & (1 << d)) )
+                continue;
+
+            at  = d * SCHEDULE_DAY + (uint32_t)s->entry[k].slot * SCHEDULE_SLOT;
+            age = (wt >= at) ? wt - at : wt + SCHEDULE_WEEK - at;
+
+            if( age <= best )
+            {
+                best     = age;
+                setpoint = s->entry[k].setpoint;
+            }
+        }
+    }
+
+    return( setpoint );
+}
+
+
+//
+//  schedule_learn() - Once the zone reaches the set point of the change
+//                     being learned from, take the rate it got there at
+//                     into the heating or cooling rate. A change made by
+//                     hand, or one that takes too long, is not learned.
+//
+void
+schedule_learn( HVAC_SCHEDULE * s, uint32_t now, int32_t actual )
+{
+    uint32_t  took, rate;
+
+    if( !s->recovery )
+        return;
+
+    took = now - s->recovery_start;
+
+    if( (HVAC_Params.DesiredTemperature != s->recovery_to) || (took > SCHEDULE_MAX_RECOVERY) )
+    {
+        s->recovery = 0;
+        return;
+    }
+
+    if( (s->recovery == HVAC_Heat) ? (actual < (int32_t) s->recovery_to) : (actual > (int32_t) s->recovery_to) )
+        return;
+
+    if( took == 0 )
+        took = 1;
+
+    // The change was at least SCHEDULE_MIN_RECOVERY in this direction.
+    //
+    rate = (uint32_t)((s->recovery == HVAC_Heat) ? (int32_t) s->recovery_to - s->recovery_from
+                                                 : s->recovery_from - (int32_t) s->recovery_to) * 3600 / took;
+
+    if( rate < SCHEDULE_MIN_RATE )
+        rate = SCHEDULE_MIN_RATE;
+    else if( rate > 0xFFFF )
+        rate = 0xFFFF;
+
+    if( s->recovery == HVAC_Heat )
+        s->heat_rate = (s->heat_rate * 3 + rate) / 4;
+    else
+        s->cool_rate = (s->cool_rate * 3 + rate) / 4;
+
+    s->learned++;
+    s->recovery = 0;
+}
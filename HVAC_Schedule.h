@@ -0,0 +1,138 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Schedule.h
+
+PURPOSE   : Definitions and function prototypes for the "HVAC_Schedule.c"
+            module; the weekly setback schedule of the HVAC demo.
+
+            The program is a list of entries, each a set point from a time
+            of day on some days of the week, and a few holidays that hold
+            one set point for whole days. It is compiled into a table of
+            transitions sorted by time of week, and a table giving for
+            each SCHEDULE_SLOT of the week the transition in effect, so
+            that the set point now and the next change are found without
+            a search.
+
+            The schedule keeps its own clock of the week, set from the
+            shell, as this board has no real time clock.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __hvac_schedule_inc
+#define  __hvac_schedule_inc
+
+#include <mqx.h>
+
+#define  SCHEDULE_DAY              (24 * 3600)
+#define  SCHEDULE_WEEK             (7 * SCHEDULE_DAY)
+#define  SCHEDULE_SLOT             900       // Seconds, times are rounded to
+#define  SCHEDULE_SLOTS_PER_DAY    (SCHEDULE_DAY / SCHEDULE_SLOT)
+#define  SCHEDULE_SLOTS            (7 * SCHEDULE_SLOTS_PER_DAY)
+
+#define  SCHEDULE_MAX_ENTRIES      16
+#define  SCHEDULE_MAX_HOLIDAYS     4
+#define  SCHEDULE_MAX_TRANSITIONS  (7 * SCHEDULE_MAX_ENTRIES)
+
+#define  SCHEDULE_DEFAULT_RATE     20        // 1/10 degree per hour, 2.0 C
+#define  SCHEDULE_MIN_RATE         5
+#define  SCHEDULE_MAX_PRESTART     7200      // Seconds
+#define  SCHEDULE_MIN_RECOVERY     5         // 1/10 degree, smaller changes
+                                             //   are not learned from
+#define  SCHEDULE_MAX_RECOVERY     (4 * 3600)   // Seconds, longer is given up
+
+// SCHEDULE_ENTRY - "setpoint" from "slot" of the day, on each day with a
+//   bit set in "days" (bit 0 = Sunday).
+//
+typedef struct
+{
+    uint8_t   days;
+    uint8_t   slot;              // 0..SCHEDULE_SLOTS_PER_DAY-1
+    uint16_t  setpoint;          // 1/10 degree C
+
+}  SCHEDULE_ENTRY;
+
+// SCHEDULE_HOLIDAY - "setpoint" all day, for "days" days from "first_day"
+//   of the schedule clock. "days" 0 is an unused holiday.
+//
+typedef struct
+{
+    uint16_t  first_day;
+    uint8_t   days;
+    uint16_t  setpoint;
+
+}  SCHEDULE_HOLIDAY;
+
+// SCHEDULE_TRANSITION - One change of set point, in slots from Sunday
+//   00:00.
+//
+typedef struct
+{
+    uint16_t  slot;
+    uint16_t  setpoint;
+
+}  SCHEDULE_TRANSITION;
+
+// HVAC_SCHEDULE - The program, its compiled form, and what HVAC_ScheduleRun()
+//   keeps between passes.
+//
+//   A change of set point is applied "lead" seconds early, the time the
+//   zone takes to get there at the learned heating or cooling rate, so
+//   that the set point is reached at the time in the program. Once applied
+//   early, the new set point is held until the time of the change, however
+//   the zone gets on meanwhile. A set point set by hand holds until the
+//   schedule next changes it.
+//
+typedef struct
+{
+    bool                 enabled;
+    int32_t              clock_offset;  // SecCounter + offset = seconds from
+                                        //   Sunday 00:00 of day 0
+    uint8_t              entries;
+    SCHEDULE_ENTRY       entry[ SCHEDULE_MAX_ENTRIES ];
+    SCHEDULE_HOLIDAY     holiday[ SCHEDULE_MAX_HOLIDAYS ];
+
+    uint8_t              transitions;
+    SCHEDULE_TRANSITION  transition[ SCHEDULE_MAX_TRANSITIONS ];
+    uint8_t              slot[ SCHEDULE_SLOTS ];   // Transition in effect
+
+    uint16_t             applied;       // Set point last applied, 0 = none;
+                                        //   0 also drops an early start
+    uint16_t             early_sp;      // Applied early, 0 = none
+    uint32_t             early_until;   // SecCounter of its change
+    uint32_t             next_in;       // Seconds to the next change
+    uint16_t             heat_rate;     // Learned, 1/10 degree per hour
+    uint16_t             cool_rate;
+
+    uint8_t              recovery;      // 0, or HVAC_Heat\Cool being learned
+    uint32_t             recovery_start;
+    int16_t              recovery_from;  // 1/10 degree, may be below 0
+    uint16_t             recovery_to;
+
+    uint32_t             changes;       // Set points applied
+    uint32_t             prestarts;     //   of which early
+    uint32_t             learned;       // Recoveries learned from
+    uint32_t             lookups;
+    uint32_t             lookup_max;    // Cycles
+
+}  HVAC_SCHEDULE;
+
+extern HVAC_SCHEDULE   HVAC_Schedule;
+
+//
+//    Function Prototypes
+//
+void      HVAC_ScheduleInit( HVAC_SCHEDULE * s );
+bool      HVAC_ScheduleCompile( HVAC_SCHEDULE * s );
+void      HVAC_ScheduleSetClock( HVAC_SCHEDULE * s, uint32_t now, uint32_t week_time );
+uint32_t  HVAC_ScheduleClock( const HVAC_SCHEDULE * s, uint32_t now );
+uint16_t  HVAC_ScheduleLookup( const HVAC_SCHEDULE * s, uint32_t now,
+                               uint32_t * next_in, uint16_t * next_setpoint );
+void      HVAC_ScheduleRun( HVAC_SCHEDULE * s, uint32_t now, int32_t actual );
+uint32_t  HVAC_ScheduleCheck( const HVAC_SCHEDULE * s, uint32_t * fast, uint32_t * slow );
+
+#endif
@@ -33,7 +33,55 @@
 #include "hvac_public.h"
 #include "HVAC_Shell_Commands.h"
 #include "WiFi_GT202.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+#include "work_queue.h"
+#include "boot_stage.h"
+#include "core_lock.h"
+#include "live_status.h"
+#include "db_notify.h"
+#include "global.h"
+#include "config_store.h"
+#include "config_image.h"
+#include "func.h"
+#include "warm_restart.h"
+#include "journal.h"
+#include "relay_control.h"
+#include "analog_control.h"
+#include "output_commit.h"
+#include "Control_Task.h"
+#include "HVAC_Plant.h"
+#include "HVAC_Zone.h"
+#include "HVAC_Schedule.h"
+#include "sensor_failover.h"
+#include "analog_tune.h"
 
+extern int_32 print_perf(int_32 argc, char_ptr argv[]);
+
+
+/*FUNCTION*-------------------------------------------------------------------
+*
+* Function Name    :   Shell_zone_arg
+* Returned Value   :  FALSE for a zone that is not in use
+* Comments  :  Takes the optional zone, "z<zone>", in front of the other
+*              parameters of the temp, fan and hvac commands out of argv.
+*              The zone is 0 when none is given.
+*
+*END*---------------------------------------------------------------------*/
+
+static bool Shell_zone_arg(int32_t *argc, char **argv[], uint32_t *zone)
+{
+   *zone = 0;
+   if ((*argc > 1) && ((*argv)[1][0] == 'z')) {
+      if ((sscanf(&(*argv)[1][1],"%u",zone) != 1) || (*zone >= HVAC_GetZoneCount())) {
+         return FALSE;
+      }
+      (*argv)[1] = (*argv)[0];
+      (*argv)++;
+      (*argc)--;
+   }
+   return TRUE;
+}
 
 
 /*FUNCTION*-------------------------------------------------------------------
@@ -48,12 +96,18 @@ int32_t  Shell_temp(int32_t argc, char *argv[] )
 {
    bool           print_usage, shorthelp = FALSE;
    int32_t            return_code = SHELL_EXIT_SUCCESS;
-   uint32_t           temp,temp_fract;
+   uint32_t           temp,temp_fract,zone;
+   int32_t            actual;
+   char *             sign = "";
 
    print_usage = Shell_check_help_request(argc, argv, &shorthelp );
 
    if (!print_usage)  {
-      if (argc > 2) {
+      if (!Shell_zone_arg(&argc, &argv, &zone)) {
+         printf("Invalid zone\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else if (argc > 2) {
          printf("Error, invalid number of parameters\n");
          return_code = SHELL_EXIT_ERROR;
          print_usage=TRUE;
@@ -62,7 +116,7 @@ int32_t  Shell_temp(int32_t argc, char *argv[] )
             temp_fract = 0;
             if (sscanf(argv[1],"%d.%d",&temp,&temp_fract)>=1) {
                if (temp_fract<10) {
-                  HVAC_SetDesiredTemperature(temp*10+temp_fract);
+                  HVAC_SetZoneDesiredTemperature(zone,temp*10+temp_fract);
                } else {
                   printf("Invalid temperature specified, format is dd.d\n");
                }
@@ -71,18 +125,27 @@ int32_t  Shell_temp(int32_t argc, char *argv[] )
             } 
          }
 
-         temp  = HVAC_GetDesiredTemperature();
+         temp  = HVAC_GetZoneDesiredTemperature(zone);
          printf("Desired Temperature is %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
-         temp  = HVAC_GetActualTemperature();
-         printf("Actual Temperature is %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
+         actual = HVAC_GetZoneActualTemperature(zone);
+         if (actual == HVAC_ZONE_NO_TEMP) {
+            printf("Actual Temperature is not known\n");
+         } else {
+            if (actual < 0) {
+               sign   = "-";
+               actual = -actual;
+            }
+            printf("Actual Temperature is %s%d.%1d %c\n", sign, actual/10, actual%10, HVAC_GetTemperatureSymbol());
+         }
       }
    }
    
    if (print_usage)  {
       if (shorthelp)  {
-         printf("%s [<temperature>]\n", argv[0]);
+         printf("%s [z<zone>] [<temperature>]\n", argv[0]);
       } else  {
-         printf("Usage: %s [<temperature>]\n", argv[0]);
+         printf("Usage: %s [z<zone>] [<temperature>]\n", argv[0]);
+         printf("   <zone>        = zone, 0 to %u (default 0)\n", HVAC_GetZoneCount()-1);
          printf("   <temperature> = desired temperature (degrees)\n");
       }
    }
@@ -103,6 +166,8 @@ int32_t  Shell_scale(int32_t argc, char *argv[] )
    bool           print_usage, shorthelp = FALSE;
    int32_t            return_code = SHELL_EXIT_SUCCESS;
    uint32_t           temp;
+   int32_t            actual;
+   char *             sign = "";
  
    print_usage = Shell_check_help_request(argc, argv, &shorthelp );
 
@@ -129,8 +194,12 @@ int32_t  Shell_scale(int32_t argc, char *argv[] )
          }         
          temp  = HVAC_GetDesiredTemperature();
          printf("Desired Temperature is %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
-         temp  = HVAC_GetActualTemperature();
-         printf("Actual Temperature is %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
+         actual = HVAC_GetActualTemperature();
+         if (actual < 0) {
+            sign   = "-";
+            actual = -actual;
+         }
+         printf("Actual Temperature is %s%d.%1d %c\n", sign, actual/10, actual%10, HVAC_GetTemperatureSymbol());
       }
    }
    
@@ -159,35 +228,41 @@ int32_t  Shell_fan(int32_t argc, char *argv[] )
    bool           print_usage, shorthelp = FALSE;
    int32_t            return_code = SHELL_EXIT_SUCCESS;
    FAN_Mode_t        fan;
+   uint32_t          zone;
 
    print_usage = Shell_check_help_request(argc, argv, &shorthelp );
 
    if (!print_usage)  {
-      if (argc > 2) {
+      if (!Shell_zone_arg(&argc, &argv, &zone)) {
+         printf("Invalid zone\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else if (argc > 2) {
          printf("Error, invalid number of parameters\n");
          return_code = SHELL_EXIT_ERROR;
          print_usage=TRUE;
       } else {
          if (argc == 2) {
             if (strcmp(argv[1],"on")==0) {
-               HVAC_SetFanMode(Fan_On);
+               HVAC_SetZoneFanMode(zone,Fan_On);
             } else if (strcmp(argv[1],"off")==0) {
-               HVAC_SetFanMode(Fan_Automatic);
+               HVAC_SetZoneFanMode(zone,Fan_Automatic);
             } else {
                printf("Invalid fan mode specified\n");
             } 
          }
 
-         fan  = HVAC_GetFanMode();
+         fan  = HVAC_GetZoneFanMode(zone);
          printf("Fan mode is %s\n", fan == Fan_Automatic ? "Automatic" : "On");
       }
    }
    
    if (print_usage)  {
       if (shorthelp)  {
-         printf("%s [<mode>]\n", argv[0]);
+         printf("%s [z<zone>] [<mode>]\n", argv[0]);
       } else  {
-         printf("Usage: %s [<mode>]\n", argv[0]);
+         printf("Usage: %s [z<zone>] [<mode>]\n", argv[0]);
+         printf("   <zone> = zone, 0 to %u (default 0)\n", HVAC_GetZoneCount()-1);
          printf("   <mode> = on or off (off = automatic mode)\n");
       }
    }
@@ -206,38 +281,44 @@ int32_t  Shell_hvac(int32_t argc, char *argv[] )
 {
    bool           print_usage, shorthelp = FALSE;
    int32_t            return_code = SHELL_EXIT_SUCCESS;
+   uint32_t           zone;
 
    print_usage = Shell_check_help_request(argc, argv, &shorthelp );
 
    if (!print_usage)  {
-      if (argc > 2) {
+      if (!Shell_zone_arg(&argc, &argv, &zone)) {
+         printf("Invalid zone\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else if (argc > 2) {
          printf("Error, invalid number of parameters\n");
          return_code = SHELL_EXIT_ERROR;
          print_usage=TRUE;
       } else {
          if (argc == 2) {
             if (strcmp(argv[1],"off")==0) {
-               HVAC_SetHVACMode(HVAC_Off);
+               HVAC_SetZoneHVACMode(zone,HVAC_Off);
             } else if (strcmp(argv[1],"cool")==0) {
-               HVAC_SetHVACMode(HVAC_Cool);
+               HVAC_SetZoneHVACMode(zone,HVAC_Cool);
             } else if (strcmp(argv[1],"heat")==0) {
-               HVAC_SetHVACMode(HVAC_Heat);
+               HVAC_SetZoneHVACMode(zone,HVAC_Heat);
             } else if (strcmp(argv[1],"auto")==0) {
-               HVAC_SetHVACMode(HVAC_Auto);
+               HVAC_SetZoneHVACMode(zone,HVAC_Auto);
             } else {
                printf("Invalid hvac mode specified\n");
             } 
          }
 
-         printf("HVAC mode is %s\n", HVAC_HVACModeName(HVAC_GetHVACMode()));
+         printf("HVAC mode is %s\n", HVAC_HVACModeName(HVAC_GetZoneHVACMode(zone)));
       }
    }
    
    if (print_usage)  {
       if (shorthelp)  {
-         printf("%s [<mode>]\n", argv[0]);
+         printf("%s [z<zone>] [<mode>]\n", argv[0]);
       } else  {
-         printf("Usage: %s [<mode>]\n", argv[0]);
+         printf("Usage: %s [z<zone>] [<mode>]\n", argv[0]);
+         printf("   <zone> = zone, 0 to %u (default 0)\n", HVAC_GetZoneCount()-1);
          printf("   <mode> = off, cool, heat or auto\n");
       }
    }
@@ -257,6 +338,8 @@ int32_t  Shell_info(int32_t argc, char *argv[] )
    bool           print_usage, shorthelp = FALSE;
    int32_t            return_code = SHELL_EXIT_SUCCESS;
    uint32_t           temp;
+   int32_t            actual;
+   char *             sign = "";
    FAN_Mode_t        fan;
    HVAC_Output_t     output;
 
@@ -271,8 +354,12 @@ int32_t  Shell_info(int32_t argc, char *argv[] )
          printf("HVAC mode:    %s\n",  HVAC_HVACModeName(HVAC_GetHVACMode()));
          temp  = HVAC_GetDesiredTemperature();
          printf("Desired Temp: %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
-         temp  = HVAC_GetActualTemperature();
-         printf("Actual Temp:  %d.%1d %c\n", temp/10, temp%10, HVAC_GetTemperatureSymbol());
+         actual = HVAC_GetActualTemperature();
+         if (actual < 0) {
+            sign   = "-";
+            actual = -actual;
+         }
+         printf("Actual Temp:  %s%d.%1d %c\n", sign, actual/10, actual%10, HVAC_GetTemperatureSymbol());
          fan  = HVAC_GetFanMode();
          printf("Fan mode:     %s\n", fan == Fan_Automatic ? "Automatic" : "On");
 
@@ -449,5 +536,1315 @@ int32_t  Shell_wifi_params(int32_t argc, char * argv[] )
    
   } /* Endbody */
 
+
+/*FUNCTION*-------------------------------------------------------------------
+*
+* Function Name    :   Shell_top
+* Returned Value   :  int32_t error code
+* Comments  :  Prints CPU use and stack high-water mark of each task, and
+*              the CPU use of the application interrupt handlers, measured
+*              over the last one second window by the task monitor, and
+*              the state of the deferred work queues.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_top(int32_t argc, char *argv[] )
+{
+   bool           print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   TASK_STATS         stats[MAX_MONITORED_TASKS];
+   WORK_QUEUE_STATS   work;
+   static const char *work_name[MAX_WORK_PRIO] = { "high", "low", "flash" };
+   uint32_t           count = 1, tenths, size, used;
+   int                num, k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc > 2) {
+         printf("Error, invalid number of parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else if ((argc == 2) && ((sscanf(argv[1],"%u",&count) != 1) || (count == 0))) {
+         printf("Invalid count specified\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else {
+         while (count--) {
+            num = task_monitor_get_stats(stats, MAX_MONITORED_TASKS);
+
+            printf("\nTask          Id        Pri   CPU%%   Stack   Used   Free\n");
+            for (k=0;k<num;k++) {
+               printf("%-12s  0x%08x %3u  %3u.%1u  %6u %6u %6u\n",
+                  stats[k].name, (uint32_t)stats[k].task_id, stats[k].priority,
+                  stats[k].cpu_tenths/10, stats[k].cpu_tenths%10,
+                  stats[k].stack_size, stats[k].stack_used,
+                  stats[k].stack_size - stats[k].stack_used);
+            }
+            tenths = task_monitor_other_tenths();
+            printf("%-12s                 %3u.%1u\n", "(other)", tenths/10, tenths%10);
+
+            printf("\nISR           CPU%%   Count  Max cycles\n");
+            for (k=0;k<MAX_TMON_ISR;k++) {
+               tenths = task_monitor_isr_tenths(k);
+               printf("%-12s  %3u.%1u  %6u  %6u\n", IsrMonitorName[k],
+                  tenths/10, tenths%10, IsrMonitor[k].last_count, IsrMonitor[k].max_cycles);
+            }
+
+            if (task_monitor_int_stack(&size, &used)) {
+               printf("\nInterrupt stack: %u of %u bytes used\n", used, size);
+            } else {
+               printf("\nStack usage requires MQX_MONITOR_STACK\n");
+            }
+
+            printf("\nWork queue  Depth  Max     Run  Dropped  Missed  Max us\n");
+            for (k=0;k<MAX_WORK_PRIO;k++) {
+               work_queue_get_stats((WORK_PRIO)k, &work);
+               printf("%-10s  %5u  %3u  %6u  %7u  %6u  %6u\n", work_name[k],
+                  work.depth, work.max_depth, work.run, work.dropped, work.missed, work.max_latency_us);
+            }
+            printf("Longest post: %u cycles\n", work.max_post_cycles);
+
+            if (count) {
+               _time_delay(1000);
+            }
+         }
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [<count>]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [<count>]\n", argv[0]);
+         printf("   <count> = number of one second reports to print\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_trace
+* Returned Value   :  int32_t error code
+* Comments  :  Controls the event trace recorder and prints its contents.
+*              The same trace is available as Chrome trace JSON from
+*              the trace_data CGI.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_trace(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   TRACE_CURSOR       cursor;
+   TRACE_SPAN_STATS   stats[MAX_TRACE_SPANS];
+   char               line[128];
+   uint32_t           mask;
+   int                num, k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("Trace %s, mask 0x%02x, %u records\n",
+            TraceEnabled ? (TraceReaders ? "on, paused" : "on") : "off",
+            TraceClassMask, trace_count());
+      } else if ((argc == 2) && (strcmp(argv[1], "on") == 0)) {
+         TraceEnabled = TRUE;
+      } else if ((argc == 2) && (strcmp(argv[1], "off") == 0)) {
+         TraceEnabled = FALSE;
+      } else if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+         trace_clear();
+      } else if ((argc == 2) && (strcmp(argv[1], "dump") == 0)) {
+         trace_open(&cursor, FALSE);
+         while (trace_read(&cursor, line, sizeof(line)) > 0) {
+            printf("%s", line);
+         }
+         trace_close(&cursor);
+      } else if ((argc == 2) && (strcmp(argv[1], "stats") == 0)) {
+         num = trace_span_stats(stats, MAX_TRACE_SPANS);
+
+         printf("\nSpan                 Count   Min us   Avg us   Max us\n");
+         for (k=0;k<num;k++) {
+            if (stats[k].count) {
+               printf("%-18s  %6u  %7u  %7u  %7u\n", stats[k].name, stats[k].count,
+                  stats[k].min_us, stats[k].total_us / stats[k].count, stats[k].max_us);
+            }
+         }
+      } else if ((argc == 3) && (strcmp(argv[1], "mask") == 0) &&
+                 (sscanf(argv[2],"%x",&mask) == 1) && (mask <= TRACE_CLASS_ALL)) {
+         TraceClassMask = mask;
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [on|off|clear|dump|stats|mask <hex>]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [on|off|clear|dump|stats|mask <hex>]\n", argv[0]);
+         printf("   on, off  = start or stop recording\n");
+         printf("   clear    = discard all records\n");
+         printf("   dump     = print all records, oldest first\n");
+         printf("   stats    = print span latencies from the records held\n");
+         printf("   mask     = classes to record, 01 task, 02 ISR,\n");
+         printf("              04 lwevent, 08 mutex, 10 marker\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_boot
+* Returned Value   :  int32_t error code
+* Comments  :  Prints when each boot stage was started and became ready,
+*              where the run time state was restored from after the last
+*              reset, and the Atheros driver's boot profile events.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_boot(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   const char *       state;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc > 1) {
+         printf("Error, invalid number of parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else {
+         printf("\nStage       State    Start ms  Ready ms\n");
+         for (k=0;k<MAX_BOOT_STAGE;k++) {
+            switch (BootStatus[k].state) {
+               case BOOT_STATE_READY:   state = "ready";   break;
+               case BOOT_STATE_STARTED: state = "started"; break;
+               default:                 state = "waiting"; break;
+            }
+            printf("%-10s  %-7s  ", BootStageTable[k].name, state);
+
+            if (BootStageTable[k].start == NULL) {
+               printf("%8s", "-");
+            } else if (BootStatus[k].state != BOOT_STATE_WAITING) {
+               printf("%8u", BootStatus[k].start_ms);
+            } else {
+               printf("%8s", "");
+            }
+
+            if (BootStatus[k].state == BOOT_STATE_READY) {
+               printf("  %8u", BootStatus[k].ready_ms);
+            }
+            printf("%s\n", BootStatus[k].late ? "  (late)" : "");
+         }
+         printf("\nReset %u, SRS 0x%02x%02x%s, state from %s",
+            ResetCount, ResetStatusRegHigh, ResetStatusRegLow,
+            WarmRestartStats.cold ? " (cold)" : "",
+            WarmSourceName[WarmRestartStats.source]);
+         if (WarmRestartStats.source == WARM_SOURCE_RAM) {
+            printf(", snapshot %u at %u s", WarmRestartStats.seq, WarmRestartStats.age_sec);
+         }
+         printf(", restored at %u ms\n", WarmRestartStats.restore_ms);
+         printf("Snapshots %u, max %u us, %u bad slots; relay saved to flash %u, errors %u\n\n",
+            WarmRestartStats.saves, core_lock_cycles_to_us(WarmRestartStats.save_max),
+            WarmRestartStats.rejected, WarmRestartStats.flash_saves,
+            WarmRestartStats.flash_errors);
+         print_perf(argc, argv);
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s\n", argv[0]);
+      } else  {
+         printf("Usage: %s\n", argv[0]);
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_config
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the state of the configuration store; the current
+*              record of each item, sector erase counts, and how many
+*              bytes were programmed for the bytes saved. "config test"
+*              converts a fixed schema 0 setup image and checks it.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_config(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   CFG_INDEX *        index;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("\nSector size %u, active sector %u, %u bytes free\n",
+            CfgSectorSize, CfgActiveSector, CfgSectorSize - CfgFreeOffset);
+         printf("Erases per sector:");
+         for (k=0;k<CFG_STORE_SECTORS;k++) {
+            printf(" %u", CfgSectorErases[k]);
+         }
+         printf("\n\nItem            Length  Sequence  Sector\n");
+         for (k=0;k<MAX_CFG_KEY;k++) {
+            index = &CfgIndex[k];
+            if (index->seq == 0) {
+               printf("%-14s  (not stored)\n", CfgKeyName[k]);
+            } else {
+               printf("%-14s  %6u  %8u  %6u\n", CfgKeyName[k],
+                  index->length, index->seq, index->sector);
+            }
+         }
+         printf("\nSetup image: schema %u, %u bytes, %s%s, %u rejected\n",
+            CfgImageInfo.schema, IMG_SIZE,
+            ((CfgImageInfo.schema == 0) && !CfgImageInfo.migrated) ? "not found" :
+               CfgImageInfo.in_place ? "read in place" : "read into RAM",
+            CfgImageInfo.migrated ? ", migrated" : "",
+            CfgImageInfo.rejected);
+         printf("%u writes, %u unchanged, %u compactions, %u CRC errors, %u write errors\n",
+            CfgStoreStats.writes, CfgStoreStats.unchanged, CfgStoreStats.compactions,
+            CfgStoreStats.crc_errors, CfgStoreStats.write_errors);
+         printf("%u bytes saved, %u bytes programmed", CfgStoreStats.data_bytes,
+            CfgStoreStats.flash_bytes);
+         if (CfgStoreStats.data_bytes) {
+            printf(", write amplification %u.%02u",
+               CfgStoreStats.flash_bytes / CfgStoreStats.data_bytes,
+               (CfgStoreStats.flash_bytes % CfgStoreStats.data_bytes) * 100 / CfgStoreStats.data_bytes);
+         }
+         printf("\n");
+      } else if ((argc == 2) && (strcmp(argv[1], "test") == 0)) {
+         if (cfg_image_test()) {
+            printf("Setup image schema 0 to %u conversion passed\n", IMG_SCHEMA);
+         } else {
+            printf("Setup image schema 0 to %u conversion FAILED\n", IMG_SCHEMA);
+            return_code = SHELL_EXIT_ERROR;
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [test]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [test]\n", argv[0]);
+         printf("   test = convert a fixed schema 0 setup image and check it\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_lock
+* Returned Value   :  int32_t error code
+* Comments  :  Prints mutexCore wait and hold times for each place it is
+*              locked from, and the task it last had to wait for.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_lock(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   CORE_LOCK_STATS *  stats;
+   uint32_t           limit, count;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("\nPriority inheritance %s, hold limit %u us\n",
+            CoreLockInheritOk ? "on" : "OFF", CoreLockHoldLimitUs);
+         printf("\nSite            Count  Waits  Busy  Wait avg/max us  Hold avg/max us  Over  Waited for\n");
+         for (k=0;k<MAX_CORE_SITE;k++) {
+            stats = &CoreLockStats[k];
+            count = stats->count ? stats->count : 1;
+            printf("%-14s  %5u  %5u  %4u  %7u/%-7u  %7u/%-7u  %4u", CoreLockSiteName[k],
+               stats->count, stats->contended, stats->busy,
+               core_lock_cycles_to_us(stats->wait_cycles / count), core_lock_cycles_to_us(stats->wait_max),
+               core_lock_cycles_to_us(stats->hold_cycles / count), core_lock_cycles_to_us(stats->hold_max),
+               stats->overruns);
+            if (stats->contended) {
+               printf("  %s (%s)", task_monitor_task_name(stats->last_contender),
+                  CoreLockSiteName[stats->contender_site]);
+            }
+            printf("\n");
+         }
+         k = core_lock_overrun_site();
+         if (k < MAX_CORE_SITE) {
+            printf("Held now from %s, over the limit\n", CoreLockSiteName[k]);
+         }
+
+         printf("\nLive status (no lock): %u writes, max %u us; %u reads, max %u us, %u retries\n",
+            LiveStatusStats.writes, core_lock_cycles_to_us(LiveStatusStats.write_max),
+            LiveStatusStats.reads, core_lock_cycles_to_us(LiveStatusStats.read_max),
+            LiveStatusStats.retries);
+         count = SensorSyncStats.cycles ? SensorSyncStats.cycles : 1;
+         printf("Sensor sync: %u cycles, %u published, %u status bytes/cycle, %u setup bytes\n",
+            SensorSyncStats.cycles, SensorSyncStats.published,
+            SensorSyncStats.status_bytes / count, SensorSyncStats.setup_bytes);
+      } else if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+         core_lock_clear();
+      } else if ((argc == 3) && (strcmp(argv[1], "limit") == 0) &&
+                 (sscanf(argv[2],"%u",&limit) == 1) && (limit > 0)) {
+         CoreLockHoldLimitUs = limit;
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [clear|limit <usec>]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [clear|limit <usec>]\n", argv[0]);
+         printf("   clear  = reset the statistics\n");
+         printf("   limit  = longest hold not counted as an overrun\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_notify
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the version of each database group and, for each
+*              subscriber, how often it was woken and how many changes
+*              were coalesced or held back by its rate limit. Also the
+*              size of the core database and of each task's view.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_notify(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   DB_SUBSCRIBER *    sub;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("\nDatabase: coreDB %u bytes, config version %u\n",
+            sizeof(coreDB), coreDB.config_version);
+         printf("Views:    sensorDB %u, enetDB %u bytes (each was %u)\n",
+            sizeof(sensorDB), sizeof(enetDB), sizeof(DATABASE));
+
+         printf("\nGroup           Version\n");
+         for (k=0;k<MAX_DB_GROUP;k++) {
+            printf("%-14s  %7u\n", DbGroupName[k], DbVersion[k]);
+         }
+
+         printf("\nSubscriber  Groups  Interval ms  Wakeups  Coalesced  Limited  Pending\n");
+         for (sub=DbSubscribers;sub!=NULL;sub=sub->next) {
+            printf("%-10s  0x%04x  %11u  %7u  %9u  %7u  0x%04x\n", sub->name,
+               sub->groups, sub->min_interval_ms, sub->notifications,
+               sub->coalesced, sub->limited, sub->pending);
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s\n", argv[0]);
+      } else  {
+         printf("Usage: %s\n", argv[0]);
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_validate
+* Returned Value   :  int32_t error code
+* Comments  :  Validates the setup of every sensor and output in coreDB
+*              in one pass, and prints the errors found and the time
+*              taken. A count repeats it to time it; the text of the
+*              errors is only made once.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_validate(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   VALID_RESULT       result, one;
+   char               msg[160], *text, *end;
+   uint32_t           count = 1, pass, start, cycles, text_cycles;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if ((argc > 2) || ((argc == 2) && ((sscanf(argv[1],"%u",&count) != 1) || (count == 0)))) {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      } else {
+         start = TMON_CYCLE_COUNT();
+
+         for (pass=0;pass<count;pass++) {
+            valid_result_init(&result, TRUE);
+            check_setup(&coreDB, &result);
+         }
+
+         cycles = TMON_CYCLE_COUNT() - start;
+
+         // The text of each error, as the web server would show it
+         text_cycles = 0;
+         for (k=0;k<result.count;k++) {
+            one.count     = 1;
+            one.dropped   = 0;
+            one.show_item = TRUE;
+            one.error[0]  = result.error[k];
+
+            start = TMON_CYCLE_COUNT();
+            render_valid_errors(&one, msg, sizeof(msg));
+            text_cycles += TMON_CYCLE_COUNT() - start;
+
+            // Without the HTML bullet and line break
+            text = strstr(msg, "  ") + 2;
+            end  = strstr(text, "<br/>");
+            if (end != NULL) *end = 0;
+            printf("%2u  %s\n", one.error[0].code, text);
+         }
+         if (result.dropped) {
+            printf("%u more errors not kept\n", result.dropped);
+         }
+
+         printf("\n%u passes of %u sensors and %u outputs, %u errors, %u us, %u us per pass\n",
+            count, SENSOR_ID_THREE - SENSOR_ID_ONE + 1, MAX_OUTPUTS, result.count + result.dropped,
+            core_lock_cycles_to_us(cycles), core_lock_cycles_to_us(cycles / count));
+         printf("Text of the errors %u us, result %u bytes\n",
+            core_lock_cycles_to_us(text_cycles), sizeof(VALID_RESULT));
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [<count>]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [<count>]\n", argv[0]);
+         printf("   <count> = times to repeat, to time it\n");
+      }
+   }
+   return return_code;
+} 
+
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_journal
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the event journal, from a sequence number or a
+*              time on, and the next sequence number to page on from.
+*              The same records are available from the journal_data CGI.
+*
+*END*---------------------------------------------------------------------*/
+
+#define  JOURNAL_PAGE   16
+
+int32_t  Shell_journal(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   JOURNAL_RECORD     recs[JOURNAL_PAGE];
+   char               line[80];
+   uint32_t           seq, value, count = 10;
+   int                num, k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if ((argc == 4) && ((sscanf(argv[3],"%u",&count) != 1) || (count == 0))) {
+         print_usage = TRUE;
+      } else if (argc == 1) {
+         seq = journal_last_seq();
+         seq = (seq > count) ? seq - count + 1 : 1;
+      } else if (((argc == 3) || (argc == 4)) && (sscanf(argv[2],"%u",&value) == 1) &&
+                 (strcmp(argv[1], "from") == 0)) {
+         seq = value;
+      } else if (((argc == 3) || (argc == 4)) && (sscanf(argv[2],"%u",&value) == 1) &&
+                 (strcmp(argv[1], "since") == 0)) {
+         seq = journal_seq_at_time(value);
+      } else {
+         print_usage = TRUE;
+      }
+
+      if (print_usage) {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+      } else {
+         printf("\n     Seq      Time  Type            Id   Arg\n");
+
+         while (count) {
+            num = journal_read(seq, recs, (count < JOURNAL_PAGE) ? count : JOURNAL_PAGE);
+            if (num == 0) break;
+
+            for (k=0;k<num;k++) {
+               journal_format(&recs[k], line, sizeof(line));
+               printf("%s\n", line);
+            }
+            seq    = recs[num-1].seq + 1;
+            count -= num;
+         }
+
+         printf("\nRecords %u to %u, next %u\n", journal_first_seq(), journal_last_seq(), seq);
+         printf("%u recorded, %u in flash, %u lost, %u erases, %u flash errors\n",
+            JournalStats.records, JournalStats.flashed, JournalStats.lost,
+            JournalStats.erases, JournalStats.flash_errors);
+         printf("%u queries, longest %u us\n", JournalStats.queries,
+            core_lock_cycles_to_us(JournalStats.query_max));
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [from <seq>|since <sec> [<count>]]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [from <seq>|since <sec> [<count>]]\n", argv[0]);
+         printf("   from  = records from this sequence number on\n");
+         printf("   since = records from this operating time on, seconds\n");
+         printf("   count = records to print, default 10 (the newest\n");
+         printf("           10 without \"from\" or \"since\")\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_control
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the state of each relay output as the relay engine
+*              sees it, with the time left on its delay and minimum
+*              On\Off timers, then the output and integral of each
+*              analog output, the cost of each engine, the frames sent
+*              to the expansion modules, and the time from the end of a
+*              sample cycle to the outputs.
+*
+*END*---------------------------------------------------------------------*/
+
+#if OUTPUT_BUS_TEST
+#define  CONTROL_BUSFAIL_USAGE   "busfail <pct>|"
+#else
+#define  CONTROL_BUSFAIL_USAGE   ""
+#endif
+
+int32_t  Shell_control(int32_t argc, char *argv[] )
+{
+   static const char * mode_name[] = { "none", "direct", "reverse", "binary" };
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   RELAY_ENTRY *      e;
+   ANALOG_ENTRY *     a;
+   CONTROL_LATENCY *  lat;
+   uint32_t           count;
+   uint32_t           now;
+   int32_t            delay_left, min_left;
+   int                k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         now = SecCounter;
+         printf("\nOut  Mode     Sensor  Cut-on  Cut-off  State      Delay s  Min s\n");
+         for (k=0;k<MAX_OUTPUTS;k++) {
+            e = &RelayEngine.relay[k];
+            if (e->mode == RELAY_MODE_NONE) continue;
+
+            delay_left = (int32_t)(e->delay_deadline - now);
+            min_left   = (int32_t)(e->min_deadline - now);
+            if ((e->state != RELAY_ON_DELAY) && (e->state != RELAY_OFF_DELAY)) delay_left = 0;
+            printf("%3d  %-7s  %6u  %6d  %7d  %-9s  %7d  %5d\n", k+1,
+               mode_name[e->mode], e->sensor_id, e->cut_on, e->cut_off,
+               RelayStateName[e->state], (delay_left > 0) ? delay_left : 0,
+               (min_left > 0) ? min_left : 0);
+         }
+         printf("\n%u passes, longest %u us, %u switches, %u fail mode demands\n",
+            RelayEngine.passes, core_lock_cycles_to_us(RelayEngine.pass_max),
+            RelayEngine.switches, RelayEngine.fail_demands);
+         printf("Setup version %u, table rebuilt %u times, %u bytes\n",
+            RelayEngine.config_version, RelayEngine.setups, sizeof(RelayEngine.relay));
+         printf("Starts %u, at most %u every %u s; most in one pass %u\n",
+            RelayEngine.starts, RelayEngine.max_starts, RelayEngine.stagger,
+            RelayEngine.peak_starts);
+         printf("%u starts waited, %u s in all, longest %u s; waiting now:",
+            RelayEngine.deferred, RelayEngine.deferral_total, RelayEngine.deferral_max);
+         for (k=0;k<RelayEngine.queued;k++) {
+            printf(" %u", RelayEngine.queue[k]+1);
+         }
+         printf("\n");
+
+         printf("\nOut  Sensor      SP      EP  Output %%  I %%band  Update s\n");
+         for (k=0;k<MAX_OUTPUTS;k++) {
+            a = &AnalogEngine.analog[k];
+            if (!(a->flags & ANALOG_ACTIVE)) continue;
+
+            min_left = (int32_t)(a->update_deadline - now);
+            printf("%3d  %6u  %6d  %6d  %8u  %7d  %8d\n", k+1, a->sensor_id, a->sp, a->ep,
+               (a->written * 100 + ANALOG_MAX_COUNTS/2) / ANALOG_MAX_COUNTS,
+               a->i_q24 / (ANALOG_Q24_ONE / 100), (min_left > 0) ? min_left : 0);
+         }
+         printf("\n%u updates, %u writes, %u held by the output band, longest %u us\n",
+            AnalogEngine.updates, AnalogEngine.writes, AnalogEngine.suppressed,
+            core_lock_cycles_to_us(AnalogEngine.pass_max));
+         printf("%u integrations held at a limit, %u bumpless transfers\n",
+            AnalogEngine.windup_holds, AnalogEngine.aligns);
+
+         count = OutputCommit.passes ? OutputCommit.passes : 1;
+         printf("\nModule frames %u, %u bytes, %u.%02u frames a pass; one per change: %u, %u bytes\n",
+            OutputCommit.frames, OutputCommit.bytes, OutputCommit.frames / count,
+            (OutputCommit.frames * 100 / count) % 100, OutputCommit.single_msgs,
+            OutputCommit.single_bytes);
+         printf("Unchanged %u, failed %u, waiting to retry %u, links failed %u, longest %u us\n",
+            OutputCommit.skipped, OutputCommit.failures, OutputCommit.deferred,
+            OutputCommit.link_failures, core_lock_cycles_to_us(OutputCommit.pass_max));
+
+         lat = &ControlLatency;
+         count = lat->passes ? lat->passes : 1;
+         printf("\nTrigger %s, sample cycle to outputs: %u passes, avg %u us, max %u us\n",
+            ControlTriggerName[ControlTrigger], lat->passes, lat->total_us / count, lat->max_us);
+         printf("Over %u us: %u, timeouts %u, stale %u\n", ControlLatencyLimitUs,
+            lat->misses, lat->timeouts, lat->stale);
+         printf("<1 ms %u, <10 ms %u, <100 ms %u, <1 s %u, more %u\n", lat->bucket[0],
+            lat->bucket[1], lat->bucket[2], lat->bucket[3], lat->bucket[4]);
+      } else if ((argc == 3) && (strcmp(argv[1], "trigger") == 0) &&
+                 ((strcmp(argv[2], "sensor") == 0) || (strcmp(argv[2], "phase") == 0))) {
+         ControlTrigger = (strcmp(argv[2], "sensor") == 0) ? CONTROL_TRIGGER_SENSOR : CONTROL_TRIGGER_PHASE;
+         control_latency_clear();
+      } else if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+         control_latency_clear();
+      } else if ((argc == 3) && (strcmp(argv[1], "limit") == 0) &&
+                 (sscanf(argv[2],"%u",&count) == 1) && (count > 0)) {
+         ControlLatencyLimitUs = count;
+#if OUTPUT_BUS_TEST
+      } else if ((argc == 3) && (strcmp(argv[1], "busfail") == 0) &&
+                 (sscanf(argv[2],"%u",&count) == 1) && (count <= 100)) {
+         OutputBusFailPct = count;
+#endif
+      } else if ((argc == 4) && (strcmp(argv[1], "starts") == 0) &&
+                 (sscanf(argv[2],"%u",&count) == 1) && (count <= MAX_OUTPUTS) &&
+                 (sscanf(argv[3],"%u",&now) == 1) && (now <= 255)) {
+         relay_control_starts(&RelayEngine, count, now);
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [trigger sensor|phase|clear|limit <usec>|" CONTROL_BUSFAIL_USAGE "\n"
+                "        starts <max> <stagger>]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [trigger sensor|phase|clear|limit <usec>|" CONTROL_BUSFAIL_USAGE "\n"
+                "          starts <max> <stagger>]\n", argv[0]);
+         printf("   trigger = run a pass when a sample cycle is published,\n");
+         printf("             or in the control slot of the 1 second timer\n");
+         printf("   clear   = reset the latency statistics\n");
+         printf("   limit   = latency counted as a missed deadline\n");
+#if OUTPUT_BUS_TEST
+         printf("   busfail = percent of module frames failed, to try the retries\n");
+#endif
+         printf("   starts  = start at most <max> relays every <stagger>\n");
+         printf("             seconds, <max> 0 = no limit\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_plant
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the zone model behind the ambient temperature, or
+*              runs the HVAC logic against a new model, faster than real
+*              time, and prints how well it held the desired temperature.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_plant(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   HVAC_PLANT_RESULT  result;
+   uint32_t           hours, tolerance = HVAC_TEMP_TOLERANCE, us, seconds;
+   int32_t            zone;
+   int                profile = -1, k;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if ((argc >= 3) && (argc <= 5)) {
+         for (k=0;k<HVAC_MAX_PROFILE;k++) {
+            if (strcmp(argv[argc == 3 ? 2 : 3], HVAC_ProfileName[k]) == 0) profile = k;
+         }
+      }
+
+      if (argc == 1) {
+         zone = HVAC_PlantTemperature(&HVAC_LivePlant);
+         printf("Zone %s%d.%1d C, outdoor %d C (%s), heat %u%%, cool %u%%, model time %u s\n",
+            (zone < 0) ? "-" : "", (zone < 0 ? -zone : zone)/10, (zone < 0 ? -zone : zone)%10,
+            (int)HVAC_PlantOutdoor(&HVAC_LivePlant), HVAC_ProfileName[HVAC_LivePlant.profile],
+            (uint32_t)(HVAC_LivePlant.heat_output*100), (uint32_t)(HVAC_LivePlant.cool_output*100),
+            HVAC_LivePlant.time);
+      } else if ((argc == 3) && (strcmp(argv[1], "profile") == 0) && (profile >= 0)) {
+         HVAC_LivePlant.profile = profile;
+      } else if ((argc >= 4) && (strcmp(argv[1], "run") == 0) && (profile >= 0) &&
+                 (sscanf(argv[2],"%u",&hours) == 1) && (hours > 0) && (hours <= HVAC_PLANT_MAX_HOURS) &&
+                 ((argc == 4) || (sscanf(argv[4],"%u",&tolerance) == 1))) {
+         HVAC_PlantRun(profile, hours, tolerance, &result);
+
+         seconds = result.seconds ? result.seconds : 1;
+         us = core_lock_cycles_to_us(result.cycles);
+         printf("%u hours %s, mode %s, desired %u.%1u C, tolerance %u.%1u\n", hours,
+            HVAC_ProfileName[profile], HVAC_HVACModeName(HVAC_GetHVACMode()),
+            HVAC_GetDesiredTemperature()/10, HVAC_GetDesiredTemperature()%10,
+            tolerance/10, tolerance%10);
+         printf("Error avg %u.%02u C, max %u.%1u C\n", result.error_sum / seconds / 10,
+            (result.error_sum * 10 / seconds) % 100, result.error_max/10, result.error_max%10);
+         printf("Runtime heat %u s, cool %u s, fan %u s\n", result.heat_seconds,
+            result.cool_seconds, result.fan_seconds);
+         printf("Starts heat %u, cool %u, short cycles (< %u s) %u\n", result.heat_starts,
+            result.cool_starts, HVAC_PLANT_SHORT_CYCLE, result.short_cycles);
+         printf("Took %u ms, %u x real time\n", us / 1000, us ? (uint32_t)((uint64_t)seconds * 1000000 / us) : 0);
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [profile <name>|run <hours> <profile> [<tolerance>]]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [profile <name>|run <hours> <profile> [<tolerance>]]\n", argv[0]);
+         printf("   profile   = outdoor profile of the live model; winter, swing\n");
+         printf("               or summer\n");
+         printf("   run       = run the HVAC logic against a new model, up to\n");
+         printf("               %u hours, with the current mode and set point\n", HVAC_PLANT_MAX_HOURS);
+         printf("   tolerance = in 1/10 degree, default HVAC_TEMP_TOLERANCE\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_zones
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the set point, temperature and outputs of each zone
+*              and the cost of the zone engine, sets the number of zones
+*              and the sensor of each, or measures a pass over 1 to
+*              HVAC_MAX_ZONES zones. The outputs of zone 1 and up are
+*              decisions only; they are not driven.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_zones(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   uint32_t           zone, id, count, passes = 100, cycles;
+   int32_t            actual;
+   char               value[8];
+   char *             sign;
+   uint8_t            out;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("%u zones, tolerance %u.%1u, stage 2 at %u.%1u, min On %u s, min Off %u s\n",
+            HVAC_Zones.count, HVAC_Zones.tolerance/10, HVAC_Zones.tolerance%10,
+            HVAC_Zones.stage_delta/10, HVAC_Zones.stage_delta%10,
+            HVAC_Zones.min_on, HVAC_Zones.min_off);
+         printf("\nZone  Sensor  Mode  Fan   Desired  Actual  Outputs (zone 1 and up not driven)\n");
+         for (zone=0;zone<HVAC_Zones.count;zone++) {
+            out = HVAC_Zones.outputs[zone];
+            printf("%4u  %6u  %-4s  %-4s  %4u.%1u  ", zone, HVAC_Zones.sensor[zone],
+               HVAC_HVACModeName((HVAC_Mode_t)HVAC_Zones.mode[zone]),
+               HVAC_Zones.fan[zone] == Fan_On ? "on" : "auto",
+               HVAC_Zones.desired[zone]/10, HVAC_Zones.desired[zone]%10);
+            actual = HVAC_Zones.actual[zone];
+            if (actual == HVAC_ZONE_NO_TEMP) {
+               printf("   --.-  ");
+            } else {
+               sign = "";
+               if (actual < 0) {
+                  sign   = "-";
+                  actual = -actual;
+               }
+               snprintf(value, sizeof(value), "%s%d.%1d", sign, actual/10, actual%10);
+               printf("%6s  ", value);
+            }
+            printf("%s%s%s%s%s\n", (out & HVAC_ZONE_FAN) ? "fan " : "",
+               (out & HVAC_ZONE_HEAT1) ? "heat1 " : "", (out & HVAC_ZONE_HEAT2) ? "heat2 " : "",
+               (out & HVAC_ZONE_COOL1) ? "cool1 " : "", (out & HVAC_ZONE_COOL2) ? "cool2 " : "");
+         }
+         printf("\nPasses %u, starts %u, stage ups %u, held %u, no temperature %u\n",
+            HVAC_Zones.passes, HVAC_Zones.starts, HVAC_Zones.stage_ups,
+            HVAC_Zones.held, HVAC_Zones.no_temp);
+         printf("Pass %u us, max %u us\n", core_lock_cycles_to_us(HVAC_Zones.pass_last),
+            core_lock_cycles_to_us(HVAC_Zones.pass_max));
+      } else if ((argc == 3) && (strcmp(argv[1], "count") == 0) &&
+                 (sscanf(argv[2],"%u",&count) == 1) && (count > 0) && (count <= HVAC_MAX_ZONES)) {
+         HVAC_SetZoneCount(count);
+      } else if ((argc == 4) && (strcmp(argv[1], "sensor") == 0) &&
+                 (sscanf(argv[2],"%u",&zone) == 1) && (zone > 0) && (zone < HVAC_GetZoneCount()) &&
+                 (sscanf(argv[3],"%u",&id) == 1) && (id <= MAX_SENSOR_ID)) {
+         HVAC_Zones.sensor[zone] = id;
+      } else if ((argc <= 3) && (strcmp(argv[1], "bench") == 0) &&
+                 ((argc == 2) || ((sscanf(argv[2],"%u",&passes) == 1) && (passes > 0)))) {
+         printf("Zones  us/pass  ns/zone\n");
+         for (count=1;count<=HVAC_MAX_ZONES;count*=2) {
+            cycles = HVAC_ZoneBench(count, passes);
+            // Cycles * 1000 converted to us gives ns
+            printf("%5u  %7u  %7u\n", count, core_lock_cycles_to_us(cycles),
+               core_lock_cycles_to_us(cycles * 1000) / count);
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [count <n>|sensor <zone> <id>|bench [<passes>]]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [count <n>|sensor <zone> <id>|bench [<passes>]]\n", argv[0]);
+         printf("   count  = zones in use, 1 to %u; zone 0 is the thermostat\n", HVAC_MAX_ZONES);
+         printf("            and the only zone whose outputs are driven, the\n");
+         printf("            outputs of the others are decisions only\n");
+         printf("   sensor = temperature sensor of zone 1 and up, 0 = none\n");
+         printf("   bench  = time a pass over 1 to %u zones, 100 passes each\n", HVAC_MAX_ZONES);
+         printf("            by default\n");
+         printf("Set points and modes are set with temp, hvac and fan z<zone>\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_schedule
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the weekly schedule, its clock and learned rates, or
+*              turns it on or off, sets its clock, edits its entries and
+*              holidays, or checks the compiled lookup against a search of
+*              the entries.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_schedule(int32_t argc, char *argv[] )
+{
+   static const char  *day_name[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   HVAC_SCHEDULE      *s = &HVAC_Schedule;
+   SCHEDULE_ENTRY     entry;
+   SCHEDULE_HOLIDAY   *h;
+   uint32_t           t, k, d, day, hh, mm, temp, temp_fract = 0, start, days, fast, slow, errors;
+   uint32_t           next_in;
+   uint16_t           next;
+   char               *p;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         t = HVAC_ScheduleClock(s, SecCounter);
+         printf("Schedule %s, day %u %s %02u:%02u, set point ", s->enabled ? "on" : "off",
+            t / SCHEDULE_DAY, day_name[(t / SCHEDULE_DAY) % 7], (t % SCHEDULE_DAY) / 3600,
+            (t % 3600) / 60);
+         temp = HVAC_ScheduleLookup(s, SecCounter, &next_in, &next);
+         if (temp) {
+            printf("%u.%1u C, %u.%1u C in %u min\n", temp/10, temp%10, next/10, next%10, next_in/60);
+         } else {
+            printf("none\n");
+         }
+         printf("\n  #  Days     Time   Set point\n");
+         for (k=0;k<s->entries;k++) {
+            printf("%3u  ", k);
+            for (d=0;d<7;d++) {
+               printf("%c", (s->entry[k].days & (1 << d)) ? '0' + d : '-');
+            }
+            printf("  %02u:%02u  %4u.%1u\n", s->entry[k].slot / 4, (s->entry[k].slot % 4) * 15,
+               s->entry[k].setpoint/10, s->entry[k].setpoint%10);
+         }
+         for (k=0;k<SCHEDULE_MAX_HOLIDAYS;k++) {
+            h = &s->holiday[k];
+            if (h->days) {
+               printf("Holiday day %u to %u, %u.%1u C\n", h->first_day, h->first_day + h->days - 1,
+                  h->setpoint/10, h->setpoint%10);
+            }
+         }
+         printf("\n%u transitions, heat rate %u.%1u C/h, cool rate %u.%1u C/h\n", s->transitions,
+            s->heat_rate/10, s->heat_rate%10, s->cool_rate/10, s->cool_rate%10);
+         printf("Set points applied %u, early %u, recoveries learned %u\n",
+            s->changes, s->prestarts, s->learned);
+         printf("Lookups %u, max %u us\n", s->lookups, core_lock_cycles_to_us(s->lookup_max));
+      } else if ((argc == 2) && (strcmp(argv[1], "on") == 0)) {
+         s->enabled = TRUE;
+         s->applied = 0;
+      } else if ((argc == 2) && (strcmp(argv[1], "off") == 0)) {
+         s->enabled = FALSE;
+      } else if ((argc == 4) && (strcmp(argv[1], "clock") == 0) &&
+                 (sscanf(argv[2],"%u",&day) == 1) && (day < 7) &&
+                 (sscanf(argv[3],"%u:%u",&hh,&mm) == 2) && (hh < 24) && (mm < 60)) {
+         HVAC_ScheduleSetClock(s, SecCounter, day * SCHEDULE_DAY + hh * 3600 + mm * 60);
+      } else if ((argc == 5) && (strcmp(argv[1], "add") == 0) &&
+                 (sscanf(argv[3],"%u:%u",&hh,&mm) == 2) && (hh < 24) && (mm < 60) &&
+                 (sscanf(argv[4],"%u.%u",&temp,&temp_fract) >= 1) && (temp_fract < 10) &&
+                 (temp > 0) && (temp < 100)) {
+         entry.days = 0;
+         for (p=argv[2];(*p >= '0') && (*p <= '6');p++) {
+            entry.days |= 1 << (*p - '0');
+         }
+         entry.slot     = hh * 4 + mm / 15;
+         entry.setpoint = temp * 10 + temp_fract;
+         if (*p || (entry.days == 0)) {
+            printf("Invalid days, use the digits 0 (Sunday) to 6 (Saturday)\n");
+            return_code = SHELL_EXIT_ERROR;
+         } else if (s->entries >= SCHEDULE_MAX_ENTRIES) {
+            printf("Schedule full, %u entries\n", SCHEDULE_MAX_ENTRIES);
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            s->entry[s->entries++] = entry;
+            HVAC_ScheduleCompile(s);
+         }
+      } else if ((argc == 3) && (strcmp(argv[1], "del") == 0) &&
+                 (sscanf(argv[2],"%u",&k) == 1) && (k < s->entries)) {
+         memmove(&s->entry[k], &s->entry[k+1], (s->entries - k - 1) * sizeof(SCHEDULE_ENTRY));
+         s->entries--;
+         HVAC_ScheduleCompile(s);
+      } else if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+         s->entries = 0;
+         HVAC_ScheduleCompile(s);
+      } else if ((argc == 3) && (strcmp(argv[1], "holiday") == 0) && (strcmp(argv[2], "clear") == 0)) {
+         memset(s->holiday, 0, sizeof(s->holiday));
+         s->applied = 0;
+      } else if ((argc == 5) && (strcmp(argv[1], "holiday") == 0) &&
+                 (sscanf(argv[2],"%u",&start) == 1) && (start < 1000) &&
+                 (sscanf(argv[3],"%u",&days) == 1) && (days > 0) && (days < 256) &&
+                 (sscanf(argv[4],"%u.%u",&temp,&temp_fract) >= 1) && (temp_fract < 10) &&
+                 (temp > 0) && (temp < 100)) {
+         for (k=0;(k < SCHEDULE_MAX_HOLIDAYS) && s->holiday[k].days;k++) {
+         }
+         if (k == SCHEDULE_MAX_HOLIDAYS) {
+            printf("No free holiday, %u in use\n", SCHEDULE_MAX_HOLIDAYS);
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            s->holiday[k].first_day = HVAC_ScheduleClock(s, SecCounter) / SCHEDULE_DAY + start;
+            s->holiday[k].days      = days;
+            s->holiday[k].setpoint  = temp * 10 + temp_fract;
+            s->applied = 0;
+         }
+      } else if ((argc == 2) && (strcmp(argv[1], "check") == 0)) {
+         errors = HVAC_ScheduleCheck(s, &fast, &slow);
+         printf("%u minutes of the week checked, %u wrong\n", SCHEDULE_WEEK / 60, errors);
+         // Cycles * 1000 converted to us gives ns
+         printf("Lookup %u ns, search of %u entries %u ns\n", core_lock_cycles_to_us(fast * 1000),
+            s->entries, core_lock_cycles_to_us(slow * 1000));
+         if (errors) {
+            return_code = SHELL_EXIT_ERROR;
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [on|off|clock <day> <hh:mm>|add <days> <hh:mm> <temp>|del <n>|clear|\n", argv[0]);
+         printf("   holiday <in days> <days> <temp>|holiday clear|check]\n");
+      } else  {
+         printf("Usage: %s [on|off|clock <day> <hh:mm>|add <days> <hh:mm> <temp>|del <n>|clear|\n", argv[0]);
+         printf("   holiday <in days> <days> <temp>|holiday clear|check]\n");
+         printf("   on, off = follow the schedule, or leave the set point alone\n");
+         printf("   clock   = day of the week, 0 = Sunday, and time; there is no\n");
+         printf("             real time clock, set it after each reset\n");
+         printf("   add     = set point dd.d C from hh:mm, rounded down to 15 min, on\n");
+         printf("             each day given as a digit, e.g. 12345 for Mon to Fri\n");
+         printf("   del     = remove entry n, clear = remove all entries\n");
+         printf("   holiday = hold temp for days days, from in days days from today\n");
+         printf("   check   = compare the lookup with a search of the entries at\n");
+         printf("             every minute of the week\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_failover
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the health of each sensor and the source each
+*              output is run from, sets the backups of an output or the
+*              noise limit, or injects a fault into a sensor to measure
+*              how fast the outputs move off it.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_failover(int32_t argc, char *argv[] )
+{
+   static const char  *inject_name[] = { "", "fail", "noise" };
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   SENSOR_FAILOVER    *fo = &SensorFailover;
+   FAILOVER_ENTRY     *f;
+   uint32_t           k, i, id, out, limit;
+   uint8_t            backup[FAILOVER_SOURCES-1];
+   uint8_t            fault;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("Sensor  Health  Noise  Fault\n");
+         for (id=SENSOR_ID_ONE;id<=MAX_SENSOR_ID;id++) {
+            if (fo->sensor_type[id] == SENSOR_TYPE_NONE) continue;
+            printf("%6u  %6u  %2u.%02u  %s\n", id, fo->health[id], fo->noise[id] / 16,
+               (fo->noise[id] % 16) * 100 / 16, inject_name[fo->inject[id]]);
+         }
+         printf("\nOut  Sources     In use  Switches\n");
+         for (k=0;k<MAX_OUTPUTS;k++) {
+            f = &fo->entry[k];
+            if (f->sources == 0) continue;
+            printf("%3u  ", k+1);
+            for (i=0;i<FAILOVER_SOURCES;i++) {
+               if (i >= f->sources) {
+                  printf("    ");
+               } else if (f->source[i] == FAILOVER_AVERAGE) {
+                  printf("avg ");
+               } else {
+                  printf("%-3u ", f->source[i]);
+               }
+            }
+            if (f->active >= f->sources) {
+               printf("none    ");
+            } else if (f->source[f->active] == FAILOVER_AVERAGE) {
+               printf("avg     ");
+            } else {
+               printf("%-6u  ", f->source[f->active]);
+            }
+            printf("%8u\n", f->switches);
+         }
+         printf("\nNoise limit %u, %u passes, longest %u us\n", fo->noise_limit, fo->passes,
+            core_lock_cycles_to_us(fo->pass_max));
+         printf("Failovers %u, returns %u, flaps %u, with no fault %u, passes with no source %u\n",
+            fo->failovers, fo->returns, fo->flaps, fo->false_switches, fo->no_source);
+         printf("Sample cycles from an injected fault to the switch: last %u, max %u\n",
+            fo->latency_last, fo->latency_max);
+      } else if ((argc == 2) && (strcmp(argv[1], "clear") == 0)) {
+         sensor_failover_clear(fo);
+      } else if ((argc == 3) && (strcmp(argv[1], "noise") == 0) &&
+                 (sscanf(argv[2],"%u",&limit) == 1) && (limit > 0) && (limit < 256)) {
+         fo->noise_limit = limit;
+      } else if ((argc == 4) && (strcmp(argv[1], "inject") == 0) &&
+                 (sscanf(argv[2],"%u",&id) == 1) && (id > SENSOR_ID_NONE) && (id <= MAX_SENSOR_ID)) {
+         for (fault=0;fault<NUM_FAILOVER_INJECTS;fault++) {
+            if (strcmp(argv[3], (fault == FAILOVER_INJECT_NONE) ? "off" : inject_name[fault]) == 0) break;
+         }
+         if (fault == NUM_FAILOVER_INJECTS) {
+            printf("Invalid fault, use fail, noise or off\n");
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            sensor_failover_inject(fo, id, fault);
+         }
+      } else if ((argc >= 3) && (argc <= 2 + FAILOVER_SOURCES - 1) &&
+                 (sscanf(argv[1],"%u",&out) == 1) && (out > 0) && (out <= MAX_OUTPUTS)) {
+         memset(backup, SENSOR_ID_NONE, sizeof(backup));
+         for (i=2;i<argc;i++) {
+            if (strcmp(argv[i], "avg") == 0) {
+               backup[i-2] = FAILOVER_AVERAGE;
+            } else if (strcmp(argv[i], "none") == 0) {
+               backup[i-2] = SENSOR_ID_NONE;
+            } else if ((sscanf(argv[i],"%u",&id) == 1) && (id > SENSOR_ID_NONE) && (id <= MAX_SENSOR_ID)) {
+               backup[i-2] = id;
+            } else {
+               break;
+            }
+         }
+         if (i < argc) {
+            printf("Invalid backup, use a sensor 1 to %u, avg or none\n", MAX_SENSOR_ID);
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            // Picked up by the Control_Task with the next pass
+            memcpy(fo->entry[out-1].backup, backup, sizeof(backup));
+            fo->rebuild = TRUE;
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [<output> <backup> [<backup>]|noise <limit>|inject <sensor> fail|noise|off|\n", argv[0]);
+         printf("        clear]\n");
+      } else  {
+         printf("Usage: %s [<output> <backup> [<backup>]|noise <limit>|inject <sensor> fail|noise|off|\n", argv[0]);
+         printf("          clear]\n");
+         printf("   output = 1 to %u, run from backup when its sensor fails; a\n", MAX_OUTPUTS);
+         printf("            sensor of the same type, avg for the average of the\n");
+         printf("            healthy sensors 1 to 3 of that type, or none\n");
+         printf("   noise  = mean change per sample cycle over which a sensor\n");
+         printf("            is taken as noisy, default %u\n", FAILOVER_NOISE_LIMIT);
+         printf("   inject = fail a sensor, or make it noisy, until off\n");
+         printf("   clear  = reset the counts\n");
+      }
+   }
+   return return_code;
+} 
+
+
+/*FUNCTION*-------------------------------------------------------------
+*
+* Function Name    :   Shell_tune
+* Returned Value   :  int32_t error code
+* Comments  :  Prints the state and result of the analog output auto-tuner,
+*              starts a relay feedback test on an analog output, stops it,
+*              or writes its result into the setup of the output.
+*
+*END*---------------------------------------------------------------------*/
+
+int32_t  Shell_tune(int32_t argc, char *argv[] )
+{
+   bool               print_usage, shorthelp = FALSE;
+   int32_t            return_code = SHELL_EXIT_SUCCESS;
+   ANALOG_TUNE        *tune = &AnalogTune;
+   const ANALOG_SETUP *setup;
+   uint32_t           out, step = TUNE_DEFAULT_STEP;
+   int32_t            hysteresis = 0;
+
+   print_usage = Shell_check_help_request(argc, argv, &shorthelp );
+
+   if (!print_usage)  {
+      if (argc == 1) {
+         printf("Output %u, %s %s\n", tune->output+1, TuneStateName[tune->state],
+            (tune->state == TUNE_FAILED) ? TuneErrorName[tune->error] : "");
+         if (tune->state != TUNE_IDLE) {
+            printf("SP %d, hysteresis %d, output %u +- %u counts, %u cycles measured, %u s\n",
+               tune->sp, tune->hysteresis, tune->bias, tune->step, tune->cycles,
+               SecCounter - tune->started);
+         }
+         if ((tune->state == TUNE_SETTLE) || (tune->state == TUNE_DONE)) {
+            setup = &coreDB.output[tune->output].setup.output.analog;
+            printf("Ku %u.%02u counts per unit, Tu %u s\n", tune->ku_q8 >> 8,
+               ((tune->ku_q8 & 0xFF) * 100) >> 8, tune->tu);
+            printf("EP %d -> %d, Integration Constant %u -> %u, Update Rate %u -> %u s\n",
+               setup->ep, tune->new_ep, setup->int_constant, tune->new_int_constant,
+               setup->update_rate, tune->new_update_rate);
+         }
+         printf("Settled after the test in ");
+         if (tune->settle_time >= TUNE_MAX_SETTLE) {
+            printf("more than %u s", TUNE_MAX_SETTLE);
+         } else {
+            printf("%u s", tune->settle_time);
+         }
+         printf(", the test before %u s\n", tune->settle_last);
+         printf("%u tests, %u applied\n", tune->runs, tune->applied);
+      } else if ((argc == 2) && (strcmp(argv[1], "stop") == 0)) {
+         tune->stop = TRUE;
+      } else if ((argc == 2) && (strcmp(argv[1], "apply") == 0)) {
+         if (tune->state != TUNE_DONE) {
+            printf("No result to apply\n");
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            // Written into the setup by the Control_Task
+            tune->apply = TRUE;
+         }
+      } else if ((argc >= 2) && (argc <= 4) &&
+                 (sscanf(argv[1],"%u",&out) == 1) && (out > 0) && (out <= MAX_OUTPUTS) &&
+                 ((argc < 3) || ((sscanf(argv[2],"%u",&step) == 1) && (step > 0) && (step <= 50))) &&
+                 ((argc < 4) || ((sscanf(argv[3],"%d",&hysteresis) == 1) && (hysteresis > 0)))) {
+         if ((tune->state == TUNE_START) || (tune->state == TUNE_RELAY) || (tune->state == TUNE_SETTLE)) {
+            printf("Test of output %u running, stop it first\n", tune->output+1);
+            return_code = SHELL_EXIT_ERROR;
+         } else if (!(AnalogEngine.analog[out-1].flags & ANALOG_ACTIVE)) {
+            printf("Output %u is not an analog output with a sensor\n", out);
+            return_code = SHELL_EXIT_ERROR;
+         } else {
+            tune->output     = out - 1;
+            tune->step_pct   = step;
+            tune->hysteresis = hysteresis;
+            tune->stop       = FALSE;
+            tune->apply      = FALSE;
+            tune->state      = TUNE_START;
+         }
+      } else {
+         printf("Invalid parameters\n");
+         return_code = SHELL_EXIT_ERROR;
+         print_usage=TRUE;
+      }
+   }
+   
+   if (print_usage)  {
+      if (shorthelp)  {
+         printf("%s [<output> [<step> [<hysteresis>]]|stop|apply]\n", argv[0]);
+      } else  {
+         printf("Usage: %s [<output> [<step> [<hysteresis>]]|stop|apply]\n", argv[0]);
+         printf("   output     = analog output to test, run off its PI controller\n");
+         printf("   step       = relay step, %% of the output, default %u\n", TUNE_DEFAULT_STEP);
+         printf("   hysteresis = in sensor units, default 5%% of SP to EP\n");
+         printf("   stop       = end the test, the output goes back to PI\n");
+         printf("   apply      = write the EP, Integration Constant and Update\n");
+         printf("                Rate found into the setup of the output\n");
+      }
+   }
+   return return_code;
+} 
+
   
 /* EOF*/
@@ -35,6 +35,20 @@ extern int32_t Shell_temp(int32_t argc, char *argv[] );
 extern int32_t Shell_info(int32_t argc, char *argv[] ); 
 extern int32_t Shell_log(int32_t argc, char *argv[] ); 
 extern int32_t  Shell_wifi_params(int32_t argc, char * argv[] );
+extern int32_t Shell_top(int32_t argc, char *argv[] );
+extern int32_t Shell_trace(int32_t argc, char *argv[] );
+extern int32_t Shell_boot(int32_t argc, char *argv[] );
+extern int32_t Shell_lock(int32_t argc, char *argv[] );
+extern int32_t Shell_notify(int32_t argc, char *argv[] );
+extern int32_t Shell_config(int32_t argc, char *argv[] );
+extern int32_t Shell_validate(int32_t argc, char *argv[] );
+extern int32_t Shell_journal(int32_t argc, char *argv[] );
+extern int32_t Shell_control(int32_t argc, char *argv[] );
+extern int32_t Shell_plant(int32_t argc, char *argv[] );
+extern int32_t Shell_zones(int32_t argc, char *argv[] );
+extern int32_t Shell_schedule(int32_t argc, char *argv[] );
+extern int32_t Shell_failover(int32_t argc, char *argv[] );
+extern int32_t Shell_tune(int32_t argc, char *argv[] );
 
 #endif
 
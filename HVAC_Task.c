@@ -30,6 +30,11 @@
 #include "hvac_public.h"
 #include "hvac_private.h"
 #include "global.h"
+#include "db_notify.h"
+#include "warm_restart.h"
+#include "journal.h"
+#include "HVAC_Zone.h"
+#include "HVAC_Schedule.h"
 #include <ipcfg.h>
 #include <lwgpio.h>
 
@@ -74,8 +79,8 @@ HVAC_STATE  HVAC_State =  {HVAC_Off};
 
 void HVAC_Task(uint32_t param)
 {
-   HVAC_Mode_t mode;
    uint32_t counter = HVAC_LOG_CYCLE_IN_CONTROL_CYCLES;
+   uint8_t  outputs;
 
    /* Initialize operating parameters to default values */
    HVAC_InitializeParameters();
@@ -88,41 +93,31 @@ void HVAC_Task(uint32_t param)
 
    while( TRUE ) 
    {
-      // Read current temperature
+      // Read current temperatures, zone 0 is the ambient
       HVAC_State.ActualTemperature = HVAC_GetAmbientTemperature();
 
-      // Examine current parameters and set state accordingly 
-      HVAC_State.HVACState = HVAC_Off;
-      HVAC_State.FanOn = FALSE;
+      // Follow the weekly schedule, which may change the set point
+      HVAC_ScheduleRun(&HVAC_Schedule, SecCounter, HVAC_State.ActualTemperature);
 
-      mode = HVAC_GetHVACMode();
-      
-      if (mode == HVAC_Cool || mode == HVAC_Auto)  
-      {
-         if (HVAC_State.ActualTemperature > (HVAC_Params.DesiredTemperature+HVAC_TEMP_TOLERANCE)) 
-         {
-            HVAC_State.HVACState = HVAC_Cool;
-            HVAC_State.FanOn = TRUE;
-         }
-      } 
-      
-      if (mode == HVAC_Heat || mode == HVAC_Auto) 
-      {
-         if (HVAC_State.ActualTemperature < (HVAC_Params.DesiredTemperature-HVAC_TEMP_TOLERANCE)) 
-         {
-            HVAC_State.HVACState = HVAC_Heat;
-            HVAC_State.FanOn = TRUE;
-         }
-      }
+      HVAC_Zones.actual[0]  = (int16_t) HVAC_State.ActualTemperature;
+      HVAC_Zones.desired[0] = HVAC_Params.DesiredTemperature;
+      HVAC_Zones.mode[0]    = HVAC_Params.HVACMode;
+      HVAC_Zones.fan[0]     = HVAC_Params.FanMode;
+      HVAC_ZoneReadSensors(&HVAC_Zones);
+
+      // Examine current parameters and set the state of every zone
+      HVAC_ZoneEvaluate(&HVAC_Zones, SecCounter);
 
-      if (HVAC_GetFanMode() == Fan_On) {
-         HVAC_State.FanOn = TRUE;
-      }         
+      outputs = HVAC_Zones.outputs[0];
+      HVAC_State.HVACState = (outputs & HVAC_ZONE_HEAT) ? HVAC_Heat :
+                             (outputs & HVAC_ZONE_COOL) ? HVAC_Cool : HVAC_Off;
+      HVAC_State.FanOn = (outputs & HVAC_ZONE_FAN) != 0;
 
-      // Set outputs to reflect new state 
-   //   HVAC_SetOutput( HVAC_FAN_OUTPUT,  HVAC_State.FanOn );
-    //  HVAC_SetOutput( HVAC_HEAT_OUTPUT, HVAC_State.HVACState == HVAC_Heat );
-     // HVAC_SetOutput( HVAC_COOL_OUTPUT, HVAC_State.HVACState == HVAC_Cool );
+      // Set outputs to reflect new state. Only zone 0 has outputs; the
+      //    other zones are decided but not driven.
+      HVAC_SetOutput( HVAC_FAN_OUTPUT,  HVAC_State.FanOn );
+      HVAC_SetOutput( HVAC_HEAT_OUTPUT, HVAC_State.HVACState == HVAC_Heat );
+      HVAC_SetOutput( HVAC_COOL_OUTPUT, HVAC_State.HVACState == HVAC_Cool );
 
       // Log Current state 
       if( ++counter >= HVAC_LOG_CYCLE_IN_CONTROL_CYCLES ) 
@@ -213,16 +208,38 @@ void Button_Task(uint32_t param)
         else{
           gRelayState = 1;
       }      
+        journal_record( JOURNAL_RELAY_REQUEST, JOURNAL_SOURCE_BUTTON, gRelayState );
+        db_publish( DB_BIT( DB_GROUP_RELAY ) );
     }
       button_previously_pressed = button_pressed; 
   }
 }
+
+/*TASK*-----------------------------------------------------------------
+*
+* Function Name  : RControl_Task
+* Returned Value : void
+* Comments       : Drives the fan relay and LEDs from gRelayState. Waits
+*                  for a DB_GROUP_RELAY change rather than polling.
+*
+*END------------------------------------------------------------------*/
+
+#define RCONTROL_RELAY_CHANGED   1
+
+static LWEVENT_STRUCT RControlEvent;
+static DB_SUBSCRIBER  RControlSubscriber = {
+   "RControl", DB_BIT( DB_GROUP_RELAY ), &RControlEvent, RCONTROL_RELAY_CHANGED
+};
+
 void RControl_Task(uint32_t param)
 {
+  int driven = -1;    // State the relay was last driven to
+
+  _lwevent_create( &RControlEvent, LWEVENT_AUTO_CLEAR );
+  db_subscribe( &RControlSubscriber );
+
   while( TRUE )
   {
-    _time_delay( 100 );
-  
       if( gRelayState == 1 ){
         FAN_ON;
         GREEN_LED_ON;
@@ -235,6 +252,19 @@ void RControl_Task(uint32_t param)
         RED_LED_OFF;
         OFF_BOARD_LED_ON;
       }
+
+      if( gRelayState != driven ){
+        driven = gRelayState;
+        journal_record( JOURNAL_RELAY_OUTPUT, 0, driven );
+      }
+
+      // Keep the relay state in flash, to be restored after a power cycle.
+      //    The flash is written later by the Flash_Task.
+      //
+      warm_restart_request_control();
+
+      _lwevent_wait_ticks( &RControlEvent, RCONTROL_RELAY_CHANGED, TRUE, 0 );
+      db_changes( &RControlSubscriber );
   }
     
   
@@ -30,21 +30,35 @@
 
 #include "hvac_public.h"
 #include "hvac_private.h"
+#include "db_notify.h"
+#include "global.h"
+#include "HVAC_Plant.h"
+#include "HVAC_Zone.h"
+#include "HVAC_Schedule.h"
 
 HVAC_PARAMS HVAC_Params = {0};
 
 const char *HVACModeName[] = {"Off", "Cool", "Heat", "Auto"};
 
+// The HVAC task is notified of parameter changes through db_notify.c.
+static DB_SUBSCRIBER HVAC_Subscriber = {
+   "HVAC", DB_BIT( DB_GROUP_HVAC_PARAMS ), &HVAC_Params.Event, HVAC_PARAMS_CHANGED
+};
+
 // Function Prototypes
 void   Switch_Poll( void );
 
 void HVAC_InitializeParameters(void) 
 {
    _lwevent_create(&HVAC_Params.Event, 0);
+   db_subscribe(&HVAC_Subscriber);
    HVAC_Params.HVACMode = HVAC_Auto;
    HVAC_Params.FanMode = Fan_Automatic;
    HVAC_Params.TemperatureScale = Celsius;
    HVAC_Params.DesiredTemperature = HVAC_DEFAULT_TEMP;
+   HVAC_PlantInit(&HVAC_LivePlant, HVAC_PROFILE_SWING);
+   HVAC_ZoneInit(&HVAC_Zones, 1, SecCounter);
+   HVAC_ScheduleInit(&HVAC_Schedule);
 }
 
 
@@ -69,8 +83,10 @@ bool HVAC_WaitParameters(int32_t timeout)
             
     } while (elapsed < timeout);
         
-    catched = (HVAC_Params.Event.VALUE & HVAC_PARAMS_CHANGED) != 0;
+    // A change published after the event is cleared is still pending,
+    //    so it is reported here rather than lost.
     _lwevent_clear(&HVAC_Params.Event, HVAC_PARAMS_CHANGED);
+    catched = db_changes(&HVAC_Subscriber) != 0;
 
     return catched;  
 }
@@ -116,7 +132,7 @@ uint32_t HVAC_GetDesiredTemperature(void) {
 void HVAC_SetDesiredTemperature(uint32_t temp)
 {
    HVAC_Params.DesiredTemperature = HVAC_ConvertDisplayTempToCelsius(temp);
-   _lwevent_set(&HVAC_Params.Event, HVAC_PARAMS_CHANGED);
+   db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
 }
 
 
@@ -128,7 +144,7 @@ FAN_Mode_t HVAC_GetFanMode(void) {
 void HVAC_SetFanMode(FAN_Mode_t mode)
 {
    HVAC_Params.FanMode = mode;
-   _lwevent_set(&HVAC_Params.Event, HVAC_PARAMS_CHANGED);
+   db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
 }
 
 
@@ -141,12 +157,19 @@ HVAC_Mode_t HVAC_GetHVACMode(void)
 void HVAC_SetHVACMode(HVAC_Mode_t mode)
 {
    HVAC_Params.HVACMode = mode;
-   _lwevent_set(&HVAC_Params.Event, HVAC_PARAMS_CHANGED);
+   db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
 }
 
 
-uint32_t HVAC_GetActualTemperature(void) {
-   return HVAC_ConvertCelsiusToDisplayTemp(HVAC_State.ActualTemperature);
+// The temperature may be below 0, so this is converted here and not
+// with the unsigned HVAC_ConvertCelsiusToDisplayTemp().
+int32_t HVAC_GetActualTemperature(void) {
+   int32_t  temp = HVAC_State.ActualTemperature;
+
+   if (HVAC_Params.TemperatureScale != Celsius) {
+      temp = temp*9/5+320;
+   }
+   return temp;
 }
 
 
@@ -159,7 +182,7 @@ Temperature_Scale_t HVAC_GetTemperatureScale(void)
 void HVAC_SetTemperatureScale(Temperature_Scale_t scale)
 {
    HVAC_Params.TemperatureScale = scale;
-   _lwevent_set(&HVAC_Params.Event, HVAC_PARAMS_CHANGED);
+   db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
 }
 
 char HVAC_GetTemperatureSymbol(void) 
@@ -168,6 +191,118 @@ char HVAC_GetTemperatureSymbol(void)
 }
 
 
+// Zone 0 is the thermostat above; the other zones are kept in HVAC_Zones.
+// Callers check the zone against HVAC_GetZoneCount().
+uint32_t HVAC_GetZoneCount(void) 
+{
+   return HVAC_Zones.count;
+}
+
+
+void HVAC_SetZoneCount(uint32_t count)
+{
+   uint32_t zone;
+
+   if (count == 0 || count > HVAC_MAX_ZONES) {
+      return;
+   }
+   for (zone=count;zone<HVAC_Zones.count;zone++) {
+      HVAC_Zones.outputs[zone] = 0;
+   }
+   HVAC_Zones.count = count;
+   db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
+}
+
+
+uint32_t HVAC_GetZoneDesiredTemperature(uint32_t zone) 
+{
+   if (zone == 0) {
+      return HVAC_GetDesiredTemperature();
+   }
+   return HVAC_ConvertCelsiusToDisplayTemp(HVAC_Zones.desired[zone]);
+}
+
+
+void HVAC_SetZoneDesiredTemperature(uint32_t zone, uint32_t temp)
+{
+   if (zone == 0) {
+      HVAC_SetDesiredTemperature(temp);
+   } else if (zone < HVAC_MAX_ZONES) {
+      HVAC_Zones.desired[zone] = HVAC_ConvertDisplayTempToCelsius(temp);
+      db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
+   }
+}
+
+
+// Returns HVAC_ZONE_NO_TEMP when the zone has no temperature. The zone
+// may be below 0, so this is converted here and not with the unsigned
+// HVAC_ConvertCelsiusToDisplayTemp().
+int32_t HVAC_GetZoneActualTemperature(uint32_t zone) 
+{
+   int32_t  temp;
+
+   if (zone == 0) {
+      return HVAC_GetActualTemperature();
+   }
+   temp = HVAC_Zones.actual[zone];
+   if (temp == HVAC_ZONE_NO_TEMP) {
+      return HVAC_ZONE_NO_TEMP;
+   }
+   if (HVAC_Params.TemperatureScale != Celsius) {
+      temp = temp*9/5+320;
+   }
+   return temp;
+}
+
+
+HVAC_Mode_t HVAC_GetZoneHVACMode(uint32_t zone) 
+{
+   return (zone == 0) ? HVAC_GetHVACMode() : (HVAC_Mode_t)HVAC_Zones.mode[zone];
+}
+
+
+void HVAC_SetZoneHVACMode(uint32_t zone, HVAC_Mode_t mode)
+{
+   if (zone == 0) {
+      HVAC_SetHVACMode(mode);
+   } else if (zone < HVAC_MAX_ZONES) {
+      HVAC_Zones.mode[zone] = mode;
+      db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
+   }
+}
+
+
+FAN_Mode_t HVAC_GetZoneFanMode(uint32_t zone) 
+{
+   return (zone == 0) ? HVAC_GetFanMode() : (FAN_Mode_t)HVAC_Zones.fan[zone];
+}
+
+
+void HVAC_SetZoneFanMode(uint32_t zone, FAN_Mode_t mode)
+{
+   if (zone == 0) {
+      HVAC_SetFanMode(mode);
+   } else if (zone < HVAC_MAX_ZONES) {
+      HVAC_Zones.fan[zone] = mode;
+      db_publish(DB_BIT(DB_GROUP_HVAC_PARAMS));
+   }
+}
+
+
+bool HVAC_GetZoneOutput(uint32_t zone, HVAC_Output_t output)
+{
+   if (zone == 0) {
+      return HVAC_GetOutput(output);
+   }
+   switch (output) {
+      case HVAC_FAN_OUTPUT:  return (HVAC_Zones.outputs[zone] & HVAC_ZONE_FAN) != 0;
+      case HVAC_HEAT_OUTPUT: return (HVAC_Zones.outputs[zone] & HVAC_ZONE_HEAT) != 0;
+      case HVAC_COOL_OUTPUT: return (HVAC_Zones.outputs[zone] & HVAC_ZONE_COOL) != 0;
+      default:               return FALSE;
+   }
+}
+
+
 void Switch_Poll(void) 
 {
    static bool    InputState[HVAC_MAX_INPUTS] = {0};
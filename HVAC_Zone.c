@@ -0,0 +1,263 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Zone.c
+
+PURPOSE   : Control engine for the zones of the HVAC demo. The HVAC_Task
+            fills in zone 0 from HVAC_Params and the ambient temperature,
+            HVAC_ZoneReadSensors() the temperature of the other zones, and
+            HVAC_ZoneEvaluate() then decides the fan, heating and cooling
+            stages of every zone in one pass. Only the outputs of zone 0
+            are driven, by the HVAC_Task; those of the other zones are
+            decisions only, see HVAC_Zone.h.
+
+            There is no task per zone. A pass looks at each zone once,
+            with the policy limits (tolerance, staging, minimum On and Off
+            times) shared by all of them, so a pass over 64 zones costs
+            64 times a pass over one. "zones bench" measures it.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include "hvac.h"
+#include "hvac_public.h"
+#include "hvac_private.h"
+#include "defines.h"
+#include "global.h"
+#include "live_status.h"
+#include "task_monitor.h"
+#include "HVAC_Zone.h"
+
+HVAC_ZONES      HVAC_Zones;
+HVAC_ZONES      HvacBenchZones;     // Scratch table for HVAC_ZoneBench()
+
+
+//
+//  HVAC_ZoneInit() - Start "count" zones with the default policy, Off, at
+//                    the default set point and with no temperature. They
+//                    may start at once; the minimum Off time is taken as
+//                    already past.
+//
+void
+HVAC_ZoneInit( HVAC_ZONES * zones, uint8_t count, uint32_t now )
+{
+    int  k;
+
+    memset( zones, 0, sizeof( HVAC_ZONES ) );
+
+    zones->count       = (count > 0 && count <= HVAC_MAX_ZONES) ? count : 1;
+    zones->tolerance   = HVAC_ZONE_TOLERANCE;
+    zones->stage_delta = HVAC_ZONE_STAGE_DELTA;
+    zones->min_on      = HVAC_ZONE_MIN_ON;
+    zones->min_off     = HVAC_ZONE_MIN_OFF;
+
+    for( k=0; k<HVAC_MAX_ZONES; k++ )
+    {
+        zones->desired[k] = HVAC_DEFAULT_TEMP;
+        zones->actual[k]  = HVAC_ZONE_NO_TEMP;
+        zones->mode[k]    = HVAC_Off;
+        zones->fan[k]     = Fan_Automatic;
+        zones->sensor[k]  = SENSOR_ID_NONE;
+        zones->changed[k] = now - HVAC_ZONE_MIN_OFF;
+    }
+}
+
+
+//
+//  HVAC_ZoneReadSensors() - Take the temperature of zones 1 and up from
+//                           one snapshot of the live status. A zone whose
+//                           sensor is not a temperature, or has failed,
+//                           has no temperature.
+//
+void
+HVAC_ZoneReadSensors( HVAC_ZONES * zones )
+{
+    LIVE_STATUS  status;
+    int          k;
+    uint8_t      id;
+    bool         valid;
+    float        temp;
+
+    if( zones->count < 2 )
+        return;
+
+    live_status_read( &status );
+
+    for( k=1; k<zones->count; k++ )
+    {
+        id    = zones->sensor[k];
+        valid = FALSE;
+        temp  = 0.0;
+
+        // The sensor type is one byte, read without mutexCore.
+        //
+        if( (id != SENSOR_ID_NONE) && (id <= MAX_SENSOR_ID) && !status.sensor[id].fail )
+        {
+            switch( coreDB.sensor[id].setup.sensor_type )
+            {
+                case SENSOR_TYPE_TEMP_C:
+                case SENSOR_TYPE_TEMP_HI_C:
+                    temp  = status.sensor[id].value_float * 10.0;
+                    valid = TRUE;
+                    break;
+
+                case SENSOR_TYPE_TEMP_F:
+                case SENSOR_TYPE_TEMP_HI_F:
+                    temp  = (status.sensor[id].value_float - 32.0) * 50.0 / 9.0;
+                    valid = TRUE;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Rounded to the nearest 1/10 degree, either side of zero. A value
+        //    out of range is taken as no temperature.
+        //
+        if( valid && (temp > -3000.0) && (temp < 3000.0) )
+            zones->actual[k] = (int16_t)((temp >= 0.0) ? temp + 0.5 : temp - 0.5);
+        else
+            zones->actual[k] = HVAC_ZONE_NO_TEMP;
+    }
+}
+
+
+//
+//  HVAC_ZoneEvaluate() - One pass over all of the zones, "now" in seconds.
+//                        Sets outputs[] of each zone.
+//
+void
+HVAC_ZoneEvaluate( HVAC_ZONES * zones, uint32_t now )
+{
+    int       k;
+    int32_t   err;
+    uint32_t  start;
+    uint32_t  on_time;
+    uint8_t   out, next, want;
+    uint8_t   mode;
+
+    start = TMON_CYCLE_COUNT();
+
+    for( k=0; k<zones->count; k++ )
+    {
+        out     = zones->outputs[k];
+        next    = out & (HVAC_ZONE_HEAT | HVAC_ZONE_COOL);
+        mode    = zones->mode[k];
+        on_time = now - zones->changed[k];
+
+        if( zones->actual[k] == HVAC_ZONE_NO_TEMP )
+        {
+            zones->no_temp++;
+            next = 0;
+        }
+        else if( out & HVAC_ZONE_HEAT1 )
+        {
+            err = (int32_t)zones->desired[k] - zones->actual[k];
+
+            if( ((mode != HVAC_Heat) && (mode != HVAC_Auto)) || (err <= 0) )
+            {
+                if( on_time >= zones->min_on )
+                    next = 0;
+                else
+                    zones->held++;
+            }
+            else if( err >= zones->stage_delta )
+                next |= HVAC_ZONE_HEAT2;
+            else if( err < zones->stage_delta / 2 )
+                next &= ~HVAC_ZONE_HEAT2;
+        }
+        else if( out & HVAC_ZONE_COOL1 )
+        {
+            err = (int32_t)zones->actual[k] - zones->desired[k];
+
+            if( ((mode != HVAC_Cool) && (mode != HVAC_Auto)) || (err <= 0) )
+            {
+                if( on_time >= zones->min_on )
+                    next = 0;
+                else
+                    zones->held++;
+            }
+            else if( err >= zones->stage_delta )
+                next |= HVAC_ZONE_COOL2;
+            else if( err < zones->stage_delta / 2 )
+                next &= ~HVAC_ZONE_COOL2;
+        }
+        else
+        {
+            want = 0;
+            err  = (int32_t)zones->desired[k] - zones->actual[k];
+
+            if( ((mode == HVAC_Heat) || (mode == HVAC_Auto)) && (err > zones->tolerance) )
+                want = HVAC_ZONE_HEAT1;
+            else if( ((mode == HVAC_Cool) || (mode == HVAC_Auto)) && (-err > zones->tolerance) )
+                want = HVAC_ZONE_COOL1;
+
+            if( want )
+            {
+                if( on_time >= zones->min_off )
+                {
+                    next = want;
+                    zones->starts++;
+                }
+                else
+                    zones->held++;
+            }
+        }
+
+        if( (next ^ out) & (HVAC_ZONE_HEAT1 | HVAC_ZONE_COOL1) )
+            zones->changed[k] = now;
+
+        if( next & ~out & (HVAC_ZONE_HEAT2 | HVAC_ZONE_COOL2) )
+            zones->stage_ups++;
+
+        if( next || (zones->fan[k] == Fan_On) )
+            next |= HVAC_ZONE_FAN;
+
+        zones->outputs[k] = next;
+    }
+
+    zones->passes++;
+    zones->pass_last = TMON_CYCLE_COUNT() - start;
+    if( zones->pass_last > zones->pass_max )
+        zones->pass_max = zones->pass_last;
+}
+
+
+//
+//  HVAC_ZoneBench() - Evaluate "count" zones "passes" times in the scratch
+//                     table, with temperatures that wander around the set
+//                     points so that zones start, stage and stop. Returns
+//                     the average cycles per pass, the setup of each pass
+//                     not counted.
+//
+uint32_t
+HVAC_ZoneBench( uint8_t count, uint32_t passes )
+{
+    HVAC_ZONES * zones = &HvacBenchZones;
+    uint32_t     p, total = 0;
+    int          k;
+
+    HVAC_ZoneInit( zones, count, 0 );
+
+    for( k=0; k<zones->count; k++ )
+    {
+        zones->desired[k] = HVAC_DEFAULT_TEMP + (k % 5) * 5;
+        zones->mode[k]    = (k % 4 == 3) ? HVAC_Off : HVAC_Auto;
+    }
+
+    for( p=0; p<passes; p++ )
+    {
+        for( k=0; k<zones->count; k++ )
+            zones->actual[k] = (int16_t)(zones->desired[k] + (int)((k * 7 + p * 3) % 61) - 30);
+
+        HVAC_ZoneEvaluate( zones, p * 60 );
+        total += zones->pass_last;
+    }
+
+    return( passes ? total / passes : 0 );
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : HVAC_Zone.h
+
+PURPOSE   : Definitions and function prototypes for the "HVAC_Zone.c"
+            module; the control engine for the zones of the HVAC demo.
+
+            Zone 0 is the original thermostat; its set point, mode and fan
+            come from HVAC_Params and its temperature from the ambient
+            model, and its outputs drive the fan, heat and cool outputs.
+            Further zones read a temperature sensor. For them the engine
+            decides only: their outputs are shown by the "zones" command
+            and are not mapped to any relay.
+
+            The zone state is kept as arrays, one entry per zone, so that
+            one pass of HVAC_ZoneEvaluate() walks each array once and the
+            cost grows with the number of zones only.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __hvac_zone_inc
+#define  __hvac_zone_inc
+
+#include <mqx.h>
+#include "hvac_public.h"
+
+#define  HVAC_MAX_ZONES          64
+#define  HVAC_ZONE_NO_TEMP       (-32767 - 1)   // Zone without a temperature,
+                                                //   INT16_MIN
+
+// Default policy, see HVAC_ZONES
+//
+#define  HVAC_ZONE_TOLERANCE     HVAC_TEMP_TOLERANCE
+#define  HVAC_ZONE_STAGE_DELTA   20        // 1/10 degree, 2.0 C
+#define  HVAC_ZONE_MIN_ON        180       // Seconds
+#define  HVAC_ZONE_MIN_OFF       300       // Seconds
+
+// Bits of HVAC_ZONES.outputs[]
+//
+#define  HVAC_ZONE_FAN           0x01
+#define  HVAC_ZONE_HEAT1         0x02
+#define  HVAC_ZONE_HEAT2         0x04
+#define  HVAC_ZONE_COOL1         0x08
+#define  HVAC_ZONE_COOL2         0x10
+
+#define  HVAC_ZONE_HEAT          (HVAC_ZONE_HEAT1 | HVAC_ZONE_HEAT2)
+#define  HVAC_ZONE_COOL          (HVAC_ZONE_COOL1 | HVAC_ZONE_COOL2)
+
+// HVAC_ZONES - The state of every zone, and the policy they share.
+//   Temperatures are in 1/10 degree C, as HVAC_Params.DesiredTemperature.
+//   The actual temperature is signed, as a zone may be below freezing.
+//
+//   A zone starts heating (cooling) when it is more than "tolerance" below
+//   (above) its set point, and stops when it reaches the set point. The
+//   second stage is added while the zone is "stage_delta" or more away
+//   from the set point, and dropped at half of that. A start or stop is
+//   held back until the equipment has been Off for "min_off" or On for
+//   "min_on" seconds, except when the temperature is lost.
+//
+typedef struct
+{
+    uint8_t   count;                         // Zones in use, 1..HVAC_MAX_ZONES
+    uint16_t  tolerance;
+    uint16_t  stage_delta;
+    uint16_t  min_on;
+    uint16_t  min_off;
+
+    uint16_t  desired[ HVAC_MAX_ZONES ];
+    int16_t   actual[ HVAC_MAX_ZONES ];      // HVAC_ZONE_NO_TEMP = none
+    uint8_t   mode[ HVAC_MAX_ZONES ];        // HVAC_Mode_t
+    uint8_t   fan[ HVAC_MAX_ZONES ];         // FAN_Mode_t
+    uint8_t   sensor[ HVAC_MAX_ZONES ];      // SENSOR_ID_xxx, NONE for zone 0
+    uint8_t   outputs[ HVAC_MAX_ZONES ];     // HVAC_ZONE_xxx
+    uint32_t  changed[ HVAC_MAX_ZONES ];     // Time of the last start or stop
+
+    uint32_t  passes;
+    uint32_t  starts;
+    uint32_t  stage_ups;
+    uint32_t  held;                          // Zone passes held by min_on\off
+    uint32_t  no_temp;                       // Zone passes without a temperature
+    uint32_t  pass_last;                     // Cycles, last pass
+    uint32_t  pass_max;
+
+}  HVAC_ZONES;
+
+extern HVAC_ZONES   HVAC_Zones;
+
+//
+//    Function Prototypes
+//
+void      HVAC_ZoneInit( HVAC_ZONES * zones, uint8_t count, uint32_t now );
+void      HVAC_ZoneReadSensors( HVAC_ZONES * zones );
+void      HVAC_ZoneEvaluate( HVAC_ZONES * zones, uint32_t now );
+uint32_t  HVAC_ZoneBench( uint8_t count, uint32_t passes );
+
+#endif
@@ -23,7 +23,15 @@
 
 //#include "watchdog_func.h"
 #include "Sensor_Task.h"
-//#include "Control_Task.h"
+#include "task_monitor.h"
+#include "work_queue.h"
+#include "boot_stage.h"
+#include "core_lock.h"
+#include "config_store.h"
+#include "config_image.h"
+#include "warm_restart.h"
+#include "journal.h"
+#include "Control_Task.h"
 //#include "UI_Task.h"
 
 //    #include "rtcs_func.h"
@@ -37,7 +45,7 @@
 //#include "i2cExpModules.h"
 //#include "sensors.h"
 //#include "eeprom.h"
-//#include "func.h"
+#include "func.h"
 //#include "periodic_events.h"
 
 
@@ -71,6 +79,9 @@ const TASK_TEMPLATE_STRUCT MQX_template_list[] =
   //added
   { BUTTON_TASK,     Button_Task,      1500,    9,      "Button",    0,                   0,      0 },
   { RCONTROL_TASK,   RControl_Task,    1500,    9,      "Control",   0,                   0,      0 },   
+  { WORK_TASK,       Work_Task,        1200,    8,      "Work",      0,                   0,      0 },
+  { FLASH_TASK,      Flash_Task,       1200,   12,      "Flash",     0,                   0,      0 },
+  { CONTROL_TASK,    Control_Task,     1000,    9,      "Relays",    0,                   0,      0 },
 
   {0}
 };
@@ -79,22 +90,78 @@ const TASK_TEMPLATE_STRUCT MQX_template_list[] =
 void init_globals( void );
 void init_gpio( void );
 
+void boot_start_core( void );
+void boot_start_monitor( void );
+void boot_start_work( void );
+void boot_start_scheduler( void );
+void boot_start_sensing( void );
+void boot_start_control( void );
+void boot_start_shell( void );
+void boot_start_network( void );
+void boot_create_task( _mqx_uint template_index );
+
+//
+//  Boot stages. A stage is started once all of the stages in its
+//    "depends" mask are ready; see boot_stage.c. Sensing and control
+//    come up first. Networking, which can block for several seconds
+//    in the Atheros driver, Wi-Fi association and DHCP, waits until
+//    the first sensor values are in coreDB, or until 3 seconds after
+//    reset if sensing has not come up by then.
+//
+const BOOT_STAGE BootStageTable[ MAX_BOOT_STAGE ] =
+{
+  // Name,        Depends on,                                                  Wait ms, Start,                Ready on start
+  { "core",       0,                                                           0,       boot_start_core,      TRUE  },
+  { "monitor",    BOOT_BIT( BOOT_STAGE_CORE ),                                 0,       boot_start_monitor,   TRUE  },
+  { "work",       BOOT_BIT( BOOT_STAGE_MONITOR ),                              0,       boot_start_work,      TRUE  },
+  { "scheduler",  BOOT_BIT( BOOT_STAGE_WORK ),                                 0,       boot_start_scheduler, TRUE  },
+  { "sensing",    BOOT_BIT( BOOT_STAGE_SCHEDULER ),                            0,       boot_start_sensing,   FALSE },
+  { "control",    BOOT_BIT( BOOT_STAGE_SCHEDULER ),                            0,       boot_start_control,   TRUE  },
+  { "shell",      BOOT_BIT( BOOT_STAGE_CORE ),                                 0,       boot_start_shell,     TRUE  },
+  { "network",    BOOT_BIT( BOOT_STAGE_SENSING ) | BOOT_BIT( BOOT_STAGE_CONTROL ), 3000, boot_start_network,   FALSE },
+  { "wifi",       BOOT_BIT( BOOT_STAGE_NETWORK ),                              0,       NULL,                 FALSE },
+  { "http",       BOOT_BIT( BOOT_STAGE_NETWORK ),                              0,       NULL,                 FALSE }
+};
+
 //
 //   Init_Task() - Kick-start all the other tasks used in this application
 //
 void Init_Task(uint_32 data)
+{
+    boot_run();
+
+    _task_block();
+}
+
+//
+//   boot_create_task() - Create a task and add it to the task monitor.
+//
+void
+boot_create_task( _mqx_uint template_index )
+{
+    _task_id  tid;
+
+    tid = _task_create( 0, template_index, 0 );
+
+    if( tid != MQX_NULL_TASK_ID )
+        task_monitor_add_task( tid );
+}
+
+//
+//   boot_start_core() - Core data, GPIO and globals used by every task.
+//
+void
+boot_start_core( void )
 {
     // Initialize the mutex that will be used to protect / synchronize the
     //    core data that is shared by the tasks. Any task wanting to read
     //    or write to this core data must first "lock" the mutex, perform
     //    the memory read/write, and then "unlock" the mutex. Included in
     //    the core data are the Output[] structures, and Sensor[] 
-    //    structures.
+    //    structures. The mutex is accessed through core_lock() and
+    //    core_unlock(), which measure contention; see "lock" command.
     //
-    if( _mutex_init( &mutexCore, NULL ) != MQX_OK )
-    {
-        _mqx_exit( 0 );   // "0" is the error code
-    }
+    core_lock_init();
 
     TickPerSecond = _time_get_ticks_per_sec();
     HwTickPerTick = _time_get_hwticks_per_tick();
@@ -143,31 +210,101 @@ PmcRegsc  = PMC_REGSC;
     BaseInfo.ssm        = SSM_NUMBER;
     BaseInfo.sim_sdid   = SIM_SDID;    // Read the Device ID Register
 
-    // Start the PIT0 timer which will schedule running of
-    //    the Control and UI tasks.
-    //
-    init_event_handlers();
-
     //  Install the unexpected ISR handler.
     _int_install_unexpected_isr();
 //DES Installs the MQX-provided _int_exception_isr() as the default ISR for unhandled interrupts and exceptions.
     _int_install_exception_isr();                   //DES added
+}
+
+//
+//   boot_start_monitor() - Start the task monitor, which measures stack
+//                          and CPU use of each task; see "top" command.
+//                          Tasks created later are added to it by
+//                          boot_create_task().
+//
+void
+boot_start_monitor( void )
+{
+    task_monitor_init();
 
+    // Start recording the event trace; see "trace" command. This uses
+    //    the cycle counter enabled by task_monitor_init().
+    //
+    trace_init();
+}
 
+//
+//   boot_start_work() - Create the deferred work queue before any
+//                       interrupt or driver callback that may post to
+//                       it is enabled.
+//
+void
+boot_start_work( void )
+{
+    work_queue_init();
 
-    _task_create( 0, WMICONFIG_TASK1, 0 );
-    _task_create( 0, WMICONFIG_TASK2, 0 );
-    _task_create( 0, HVAC_TASK,       0 );
-    _task_create( 0, SHELL_TASK,      0 );
-    _task_create( 0, HEARTBEAT_TASK,  0 );
-    
-    _task_create( 0, BUTTON_TASK,     0);
-    _task_create( 0, RCONTROL_TASK,    0);
+    boot_create_task( WORK_TASK );
+    boot_create_task( FLASH_TASK );
 
-    // Create Sensor Task to routinely sample the sensor inputs
-    _task_create( 0, SENSOR_TASK, 0 );
+    // Events recorded so far are written to flash by the Flash_Task.
+    //
+    journal_start();
+}
 
-    _task_block();
+//
+//   boot_start_scheduler() - Start the PIT0 timer which will schedule
+//                            running of the Sensor, Control and UI tasks.
+//
+void
+boot_start_scheduler( void )
+{
+    init_event_handlers();
+}
+
+//
+//   boot_start_sensing() - Create Sensor Task to routinely sample the
+//                          sensor inputs. It signals BOOT_STAGE_SENSING
+//                          once the first values are in coreDB.
+//
+void
+boot_start_sensing( void )
+{
+    boot_create_task( SENSOR_TASK );
+}
+
+//
+//   boot_start_control() - Create the HVAC control, relay engine, relay
+//                          control and button tasks.
+//
+void
+boot_start_control( void )
+{
+    boot_create_task( HVAC_TASK );
+    boot_create_task( HEARTBEAT_TASK );
+    boot_create_task( CONTROL_TASK );
+    boot_create_task( BUTTON_TASK );
+    boot_create_task( RCONTROL_TASK );
+}
+
+//
+//   boot_start_shell() - Create the serial shell task.
+//
+void
+boot_start_shell( void )
+{
+    boot_create_task( SHELL_TASK );
+}
+
+//
+//   boot_start_network() - Create the wmiconfig tasks. WMICONFIG2 brings
+//                          up the Atheros driver, RTCS, Wi-Fi and the
+//                          web server, and signals BOOT_STAGE_NETWORK.
+//
+void
+boot_start_network( void )
+{
+    boot_create_task( WMICONFIG_TASK1 );
+    boot_create_task( WMICONFIG_TASK2 );
 }
 
 void
@@ -209,9 +346,13 @@ init_globals( void )
 {
 //    EXP_POLL_RESPONSE   poll;
     int                 temp, k;
+    bool                enet_ok;
+    const uint8_t *     image;
 
     System.model_type = MODULE_TYPE_C450CEN;
 
+    init_setpoint_limits();
+
     
     //  Clear all Error flags, intialize countdown timers
     Error.supply_power_fail    = FALSE;
@@ -226,11 +367,26 @@ init_globals( void )
     CommLedRequest.xmit_led        = COMM_LED_OFF;
     CommLedRequest.recv_led        = COMM_LED_OFF;
 
-    // If EEPROM fails, load default calibration data to EEPROM
-    //    and to the global variable CalData.
+    // The persistent configuration is kept in the internal flash, see
+    //    config_store.c. If it cannot be started, the items below are
+    //    not found and the defaults are used.
     //
-//    if( ee_read_calibration( &CalData ) == FALSE )
-//    {
+    cfg_store_init();
+
+    // The calibration, sensor setup and output setup are read from the
+    //    setup image, in place in the flash; see config_image.c. An image
+    //    of an older schema, or the records saved by earlier firmware,
+    //    are converted first. If there is none the defaults are used.
+    //    An image is saved below unless one of this schema was read.
+    //
+    image = cfg_image_map();
+
+    if( image != NULL )
+    {
+        cfg_image_get_calibration( image, &CalData );
+    }
+    else
+    {
         CalData.five_volt_external = DEFAULT_CAL_5_VOLT_EXTERNAL;
 
         CalData.volt_adc_ground_1  = DEFAULT_CAL_VIN_GROUND;
@@ -244,9 +400,7 @@ init_globals( void )
         CalData.resistive_offset_1 = DEFAULT_CAL_RIN_OFFSET;
         CalData.resistive_offset_2 = DEFAULT_CAL_RIN_OFFSET;
         CalData.resistive_offset_3 = DEFAULT_CAL_RIN_OFFSET;
-
-//        ee_write_calibration( &CalData );
-//    }
+    }
 
     // If EEPROM fails, load default calibration data to EEPROM
     //    and to the global variable CalData.
@@ -278,11 +432,10 @@ init_globals( void )
 //        ee_write_mac_id( &coreDB.mac );
 //    }
 
-//    if( ee_read_enet_setup( &coreDB.enet_setup ) == FALSE )
-//    {
+    enet_ok = cfg_store_read( CFG_KEY_ENET_SETUP, &coreDB.enet_setup, sizeof( ENET_SETUP ) );
+
+    if( !enet_ok )
         load_default_enet_setup( &coreDB.enet_setup );
-//        ee_write_enet_setup( &coreDB.enet_setup );
-//    }
 
 //    if( ee_read_ddns_setup( &coreDB.dyndns ) == FALSE )
 //    {
@@ -301,22 +454,23 @@ init_globals( void )
 //    }
 
 
-    // If EEPROM fails, load default sensor data to EEPROM
-    //    and to the global variable coreDB.sensor[].
+    // Load default sensor data to the global variable coreDB.sensor[],
+    //    unless a setup is saved.
     //
-//    if( ee_read_sensor_setup( &coreDB.sensor[SENSOR_ID_ONE] ) == FALSE )
-//    {
-        for( k=0; k<MAX_SENSORS; k++ )
-        {
-            coreDB.sensor[k].setup.sensor_type  = SENSOR_TYPE_NONE;
-            coreDB.sensor[k].setup.offset       = 0;
-        }
-            
-        // Write defaults to EEPROM. Configurations are
-        //    stored in EEPROM for sensor IDs 1, 2, & 3 only.
-        //    It is assumed that Sensor IDs 1,2,3 are contiguous.
-//        ee_write_sensor_setup( &coreDB.sensor[SENSOR_ID_ONE] );
-//    }        
+    for( k=0; k<MAX_SENSORS; k++ )
+    {
+        coreDB.sensor[k].setup.sensor_type  = SENSOR_TYPE_NONE;
+        coreDB.sensor[k].setup.offset       = 0;
+    }
+
+    // Configurations are stored for sensor IDs 1, 2, & 3 only.
+    //    It is assumed that Sensor IDs 1,2,3 are contiguous.
+    //
+    if( image != NULL )
+    {
+        for( k=SENSOR_ID_ONE; k<=SENSOR_ID_THREE; k++ )
+            cfg_image_get_sensor( image, k - SENSOR_ID_ONE, &coreDB.sensor[k].setup );
+    }
 
 //    if( !ee_read_sensor_name( coreDB.sensor[SENSOR_ID_ONE].name, SENSOR_ID_ONE ) )
 //    {
@@ -361,7 +515,7 @@ init_globals( void )
 
     // Prior to polling the expansion modules to determine what outputs
     //    exist in the system, read all of the output setup structures
-    //    from EEPROM and initialize any problem data with defaults.
+    //    from the setup image, or use defaults.
     //
     for( k=0; k<MAX_OUTPUTS; k++ )
     {
@@ -369,12 +523,15 @@ init_globals( void )
         coreDB.output[k].module_addr  = 0;
         coreDB.output[k].point_addr   = 0;
 
-//        if( !ee_read_output_setup( &coreDB.output[k].setup, k ) )
-//        {
+        if( image != NULL )
+        {
+            cfg_image_get_output( image, k, &coreDB.output[k].setup );
+        }
+        else
+        {
             coreDB.output[k].setup.output_type = OUTPUT_TYPE_RELAY;
             load_default_setup( &coreDB.output[k], SENSOR_TYPE_NONE );        
-//            ee_write_output_setup( &coreDB.output[k].setup, k );
-//        }
+        }
 
 //        if( !ee_read_output_name( coreDB.output[k].name, k ) )
 //        {
@@ -383,6 +540,20 @@ init_globals( void )
 //        }
     }
 
+    // Writing to the store may move the setup image, so defaults are
+    //    only saved now that it has been read. The records of earlier
+    //    firmware are erased once the image is saved.
+    //
+    if( !enet_ok )
+        cfg_store_write( CFG_KEY_ENET_SETUP, &coreDB.enet_setup, sizeof( ENET_SETUP ) );
+
+    if( ((image == NULL) || CfgImageInfo.migrated) && cfg_image_save( &CalData, &coreDB ) )
+    {
+        cfg_store_erase( CFG_KEY_CALIBRATION );
+        cfg_store_erase( CFG_KEY_SENSOR_SETUP );
+        cfg_store_erase( CFG_KEY_OUTPUT_SETUP );
+    }
+
     System.num_outputs = 0;
 
     // Initialize the EeImage to match the core Database. Following this
@@ -410,12 +581,24 @@ init_globals( void )
 //    EeImage.enet_setup = coreDB.enet_setup;
 //    EeImage.dyndns     = coreDB.dyndns;
 
-    // Update all copies of the data as used by the various tasks so
+    // Update the views of the data as used by the various tasks so
     //   that they are synchronized with the Core Database.
     //
-    sensorDB  = coreDB;     // sensorDB is used by the Sensor Task
-    controlDB = coreDB;     // controlDB is used by the Control Task
-    uiDB      = coreDB;     // uiDB is used by the UI Task
-    modbusDB  = coreDB;     // modbusDB is used by the Modbus Task
-    enetDB    = coreDB;     // enetDB is used by the web server task
+    for( k=0; k<MAX_SENSORS; k++ )
+    {
+        sensorDB.sensor[k]     = coreDB.sensor[k];       // Sensor Task
+        enetDB.sensor_setup[k] = coreDB.sensor[k].setup; // Web server task
+    }
+
+    sensorDB.config_version = coreDB.config_version;
+    enetDB.config_version   = coreDB.config_version;
+
+    // After a watchdog or software reset, put back the sensor values,
+    //    output timers and relay state from before the reset.
+    //
+    warm_restart_restore();
+
+    // Carry on the event journal from where it was in flash.
+    //
+    journal_init();
 }
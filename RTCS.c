@@ -31,6 +31,7 @@
 #include "tfs.h"
 #include "atheros_main.h"
 #include "WiFi_GT202.h"
+#include "boot_stage.h"
 
 #include  <ipcfg.h>
 #include "httpsrv.h"
@@ -166,6 +167,10 @@ void HVAC_initialize_networking(void)
         {
             printf("Error: HTTP server init error.\n");
         }
+        else
+        {
+            boot_stage_ready(BOOT_STAGE_HTTP);
+        }
     }
 }
 
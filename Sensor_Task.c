@@ -50,6 +50,12 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 #include "Sensor_Task.h"
 #include "sensors.h"
 #include "func.h"
+#include "task_monitor.h"
+#include "boot_stage.h"
+#include "core_lock.h"
+#include "live_status.h"
+#include "db_notify.h"
+#include "journal.h"
 
 // There are two events that may trigger this task to run;
 //
@@ -131,6 +137,13 @@ const ADC_CONFIG AdcConfig[] =
 SAMPLE_STRUCT    Sample[MAX_ANA_INPUTS];
 int              SampleState;
 
+LIVE_STATUS      SensorLiveStatus;   // Built each sample cycle, then published
+SENSOR_SYNC_STATS SensorSyncStats;
+volatile uint32_t SampleCompleteStamp; // Cycle count at the last conversion
+                                        //   of a sample cycle
+volatile uint32_t SensorCycleStamp;  // SampleCompleteStamp of the cycle
+                                     //   last published
+
                  // The random number generator is seeded by this task,
                  //    using the sum of the ADC value of all of the analog 
                  //    inputs. This is done only once, after these inputs
@@ -173,7 +186,7 @@ void Sensor_Task( uint32_t data )
 {
     _mqx_uint  event_signal, result;
     int        calibrate_timer, k;
-    uint32_t   seed_value;
+    uint32_t   seed_value, dirty;
 
     _lwevent_clear( &eventSensorTask, (_mqx_uint) SENSOR_TASK_EVENTS );
 
@@ -225,6 +238,7 @@ Spi1_sr    = SPI1_SR;
         //     of the possible events has just occurred.
         //
         event_signal = _lwevent_get_signalled();
+        TRACE_EVENT_WAIT( TRACE_EVENT_SENSOR, event_signal );
 
         // Clear all of the events that have been detected.
         _lwevent_clear( &eventSensorTask, event_signal );
@@ -273,6 +287,8 @@ Spi1_sr    = SPI1_SR;
                 srand( (unsigned int) seed_value );
             }
 
+            TRACE_BEGIN( TRACE_MARK_SENSOR_CONVERT );
+
             // Convert Raw Sn-1 samples to engineering units
             sensor_eng_units( &sensorDB.sensor[ SENSOR_ID_ONE ], &CalData, Sample[ IDX_ANA_SENSOR_1 ].raw, SENSOR_ID_ONE );
 
@@ -288,18 +304,18 @@ Spi1_sr    = SPI1_SR;
             update_high_signal_sensor( &sensorDB.sensor[0] );
 
             // Convert Raw 5 vdc external samples to engineering units
-            coreDB.five_volt_ext = calc_reference_voltage( Sample[ IDX_ANA_5_VOLT ].raw );
+            sensorDB.five_volt_ext = calc_reference_voltage( Sample[ IDX_ANA_5_VOLT ].raw );
 
             // Convert Raw 10 vdc reference samples to engineering units
-            coreDB.ten_volt_ref = calc_reference_voltage( Sample[ IDX_ANA_10_VOLT ].raw );
+            sensorDB.ten_volt_ref = calc_reference_voltage( Sample[ IDX_ANA_10_VOLT ].raw );
 
             // Convert Raw CPU Temp samples to engineering units
-            coreDB.cpu_temp = calc_cpu_temp( Sample[ IDX_ANA_CPU_TEMP ].raw );
+            sensorDB.cpu_temp = calc_cpu_temp( Sample[ IDX_ANA_CPU_TEMP ].raw );
 
             // If the ext. 5 vdc is low, check for the error condition.
             // Else; clear the error condition.
             //
-            if( coreDB.five_volt_ext < SENSOR_POWER_THRESHOLD )
+            if( sensorDB.five_volt_ext < SENSOR_POWER_THRESHOLD )
             {
                 if( Error.sensor_power_pending == FALSE )
                 {
@@ -311,12 +327,18 @@ Spi1_sr    = SPI1_SR;
                     if( Error.sensor_power_delay )
                         Error.sensor_power_delay--;
 
-                    if( Error.sensor_power_delay == 0 )
+                    if( (Error.sensor_power_delay == 0) && !Error.sensor_power_fail )
+                    {
                         Error.sensor_power_fail = TRUE;
+                        journal_record( JOURNAL_SENSOR_POWER, 0, 1 );
+                    }
                 }
             }
             else
             {
+                if( Error.sensor_power_fail )
+                    journal_record( JOURNAL_SENSOR_POWER, 0, 0 );
+
                 Error.sensor_power_fail    = FALSE;
                 Error.sensor_power_pending = FALSE;
                 Error.sensor_power_delay   = SUPPLY_POWER_DELAY_TIME;
@@ -325,7 +347,7 @@ Spi1_sr    = SPI1_SR;
             // If the 10vdc reference is low, check for the error condition.
             // Else; clear the error condition.
             //
-            if( coreDB.ten_volt_ref < SUPPLY_POWER_THRESHOLD )
+            if( sensorDB.ten_volt_ref < SUPPLY_POWER_THRESHOLD )
             {
                 if( Error.supply_power_pending == FALSE )
                 {
@@ -337,12 +359,18 @@ Spi1_sr    = SPI1_SR;
                     if( Error.supply_power_delay )
                         Error.supply_power_delay--;
 
-                    if( Error.supply_power_delay == 0 )
+                    if( (Error.supply_power_delay == 0) && !Error.supply_power_fail )
+                    {
                         Error.supply_power_fail = TRUE;
+                        journal_record( JOURNAL_SUPPLY_POWER, 0, 1 );
+                    }
                 }
             }
             else
             {
+                if( Error.supply_power_fail )
+                    journal_record( JOURNAL_SUPPLY_POWER, 0, 0 );
+
                 Error.supply_power_fail    = FALSE;
                 Error.supply_power_pending = FALSE;
                 Error.supply_power_delay   = SUPPLY_POWER_DELAY_TIME;
@@ -362,37 +390,108 @@ Spi1_sr    = SPI1_SR;
                 }
             }
 
+            TRACE_END( TRACE_MARK_SENSOR_CONVERT );
+            TRACE_BEGIN( TRACE_MARK_SENSOR_UPDATE );
+
+            // Publish the current sensor status data. This does not use
+            //    the mutex, readers get it with live_status_read(). Only
+            //    the sensors whose status changed are copied, and if
+            //    nothing changed the version is left as it is so that
+            //    readers and subscribers have nothing to do.
+            //
+            SensorSyncStats.cycles++;
+            dirty = SensorStatusDirty;
+            SensorStatusDirty = 0;
+
+            for( k=0; k<MAX_SENSORS; k++ )
+            {
+                if( dirty & SENSOR_BIT( k ) )
+                {
+                    if( SensorLiveStatus.sensor[k].fail != sensorDB.sensor[k].fail )
+                        journal_record( JOURNAL_SENSOR_FAIL, k, sensorDB.sensor[k].fail );
+
+                    SensorLiveStatus.sensor[k].value_int   = sensorDB.sensor[k].value_int;
+                    SensorLiveStatus.sensor[k].value_float = sensorDB.sensor[k].value_float;
+                    SensorLiveStatus.sensor[k].fail        = sensorDB.sensor[k].fail;
+                    SensorLiveStatus.sensor[k].signal      = sensorDB.sensor[k].signal;
+                    SensorSyncStats.status_bytes += sizeof( SENSOR_STATUS );
+                }
+            }
+
+            if(    (SensorLiveStatus.five_volt_ext != sensorDB.five_volt_ext)
+                || (SensorLiveStatus.ten_volt_ref  != sensorDB.ten_volt_ref)
+                || (SensorLiveStatus.cpu_temp      != sensorDB.cpu_temp) )
+            {
+                SensorLiveStatus.five_volt_ext = sensorDB.five_volt_ext;
+                SensorLiveStatus.ten_volt_ref  = sensorDB.ten_volt_ref;
+                SensorLiveStatus.cpu_temp      = sensorDB.cpu_temp;
+                SensorSyncStats.status_bytes += 3 * sizeof( float );
+                dirty |= SENSOR_SUPPLY_BIT;
+            }
+
+            if( dirty )
+            {
+                live_status_publish( &SensorLiveStatus );
+                db_publish( DB_BIT( DB_GROUP_SENSOR_STATUS ) );
+                SensorSyncStats.published++;
+            }
+
+            // The values of this cycle are now available, changed or not.
+            //    Run the control engines on them at once, see Control_Task.
+            //
+            SensorCycleStamp = SampleCompleteStamp;
+            _lwevent_set( &eventControlTask, (_mqx_uint) CTRL_SENSOR_CYCLE_EVENT );
+            TRACE_EVENT_SET( TRACE_EVENT_CONTROL, CTRL_SENSOR_CYCLE_EVENT );
+
+            // The first sensor values are available, networking
+            //    may now be started.
+            //
+            boot_stage_ready( BOOT_STAGE_SENSING );
+
             // If the mutex is succesfully locked (access is granted), update
-            //    the "sensorDB" with the core sensor setup data. Update 
-            //    the "coreDB" with the current sensor status data.
+            //    the "sensorDB" with the core sensor setup data. The task
+            //    never waits for the mutex; if it is busy, the setup data
+            //    is synchronized on the next sample cycle.
             //
-            if( _mutex_lock( &mutexCore ) == MQX_OK )
+            if( core_try_lock( CORE_SITE_SENSOR_UPDATE ) == MQX_OK )
             {
                 // Copy the sensor setup information for sensors 1, 2, and 3
-                //    from the core DB.
+                //    from the core DB, if it has changed.
                 //
-                for( k=SENSOR_ID_NONE; k<=SENSOR_ID_THREE; k++ )
-                    sensorDB.sensor[k].setup = coreDB.sensor[k].setup;
+                if( sensorDB.config_version != coreDB.config_version )
+                {
+                    for( k=SENSOR_ID_NONE; k<=SENSOR_ID_THREE; k++ )
+                        sensorDB.sensor[k].setup = coreDB.sensor[k].setup;
+
+                    sensorDB.config_version = coreDB.config_version;
+                }
 
                 // Copy the sensor setup information for Sn-d, HI-2, and HI-3
                 //    from the sensor DB -> the core DB. THESE ARE "virtual"
                 //    sensors and their state is determined by the sensor 
-                //    task.
-                for( k=SENSOR_ID_DIFF; k<=SENSOR_ID_HIGH_SIGNAL_3; k++ )
-                    coreDB.sensor[k].setup = sensorDB.sensor[k].setup;
+                //    task. Only those marked dirty are copied, and the
+                //    version only changes if one of them did.
+                dirty = SensorSetupDirty & SENSOR_VIRTUAL_BITS;
 
-                // Copy the current sensor status data TO the core DB
-                //
-                for( k=0; k<MAX_SENSORS; k++ )
+                if( dirty )
                 {
-                    coreDB.sensor[k].value_int   = sensorDB.sensor[k].value_int;
-                    coreDB.sensor[k].value_float = sensorDB.sensor[k].value_float;
-                    coreDB.sensor[k].fail        = sensorDB.sensor[k].fail;
-                    coreDB.sensor[k].signal      = sensorDB.sensor[k].signal;
+                    for( k=SENSOR_ID_DIFF; k<=SENSOR_ID_HIGH_SIGNAL_3; k++ )
+                    {
+                        if( dirty & SENSOR_BIT( k ) )
+                        {
+                            coreDB.sensor[k].setup = sensorDB.sensor[k].setup;
+                            SensorSyncStats.setup_bytes += sizeof( SENSOR_SETUP );
+                        }
+                    }
+
+                    sensorDB.config_version = ++coreDB.config_version;
+                    SensorSetupDirty &= ~dirty;
                 }
 
-                _mutex_unlock( &mutexCore );    // Unlock the mutex
+                core_unlock( CORE_SITE_SENSOR_UPDATE );    // Unlock the mutex
             }
+
+            TRACE_END( TRACE_MARK_SENSOR_UPDATE );
         }      // End - if( event_signal & ADC_SAMPLE_CYCLE_COMPLETE_MASK )
     }
 }
@@ -435,6 +534,7 @@ init_sensor_isr_handlers( void )
 void  pit_1_isr( uintptr_t /* pointer */ isr )
 {
     PIT_MemMapPtr  pit;
+    TMON_ISR_ENTER( TMON_ISR_PIT1 );
 
     // Get a pointer to the PIT registers
     pit = (PIT_MemMapPtr) PIT_BASE_PTR;
@@ -475,6 +575,8 @@ void  pit_1_isr( uintptr_t /* pointer */ isr )
             start_analog_conversion( Sample[IDX_ANA_CPU_TEMP].adc_cfg );
         break;
     }
+
+    TMON_ISR_EXIT( TMON_ISR_PIT1 );
 }
 
 
@@ -487,10 +589,13 @@ void  pit_1_isr( uintptr_t /* pointer */ isr )
 void adc0_isr( uintptr_t /* pointer */ isr )
 {
     uint32_t  raw_value;
+    TMON_ISR_ENTER( TMON_ISR_ADC0 );
 
     raw_value = ADC0_RA;   // Always read the ADC result register
 
     update_sample_state( raw_value );
+
+    TMON_ISR_EXIT( TMON_ISR_ADC0 );
 }
 
 
@@ -503,10 +608,13 @@ void adc0_isr( uintptr_t /* pointer */ isr )
 void adc1_isr( uintptr_t /* pointer */ isr )
 {
     uint32_t  raw_value;
+    TMON_ISR_ENTER( TMON_ISR_ADC1 );
 
     raw_value = ADC1_RA;   // Always read the ADC result register
 
     update_sample_state( raw_value );
+
+    TMON_ISR_EXIT( TMON_ISR_ADC1 );
 }
 
 
@@ -586,7 +694,9 @@ update_sample_state( uint32_t raw_value )
             SampleState  = STATE_SAMPLE_IDLE;
 
             stop_sample_sequence();  // Disable PIT 1, stop routine conversions
+            SampleCompleteStamp = TMON_CYCLE_COUNT();
             _lwevent_set( &eventSensorTask, (_mqx_uint) ADC_SAMPLE_CYCLE_COMPLETE_MASK );
+            TRACE_EVENT_SET( TRACE_EVENT_SENSOR, ADC_SAMPLE_CYCLE_COMPLETE_MASK );
         break;
 
         default:
@@ -202,6 +202,21 @@ typedef enum
 
 #define  MAX_ANA_INPUTS   IDX_ANA_CPU_TEMP + 1  
 
+// SENSOR_SYNC_STATS - What the Sensor_Task copied, to the live status
+//   and to coreDB, over all sample cycles. Shown by "lock".
+//
+typedef struct
+{
+    uint32_t  cycles;           // Sample cycles completed
+    uint32_t  published;        // Cycles in which something changed
+    uint32_t  status_bytes;     // Status bytes copied for publishing
+    uint32_t  setup_bytes;      // Setup bytes copied to coreDB
+
+}  SENSOR_SYNC_STATS;
+
+extern SENSOR_SYNC_STATS  SensorSyncStats;
+extern volatile uint32_t  SensorCycleStamp;
+
 
 void Sensor_Task( uint32_t data );
 
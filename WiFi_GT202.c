@@ -5,6 +5,11 @@
 #include "atheros_main.h"
 #include "WiFi_GT202.h"
 #include "string.h"
+#include "event_trace.h"
+#include "work_queue.h"
+#include "boot_stage.h"
+#include "config_store.h"
+#include "journal.h"
 
 #if (ENABLE_STACK_OFFLOAD == 1)
     #error This demo requires ENABLE_STACK_OFFLOAD = 0 in a_config.h.  Rebuild BSP after changing
@@ -30,6 +35,7 @@ static uint32_t set_cipher (uint32_t dev_num, char * u_cipher, char * m_cipher);
 void            wait_connect(WIFI_PARAMS_PTR params);
 _mqx_int        disconnect_wifi(void);
 void            wifi_flash_read(WIFI_PARAMS_PTR params);
+static void     wifi_connect_work(void * ctx, uint32_t val);
         
         
 /*FUNCTION*-------------------------------------------------------------
@@ -111,16 +117,42 @@ static uint32_t set_cipher
 *
 * Function Name  : wifi_Callback
 * Returned Value : N/A
-* Comments       : Called from driver on a WiFI connection event
+* Comments       : Called from driver on a WiFI connection event. This
+*                  runs in the driver's context, so the handling is
+*                  deferred to the Work_Task.
 *
 *END------------------------------------------------------------------*/
 void wifi_Callback(int val)
+{
+    if(val == A_TRUE || val == A_FALSE)
+    {
+        journal_record(JOURNAL_WIFI, 0, (val == A_TRUE) ? 1 : 0);
+    }
+
+    if(!work_queue_post(WORK_PRIO_LOW, wifi_connect_work, NULL, (uint32_t) val))
+    {
+        // Queue full, handle the event here rather than lose it
+        wifi_connect_work(NULL, (uint32_t) val);
+    }
+}
+
+/*FUNCTION*-----------------------------------------------------------------
+*
+* Function Name  : wifi_connect_work
+* Returned Value : N/A
+* Comments       : Deferred handling of a WiFI connection event, run by
+*                  the Work_Task. "val" is the value passed to
+*                  wifi_Callback().
+*
+*END------------------------------------------------------------------*/
+static void wifi_connect_work(void * ctx, uint32_t val)
 {
 
 	if(val == A_TRUE)
 	{
             wifi_set_property(gp_WIFI_Params, WIFI_WIFI_CONNECTED, TRUE);          
             printf("Connected to %s\n", gp_WIFI_Params->ssid);
+            boot_stage_ready(BOOT_STAGE_WIFI);
             
             #if DEMOCFG_ENABLE_DEVICECLOUD_IO
                   // Check if DCIO needs to be reconnected manually
@@ -138,6 +170,7 @@ void wifi_Callback(int val)
             #endif
                  
             _lwevent_set(&lwevent_wifi_connect, LWEVENT_WIFI_CONNECTED);            
+            TRACE_EVENT_SET(TRACE_EVENT_WIFI, LWEVENT_WIFI_CONNECTED);
 	}
         else if(val == A_FALSE)
         {
@@ -200,6 +233,8 @@ void wait_connect(WIFI_PARAMS_PTR params)
 
   _mqx_uint result;
   
+  TRACE_BEGIN(TRACE_MARK_WAIT_CONNECT);
+
   result = _lwevent_wait_ticks(&lwevent_wifi_connect, LWEVENT_WIFI_CONNECTED, FALSE, 2000);      // Wait 10 seconds to connect
     
   if(result == LWEVENT_WAIT_TIMEOUT)
@@ -224,6 +259,8 @@ void wait_connect(WIFI_PARAMS_PTR params)
           printf("Failed connecting to %s\n", params->ssid);
       }
   }
+
+  TRACE_END(TRACE_MARK_WAIT_CONNECT);
 }
 
 _mqx_uint wifi_params_init(void)
@@ -247,8 +284,14 @@ _mqx_uint wifi_params_init(void)
     if(gp_WIFI_Params == 0)
         return MQX_OUT_OF_MEMORY;
     
-    // Read params stored in flash
-    wifi_flash_read(gp_WIFI_Params);
+    // Read params from the configuration store. Params saved by earlier
+    // firmware are in the old Wi-Fi sector; they are moved to the store.
+    if(!cfg_store_read(CFG_KEY_WIFI_PARAMS, gp_WIFI_Params, sizeof(WIFI_PARAMS)))
+    {
+        wifi_flash_read(gp_WIFI_Params);
+        if(gp_WIFI_Params->ssid[0] != 0xFF)
+            cfg_store_write(CFG_KEY_WIFI_PARAMS, gp_WIFI_Params, sizeof(WIFI_PARAMS));
+    }
     
     
     // Check if Wi-Fi params are valied, or assign default params
@@ -483,35 +526,28 @@ void wifi_flash_read(WIFI_PARAMS_PTR params)
     
 }
 
+// Saves the Wi-Fi parameters in the configuration store. This appends
+// a record, the flash sector is not erased.
 void wifi_flash_program(WIFI_PARAMS_PTR params)
 {
-    uint32_t        ioctl_param;
-    _mqx_int        len = 0;
-    
-    /* Move to beginning */
-    fseek(flash_file, 1, IO_SEEK_SET);
-
-    /* Unprotecting  the FLASH might be required */
-    ioctl_param = 0;
-    ioctl(flash_file, FLASH_IOCTL_WRITE_PROTECT, &ioctl_param);
-
-    wifi_flash_erase(params);
-    
-    len = write(flash_file, params, sizeof(WIFI_PARAMS));
-    if (len != sizeof(WIFI_PARAMS)) {
-        printf("\nError writing Wi-Fi parameters to flash. Error code: %d", _io_ferror(flash_file));
+    if (!cfg_store_write(CFG_KEY_WIFI_PARAMS, params, sizeof(WIFI_PARAMS))) {
+        printf("\nError writing Wi-Fi parameters to flash.");
     }
 
-    wifi_flash_read(params);
+    cfg_store_read(CFG_KEY_WIFI_PARAMS, params, sizeof(WIFI_PARAMS));
     printf("Wi-Fi parameters loaded from flash are:\n");
     wifi_param_print(params);
 }
 
+// Erases the Wi-Fi parameters from the configuration store, and the
+// old Wi-Fi sector so that they are not moved to the store again.
 void wifi_flash_erase(WIFI_PARAMS_PTR params)
 {
     uint32_t        ioctl_param;
     _mqx_int        error;
     
+    cfg_store_erase(CFG_KEY_WIFI_PARAMS);
+
     /* Move to beginning */
     fseek(flash_file, 1, IO_SEEK_SET);
 
@@ -0,0 +1,335 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : analog_control.c
+
+PURPOSE   : PI controller for the analog outputs. analog_control_setup()
+            turns the ANALOG_SETUP of each output into the fixed point
+            constants the controller uses; the output counts at SP and
+            EP, the reciprocal of the band and the integration time.
+            analog_control_run() then evaluates every analog output once
+            per control event, without floating point or division by the
+            band.
+
+            The output is SP output + (EP output - SP output) * (P + I),
+            where P is the offset from SP as a fraction of the band and I
+            is P integrated over the integration time. P + I is limited to
+            the band, and the integral is not taken further while the
+            output is held at a limit (anti-windup).
+
+            The integral is taken every pass, but the output is only
+            worked out every "update_rate" seconds, and is only written
+            when it has moved by the output band or reached 0 or 100%.
+            Each write is sent to the module by the output commit stage.
+
+            When the setup changes, or the sensor comes back after a
+            failure, the integral is set so that the output carries on
+            from the value last written (bumpless transfer).
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "task_monitor.h"
+#include "analog_control.h"
+
+#define  ANALOG_DUE( now, deadline )   ((int32_t)((now) - (deadline)) >= 0)
+
+#define  PCT_TO_COUNTS( pct )   ((uint8_t)(((pct) * ANALOG_MAX_COUNTS + 50) / 100))
+
+ANALOG_ENGINE      AnalogEngine;
+
+
+// Function Prototypes - used by this module only
+//
+void      analog_align( ANALOG_ENGINE * engine, ANALOG_ENTRY * a, int32_t err );
+
+
+//
+//  analog_control_setup() - Rebuild the table from the output and sensor
+//                           setup in "db". An output whose setup changed
+//                           is aligned on its next pass. Called with
+//                           mutexCore locked.
+//
+void
+analog_control_setup( ANALOG_ENGINE * engine, const DATABASE * db )
+{
+    int                   k;
+    uint8_t               id;
+    uint16_t              ti;
+    uint8_t               sp_counts, ep_counts;
+    ANALOG_ENTRY        * a;
+    const ANALOG_SETUP  * setup;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        a     = &engine->analog[k];
+        setup = &db->output[k].setup.output.analog;
+        id    = setup->sensor_id;
+
+        if(    (db->output[k].setup.output_type != OUTPUT_TYPE_ANALOG)
+            || (id == SENSOR_ID_NONE) || (id > MAX_SENSOR_ID)
+            || (db->sensor[id].setup.sensor_type == SENSOR_TYPE_NONE)
+            || (setup->sp == setup->ep) )
+        {
+            a->flags = 0;
+            continue;
+        }
+
+        ti        = (setup->int_constant <= MAX_I_TERM) ? IntegrationTime[ setup->int_constant ] : 0;
+        sp_counts = PCT_TO_COUNTS( setup->sp_output );
+        ep_counts = PCT_TO_COUNTS( setup->ep_output );
+
+        if( !(a->flags & ANALOG_ACTIVE) )
+        {
+            a->written = db->output[k].output_state;
+            a->flags   = ANALOG_ACTIVE | ANALOG_ALIGN | ANALOG_FORCE;
+            a->update_deadline = 0;
+        }
+        else if(    (a->sp != setup->sp) || (a->ep != setup->ep) || (a->ti != ti)
+                 || (a->sp_counts != sp_counts) || (a->ep_counts != ep_counts) )
+        {
+            a->flags |= ANALOG_ALIGN;
+        }
+
+        a->sp          = setup->sp;
+        a->ep          = setup->ep;
+        a->span_inv    = (int32_t)(1L << 24) / (setup->ep - setup->sp);
+        a->ti          = ti;
+        a->sensor_id   = id;
+        a->sp_counts   = sp_counts;
+        a->ep_counts   = ep_counts;
+        a->band_counts = PCT_TO_COUNTS( setup->output_band );
+        a->update_rate = (setup->update_rate > 0) ? setup->update_rate : 1;
+        a->fail_counts = (setup->sensor_fail_mode == SENSOR_FAIL_ON) ? ep_counts : sp_counts;
+    }
+}
+
+
+//
+//  analog_control_restore() - Carry on from the outputs and update timers
+//                             in "db", as restored after a warm reset.
+//                             Called after analog_control_setup().
+//
+void
+analog_control_restore( ANALOG_ENGINE * engine, const DATABASE * db, uint32_t now )
+{
+    int             k;
+    ANALOG_ENTRY  * a;
+    const OUTPUT  * out;
+
+    engine->last_time = now;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        a   = &engine->analog[k];
+        out = &db->output[k];
+
+        if( !(a->flags & ANALOG_ACTIVE) )
+            continue;
+
+        a->written         = out->output_state;
+        a->update_deadline = now + out->update_timer;
+        a->flags          |= ANALOG_ALIGN;
+
+        if( out->force_update )
+            a->flags |= ANALOG_FORCE;
+    }
+}
+
+
+//
+//  analog_control_run() - One pass over all of the analog outputs, from
+//                         the value "input" of each.
+//
+void
+analog_control_run( ANALOG_ENGINE * engine, const SENSOR_STATUS * input, uint32_t now )
+{
+    int                    k;
+    uint32_t               dt;
+    uint32_t               start;
+    int32_t                err;
+    int32_t                u;
+    int                    output;
+    int                    change;
+    ANALOG_ENTRY         * a;
+    const SENSOR_STATUS  * sensor;
+
+    start = TMON_CYCLE_COUNT();
+
+    dt = now - engine->last_time;
+    engine->last_time = now;
+    if( dt > ANALOG_MAX_DT )
+        dt = ANALOG_MAX_DT;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        a = &engine->analog[k];
+
+        if( !(a->flags & ANALOG_ACTIVE) )
+            continue;
+
+        sensor = &input[k];
+
+        if( sensor->fail )
+        {
+            // Hold the fail mode output, and carry on from it without a
+            //    bump once the sensor is back.
+            //
+            output    = a->fail_counts;
+            a->flags |= ANALOG_ALIGN;
+        }
+        else
+        {
+            err = (int32_t)(((int64_t)(sensor->value_int - a->sp) * a->span_inv) >> 8);
+
+            if( err > ANALOG_ERROR_LIMIT )
+                err = ANALOG_ERROR_LIMIT;
+            else if( err < -ANALOG_ERROR_LIMIT )
+                err = -ANALOG_ERROR_LIMIT;
+
+            if( a->flags & ANALOG_ALIGN )
+                analog_align( engine, a, err );
+
+            u = err + (a->i_q24 >> 8);
+
+            if( a->ti )
+            {
+                if( ((u >= ANALOG_Q16_ONE) && (err > 0)) || ((u <= 0) && (err < 0)) )
+                {
+                    engine->windup_holds++;
+                }
+                else
+                {
+                    a->i_q24 += ((err * 256) / a->ti) * (int32_t)dt;
+
+                    if( a->i_q24 > ANALOG_Q24_ONE )
+                        a->i_q24 = ANALOG_Q24_ONE;
+                    else if( a->i_q24 < -ANALOG_Q24_ONE )
+                        a->i_q24 = -ANALOG_Q24_ONE;
+                }
+            }
+
+            if( u > ANALOG_Q16_ONE )
+                u = ANALOG_Q16_ONE;
+            else if( u < 0 )
+                u = 0;
+
+            output = a->sp_counts + ((((int32_t)a->ep_counts - a->sp_counts) * u + 0x8000) >> 16);
+        }
+
+        if( !ANALOG_DUE( now, a->update_deadline ) && !(a->flags & ANALOG_FORCE) )
+            continue;
+
+        a->update_deadline = now + a->update_rate;
+        engine->updates++;
+
+        change = output - a->written;
+        if( change < 0 )
+            change = -change;
+
+        if(    (a->flags & ANALOG_FORCE)
+            || ((change > 0) && (   (change >= a->band_counts)
+                                 || (output == 0) || (output == ANALOG_MAX_COUNTS))) )
+        {
+            a->written = (uint8_t) output;
+            a->flags  &= ~ANALOG_FORCE;
+            engine->writes++;
+        }
+        else if( change > 0 )
+        {
+            engine->suppressed++;
+        }
+    }
+
+    start = TMON_CYCLE_COUNT() - start;
+    if( start > engine->pass_max )
+        engine->pass_max = start;
+}
+
+
+//
+//  analog_control_store() - Put the output, integral and time to the next
+//                           update of each analog output into "db", and
+//                           take any request to force an update. Called
+//                           with mutexCore locked.
+//
+void
+analog_control_store( ANALOG_ENGINE * engine, DATABASE * db, uint32_t now )
+{
+    int             k;
+    int32_t         left;
+    OUTPUT        * out;
+    ANALOG_ENTRY  * a;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        a   = &engine->analog[k];
+        out = &db->output[k];
+
+        if( out->setup.output_type != OUTPUT_TYPE_ANALOG )
+            continue;
+
+        if( !(a->flags & ANALOG_ACTIVE) )
+        {
+            out->output_state = 0;
+            out->i_term       = 0.0;
+            out->update_timer = 0;
+            continue;
+        }
+
+        if( out->force_update )
+        {
+            a->flags |= ANALOG_FORCE;
+            out->force_update = FALSE;
+        }
+
+        left = (int32_t)(a->update_deadline - now);
+
+        out->desired_state = a->written;
+        out->output_state  = a->written;
+        out->i_term        = (float) a->i_q24 / ANALOG_Q24_ONE;
+        out->update_timer  = (left > 0) ? left : 0;
+    }
+}
+
+
+//
+//  analog_align() - Set the integral so that P + I gives the output last
+//                   written, for the offset "err". Without an integral
+//                   the output follows P at once.
+//
+void
+analog_align( ANALOG_ENGINE * engine, ANALOG_ENTRY * a, int32_t err )
+{
+    int32_t  u;
+
+    a->flags &= ~ANALOG_ALIGN;
+    a->i_q24  = 0;
+
+    if( (a->ti == 0) || (a->ep_counts == a->sp_counts) )
+        return;
+
+    u = ((int32_t)(a->written - a->sp_counts) << 16) / ((int32_t)a->ep_counts - a->sp_counts);
+
+    if( u > ANALOG_Q16_ONE )
+        u = ANALOG_Q16_ONE;
+    else if( u < 0 )
+        u = 0;
+
+    a->i_q24 = (u - err) * 256;
+
+    if( a->i_q24 > ANALOG_Q24_ONE )
+        a->i_q24 = ANALOG_Q24_ONE;
+    else if( a->i_q24 < -ANALOG_Q24_ONE )
+        a->i_q24 = -ANALOG_Q24_ONE;
+
+    engine->aligns++;
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : analog_control.h
+
+PURPOSE   : Definitions and function prototypes for the "analog_control.c"
+            module; the PI controller for the analog outputs, run by the
+            Control_Task together with the relay engine.
+
+            The controller works in fixed point. The offset from the
+            setpoint is a fraction of the proportional band, SP to EP, in
+            Q16 (65536 = the whole band), and the integral is kept in Q24
+            so that the slowest integration time still moves it by a few
+            counts a second.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __analog_control_inc
+#define  __analog_control_inc
+
+#include <mqx.h>
+#include "defines.h"
+#include "live_status.h"
+
+#define  ANALOG_Q16_ONE       0x00010000      // 1.0, the whole band
+#define  ANALOG_Q24_ONE       0x01000000
+#define  ANALOG_ERROR_LIMIT   (4 * ANALOG_Q16_ONE)  // Offset limit, in bands
+#define  ANALOG_MAX_DT        5               // Longest time integrated in
+                                              //   one pass, seconds
+#define  ANALOG_MAX_COUNTS    255             // output_state at 100%
+
+// Flags in ANALOG_ENTRY
+//
+#define  ANALOG_ACTIVE        0x01    // Analog output with a sensor
+#define  ANALOG_ALIGN         0x02    // Set the integral so that the output
+                                      //   carries on from "written"
+#define  ANALOG_FORCE         0x04    // Write at the next update
+
+// ANALOG_ENTRY - One output. Outputs are 0..ANALOG_MAX_COUNTS, as in
+//   OUTPUT.output_state.
+//
+typedef struct
+{
+    int16_t   sp;
+    int16_t   ep;
+    int32_t   span_inv;          // (1 << 24) / (ep - sp)
+    uint16_t  ti;                // Integration time, seconds, 0 = P only
+    uint8_t   sensor_id;
+    uint8_t   flags;             // ANALOG_xxx
+    uint8_t   sp_counts;         // Output at SP
+    uint8_t   ep_counts;         // Output at EP
+    uint8_t   band_counts;       // Smallest change written, 0 = any change
+    uint8_t   update_rate;       // Seconds between updates
+    uint8_t   fail_counts;       // Output when the sensor has failed
+    uint8_t   written;           // Output last written to the module
+
+    int32_t   i_q24;             // Integral, fraction of the band
+    uint32_t  update_deadline;   // SecCounter of the next update
+
+}  ANALOG_ENTRY;
+
+// ANALOG_ENGINE - The table of all outputs, and counts since reset shown
+//   by the "control" shell command.
+//
+typedef struct
+{
+    uint32_t      last_time;         // SecCounter of the last pass
+
+    uint32_t      updates;           // Updates that were due
+    uint32_t      writes;            // Updates that changed the output
+    uint32_t      suppressed;        // Changes smaller than the output band
+    uint32_t      windup_holds;      // Integrations skipped at a limit
+    uint32_t      aligns;            // Bumpless transfers
+    uint32_t      pass_max;          // Longest pass, cycles
+
+    ANALOG_ENTRY  analog[ MAX_OUTPUTS ];
+
+}  ANALOG_ENGINE;
+
+extern ANALOG_ENGINE   AnalogEngine;
+
+//
+//    Function Prototypes
+//
+void      analog_control_setup( ANALOG_ENGINE * engine, const DATABASE * db );
+void      analog_control_restore( ANALOG_ENGINE * engine, const DATABASE * db, uint32_t now );
+void      analog_control_run( ANALOG_ENGINE * engine, const SENSOR_STATUS * input, uint32_t now );
+void      analog_control_store( ANALOG_ENGINE * engine, DATABASE * db, uint32_t now );
+
+#endif
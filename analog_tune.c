@@ -0,0 +1,403 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : analog_tune.c
+
+PURPOSE   : Relay feedback auto-tuner of the analog outputs, run by the
+            Control_Task after the analog controller, on one output at a
+            time and in the fixed memory of AnalogTune.
+
+            While the test runs the output is driven from here instead of
+            from the PI controller, which is kept aligned to it so that it
+            carries on without a bump when the test ends. The first cycle
+            is not measured; the next TUNE_CYCLES give the period Tu and
+            the amplitude a of the oscillation. With a relay step d and
+            hysteresis h, the ultimate gain is
+
+              Ku = 4 d / (pi * sqrt( a^2 - h^2 ))
+
+            The PI settings use the Tyreus-Luyben rules, Kc = Ku / 3.2 and
+            Ti = 2.2 Tu, which overshoot less than Ziegler-Nichols. Kc is
+            turned into an EP with the SP, and the outputs at SP and EP
+            kept; Ti into the nearest Integration Constant; and the Update
+            Rate is Tu / 20, all within the ANALOG_SETUP limits.
+
+            After the test the time the loop takes to settle back on its
+            PI controller is measured. Running the test again after the
+            new settings are applied gives the settling time with them, to
+            compare with the one before.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <math.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "func.h"
+#include "analog_tune.h"
+
+#define  TUNE_DUE( now, deadline )   ((int32_t)((now) - (deadline)) >= 0)
+
+ANALOG_TUNE        AnalogTune;
+
+const char *       TuneStateName[ NUM_TUNE_STATES ] =
+{
+    "idle",               // TUNE_IDLE
+    "starting",           // TUNE_START
+    "relay test",         // TUNE_RELAY
+    "settling",           // TUNE_SETTLE
+    "done",               // TUNE_DONE
+    "failed"              // TUNE_FAILED
+};
+
+const char *       TuneErrorName[ NUM_TUNE_ERRS ] =
+{
+    "",                   // TUNE_ERR_NONE
+    "setup",              // TUNE_ERR_SETUP
+    "sensor failed",      // TUNE_ERR_SENSOR
+    "no oscillation",     // TUNE_ERR_TIMEOUT
+    "amplitude too small",  // TUNE_ERR_AMPLITUDE
+    "stopped"             // TUNE_ERR_STOPPED
+};
+
+
+// Function Prototypes - used by this module only
+//
+void      tune_start( ANALOG_TUNE * tune, const ANALOG_ENTRY * a, int16_t value, uint32_t now );
+void      tune_relay( ANALOG_TUNE * tune, int16_t value, uint32_t now );
+void      tune_result( ANALOG_TUNE * tune, const ANALOG_ENTRY * a );
+void      tune_settle( ANALOG_TUNE * tune, int16_t value, uint32_t now );
+void      tune_fail( ANALOG_TUNE * tune, ANALOG_ENTRY * a, uint8_t error );
+
+
+//
+//  analog_tune_run() - One pass of the test, after analog_control_run().
+//
+void
+analog_tune_run( ANALOG_TUNE * tune, ANALOG_ENGINE * engine, const SENSOR_STATUS * input, uint32_t now )
+{
+    ANALOG_ENTRY  * a;
+    int32_t         output;
+
+    if( (tune->state == TUNE_IDLE) || (tune->state == TUNE_DONE) || (tune->state == TUNE_FAILED) )
+        return;
+
+    a = &engine->analog[ tune->output ];
+
+    if( tune->stop )
+    {
+        tune->stop = FALSE;
+        tune_fail( tune, a, TUNE_ERR_STOPPED );
+        return;
+    }
+
+    if( !(a->flags & ANALOG_ACTIVE) || (a->sp_counts == a->ep_counts) )
+    {
+        tune_fail( tune, a, TUNE_ERR_SETUP );
+        return;
+    }
+
+    if( input[ tune->output ].fail )
+    {
+        tune_fail( tune, a, TUNE_ERR_SENSOR );
+        return;
+    }
+
+    if( tune->state == TUNE_START )
+        tune_start( tune, a, input[ tune->output ].value_int, now );
+
+    if( tune->state == TUNE_SETTLE )
+    {
+        tune_settle( tune, input[ tune->output ].value_int, now );
+        return;
+    }
+
+    tune_relay( tune, input[ tune->output ].value_int, now );
+
+    if( tune->cycles >= TUNE_CYCLES )
+    {
+        tune_result( tune, a );
+        return;
+    }
+
+    if( TUNE_DUE( now, tune->started + TUNE_MAX_TIME ) )
+    {
+        tune_fail( tune, a, TUNE_ERR_TIMEOUT );
+        return;
+    }
+
+    // Drive the output from the relay, and keep the PI controller aligned
+    //    to it.
+    //
+    output = tune->bias + ((tune->high ? tune->sign : -tune->sign) * tune->step);
+
+    if( output < 0 )
+        output = 0;
+    else if( output > ANALOG_MAX_COUNTS )
+        output = ANALOG_MAX_COUNTS;
+
+    a->written = (uint8_t) output;
+    a->flags  |= ANALOG_ALIGN;
+}
+
+
+//
+//  analog_tune_store() - Write the result of the test into the setup of
+//                        its output, if asked to and it is valid. Called
+//                        with mutexCore locked.
+//
+void
+analog_tune_store( ANALOG_TUNE * tune, DATABASE * db )
+{
+    ANALOG_SETUP             setup;
+    const SETPOINT_LIMITS  * limits;
+    int32_t                  ep;
+    int                      type;
+
+    if( !tune->apply )
+        return;
+
+    tune->apply = FALSE;
+
+    if( tune->state != TUNE_DONE )
+        return;
+
+    setup  = db->output[ tune->output ].setup.output.analog;
+    type   = get_sensor_type_from_id( db, setup.sensor_id );
+    limits = get_setpoint_limits( type, setup.sensor_id );
+
+    // Keep EP on its side of SP, at least the minimum difference away.
+    //
+    ep = tune->new_ep;
+
+    if( (setup.ep > setup.sp) && (ep < setup.sp + limits->min_diff) )
+        ep = setup.sp + limits->min_diff;
+    else if( (setup.ep < setup.sp) && (ep > setup.sp - limits->min_diff) )
+        ep = setup.sp - limits->min_diff;
+
+    if( ep > limits->max_sp )
+        ep = limits->max_sp;
+    else if( ep < limits->min_sp )
+        ep = limits->min_sp;
+
+    setup.ep           = (int16_t) ep;
+    setup.int_constant = tune->new_int_constant;
+    setup.update_rate  = tune->new_update_rate;
+
+    if( (setup.ep == setup.sp) || !check_analog_setup( db, &setup, type, tune->output + 1, NULL ) )
+    {
+        tune->state = TUNE_FAILED;
+        tune->error = TUNE_ERR_SETUP;
+        return;
+    }
+
+    db->output[ tune->output ].setup.output.analog = setup;
+    db->config_version++;
+
+    tune->new_ep = ep;
+    tune->save   = TRUE;
+    tune->state  = TUNE_IDLE;
+    tune->applied++;
+}
+
+
+//
+//  tune_start() - Start the relay test from the output as it is now.
+//
+void
+tune_start( ANALOG_TUNE * tune, const ANALOG_ENTRY * a, int16_t value, uint32_t now )
+{
+    int32_t  h;
+
+    tune->state        = TUNE_RELAY;
+    tune->error        = TUNE_ERR_NONE;
+    tune->sp           = a->sp;
+    tune->bias         = a->written;
+    tune->step         = (uint8_t)((tune->step_pct * ANALOG_MAX_COUNTS + 50) / 100);
+    tune->sign         = ((a->ep_counts > a->sp_counts) == (a->ep > a->sp)) ? 1 : -1;
+    tune->high         = (value > a->sp);
+    tune->started      = now;
+    tune->last_up      = now;
+    tune->crossings    = 0;
+    tune->cycles       = 0;
+    tune->peak_max     = value;
+    tune->peak_min     = value;
+    tune->period_total = 0;
+    tune->swing_total  = 0;
+
+    if( tune->hysteresis <= 0 )
+    {
+        h = (a->ep > a->sp) ? (a->ep - a->sp) / 20 : (a->sp - a->ep) / 20;
+        tune->hysteresis = (h > 0) ? (int16_t) h : 1;
+    }
+
+    tune->runs++;
+}
+
+
+//
+//  tune_relay() - Follow the value; count a cycle at each crossing above
+//                 SP + hysteresis, after the first.
+//
+void
+tune_relay( ANALOG_TUNE * tune, int16_t value, uint32_t now )
+{
+    if( value > tune->peak_max )
+        tune->peak_max = value;
+
+    if( value < tune->peak_min )
+        tune->peak_min = value;
+
+    if( tune->high )
+    {
+        if( value < tune->sp - tune->hysteresis )
+            tune->high = FALSE;
+        return;
+    }
+
+    if( value <= tune->sp + tune->hysteresis )
+        return;
+
+    tune->high = TRUE;
+
+    if( tune->crossings >= 2 )
+    {
+        tune->period_total += now - tune->last_up;
+        tune->swing_total  += tune->peak_max - tune->peak_min;
+        tune->cycles++;
+    }
+
+    if( tune->crossings < 255 )
+        tune->crossings++;
+
+    tune->last_up  = now;
+    tune->peak_max = value;
+    tune->peak_min = value;
+}
+
+
+//
+//  tune_result() - Work out Ku and Tu from the cycles measured, and the
+//                  setup they call for, then let the PI controller have
+//                  the output back.
+//
+void
+tune_result( ANALOG_TUNE * tune, const ANALOG_ENTRY * a )
+{
+    float     amplitude, h, ku, kc, ti, best, ratio;
+    int32_t   span;
+    int32_t   rate;
+    int       k;
+
+    amplitude = (float) tune->swing_total / (2.0f * tune->cycles);
+    h         = (float) tune->hysteresis;
+
+    if( amplitude <= h )
+    {
+        tune->state = TUNE_FAILED;
+        tune->error = TUNE_ERR_AMPLITUDE;
+        return;
+    }
+
+    ku       = (4.0f * tune->step) / (3.14159265f * sqrtf( amplitude * amplitude - h * h ));
+    tune->tu = (uint16_t)((tune->period_total + tune->cycles / 2) / tune->cycles);
+    if( tune->tu == 0 )
+        tune->tu = 1;
+
+    tune->ku_q8 = (uint32_t)(ku * 256.0f + 0.5f);
+
+    kc = ku / 3.2f;
+    ti = 2.2f * tune->tu;
+
+    // Kc is counts per unit; the band SP to EP gives the output span.
+    //
+    span = (int32_t)a->ep_counts - a->sp_counts;
+    tune->new_ep = a->sp + (int32_t)((span * tune->sign) / kc + ((span * tune->sign > 0) ? 0.5f : -0.5f));
+
+    // The Integration Constant whose time is nearest Ti, by ratio.
+    //
+    tune->new_int_constant = I_TERM_1;
+    best = 0.0f;
+    for( k=I_TERM_1; k<=MAX_I_TERM; k++ )
+    {
+        ratio = (IntegrationTime[k] > ti) ? ti / IntegrationTime[k] : IntegrationTime[k] / ti;
+        if( ratio > best )
+        {
+            best = ratio;
+            tune->new_int_constant = k;
+        }
+    }
+
+    rate = tune->tu / 20;
+    if( rate < MIN_UPDATE_RATE )
+        rate = MIN_UPDATE_RATE;
+    else if( rate > MAX_UPDATE_RATE )
+        rate = MAX_UPDATE_RATE;
+    tune->new_update_rate = (uint8_t) rate;
+
+    tune->state        = TUNE_SETTLE;
+    tune->settle_start = tune->last_up;
+    tune->settle_in    = 0;
+}
+
+
+//
+//  tune_settle() - Time how long the value takes to stay within twice
+//                  the hysteresis of SP for TUNE_SETTLE_HOLD seconds.
+//
+void
+tune_settle( ANALOG_TUNE * tune, int16_t value, uint32_t now )
+{
+    int32_t  off = value - tune->sp;
+
+    if( off < 0 )
+        off = -off;
+
+    if( off > 2 * tune->hysteresis )
+    {
+        tune->settle_in = 0;
+    }
+    else if( tune->settle_in == 0 )
+    {
+        tune->settle_in = now ? now : 1;
+    }
+    else if( TUNE_DUE( now, tune->settle_in + TUNE_SETTLE_HOLD ) )
+    {
+        tune->settle_last = tune->settle_time;
+        tune->settle_time = tune->settle_in - tune->settle_start;
+        tune->state       = TUNE_DONE;
+        return;
+    }
+
+    if( TUNE_DUE( now, tune->settle_start + TUNE_MAX_SETTLE ) )
+    {
+        tune->settle_last = tune->settle_time;
+        tune->settle_time = TUNE_MAX_SETTLE;
+        tune->state       = TUNE_DONE;
+    }
+}
+
+
+//
+//  tune_fail() - End the test. The output goes back to the PI controller,
+//                which carries on from the output last written.
+//
+void
+tune_fail( ANALOG_TUNE * tune, ANALOG_ENTRY * a, uint8_t error )
+{
+    if( (tune->state == TUNE_RELAY) && (a->flags & ANALOG_ACTIVE) )
+    {
+        a->written = tune->bias;
+        a->flags  |= ANALOG_ALIGN | ANALOG_FORCE;
+    }
+
+    tune->state = TUNE_FAILED;
+    tune->error = error;
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : analog_tune.h
+
+PURPOSE   : Definitions and function prototypes for the "analog_tune.c"
+            module; the relay feedback auto-tuner of the analog outputs.
+
+            One output at a time is taken off its PI controller and
+            switched between "bias" + and - "step" each time its sensor
+            crosses SP by the hysteresis, so that the loop oscillates at
+            its ultimate period. The amplitude and period of the
+            oscillation give the ultimate gain and period, and from them
+            the EP, Integration Constant and Update Rate of the output.
+            These are only written into the setup when asked for.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __analog_tune_inc
+#define  __analog_tune_inc
+
+#include <mqx.h>
+#include "defines.h"
+#include "live_status.h"
+#include "analog_control.h"
+
+#define  TUNE_DEFAULT_STEP      20      // Relay step, % of the output
+#define  TUNE_CYCLES            3       // Cycles measured, after the first
+#define  TUNE_MAX_TIME          (4 * 3600)   // Seconds, for the relay test
+#define  TUNE_SETTLE_HOLD       120     // Seconds within the band to count
+                                        //   as settled
+#define  TUNE_MAX_SETTLE        (2 * 3600)   // Seconds
+
+// States, see ANALOG_TUNE
+//
+enum{  TUNE_IDLE,
+       TUNE_START,              // Asked for by the shell
+       TUNE_RELAY,              // Relay test running
+       TUNE_SETTLE,             // Back on PI, timing how long it settles
+       TUNE_DONE,               // Result ready to apply
+       TUNE_FAILED,
+       NUM_TUNE_STATES  };
+
+// Why a test failed
+//
+enum{  TUNE_ERR_NONE,
+       TUNE_ERR_SETUP,          // Not an active analog output, or the new
+                                //   setup is not valid
+       TUNE_ERR_SENSOR,         // Sensor failed during the test
+       TUNE_ERR_TIMEOUT,        // No steady oscillation in TUNE_MAX_TIME
+       TUNE_ERR_AMPLITUDE,      // Oscillation not above the hysteresis
+       TUNE_ERR_STOPPED,
+       NUM_TUNE_ERRS  };
+
+// ANALOG_TUNE - The test of one output, and its result. Values are in
+//   the units of value_int, outputs in counts, 0..ANALOG_MAX_COUNTS.
+//
+//   The shell fills in "output", "step_pct" and "hysteresis" and then
+//   sets TUNE_START, or sets "stop" or "apply"; the Control_Task does the
+//   rest.
+//
+typedef struct
+{
+    uint8_t   state;             // TUNE_xxx
+    uint8_t   error;             // TUNE_ERR_xxx
+    uint8_t   output;            // 0..MAX_OUTPUTS-1
+    uint8_t   step_pct;
+    int16_t   hysteresis;        // 0 = 5% of SP to EP
+    bool      stop;
+    bool      apply;
+    bool      save;              // Setup changed, save it after the unlock
+
+    int16_t   sp;
+    uint8_t   bias;              // Output when the test started
+    uint8_t   step;
+    int8_t    sign;              // +1 when the output rises with the value
+    bool      high;              // Value last crossed above SP
+    uint32_t  started;           // SecCounter
+    uint32_t  last_up;           // SecCounter of the last crossing above
+    uint8_t   crossings;         // Crossings above SP
+    uint8_t   cycles;            // Cycles measured
+    int16_t   peak_max;          // This cycle
+    int16_t   peak_min;
+    uint32_t  period_total;      // Seconds, the cycles measured
+    uint32_t  swing_total;       // Peak to peak, the cycles measured
+
+    uint32_t  ku_q8;             // Ultimate gain, counts per unit, Q8
+    uint16_t  tu;                // Ultimate period, seconds
+    int32_t   new_ep;
+    uint8_t   new_int_constant;
+    uint8_t   new_update_rate;
+
+    uint32_t  settle_start;      // SecCounter the test ended
+    uint32_t  settle_in;         // SecCounter the value came into the band
+    uint32_t  settle_time;       // Seconds, this test; TUNE_MAX_SETTLE = not
+    uint32_t  settle_last;       //   settled; and the test before
+
+    uint32_t  runs;
+    uint32_t  applied;
+
+}  ANALOG_TUNE;
+
+extern ANALOG_TUNE      AnalogTune;
+extern const char *     TuneStateName[ NUM_TUNE_STATES ];
+extern const char *     TuneErrorName[ NUM_TUNE_ERRS ];
+
+//
+//    Function Prototypes
+//
+void      analog_tune_run( ANALOG_TUNE * tune, ANALOG_ENGINE * engine, const SENSOR_STATUS * input,
+                           uint32_t now );
+void      analog_tune_store( ANALOG_TUNE * tune, DATABASE * db );
+
+#endif
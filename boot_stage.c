@@ -0,0 +1,188 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : boot_stage.c
+
+PURPOSE   : Dependency ordered start-up. boot_run() is called by the
+            Init_Task and walks BootStageTable[] (see Init_Task.c),
+            starting each stage once every stage it depends on is
+            ready. While it waits it blocks, so stages that do not
+            depend on one another run in parallel in their own tasks.
+
+            A stage whose dependencies are still not ready at its
+            "wait_ms" time is started anyway, and flagged as late, so
+            that a failed sensor cannot keep the network from starting.
+
+            The time each stage starts and becomes ready is kept in
+            BootStatus[] and also passed to boot_profile_output(), so
+            the "boot" shell command can list the application stages
+            alongside the Atheros driver's boot events.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <mqx.h>
+#include <bsp.h>
+#include <lwevent.h>
+
+#include "defines.h"
+#include "boot_stage.h"
+
+#define  BOOT_EVENT_READY   0x01
+
+BOOT_STATUS         BootStatus[ MAX_BOOT_STAGE ];
+volatile uint32_t   BootReady;          // BOOT_BIT()s of the ready stages
+LWEVENT_STRUCT      eventBoot;
+
+extern void boot_profile_output( uint_32 signal );
+
+
+// Function Prototypes - used by this module only
+//
+uint32_t  boot_time_ms( void );
+void      boot_stage_start( int stage, bool late );
+
+
+//
+//  boot_run() - Start all of the stages in BootStageTable[], each one
+//               as soon as its dependencies are ready. Returns once
+//               every stage with a start function has been started.
+//
+void
+boot_run( void )
+{
+    const BOOT_STAGE * stage;
+    uint32_t           now, wait_ms, ticks;
+    bool               progress;
+    int                k, pending;
+
+    if( _lwevent_create( &eventBoot, LWEVENT_AUTO_CLEAR ) != MQX_OK ) { _mqx_exit( 1L ); }
+
+    while( TRUE )
+    {
+        now      = boot_time_ms();
+        wait_ms  = 0;
+        pending  = 0;
+        progress = FALSE;
+
+        for( k = 0; k < MAX_BOOT_STAGE; k++ )
+        {
+            stage = &BootStageTable[k];
+
+            if( (stage->start == NULL) || (BootStatus[k].state != BOOT_STATE_WAITING) )
+                continue;
+
+            if( (BootReady & stage->depends) == stage->depends )
+            {
+                boot_stage_start( k, FALSE );
+                progress = TRUE;
+            }
+            else if( stage->wait_ms && (now >= stage->wait_ms) )
+            {
+                boot_stage_start( k, TRUE );
+                progress = TRUE;
+            }
+            else
+            {
+                pending++;
+
+                // Wake up in time for the earliest "wait_ms"
+                //
+                if( stage->wait_ms && ((wait_ms == 0) || (stage->wait_ms - now < wait_ms)) )
+                    wait_ms = stage->wait_ms - now;
+            }
+        }
+
+        // A stage that was just started may be ready already, which
+        //    may let a stage earlier in the table start.
+        //
+        if( progress )
+            continue;
+
+        if( pending == 0 )
+            break;
+
+        ticks = (wait_ms * _time_get_ticks_per_sec() + 999) / 1000;
+
+        _lwevent_wait_ticks( &eventBoot, BOOT_EVENT_READY, FALSE, ticks );
+    }
+}
+
+
+//
+//  boot_stage_ready() - Signal that a stage is ready. Called by the code
+//                       a stage started, from any task. Only the first
+//                       call for each stage has any effect.
+//
+void
+boot_stage_ready( BOOT_STAGE_ID stage )
+{
+    uint32_t  now;
+
+    if( BootStatus[ stage ].state == BOOT_STATE_READY )
+        return;
+
+    now = boot_time_ms();
+
+    _int_disable();
+
+    if( BootStatus[ stage ].state == BOOT_STATE_READY )
+    {
+        _int_enable();
+        return;
+    }
+
+    BootStatus[ stage ].state    = BOOT_STATE_READY;
+    BootStatus[ stage ].ready_ms = now;
+    BootReady |= BOOT_BIT( stage );
+
+    _int_enable();
+
+    boot_profile_output( BOOT_PROFILE_APP_BASE + stage );
+
+    _lwevent_set( &eventBoot, BOOT_EVENT_READY );
+}
+
+
+//
+//  boot_stage_is_ready() - Returns TRUE if the stage has signalled ready.
+//
+bool
+boot_stage_is_ready( BOOT_STAGE_ID stage )
+{
+    return( (BootReady & BOOT_BIT( stage )) != 0 );
+}
+
+
+//
+//  boot_stage_start() - Call the start function of one stage.
+//
+void
+boot_stage_start( int stage, bool late )
+{
+    BootStatus[ stage ].state    = BOOT_STATE_STARTED;
+    BootStatus[ stage ].late     = late;
+    BootStatus[ stage ].start_ms = boot_time_ms();
+
+    BootStageTable[ stage ].start();
+
+    if( BootStageTable[ stage ].ready_on_start )
+        boot_stage_ready( (BOOT_STAGE_ID) stage );
+}
+
+
+//
+//  boot_time_ms() - Milliseconds since reset.
+//
+uint32_t
+boot_time_ms( void )
+{
+    TIME_STRUCT  time;
+
+    _time_get_elapsed( &time );
+
+    return( time.SECONDS * 1000 + time.MILLISECONDS );
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : boot_stage.h
+
+PURPOSE   : Definitions and function prototypes for the "boot_stage.c"
+            module. Start-up is divided into stages, each of which
+            declares the stages it depends on. A stage is started as
+            soon as all of its dependencies are ready, so sensing and
+            relay control are running before the Wi-Fi module has even
+            been initialized.
+
+            Some stages are ready as soon as they have been started
+            (their tasks have been created). Others are ready only when
+            the code they start signals it with boot_stage_ready(), for
+            example when the first sensor values are in coreDB.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __boot_stage_inc
+#define  __boot_stage_inc
+
+#include <mqx.h>
+
+// Boot stages, in the order they are listed in BootStageTable[].
+//
+typedef enum
+{
+    BOOT_STAGE_CORE      = 0,   // mutexCore, GPIO, globals
+    BOOT_STAGE_MONITOR   = 1,   // Task monitor and event trace
+    BOOT_STAGE_WORK      = 2,   // Work queue, Work_Task and Flash_Task
+    BOOT_STAGE_SCHEDULER = 3,   // PIT0 periodic task events
+    BOOT_STAGE_SENSING   = 4,   // Sensor_Task, ready at first sensor values
+    BOOT_STAGE_CONTROL   = 5,   // HVAC, relay control and button tasks
+    BOOT_STAGE_SHELL     = 6,   // Serial shell
+    BOOT_STAGE_NETWORK   = 7,   // wmiconfig tasks, ready when RTCS is up
+    BOOT_STAGE_WIFI      = 8,   // Signalled when Wi-Fi first connects
+    BOOT_STAGE_HTTP      = 9    // Signalled when the web server is started
+
+}  BOOT_STAGE_ID;
+
+#define  MAX_BOOT_STAGE   BOOT_STAGE_HTTP + 1
+
+#define  BOOT_BIT( stage )    (1 << (stage))
+
+// The boot stages are also recorded by boot_profile_output(), after the
+//   Atheros driver's own BOOT_PROFILE_* events, so that "boot" shows a
+//   single time line.
+//
+#define  BOOT_PROFILE_APP_BASE   10
+
+// BOOT_STAGE - One entry in the boot stage table.
+//
+typedef struct
+{
+    const char * name;
+    uint32_t     depends;      // BOOT_BIT()s of the stages that must be ready
+    uint32_t     wait_ms;      // Start anyway after this long, 0 = wait forever
+    void      (* start)( void );   // NULL = signalled by other code only
+    bool         ready_on_start;   // TRUE = ready once start() returns
+}  BOOT_STAGE;
+
+typedef enum
+{
+    BOOT_STATE_WAITING = 0,    // Dependencies not yet ready
+    BOOT_STATE_STARTED = 1,    // start() called, not yet ready
+    BOOT_STATE_READY   = 2
+
+}  BOOT_STATE;
+
+// BOOT_STATUS - Progress of one stage. Times are msec since reset.
+//
+typedef struct
+{
+    BOOT_STATE   state;
+    bool         late;          // Started before its dependencies were ready
+    uint32_t     start_ms;
+    uint32_t     ready_ms;
+}  BOOT_STATUS;
+
+extern const BOOT_STAGE  BootStageTable[ MAX_BOOT_STAGE ];
+extern BOOT_STATUS       BootStatus[ MAX_BOOT_STAGE ];
+
+//
+//    Function Prototypes
+//
+void      boot_run( void );
+void      boot_stage_ready( BOOT_STAGE_ID stage );
+bool      boot_stage_is_ready( BOOT_STAGE_ID stage );
+
+#endif
@@ -32,6 +32,9 @@ _mqx_int  cgi_status_data( HTTPSRV_CGI_REQ_STRUCT * param );
 _mqx_int  cgi_adc_data( HTTPSRV_CGI_REQ_STRUCT * param );
 _mqx_int  cgi_web_data ( HTTPSRV_CGI_REQ_STRUCT * param);
 _mqx_int  cgi_write_relay ( HTTPSRV_CGI_REQ_STRUCT * param);
+_mqx_int  cgi_task_data( HTTPSRV_CGI_REQ_STRUCT * param );
+_mqx_int  cgi_trace_data( HTTPSRV_CGI_REQ_STRUCT * param );
+_mqx_int  cgi_journal_data( HTTPSRV_CGI_REQ_STRUCT * param );
 
 _mqx_int cgi_index(HTTPSRV_CGI_REQ_STRUCT* param);
 _mqx_int cgi_hvac_data(HTTPSRV_CGI_REQ_STRUCT* param);
@@ -29,6 +29,8 @@
 #include "hvac_public.h"
 #include "httpsrv.h"
 #include "cgi.h"
+#include "event_trace.h"
+#include "HVAC_Zone.h"
 
 #include <string.h>
 
@@ -37,50 +39,73 @@ static int hvac_get_varval(char *var_str, char *var_name, char *var_val, _mqx_in
 _mqx_int cgi_hvac_data(HTTPSRV_CGI_REQ_STRUCT* param)
 {
     HTTPSRV_CGI_RES_STRUCT response;
-    uint32_t Td = HVAC_GetDesiredTemperature();
-    uint32_t Ta = HVAC_GetActualTemperature();
+    uint32_t Td;
+    int32_t  Ta;
+    uint32_t zone = 0;
     uint32_t length = 0;
     uint32_t size = 0;
     char* str = NULL;
+    char  z[10];
+    char  actual[20];
     
     if (param->request_method != HTTPSRV_REQ_GET)
     {
         return(0);
     }
+
+    // "hvacdata.cgi?zone=<n>" for a zone other than the thermostat
+    if ((param->query_string != NULL) && hvac_get_varval(param->query_string, "zone", z, sizeof(z)))
+    {
+        if ((sscanf(z, "%u", &zone) != 1) || (zone >= HVAC_GetZoneCount()))
+        {
+            zone = 0;
+        }
+    }
+
+    Td = HVAC_GetZoneDesiredTemperature(zone);
+    Ta = HVAC_GetZoneActualTemperature(zone);
+    if (Ta == HVAC_ZONE_NO_TEMP)
+    {
+        snprintf(actual, sizeof(actual), "n/a");
+    }
+    else
+    {
+        // Below 0 the sign is written on its own, as -0.5 is -5 tenths
+        snprintf(actual, sizeof(actual), "%s%d.%d &deg;%c", (Ta < 0) ? "-" : "",
+                 (Ta < 0 ? -Ta : Ta)/10, (Ta < 0 ? -Ta : Ta)%10, HVAC_GetTemperatureSymbol());
+    }
+
+    TRACE_BEGIN( TRACE_MARK_CGI_HVAC_DATA );
     
     response.ses_handle = param->ses_handle;
     response.content_type = HTTPSRV_CONTENT_TYPE_PLAIN;
     response.status_code = 200;
     
-    size = snprintf(NULL, 0, "%d.%d &deg;%c\n%d.%d &deg;%c\n%s\n%s\n%s\n%s\n%s\n",
-                     Ta/10,
-                     Ta%10,
-                     HVAC_GetTemperatureSymbol(),
+    size = snprintf(NULL, 0, "%s\n%d.%d &deg;%c\n%s\n%s\n%s\n%s\n%s\n",
+                     actual,
                      Td/10,
                      Td%10,
                      HVAC_GetTemperatureSymbol(), 
-                     HVAC_GetFanMode() == Fan_Automatic ? "auto" : "on", 
-                     HVAC_GetOutput(HVAC_FAN_OUTPUT) ? "on" : "off",
-                     HVAC_GetOutput(HVAC_COOL_OUTPUT) ? "on" : "off",
-                     HVAC_GetOutput(HVAC_HEAT_OUTPUT) ? "on" : "off",
-                     HVAC_HVACModeName(HVAC_GetHVACMode()));
+                     HVAC_GetZoneFanMode(zone) == Fan_Automatic ? "auto" : "on", 
+                     HVAC_GetZoneOutput(zone, HVAC_FAN_OUTPUT) ? "on" : "off",
+                     HVAC_GetZoneOutput(zone, HVAC_COOL_OUTPUT) ? "on" : "off",
+                     HVAC_GetZoneOutput(zone, HVAC_HEAT_OUTPUT) ? "on" : "off",
+                     HVAC_HVACModeName(HVAC_GetZoneHVACMode(zone)));
     size += 1;
 
     str = _mem_alloc(sizeof(char)*size);
     if (str != NULL)
     {
-        length = snprintf(str, size, "%d.%d &deg;%c\n%d.%d &deg;%c\n%s\n%s\n%s\n%s\n%s\n",
-                     Ta/10,
-                     Ta%10,
-                     HVAC_GetTemperatureSymbol(),
+        length = snprintf(str, size, "%s\n%d.%d &deg;%c\n%s\n%s\n%s\n%s\n%s\n",
+                     actual,
                      Td/10,
                      Td%10,
                      HVAC_GetTemperatureSymbol(), 
-                     HVAC_GetFanMode() == Fan_Automatic ? "auto" : "on", 
-                     HVAC_GetOutput(HVAC_FAN_OUTPUT) ? "on" : "off",
-                     HVAC_GetOutput(HVAC_COOL_OUTPUT) ? "on" : "off",
-                     HVAC_GetOutput(HVAC_HEAT_OUTPUT) ? "on" : "off",
-                     HVAC_HVACModeName(HVAC_GetHVACMode()));
+                     HVAC_GetZoneFanMode(zone) == Fan_Automatic ? "auto" : "on", 
+                     HVAC_GetZoneOutput(zone, HVAC_FAN_OUTPUT) ? "on" : "off",
+                     HVAC_GetZoneOutput(zone, HVAC_COOL_OUTPUT) ? "on" : "off",
+                     HVAC_GetZoneOutput(zone, HVAC_HEAT_OUTPUT) ? "on" : "off",
+                     HVAC_HVACModeName(HVAC_GetZoneHVACMode(zone)));
 
         response.data = str;
         response.data_length = length;
@@ -98,6 +123,7 @@ _mqx_int cgi_hvac_data(HTTPSRV_CGI_REQ_STRUCT* param)
     {
         _mem_free(str);
     }
+    TRACE_END( TRACE_MARK_CGI_HVAC_DATA );
     return (response.content_length);
 }
 
@@ -109,9 +135,12 @@ _mqx_int cgi_hvac_output(HTTPSRV_CGI_REQ_STRUCT* param)
     char     unit[10];
     char     fan[10];
     char     t[40];
+    char     z[10];
+    uint32_t  zone = 0;
     uint32_t  temp = 0;
     uint32_t  temp_fract = 0;
     bool  bParams = FALSE; 
+    bool  bZoneOk = TRUE;
     char     buffer[100];
     HTTPSRV_CGI_RES_STRUCT response;
     
@@ -119,6 +148,8 @@ _mqx_int cgi_hvac_output(HTTPSRV_CGI_REQ_STRUCT* param)
     {
         return(0);
     }
+
+    TRACE_BEGIN( TRACE_MARK_CGI_HVAC_OUT );
     
     len = param->content_length;
     len = HTTPSRV_cgi_read(param->ses_handle, buffer, (len > sizeof(buffer)) ? sizeof(buffer) : len);
@@ -135,18 +166,29 @@ _mqx_int cgi_hvac_output(HTTPSRV_CGI_REQ_STRUCT* param)
             hvac_get_varval(buffer, "fan", fan, sizeof(fan))) {
             
             bParams =  TRUE;
-         
+
+            // An optional "zone" addresses a zone other than the thermostat.
+            // A zone that does not exist changes nothing.
+            if (hvac_get_varval(buffer, "zone", z, sizeof(z)) &&
+                ((sscanf(z, "%u", &zone) != 1) || (zone >= HVAC_GetZoneCount())))
+            {
+                bZoneOk = FALSE;
+            }
+        }
+
+        if (bParams && bZoneOk)
+        {
             if (strcmp(hvac,"heat") == 0)
             {
-                HVAC_SetHVACMode(HVAC_Heat);
+                HVAC_SetZoneHVACMode(zone, HVAC_Heat);
             }
             else if (strcmp(hvac,"cool") == 0)
             {
-                HVAC_SetHVACMode(HVAC_Cool);
+                HVAC_SetZoneHVACMode(zone, HVAC_Cool);
             }
             else
             {
-                HVAC_SetHVACMode(HVAC_Off);
+                HVAC_SetZoneHVACMode(zone, HVAC_Off);
             }
             
             if (strcmp(unit,"f") == 0)
@@ -159,25 +201,25 @@ _mqx_int cgi_hvac_output(HTTPSRV_CGI_REQ_STRUCT* param)
             }
             if (strcmp(fan,"auto") == 0)
             {
-                HVAC_SetFanMode(Fan_Automatic);
+                HVAC_SetZoneFanMode(zone, Fan_Automatic);
             }
             else
             {
-                HVAC_SetFanMode(Fan_On);
+                HVAC_SetZoneFanMode(zone, Fan_On);
             }
         
             if (sscanf(t, "%d.%d", &temp, &temp_fract) >= 1)
             {
                 if (temp_fract<10)
                 {
-                    HVAC_SetDesiredTemperature(temp * 10 + temp_fract);
+                    HVAC_SetZoneDesiredTemperature(zone, temp * 10 + temp_fract);
                 }
             }
         }
     }
     response.ses_handle = param->ses_handle;
     response.content_type = HTTPSRV_CONTENT_TYPE_HTML;
-    response.status_code = 200;
+    response.status_code = bZoneOk ? 200 : 400;
     response.data = "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.0 Transitional//EN\">"
         "<html><head><title>HVAC Settings response</title>"
         "<meta http-equiv=\"REFRESH\" content=\"0;url=hvac.shtml\"></head>\n<body>\n";
@@ -191,9 +233,16 @@ _mqx_int cgi_hvac_output(HTTPSRV_CGI_REQ_STRUCT* param)
         response.data_length = strlen(response.data);
         HTTPSRV_cgi_write(&response);
     }
+    else if (!bZoneOk)
+    {
+        response.data = "Invalid zone, nothing changed.<br>\n";
+        response.data_length = strlen(response.data);
+        HTTPSRV_cgi_write(&response);
+    }
     response.data = "<br><br>\n</body></html>";
     response.data_length = strlen(response.data);
     HTTPSRV_cgi_write(&response);    
+    TRACE_END( TRACE_MARK_CGI_HVAC_OUT );
     return (response.content_length);
 }
 
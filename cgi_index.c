@@ -29,6 +29,12 @@
 #include "cgi.h"
 #include "web_func.h"
 #include "global.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+#include "core_lock.h"
+#include "live_status.h"
+#include "db_notify.h"
+#include "journal.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -47,6 +53,9 @@ const HTTPSRV_CGI_LINK_STRUCT cgi_lnk_tbl[] = {
     { "usbstat",      cgi_usbstat,     0 },
     { "web_data",     cgi_web_data,    0 },
     { "write_relay",  cgi_write_relay, 0 },
+    { "task_data",    cgi_task_data,   0 },
+    { "trace_data",   cgi_trace_data,  0 },
+    { "journal_data", cgi_journal_data, 0 },
     { 0, 0 }    // DO NOT REMOVE - last item - end of table
 };
 
@@ -92,6 +101,8 @@ cgi_status_data( HTTPSRV_CGI_REQ_STRUCT * param )
     if (param->request_method != HTTPSRV_REQ_GET)
         return(0);
 
+    TRACE_BEGIN( TRACE_MARK_CGI_STATUS );
+
     _time_get(&time);
     
     sec = time.SECONDS % 60;
@@ -99,7 +110,7 @@ cgi_status_data( HTTPSRV_CGI_REQ_STRUCT * param )
     hour = min / 60;
     min %= 60;
 
-    uint32_t Ta = HVAC_GetActualTemperature();
+    int32_t  Ta = HVAC_GetActualTemperature();
     uint32_t Td = HVAC_GetDesiredTemperature();
     
   
@@ -157,6 +168,8 @@ cgi_status_data( HTTPSRV_CGI_REQ_STRUCT * param )
 
     HTTPSRV_cgi_write( &response ); 
 
+    TRACE_END( TRACE_MARK_CGI_STATUS );
+
     return( response.content_length );
 }
 
@@ -167,6 +180,8 @@ _mqx_int cgi_web_data(  HTTPSRV_CGI_REQ_STRUCT * param )
     
     if (param->request_method != HTTPSRV_REQ_GET)
         return(0);
+
+    TRACE_BEGIN( TRACE_MARK_CGI_WEB );
      
     
      
@@ -185,6 +200,8 @@ _mqx_int cgi_web_data(  HTTPSRV_CGI_REQ_STRUCT * param )
 
     HTTPSRV_cgi_write( &response ); 
 
+    TRACE_END( TRACE_MARK_CGI_WEB );
+
     return( response.content_length );
 }
 
@@ -214,12 +231,35 @@ _mqx_int  cgi_adc_data( HTTPSRV_CGI_REQ_STRUCT * param )
 {
     HTTPSRV_CGI_RES_STRUCT response;
     char                   str[80];
+    LIVE_STATUS            status;
+    int                    k;
 
     if( param->request_method != HTTPSRV_REQ_GET )
         return( 0 );
 
+    TRACE_BEGIN( TRACE_MARK_CGI_ADC );
+
     web_blink_comm_leds();
 
+    // Copy the sensor setup from the core DB, so that the mutex is not
+    //    held while the response is formatted. The version is checked
+    //    first so that the mutex is only taken when the setup changed.
+    //    The sensor status is a snapshot of the last sample cycle, read
+    //    without the mutex.
+    //
+    if( (enetDB.config_version != coreDB.config_version) &&
+        (core_lock( CORE_SITE_CGI_ADC ) == MQX_OK) )
+    {
+        for( k=SENSOR_ID_ONE; k<=SENSOR_ID_THREE; k++ )
+            enetDB.sensor_setup[k] = coreDB.sensor[k].setup;
+
+        enetDB.config_version = coreDB.config_version;
+
+        core_unlock( CORE_SITE_CGI_ADC );
+    }
+
+    live_status_read( &status );
+
     // The 1st parameter is Sn-1, raw ADC
     sprintf( str, "%d\n", Sample[IDX_ANA_SENSOR_1].raw );     
     strcpy( cgiResp, str );
@@ -244,49 +284,49 @@ _mqx_int  cgi_adc_data( HTTPSRV_CGI_REQ_STRUCT * param )
     sprintf( str, "%d\n", Sample[IDX_ANA_CPU_TEMP].raw );     
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_ONE].value_float, 3 );   
-    strcat( str, SensorUnits[ coreDB.sensor[SENSOR_ID_ONE].setup.sensor_type ] );
+    web_build_float_string( str, status.sensor[SENSOR_ID_ONE].value_float, 3 );   
+    strcat( str, SensorUnits[ enetDB.sensor_setup[SENSOR_ID_ONE].sensor_type ] );
     strcat( cgiResp, str );
     strcat( cgiResp, "\n" );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_TWO].value_float, 3 );   
-    strcat( str, SensorUnits[ coreDB.sensor[SENSOR_ID_TWO].setup.sensor_type ] );
+    web_build_float_string( str, status.sensor[SENSOR_ID_TWO].value_float, 3 );   
+    strcat( str, SensorUnits[ enetDB.sensor_setup[SENSOR_ID_TWO].sensor_type ] );
     strcat( cgiResp, str );
     strcat( cgiResp, "\n" );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_THREE].value_float, 3 ); 
-    strcat( str, SensorUnits[ coreDB.sensor[SENSOR_ID_THREE].setup.sensor_type ] );
+    web_build_float_string( str, status.sensor[SENSOR_ID_THREE].value_float, 3 ); 
+    strcat( str, SensorUnits[ enetDB.sensor_setup[SENSOR_ID_THREE].sensor_type ] );
     strcat( cgiResp, str );
     strcat( cgiResp, "\n" );
 
-    web_build_float_string( str, coreDB.five_volt_ext, 3 ); 
+    web_build_float_string( str, status.five_volt_ext, 3 ); 
     strcat( str, " vdc\n" );
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.ten_volt_ref, 3 );
+    web_build_float_string( str, status.ten_volt_ref, 3 );
     strcat( str, " vdc\n" );
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.cpu_temp, 3 );
+    web_build_float_string( str, status.cpu_temp, 3 );
     strcat( str, " F\n" );
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_ONE].signal, 3 );  
-    if( resistive_input( coreDB.sensor[SENSOR_ID_ONE].setup.sensor_type ) )
+    web_build_float_string( str, status.sensor[SENSOR_ID_ONE].signal, 3 );  
+    if( resistive_input( enetDB.sensor_setup[SENSOR_ID_ONE].sensor_type ) )
         strcat( str, " ohms\n" );
     else
         strcat( str, " vdc\n" );
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_TWO].signal, 3 );    
-    if( resistive_input( coreDB.sensor[SENSOR_ID_TWO].setup.sensor_type ) )
+    web_build_float_string( str, status.sensor[SENSOR_ID_TWO].signal, 3 );    
+    if( resistive_input( enetDB.sensor_setup[SENSOR_ID_TWO].sensor_type ) )
         strcat( str, " ohms\n" );
     else
         strcat( str, " vdc\n" );
     strcat( cgiResp, str );
 
-    web_build_float_string( str, coreDB.sensor[SENSOR_ID_THREE].signal, 3 );  
-    if( resistive_input( coreDB.sensor[SENSOR_ID_THREE].setup.sensor_type ) )
+    web_build_float_string( str, status.sensor[SENSOR_ID_THREE].signal, 3 );  
+    if( resistive_input( enetDB.sensor_setup[SENSOR_ID_THREE].sensor_type ) )
         strcat( str, " ohms\n" );
     else
         strcat( str, " vdc\n" );
@@ -301,10 +341,154 @@ _mqx_int  cgi_adc_data( HTTPSRV_CGI_REQ_STRUCT * param )
 
     HTTPSRV_cgi_write( &response ); 
 
+    TRACE_END( TRACE_MARK_CGI_ADC );
+
     return( response.content_length );
 }
 
 
+//
+//    cgi_task_data() - Reports the results of the task monitor as a JSON
+//                      object; CPU use and stack high-water mark for each
+//                      task, and CPU use of each interrupt handler. See
+//                      task_monitor_json_read() for the format.
+//
+//    The response is written in pieces the size of cgiResp, so however
+//    many tasks there are it is never cut short.
+//
+_mqx_int  cgi_task_data( HTTPSRV_CGI_REQ_STRUCT * param )
+{
+    HTTPSRV_CGI_RES_STRUCT response;
+    TMON_JSON_CURSOR       cursor;
+    int                    len;
+
+    if( param->request_method != HTTPSRV_REQ_GET )
+        return( 0 );
+
+    TRACE_BEGIN( TRACE_MARK_CGI_TASK );
+
+    response.ses_handle     = param->ses_handle;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.status_code    = 200;
+    response.data           = cgiResp;
+    response.content_length = 0;
+
+    task_monitor_json_open( &cursor );
+
+    while( (len = task_monitor_json_read( &cursor, cgiResp, sizeof( cgiResp ) )) > 0 )
+    {
+        response.data_length = len;
+        HTTPSRV_cgi_write( &response );
+    }
+
+    TRACE_END( TRACE_MARK_CGI_TASK );
+
+    return( response.content_length );
+}
+
+//
+//    cgi_trace_data() - Returns the contents of the event trace buffer as
+//                       Chrome trace JSON. Save the response to a file
+//                       and load it into chrome://tracing or Perfetto.
+//
+//    Recording is paused while the buffer is read out. The response is
+//    written in pieces the size of cgiResp, so the content length is not
+//    known in advance.
+//
+_mqx_int  cgi_trace_data( HTTPSRV_CGI_REQ_STRUCT * param )
+{
+    HTTPSRV_CGI_RES_STRUCT response;
+    TRACE_CURSOR           cursor;
+    int                    len;
+
+    if( param->request_method != HTTPSRV_REQ_GET )
+        return( 0 );
+
+    response.ses_handle     = param->ses_handle;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.status_code    = 200;
+    response.data           = cgiResp;
+    response.content_length = 0;
+
+    trace_open( &cursor, TRUE );
+
+    while( (len = trace_read( &cursor, cgiResp, sizeof( cgiResp ) )) > 0 )
+    {
+        response.data_length = len;
+        HTTPSRV_cgi_write( &response );
+    }
+
+    trace_close( &cursor );
+
+    return( response.content_length );
+}
+
+
+//
+//    cgi_journal_data() - Returns a page of the event journal. The query
+//                         selects the first record; "seq=<n>" from a
+//                         sequence number, or "time=<sec>" from an
+//                         operating time. "max=<n>" limits the number
+//                         of records, default and at most JOURNAL_CGI_MAX.
+//
+//    One record per line, "seq,time,type,id,arg". The last line is
+//    "next,<seq>", the sequence number to ask for the next page with.
+//
+#define  JOURNAL_CGI_MAX   20
+
+_mqx_int  cgi_journal_data( HTTPSRV_CGI_REQ_STRUCT * param )
+{
+    HTTPSRV_CGI_RES_STRUCT response;
+    JOURNAL_RECORD         recs[ JOURNAL_CGI_MAX ];
+    char *                 query;
+    uint32_t               seq, value, max = JOURNAL_CGI_MAX;
+    int                    num, k, len = 0;
+
+    if( param->request_method != HTTPSRV_REQ_GET )
+        return( 0 );
+
+    query = param->query_string;
+    seq   = journal_first_seq();
+
+    if( query != NULL )
+    {
+        if( (strstr( query, "seq=" ) != NULL) && (sscanf( strstr( query, "seq=" ) + 4, "%u", &value ) == 1) )
+            seq = value;
+        else if( (strstr( query, "time=" ) != NULL) && (sscanf( strstr( query, "time=" ) + 5, "%u", &value ) == 1) )
+            seq = journal_seq_at_time( value );
+
+        if( (strstr( query, "max=" ) != NULL) && (sscanf( strstr( query, "max=" ) + 4, "%u", &value ) == 1) &&
+            (value > 0) && (value <= JOURNAL_CGI_MAX) )
+            max = value;
+    }
+
+    num = journal_read( seq, recs, max );
+
+    for( k=0; k<num; k++ )
+    {
+        len += snprintf( &cgiResp[len], sizeof( cgiResp ) - len, "%u,%u,%s,%u,%u\n",
+                         recs[k].seq, recs[k].time,
+                         (recs[k].type < MAX_JOURNAL_TYPE) ? JournalTypeName[ recs[k].type ] : "?",
+                         recs[k].id, recs[k].arg );
+    }
+
+    if( num )
+        seq = recs[ num - 1 ].seq + 1;
+
+    len += snprintf( &cgiResp[len], sizeof( cgiResp ) - len, "next,%u\n", seq );
+
+    response.ses_handle     = param->ses_handle;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.status_code    = 200;
+    response.data           = cgiResp;
+    response.data_length    = strlen( cgiResp );
+    response.content_length = response.data_length;
+
+    HTTPSRV_cgi_write( &response );
+
+    return( response.content_length );
+}
+
 
 static bool usbstick_attached()
 {
@@ -367,6 +551,8 @@ _mqx_int cgi_write_relay( HTTPSRV_CGI_REQ_STRUCT * param )
     if (param->request_method != HTTPSRV_REQ_POST)
         return(0);
 
+    TRACE_BEGIN( TRACE_MARK_CGI_RELAY );
+
         
     response.ses_handle = param->ses_handle;
     response.content_type = HTTPSRV_CONTENT_TYPE_HTML;
@@ -383,6 +569,8 @@ _mqx_int cgi_write_relay( HTTPSRV_CGI_REQ_STRUCT * param )
     else{
       gRelayState = 1;
     }
+    journal_record( JOURNAL_RELAY_REQUEST, JOURNAL_SOURCE_WEB, gRelayState );
+    db_publish( DB_BIT( DB_GROUP_RELAY ) );
     
    
     
@@ -396,6 +584,7 @@ _mqx_int cgi_write_relay( HTTPSRV_CGI_REQ_STRUCT * param )
     response.data_length = strlen(response.data);
     response.content_length = response.data_length;
     HTTPSRV_cgi_write(&response);
+    TRACE_END( TRACE_MARK_CGI_RELAY );
     return( response.content_length );
   
 }
@@ -0,0 +1,719 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : config_image.c
+
+PURPOSE   : The setup image. The calibration and the sensor and output
+            setup are kept in the config store as a single record; a
+            packed image whose layout is given by the IMG_* offsets in
+            config_image.h, independent of the compiler's struct layout.
+
+            At start-up an image of the current schema is checked and
+            then read where it is in the flash; each field is decoded
+            straight into CalData and coreDB. It is only copied into RAM
+            if it cannot be addressed in place.
+
+            An image of an older schema is converted before any of its
+            fields are read, by the converters in ImgConvert[]; one per
+            schema, each from schema N-1 to N. init_globals() then saves
+            the converted image. Schema 0 is the three records of raw
+            structs saved by firmware before the setup image; once the
+            image is saved they are erased. cfg_image_test() converts a
+            fixed schema 0 image and checks the result, see the
+            "config test" shell command.
+
+            Once the tasks are running the image is saved by a
+            Flash_Task item, see cfg_image_request_save(). It is built
+            with mutexCore locked, and written after the unlock.
+            CfgImageBuffer is therefore only used by the Init_Task before
+            the Flash_Task is started, and by the Flash_Task.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "func.h"
+#include "config_store.h"
+#include "core_lock.h"
+#include "work_queue.h"
+#include "config_image.h"
+
+CFG_IMAGE_INFO    CfgImageInfo;
+uint8_t           CfgImageBuffer[ IMG_MAX_SIZE ];    // Image being saved, or
+                                                     //   a copy read from flash
+uint8_t           ImgConvertBuffer[ IMG_MAX_SIZE ];  // Image converted at
+                                                     //   start-up
+volatile bool     CfgImagePosted;                    // cfg_image_save_work()
+                                                     //   not yet run
+
+// Function Prototypes - used by this module only
+//
+bool      img_valid( const uint8_t * image, uint16_t length );
+const uint8_t * img_read_records( uint8_t * image );
+const uint8_t * img_convert( const uint8_t * image, uint8_t * a, uint8_t * b );
+void      img_convert_0( const uint8_t * from, uint8_t * to );
+void      img_test_output( int index, OUTPUT_SETUP * setup );
+uint16_t  img_crc( const uint8_t * image, uint16_t length );
+uint16_t  img_get16( const uint8_t * p );
+uint32_t  img_get32( const uint8_t * p );
+void      img_put16( uint8_t * p, uint16_t value );
+void      img_put32( uint8_t * p, uint32_t value );
+void      img_put_header( uint8_t * image );
+void      img_put_calibration( uint8_t * p, const CALIBRATION * cal );
+void      img_put_output( uint8_t * p, const OUTPUT_SETUP * setup );
+void      img_build( uint8_t * image, const CALIBRATION * cal, const DATABASE * db );
+void      cfg_image_save_work( void * ctx, uint32_t arg );
+
+// IMG_CONVERT - Converts "from", a checked image of one schema, into an
+//   image of the next schema in "to".
+//
+typedef void (* IMG_CONVERT)( const uint8_t * from, uint8_t * to );
+
+// The converters, indexed by the schema they convert from. When
+//   IMG_SCHEMA is incremented, the converter from the previous schema is
+//   added here, and the size of the new schema to ImgSchemaSize[].
+//
+const IMG_CONVERT  ImgConvert[ IMG_SCHEMA ] =
+{
+    img_convert_0               // Records of earlier firmware to schema 1
+};
+
+const uint16_t     ImgSchemaSize[ IMG_SCHEMA + 1 ] =
+{
+    IMG0_SIZE,                  // Schema 0
+    IMG_SIZE                    // Schema 1
+};
+
+// Fixture for cfg_image_test(); the calibration of a schema 0 image.
+//
+const CALIBRATION  ImgTestCal =
+{
+    5.125, 12, 13, 14, 28100, 28200, 28300, -5, 6, -7
+};
+
+
+//
+//  cfg_image_map() - Returns the setup image, converted to this schema,
+//                    or NULL if there is none with a good CRC and there
+//                    are no records of earlier firmware. The image is in
+//                    the flash if it can be addressed there, and is only
+//                    valid until the config store is next written. Called
+//                    by the Init_Task only.
+//
+const uint8_t *
+cfg_image_map( void )
+{
+    const uint8_t * image;
+    uint16_t        length;
+
+    image = cfg_store_map( CFG_KEY_SETUP_IMAGE, &length );
+
+    if( (image != NULL) && img_valid( image, length ) )
+    {
+        CfgImageInfo.in_place = TRUE;
+    }
+    else
+    {
+        // Read a copy; the flash may not be addressable at the place the
+        //    store expects.
+        //
+        image  = NULL;
+        length = CfgIndex[ CFG_KEY_SETUP_IMAGE ].length;
+
+        if( (length != 0) && (length <= IMG_MAX_SIZE) &&
+            cfg_store_read( CFG_KEY_SETUP_IMAGE, CfgImageBuffer, length ) &&
+            img_valid( CfgImageBuffer, length ) )
+        {
+            image = CfgImageBuffer;
+        }
+        else if( length != 0 )
+        {
+            CfgImageInfo.rejected++;
+        }
+
+        if( image == NULL )
+            image = img_read_records( CfgImageBuffer );
+
+        if( image == NULL )
+            return( NULL );
+
+        CfgImageInfo.in_place = FALSE;
+    }
+
+    CfgImageInfo.schema = image[ IMG_HDR_SCHEMA ];
+
+    if( CfgImageInfo.schema == IMG_SCHEMA )
+        return( image );
+
+    CfgImageInfo.in_place = FALSE;
+    CfgImageInfo.migrated = TRUE;
+
+    return( img_convert( image, CfgImageBuffer, ImgConvertBuffer ) );
+}
+
+
+//
+//  cfg_image_get_calibration() - Decode the calibration data.
+//
+void
+cfg_image_get_calibration( const uint8_t * image, CALIBRATION * cal )
+{
+    const uint8_t * p = image + IMG_CAL;
+    uint32_t        bits;
+
+    bits = img_get32( p + IMG_CAL_5_VOLT_EXT );
+    memcpy( &cal->five_volt_external, &bits, sizeof( float ) );
+
+    cal->volt_adc_ground_1  = img_get16( p + IMG_CAL_VIN_GROUND );
+    cal->volt_adc_ground_2  = img_get16( p + IMG_CAL_VIN_GROUND + 2 );
+    cal->volt_adc_ground_3  = img_get16( p + IMG_CAL_VIN_GROUND + 4 );
+
+    cal->volt_adc_5Vext_1   = img_get16( p + IMG_CAL_VIN_5_VOLT );
+    cal->volt_adc_5Vext_2   = img_get16( p + IMG_CAL_VIN_5_VOLT + 2 );
+    cal->volt_adc_5Vext_3   = img_get16( p + IMG_CAL_VIN_5_VOLT + 4 );
+
+    cal->resistive_offset_1 = (int16_t) img_get16( p + IMG_CAL_RIN_OFFSET );
+    cal->resistive_offset_2 = (int16_t) img_get16( p + IMG_CAL_RIN_OFFSET + 2 );
+    cal->resistive_offset_3 = (int16_t) img_get16( p + IMG_CAL_RIN_OFFSET + 4 );
+}
+
+
+//
+//  cfg_image_get_sensor() - Decode the setup of sensor Sn-(index+1).
+//
+void
+cfg_image_get_sensor( const uint8_t * image, int index, SENSOR_SETUP * setup )
+{
+    const uint8_t * p = image + IMG_SENSOR + index * IMG_SENSOR_SIZE;
+
+    setup->sensor_type = p[ IMG_SENSOR_TYPE ];
+    setup->offset      = (int8_t) p[ IMG_SENSOR_OFFSET ];
+}
+
+
+//
+//  cfg_image_get_output() - Decode the setup of one output.
+//
+void
+cfg_image_get_output( const uint8_t * image, int index, OUTPUT_SETUP * setup )
+{
+    const uint8_t * p = image + IMG_OUTPUT + index * IMG_OUT_SIZE;
+
+    memset( setup, 0, sizeof( OUTPUT_SETUP ) );
+
+    setup->output_type = p[ IMG_OUT_TYPE ];
+
+    if( setup->output_type == OUTPUT_TYPE_ANALOG )
+    {
+        setup->output.analog.sensor_id        = p[ IMG_OUT_SENSOR_ID ];
+        setup->output.analog.sensor_fail_mode = p[ IMG_OUT_FAIL_MODE ];
+        setup->output.analog.sp               = (int16_t) img_get16( p + IMG_ANALOG_SP );
+        setup->output.analog.ep               = (int16_t) img_get16( p + IMG_ANALOG_EP );
+        setup->output.analog.sp_output        = p[ IMG_ANALOG_SP_OUTPUT ];
+        setup->output.analog.ep_output        = p[ IMG_ANALOG_EP_OUTPUT ];
+        setup->output.analog.int_constant     = p[ IMG_ANALOG_INT_CONST ];
+        setup->output.analog.update_rate      = p[ IMG_ANALOG_UPDATE_RATE ];
+        setup->output.analog.output_band      = p[ IMG_ANALOG_OUTPUT_BAND ];
+    }
+    else
+    {
+        setup->output.relay.sensor_id         = p[ IMG_OUT_SENSOR_ID ];
+        setup->output.relay.sensor_fail_mode  = p[ IMG_OUT_FAIL_MODE ];
+        setup->output.relay.cut_on            = (int16_t) img_get16( p + IMG_RELAY_CUT_ON );
+        setup->output.relay.cut_off           = (int16_t) img_get16( p + IMG_RELAY_CUT_OFF );
+        setup->output.relay.min_on_time       = (int16_t) img_get16( p + IMG_RELAY_MIN_ON );
+        setup->output.relay.min_off_time      = (int16_t) img_get16( p + IMG_RELAY_MIN_OFF );
+        setup->output.relay.on_delay          = (int16_t) img_get16( p + IMG_RELAY_ON_DELAY );
+        setup->output.relay.off_delay         = (int16_t) img_get16( p + IMG_RELAY_OFF_DELAY );
+    }
+}
+
+
+//
+//  cfg_image_save() - Build the image from "cal" and "db", and save it
+//                     in the config store. Nothing is written if it has
+//                     not changed. Any image returned by cfg_image_map()
+//                     must no longer be used. Called by the Init_Task
+//                     only; once the tasks run, see cfg_image_request_save().
+//
+bool
+cfg_image_save( const CALIBRATION * cal, const DATABASE * db )
+{
+    img_build( CfgImageBuffer, cal, db );
+
+    CfgImageInfo.saves++;
+
+    return( cfg_store_write( CFG_KEY_SETUP_IMAGE, CfgImageBuffer, IMG_SIZE ) );
+}
+
+
+//
+//  cfg_image_request_save() - Ask for the image of CalData and the setup in
+//                             coreDB to be saved by the Flash_Task, so that
+//                             the caller is not stalled by the flash.
+//                             Returns FALSE if the request could not be
+//                             queued.
+//
+bool
+cfg_image_request_save( void )
+{
+    if( CfgImagePosted )
+        return( TRUE );
+
+    CfgImagePosted = TRUE;
+
+    if( !work_queue_post( WORK_PRIO_FLASH, cfg_image_save_work, NULL, 0 ) )
+    {
+        CfgImagePosted = FALSE;
+        return( FALSE );
+    }
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_image_save_work() - Flash_Task callback. Build the image with
+//                          mutexCore locked, so that it is a consistent
+//                          copy of the setup, and save it after the unlock.
+//
+void
+cfg_image_save_work( void * ctx, uint32_t arg )
+{
+    // A change after this point posts another request.
+    //
+    CfgImagePosted = FALSE;
+
+    if( core_lock( CORE_SITE_CONFIG_SAVE ) != MQX_OK )
+        return;
+
+    img_build( CfgImageBuffer, &CalData, &coreDB );
+    core_unlock( CORE_SITE_CONFIG_SAVE );
+
+    CfgImageInfo.saves++;
+
+    cfg_store_write( CFG_KEY_SETUP_IMAGE, CfgImageBuffer, IMG_SIZE );
+}
+
+
+//
+//  img_build() - Build the image of "cal" and "db" in "image".
+//
+void
+img_build( uint8_t * image, const CALIBRATION * cal, const DATABASE * db )
+{
+    uint8_t *  p;
+    int        k;
+
+    img_put_header( image );
+    img_put_calibration( image + IMG_CAL, cal );
+
+    for( k=0; k<IMG_SENSORS; k++ )
+    {
+        p = image + IMG_SENSOR + k * IMG_SENSOR_SIZE;
+
+        p[ IMG_SENSOR_TYPE ]   = db->sensor[ SENSOR_ID_ONE + k ].setup.sensor_type;
+        p[ IMG_SENSOR_OFFSET ] = (uint8_t) db->sensor[ SENSOR_ID_ONE + k ].setup.offset;
+    }
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+        img_put_output( image + IMG_OUTPUT + k * IMG_OUT_SIZE, &db->output[k].setup );
+
+    img_put16( image + IMG_HDR_CRC, img_crc( image, IMG_SIZE ) );
+}
+
+
+//
+//  img_put_header() - Clear "image" and write the header of this schema.
+//                     The CRC is written once the fields are filled in.
+//
+void
+img_put_header( uint8_t * image )
+{
+    memset( image, 0, IMG_SIZE );
+
+    img_put16( image + IMG_HDR_MAGIC, IMG_MAGIC );
+    image[ IMG_HDR_SCHEMA ] = IMG_SCHEMA;
+    img_put16( image + IMG_HDR_LENGTH, IMG_SIZE );
+}
+
+
+//
+//  img_put_calibration() - Encode the calibration data.
+//
+void
+img_put_calibration( uint8_t * p, const CALIBRATION * cal )
+{
+    uint32_t  bits;
+
+    memcpy( &bits, &cal->five_volt_external, sizeof( float ) );
+    img_put32( p + IMG_CAL_5_VOLT_EXT, bits );
+
+    img_put16( p + IMG_CAL_VIN_GROUND,     cal->volt_adc_ground_1 );
+    img_put16( p + IMG_CAL_VIN_GROUND + 2, cal->volt_adc_ground_2 );
+    img_put16( p + IMG_CAL_VIN_GROUND + 4, cal->volt_adc_ground_3 );
+
+    img_put16( p + IMG_CAL_VIN_5_VOLT,     cal->volt_adc_5Vext_1 );
+    img_put16( p + IMG_CAL_VIN_5_VOLT + 2, cal->volt_adc_5Vext_2 );
+    img_put16( p + IMG_CAL_VIN_5_VOLT + 4, cal->volt_adc_5Vext_3 );
+
+    img_put16( p + IMG_CAL_RIN_OFFSET,     (uint16_t) cal->resistive_offset_1 );
+    img_put16( p + IMG_CAL_RIN_OFFSET + 2, (uint16_t) cal->resistive_offset_2 );
+    img_put16( p + IMG_CAL_RIN_OFFSET + 4, (uint16_t) cal->resistive_offset_3 );
+}
+
+
+//
+//  img_put_output() - Encode the setup of one output.
+//
+void
+img_put_output( uint8_t * p, const OUTPUT_SETUP * setup )
+{
+    p[ IMG_OUT_TYPE ] = setup->output_type;
+
+    if( setup->output_type == OUTPUT_TYPE_ANALOG )
+    {
+        p[ IMG_OUT_SENSOR_ID ]      = setup->output.analog.sensor_id;
+        p[ IMG_OUT_FAIL_MODE ]      = setup->output.analog.sensor_fail_mode;
+        img_put16( p + IMG_ANALOG_SP, (uint16_t) setup->output.analog.sp );
+        img_put16( p + IMG_ANALOG_EP, (uint16_t) setup->output.analog.ep );
+        p[ IMG_ANALOG_SP_OUTPUT ]   = setup->output.analog.sp_output;
+        p[ IMG_ANALOG_EP_OUTPUT ]   = setup->output.analog.ep_output;
+        p[ IMG_ANALOG_INT_CONST ]   = setup->output.analog.int_constant;
+        p[ IMG_ANALOG_UPDATE_RATE ] = setup->output.analog.update_rate;
+        p[ IMG_ANALOG_OUTPUT_BAND ] = setup->output.analog.output_band;
+    }
+    else
+    {
+        p[ IMG_OUT_SENSOR_ID ]      = setup->output.relay.sensor_id;
+        p[ IMG_OUT_FAIL_MODE ]      = setup->output.relay.sensor_fail_mode;
+        img_put16( p + IMG_RELAY_CUT_ON,    (uint16_t) setup->output.relay.cut_on );
+        img_put16( p + IMG_RELAY_CUT_OFF,   (uint16_t) setup->output.relay.cut_off );
+        img_put16( p + IMG_RELAY_MIN_ON,    (uint16_t) setup->output.relay.min_on_time );
+        img_put16( p + IMG_RELAY_MIN_OFF,   (uint16_t) setup->output.relay.min_off_time );
+        img_put16( p + IMG_RELAY_ON_DELAY,  (uint16_t) setup->output.relay.on_delay );
+        img_put16( p + IMG_RELAY_OFF_DELAY, (uint16_t) setup->output.relay.off_delay );
+    }
+}
+
+
+//
+//  img_valid() - TRUE if "image" is a complete image of this schema, or
+//                of an older one that can be converted. Schema 0 is
+//                never stored as an image; see img_read_records().
+//
+bool
+img_valid( const uint8_t * image, uint16_t length )
+{
+    if( (length <= IMG_HDR_CRC + 2) ||
+        (img_get16( image + IMG_HDR_MAGIC ) != IMG_MAGIC) ||
+        (image[ IMG_HDR_SCHEMA ] == 0) ||
+        (image[ IMG_HDR_SCHEMA ] > IMG_SCHEMA) ||
+        (ImgSchemaSize[ image[ IMG_HDR_SCHEMA ] ] != length) ||
+        (img_get16( image + IMG_HDR_LENGTH ) != length) )
+    {
+        return( FALSE );
+    }
+
+    return( img_get16( image + IMG_HDR_CRC ) == img_crc( image, length ) );
+}
+
+
+//
+//  img_read_records() - Copy the records saved by firmware before the
+//                       setup image into "image", as a schema 0 image.
+//                       Returns NULL if there are none.
+//
+const uint8_t *
+img_read_records( uint8_t * image )
+{
+    uint8_t  found = 0;
+
+    memset( image, 0, IMG0_SIZE );
+
+    if( cfg_store_read( CFG_KEY_CALIBRATION, image + IMG0_CAL, sizeof( CALIBRATION ) ) )
+        found |= IMG0_FOUND_CAL;
+
+    if( cfg_store_read( CFG_KEY_SENSOR_SETUP, image + IMG0_SENSOR, IMG_SENSORS * sizeof( SENSOR_SETUP ) ) )
+        found |= IMG0_FOUND_SENSOR;
+
+    if( cfg_store_read( CFG_KEY_OUTPUT_SETUP, image + IMG0_OUTPUT, MAX_OUTPUTS * sizeof( OUTPUT_SETUP ) ) )
+        found |= IMG0_FOUND_OUTPUT;
+
+    if( found == 0 )
+        return( NULL );
+
+    img_put16( image + IMG_HDR_MAGIC, IMG_MAGIC );
+    image[ IMG_HDR_SCHEMA ]   = 0;
+    image[ IMG_HDR_RESERVED ] = found;
+    img_put16( image + IMG_HDR_LENGTH, IMG0_SIZE );
+
+    return( image );
+}
+
+
+//
+//  img_convert() - Convert "image", which has been checked, to this
+//                  schema, one schema at a time. Each step writes into
+//                  whichever of "a" and "b" does not hold its input;
+//                  both are IMG_MAX_SIZE bytes. Returns the converted
+//                  image, which is in "a" or "b" unless "image" was
+//                  already of this schema.
+//
+const uint8_t *
+img_convert( const uint8_t * image, uint8_t * a, uint8_t * b )
+{
+    uint8_t *  to;
+    int        schema;
+
+    for( schema = image[ IMG_HDR_SCHEMA ]; schema < IMG_SCHEMA; schema++ )
+    {
+        to = (image == a) ? b : a;
+
+        ImgConvert[ schema ]( image, to );
+        image = to;
+    }
+
+    return( image );
+}
+
+
+//
+//  img_convert_0() - Convert the records of earlier firmware to schema 1.
+//                    A record that was not found is given the defaults
+//                    that init_globals() would otherwise have used.
+//
+//    The IMG_* offsets are those of schema 1. When the schema changes,
+//    this converter must keep writing the schema 1 layout.
+//
+void
+img_convert_0( const uint8_t * from, uint8_t * to )
+{
+    CALIBRATION   cal;
+    SENSOR_SETUP  sensor;
+    OUTPUT_SETUP  output;
+    uint8_t       found = from[ IMG_HDR_RESERVED ];
+    uint8_t *     p;
+    int           k;
+
+    img_put_header( to );
+
+    if( found & IMG0_FOUND_CAL )
+    {
+        memcpy( &cal, from + IMG0_CAL, sizeof( cal ) );
+    }
+    else
+    {
+        cal.five_volt_external = DEFAULT_CAL_5_VOLT_EXTERNAL;
+        cal.volt_adc_ground_1  = DEFAULT_CAL_VIN_GROUND;
+        cal.volt_adc_ground_2  = DEFAULT_CAL_VIN_GROUND;
+        cal.volt_adc_ground_3  = DEFAULT_CAL_VIN_GROUND;
+        cal.volt_adc_5Vext_1   = DEFAULT_CAL_VIN_5_VOLT;
+        cal.volt_adc_5Vext_2   = DEFAULT_CAL_VIN_5_VOLT;
+        cal.volt_adc_5Vext_3   = DEFAULT_CAL_VIN_5_VOLT;
+        cal.resistive_offset_1 = DEFAULT_CAL_RIN_OFFSET;
+        cal.resistive_offset_2 = DEFAULT_CAL_RIN_OFFSET;
+        cal.resistive_offset_3 = DEFAULT_CAL_RIN_OFFSET;
+    }
+
+    img_put_calibration( to + IMG_CAL, &cal );
+
+    for( k=0; k<IMG_SENSORS; k++ )
+    {
+        sensor.sensor_type = SENSOR_TYPE_NONE;
+        sensor.offset      = 0;
+
+        if( found & IMG0_FOUND_SENSOR )
+            memcpy( &sensor, from + IMG0_SENSOR + k * sizeof( SENSOR_SETUP ), sizeof( sensor ) );
+
+        p = to + IMG_SENSOR + k * IMG_SENSOR_SIZE;
+
+        p[ IMG_SENSOR_TYPE ]   = sensor.sensor_type;
+        p[ IMG_SENSOR_OFFSET ] = (uint8_t) sensor.offset;
+    }
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        if( found & IMG0_FOUND_OUTPUT )
+        {
+            memcpy( &output, from + IMG0_OUTPUT + k * sizeof( OUTPUT_SETUP ), sizeof( output ) );
+        }
+        else
+        {
+            output.output_type  = OUTPUT_TYPE_RELAY;
+            output.output.relay = DefaultRelaySetup[ SENSOR_TYPE_NONE ];
+        }
+
+        img_put_output( to + IMG_OUTPUT + k * IMG_OUT_SIZE, &output );
+    }
+
+    img_put16( to + IMG_HDR_CRC, img_crc( to, IMG_SIZE ) );
+}
+
+
+//
+//  cfg_image_test() - Convert a fixed schema 0 image, with the sensor
+//                     record missing, to this schema and check every
+//                     field decoded from the result; then check that a
+//                     damaged copy is rejected. Uses its own buffers, so
+//                     it may be run at any time. Returns TRUE if all of
+//                     the checks pass.
+//
+bool
+cfg_image_test( void )
+{
+    uint8_t          a[ IMG_MAX_SIZE ];
+    uint8_t          b[ IMG_MAX_SIZE ];
+    const uint8_t *  image;
+    CALIBRATION      cal;
+    SENSOR_SETUP     sensor;
+    OUTPUT_SETUP     output, expect;
+    int              k;
+    bool             ok;
+
+    memset( a, 0, IMG0_SIZE );
+
+    img_put16( a + IMG_HDR_MAGIC, IMG_MAGIC );
+    a[ IMG_HDR_RESERVED ] = IMG0_FOUND_CAL | IMG0_FOUND_OUTPUT;
+    img_put16( a + IMG_HDR_LENGTH, IMG0_SIZE );
+
+    memcpy( a + IMG0_CAL, &ImgTestCal, sizeof( CALIBRATION ) );
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        img_test_output( k, &expect );
+        memcpy( a + IMG0_OUTPUT + k * sizeof( OUTPUT_SETUP ), &expect, sizeof( expect ) );
+    }
+
+    image = img_convert( a, a, b );
+
+    ok = (image[ IMG_HDR_SCHEMA ] == IMG_SCHEMA) && img_valid( image, IMG_SIZE );
+
+    cfg_image_get_calibration( image, &cal );
+
+    ok = ok && (cal.five_volt_external == ImgTestCal.five_volt_external)
+            && (cal.volt_adc_ground_1  == ImgTestCal.volt_adc_ground_1)
+            && (cal.volt_adc_ground_2  == ImgTestCal.volt_adc_ground_2)
+            && (cal.volt_adc_ground_3  == ImgTestCal.volt_adc_ground_3)
+            && (cal.volt_adc_5Vext_1   == ImgTestCal.volt_adc_5Vext_1)
+            && (cal.volt_adc_5Vext_2   == ImgTestCal.volt_adc_5Vext_2)
+            && (cal.volt_adc_5Vext_3   == ImgTestCal.volt_adc_5Vext_3)
+            && (cal.resistive_offset_1 == ImgTestCal.resistive_offset_1)
+            && (cal.resistive_offset_2 == ImgTestCal.resistive_offset_2)
+            && (cal.resistive_offset_3 == ImgTestCal.resistive_offset_3);
+
+    for( k=0; k<IMG_SENSORS; k++ )
+    {
+        cfg_image_get_sensor( image, k, &sensor );
+        ok = ok && (sensor.sensor_type == SENSOR_TYPE_NONE) && (sensor.offset == 0);
+    }
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        img_test_output( k, &expect );
+        cfg_image_get_output( image, k, &output );
+
+        ok = ok && (output.output_type == expect.output_type) &&
+             (memcmp( &output.output, &expect.output, sizeof( OUTPUT_UNION ) ) == 0);
+    }
+
+    // A changed byte must fail the CRC.
+    //
+    memcpy( a, image, IMG_SIZE );
+    a[ IMG_OUTPUT ] ^= 0x01;
+
+    return( ok && !img_valid( a, IMG_SIZE ) );
+}
+
+
+//
+//  img_test_output() - The setup of output "index" in the fixture used by
+//                      cfg_image_test(); relay and analog in turn, with
+//                      negative set points.
+//
+void
+img_test_output( int index, OUTPUT_SETUP * setup )
+{
+    memset( setup, 0, sizeof( OUTPUT_SETUP ) );
+
+    if( index & 1 )
+    {
+        setup->output_type                    = OUTPUT_TYPE_ANALOG;
+        setup->output.analog.sensor_id        = SENSOR_ID_TWO;
+        setup->output.analog.sensor_fail_mode = 0;
+        setup->output.analog.sp               = -200 - index;
+        setup->output.analog.ep               = 300 + index;
+        setup->output.analog.sp_output        = 10;
+        setup->output.analog.ep_output        = 90;
+        setup->output.analog.int_constant     = 3;
+        setup->output.analog.update_rate      = 5;
+        setup->output.analog.output_band      = 25;
+    }
+    else
+    {
+        setup->output_type                    = OUTPUT_TYPE_RELAY;
+        setup->output.relay.sensor_id         = SENSOR_ID_ONE;
+        setup->output.relay.sensor_fail_mode  = 1;
+        setup->output.relay.cut_on            = -750 + index;
+        setup->output.relay.cut_off           = 700 - index;
+        setup->output.relay.min_on_time       = 30;
+        setup->output.relay.min_off_time      = 60;
+        setup->output.relay.on_delay          = 5;
+        setup->output.relay.off_delay         = 10;
+    }
+}
+
+
+//
+//  img_crc() - CRC-16 of an image, except for the CRC field itself.
+//
+uint16_t
+img_crc( const uint8_t * image, uint16_t length )
+{
+    uint16_t  crc;
+
+    crc = calc_crc16( 0xFFFF, image, IMG_HDR_CRC );
+
+    return( calc_crc16( crc, image + IMG_HDR_CRC + 2, length - IMG_HDR_CRC - 2 ) );
+}
+
+
+//
+//  img_get16(), img_get32(), img_put16(), img_put32() - Little endian
+//       fields at any alignment.
+//
+uint16_t
+img_get16( const uint8_t * p )
+{
+    return( (uint16_t)( p[0] | (p[1] << 8) ) );
+}
+
+uint32_t
+img_get32( const uint8_t * p )
+{
+    return( (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24) );
+}
+
+void
+img_put16( uint8_t * p, uint16_t value )
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t)( value >> 8 );
+}
+
+void
+img_put32( uint8_t * p, uint32_t value )
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t)( value >> 8 );
+    p[2] = (uint8_t)( value >> 16 );
+    p[3] = (uint8_t)( value >> 24 );
+}
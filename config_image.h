@@ -0,0 +1,134 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : config_image.h
+
+PURPOSE   : Definitions and function prototypes for the "config_image.c"
+            module; the setup image. The calibration, sensor setup and
+            output setup are saved together as one packed image with a
+            schema number and a single CRC, rather than as C structs
+            with compiler padding.
+
+            Every field is at a fixed offset, little endian and without
+            alignment. An image of the current schema is checked and its
+            fields decoded where it is in the flash, through accessors at
+            those offsets; it is never cast to a struct. An image of an
+            older schema is first converted, one schema at a time, into
+            a copy in RAM.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __config_image_inc
+#define  __config_image_inc
+
+#include <mqx.h>
+#include "system450.h"
+#include "defines.h"
+
+#define  IMG_MAGIC           0x4943       // "CI"
+#define  IMG_SCHEMA          1            // Change when any offset changes
+
+// Header
+//
+#define  IMG_HDR_MAGIC            0       // uint16_t, IMG_MAGIC
+#define  IMG_HDR_SCHEMA           2       // uint8_t,  IMG_SCHEMA
+#define  IMG_HDR_RESERVED         3       // uint8_t,  0
+#define  IMG_HDR_LENGTH           4       // uint16_t, whole image
+#define  IMG_HDR_CRC              6       // uint16_t, CRC-16 of all other bytes
+
+// CALIBRATION
+//
+#define  IMG_CAL                  8
+#define  IMG_CAL_5_VOLT_EXT       0       // float
+#define  IMG_CAL_VIN_GROUND       4       // uint16_t x 3, Sn-1..Sn-3
+#define  IMG_CAL_VIN_5_VOLT      10       // uint16_t x 3
+#define  IMG_CAL_RIN_OFFSET      16       // int16_t  x 3
+#define  IMG_CAL_SIZE            22
+
+// SENSOR_SETUP, for Sn-1..Sn-3
+//
+#define  IMG_SENSOR              30
+#define  IMG_SENSOR_TYPE          0       // uint8_t
+#define  IMG_SENSOR_OFFSET        1       // int8_t
+#define  IMG_SENSOR_SIZE          2
+#define  IMG_SENSORS              3
+
+// OUTPUT_SETUP. The fields after "fail_mode" depend on the output type.
+//
+#define  IMG_OUTPUT              36
+#define  IMG_OUT_TYPE             0       // uint8_t
+#define  IMG_OUT_SENSOR_ID        1       // uint8_t
+#define  IMG_OUT_FAIL_MODE        2       // uint8_t
+#define  IMG_RELAY_CUT_ON         3       // int16_t
+#define  IMG_RELAY_CUT_OFF        5       // int16_t
+#define  IMG_RELAY_MIN_ON         7       // int16_t
+#define  IMG_RELAY_MIN_OFF        9       // int16_t
+#define  IMG_RELAY_ON_DELAY      11       // int16_t
+#define  IMG_RELAY_OFF_DELAY     13       // int16_t
+#define  IMG_ANALOG_SP            3       // int16_t
+#define  IMG_ANALOG_EP            5       // int16_t
+#define  IMG_ANALOG_SP_OUTPUT     7       // uint8_t
+#define  IMG_ANALOG_EP_OUTPUT     8       // uint8_t
+#define  IMG_ANALOG_INT_CONST     9       // uint8_t
+#define  IMG_ANALOG_UPDATE_RATE  10       // uint8_t
+#define  IMG_ANALOG_OUTPUT_BAND  11       // uint8_t
+#define  IMG_OUT_SIZE            15
+#define  IMG_OUTPUTS             10
+
+#define  IMG_SIZE                (IMG_OUTPUT + IMG_OUTPUTS * IMG_OUT_SIZE)
+
+// Schema 0 is the setup as saved by firmware before the image; three
+//   records holding the CALIBRATION, SENSOR_SETUP[] and OUTPUT_SETUP[]
+//   structs as this compiler lays them out. For conversion they are
+//   copied after an image header, whose reserved byte says which of the
+//   records were found.
+//
+#define  IMG0_CAL                 8
+#define  IMG0_SENSOR             (IMG0_CAL + sizeof( CALIBRATION ))
+#define  IMG0_OUTPUT             (IMG0_SENSOR + IMG_SENSORS * sizeof( SENSOR_SETUP ))
+#define  IMG0_SIZE               (IMG0_OUTPUT + MAX_OUTPUTS * sizeof( OUTPUT_SETUP ))
+
+#define  IMG0_FOUND_CAL        0x01
+#define  IMG0_FOUND_SENSOR     0x02
+#define  IMG0_FOUND_OUTPUT     0x04
+
+// Largest image of any schema; the size of the buffers used to convert.
+//
+#define  IMG_MAX_SIZE            ((IMG0_SIZE > IMG_SIZE) ? IMG0_SIZE : IMG_SIZE)
+
+#if  MAX_OUTPUTS > IMG_OUTPUTS
+    #error  The setup image has room for IMG_OUTPUTS outputs only
+#endif
+
+// CFG_IMAGE_INFO - How the setup image was found at start-up, shown by
+//   the "config" shell command.
+//
+typedef struct
+{
+    uint8_t   schema;         // Schema of the stored image, 0 = none,
+                              //   or the records of earlier firmware
+    bool      in_place;       // Read directly from the flash
+    bool      migrated;       // Converted from an older schema
+    uint32_t  rejected;       // Images with a bad header or CRC
+    uint32_t  saves;
+
+}  CFG_IMAGE_INFO;
+
+extern CFG_IMAGE_INFO  CfgImageInfo;
+
+//
+//    Function Prototypes
+//
+const uint8_t * cfg_image_map( void );
+void      cfg_image_get_calibration( const uint8_t * image, CALIBRATION * cal );
+void      cfg_image_get_sensor( const uint8_t * image, int index, SENSOR_SETUP * setup );
+void      cfg_image_get_output( const uint8_t * image, int index, OUTPUT_SETUP * setup );
+bool      cfg_image_save( const CALIBRATION * cal, const DATABASE * db );
+bool      cfg_image_request_save( void );
+bool      cfg_image_test( void );
+
+#endif
@@ -0,0 +1,780 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : config_store.c
+
+PURPOSE   : Persistent configuration store. The configuration items
+            (see CFG_KEY) are kept as a log of records in a ring of
+            CFG_STORE_SECTORS flash sectors.
+
+            Each sector starts with a header holding a sequence number;
+            the sector with the highest is the active sector, where new
+            records are appended. Each record holds one item, its key,
+            a record sequence number and a CRC. The record with the
+            highest sequence number for a key is the current value, so
+            a change costs one record and no erase.
+
+            When the active sector is full the log moves on to the next
+            sector, which is always kept erased. The sector after that,
+            the oldest, is then compacted; the records in it that are
+            still current are copied to the new active sector, keeping
+            their sequence numbers, and it is erased to become the next
+            spare. The sectors are therefore erased in turn.
+
+            Power fail safety;
+              - A record is programmed with a single write and is only
+                used if its CRC is correct. A record cut short by a
+                power failure is ignored and the previous value is used.
+              - A sector is only erased after its current records have
+                been copied. A compaction that was cut short is redone
+                when the store is next started; a copy with the same
+                sequence number in a newer sector is used in preference
+                to the original.
+
+            Erasing or programming the flash stalls the CPU, so items
+            are only written from the Init_Task, the shell, the web
+            server and the Flash_Task, which are all below the control
+            tasks, and never when they have not changed. The control
+            tasks do not write the store themselves; they post a
+            Flash_Task item, which copies what is to be saved with
+            mutexCore locked. The counts in
+            CfgStoreStats are shown by the "config" shell command.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+#include <fio.h>
+#include <lwsem.h>
+
+#include "defines.h"
+#include "func.h"
+#include "config_store.h"
+
+#define  CFG_FLASH_NAME      "flashx:"      // Same file as FLASH_NAME, HVAC.h
+
+// The "flashx:" file is the flash after the code, from the linker symbol
+//    __FLASHX_START_ADDR; see the BSP's flashx file blocks. The flash is
+//    memory mapped, so an item can be read where it is.
+//
+extern uint8_t  __FLASHX_START_ADDR[];
+
+#define  CFG_FLASH_BASE      ((uint32_t) __FLASHX_START_ADDR)
+
+#define  CFG_SECTOR_MAGIC    0x43464753     // "CFGS"
+#define  CFG_RECORD_MAGIC    0xC5A5
+#define  CFG_ERASED_MAGIC    0xFFFF
+
+#define  CFG_ALIGN           8              // Records are padded to the
+                                            //   flash program unit
+#define  CFG_ALIGN_UP( n )   (((n) + CFG_ALIGN - 1) & ~(CFG_ALIGN - 1))
+
+#define  CFG_CHUNK           32             // Bytes compared per read
+
+// CFG_SECTOR_HEADER - The first bytes of each sector in use.
+//
+typedef struct
+{
+    uint32_t  magic;          // CFG_SECTOR_MAGIC
+    uint32_t  seq;            // Sector sequence, the highest is active
+
+}  CFG_SECTOR_HEADER;
+
+// CFG_RECORD_HEADER - Precedes the item in each record. The CRC covers
+//   this header, with "crc" set to 0, and the item.
+//
+typedef struct
+{
+    uint16_t  magic;          // CFG_RECORD_MAGIC
+    uint8_t   key;            // CFG_KEY
+    uint8_t   flags;          // Unused, 0xFF
+    uint16_t  length;         // Item length, 0 = item erased
+    uint16_t  crc;
+    uint32_t  seq;            // Record sequence number
+
+}  CFG_RECORD_HEADER;
+
+#define  CFG_HEADER_SIZE     sizeof( CFG_RECORD_HEADER )
+#define  CFG_BUFFER_SIZE     CFG_ALIGN_UP( CFG_HEADER_SIZE + CFG_MAX_DATA )
+
+CFG_STORE_STATS   CfgStoreStats;
+CFG_INDEX         CfgIndex[ MAX_CFG_KEY ];
+uint32_t          CfgSectorSize;
+uint16_t          CfgActiveSector;
+uint32_t          CfgFreeOffset;           // Next record in the active sector
+uint32_t          CfgSectorErases[ CFG_STORE_SECTORS ];
+uint32_t          CfgAreaSectors;
+
+const char *      CfgKeyName[ MAX_CFG_KEY ] =
+{
+    "calibration",        // CFG_KEY_CALIBRATION
+    "enet_setup",         // CFG_KEY_ENET_SETUP
+    "sensor_setup",       // CFG_KEY_SENSOR_SETUP
+    "output_setup",       // CFG_KEY_OUTPUT_SETUP
+    "wifi_params",        // CFG_KEY_WIFI_PARAMS
+    "control_state",      // CFG_KEY_CONTROL_STATE
+    "setup_image"         // CFG_KEY_SETUP_IMAGE
+};
+
+MQX_FILE_PTR      CfgFile;
+LWSEM_STRUCT      CfgLock;
+bool              CfgReady;
+bool              CfgSectorUsed[ CFG_STORE_SECTORS ];   // Has a valid header
+uint32_t          CfgSectorSeq;
+uint32_t          CfgRecordSeq = 1;
+uint32_t          CfgBuffer[ CFG_BUFFER_SIZE / 4 ];      // One record
+
+
+// Function Prototypes - used by this module only
+//
+bool      cfg_store_record( CFG_KEY key, const void * data, uint16_t size );
+bool      cfg_append( uint8_t key, uint16_t length, uint32_t seq );
+bool      cfg_advance( void );
+bool      cfg_compact( uint16_t sector );
+uint32_t  cfg_sector_scan( uint16_t sector );
+bool      cfg_sector_open( uint16_t sector );
+bool      cfg_sector_erase( uint16_t sector );
+bool      cfg_sector_blank( uint16_t sector );
+bool      cfg_flash_read( uint16_t sector, uint32_t offset, void * data, uint32_t len );
+bool      cfg_flash_write( uint16_t sector, uint32_t offset, const void * data, uint32_t len );
+bool      cfg_flash_equal( uint16_t sector, uint32_t offset, const void * data, uint32_t len );
+
+
+//
+//  cfg_store_init() - Open the flash, find the active sector and the
+//                     current record for each key, and finish any
+//                     compaction that a power failure cut short. An
+//                     empty or unreadable store is formatted. Must be
+//                     called before the items are read.
+//
+bool
+cfg_store_init( void )
+{
+    CFG_SECTOR_HEADER  header;
+    uint32_t           seq[ CFG_STORE_SECTORS ];
+    uint16_t           order[ CFG_STORE_SECTORS ];
+    uint16_t           count, k, j, s;
+    uint32_t           param;
+    _mem_size          size;
+
+    _lwsem_create( &CfgLock, 1 );
+
+    CfgFile = fopen( CFG_FLASH_NAME, NULL );
+
+    if( CfgFile == NULL )
+    {
+        printf( "\nUnable to open flash file %s for the configuration", CFG_FLASH_NAME );
+        return( FALSE );
+    }
+
+    ioctl( CfgFile, FLASH_IOCTL_DISABLE_SECTOR_CACHE, NULL );
+
+    param = 0;
+    ioctl( CfgFile, FLASH_IOCTL_WRITE_PROTECT, &param );
+
+    size = 0;
+    fseek( CfgFile, 0, IO_SEEK_SET );
+    ioctl( CfgFile, FLASH_IOCTL_GET_SECTOR_SIZE, &size );
+
+    if( (size < 256) || (size > 0x8000) )
+    {
+        printf( "\nUnexpected flash sector size %u, configuration not stored", size );
+        return( FALSE );
+    }
+
+    CfgSectorSize = size;
+
+    size = 0;
+    ioctl( CfgFile, FLASH_IOCTL_GET_NUM_SECTORS, &size );
+
+    if( size > CFG_AREA_FIRST_SECTOR )
+        CfgAreaSectors = size - CFG_AREA_FIRST_SECTOR;
+
+    // Read the sector headers. A sector without a valid header is
+    //    either erased, or its erase (or opening) was cut short.
+    //
+    count = 0;
+
+    for( s=0; s<CFG_STORE_SECTORS; s++ )
+    {
+        CfgSectorUsed[s] = cfg_flash_read( s, 0, &header, sizeof( header ) ) &&
+                           (header.magic == CFG_SECTOR_MAGIC);
+
+        if( CfgSectorUsed[s] )
+        {
+            seq[s] = header.seq;
+
+            // Insert into "order", oldest first
+            //
+            for( j=count; (j > 0) && (seq[ order[j-1] ] > header.seq); j-- )
+                order[j] = order[j-1];
+
+            order[j] = s;
+            count++;
+
+            if( header.seq > CfgSectorSeq )
+                CfgSectorSeq = header.seq;
+        }
+        else if( !cfg_sector_blank( s ) )
+        {
+            cfg_sector_erase( s );
+        }
+    }
+
+    // Scan the sectors oldest first, so that a record copied by a
+    //    compaction replaces the original.
+    //
+    for( k=0; k<count; k++ )
+    {
+        CfgActiveSector = order[k];
+        CfgFreeOffset   = cfg_sector_scan( order[k] );
+    }
+
+    if( count == 0 )
+    {
+        if( !cfg_sector_open( 0 ) )
+            return( FALSE );
+    }
+    else
+    {
+        // The sector after the active one must be the erased spare. If
+        //    it is not, its compaction was cut short.
+        //
+        s = (CfgActiveSector + 1) % CFG_STORE_SECTORS;
+
+        if( CfgSectorUsed[s] && !cfg_compact( s ) )
+            return( FALSE );
+    }
+
+    CfgReady = TRUE;
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_store_read() - Read the current value of an item into "data".
+//                     Returns FALSE if there is none, or if its size is
+//                     not "size" (the item was saved by a firmware
+//                     with a different layout); the caller then uses
+//                     its defaults.
+//
+bool
+cfg_store_read( CFG_KEY key, void * data, uint16_t size )
+{
+    CFG_INDEX * index;
+    bool        ok;
+
+    if( !CfgReady || (key >= MAX_CFG_KEY) )
+        return( FALSE );
+
+    _lwsem_wait( &CfgLock );
+
+    index = &CfgIndex[ key ];
+
+    ok = (index->seq != 0) && (index->length == size) && (size != 0) &&
+         cfg_flash_read( index->sector, index->offset + CFG_HEADER_SIZE, data, size );
+
+    _lwsem_post( &CfgLock );
+
+    return( ok );
+}
+
+
+//
+//  cfg_store_write() - Save an item. Nothing is written if the stored
+//                      value is the same.
+//
+bool
+cfg_store_write( CFG_KEY key, const void * data, uint16_t size )
+{
+    CFG_INDEX * index;
+    bool        ok;
+
+    if( !CfgReady || (key >= MAX_CFG_KEY) || (size == 0) || (size > CFG_MAX_DATA) )
+        return( FALSE );
+
+    _lwsem_wait( &CfgLock );
+
+    index = &CfgIndex[ key ];
+
+    if( (index->seq != 0) && (index->length == size) &&
+        cfg_flash_equal( index->sector, index->offset + CFG_HEADER_SIZE, data, size ) )
+    {
+        CfgStoreStats.unchanged++;
+        ok = TRUE;
+    }
+    else
+    {
+        ok = cfg_store_record( key, data, size );
+    }
+
+    _lwsem_post( &CfgLock );
+
+    return( ok );
+}
+
+
+//
+//  cfg_store_erase() - Erase an item, so that its defaults are used.
+//                      This appends an empty record.
+//
+bool
+cfg_store_erase( CFG_KEY key )
+{
+    bool  ok;
+
+    if( !CfgReady || (key >= MAX_CFG_KEY) )
+        return( FALSE );
+
+    _lwsem_wait( &CfgLock );
+
+    if( (CfgIndex[ key ].seq == 0) || (CfgIndex[ key ].length == 0) )
+        ok = TRUE;
+    else
+        ok = cfg_store_record( key, NULL, 0 );
+
+    _lwsem_post( &CfgLock );
+
+    return( ok );
+}
+
+
+//
+//  cfg_store_map() - Returns the address in the flash of the current
+//                    value of an item, and its length, or NULL if there
+//                    is none. The address is only valid until the store
+//                    is next written, which may move the item.
+//
+const void *
+cfg_store_map( CFG_KEY key, uint16_t * length )
+{
+    CFG_INDEX *  index;
+    const void * data = NULL;
+
+    if( !CfgReady || (key >= MAX_CFG_KEY) )
+        return( NULL );
+
+    _lwsem_wait( &CfgLock );
+
+    index = &CfgIndex[ key ];
+
+    if( (index->seq != 0) && (index->length != 0) )
+    {
+        *length = index->length;
+        data    = (const void *)( CFG_FLASH_BASE +
+                                  (CFG_STORE_FIRST_SECTOR + index->sector) * CfgSectorSize +
+                                  index->offset + CFG_HEADER_SIZE );
+    }
+
+    _lwsem_post( &CfgLock );
+
+    return( data );
+}
+
+
+//
+//  cfg_area_map() - Returns the address in the flash of a sector of the
+//                   area, or NULL if there is no such sector.
+//
+const void *
+cfg_area_map( uint16_t sector )
+{
+    if( !CfgReady || (sector >= CfgAreaSectors) )
+        return( NULL );
+
+    return( (const void *)( CFG_FLASH_BASE + (CFG_AREA_FIRST_SECTOR + sector) * CfgSectorSize ) );
+}
+
+
+//
+//  cfg_area_write() - Program erased bytes of a sector of the area.
+//
+bool
+cfg_area_write( uint16_t sector, uint32_t offset, const void * data, uint32_t len )
+{
+    bool  ok;
+
+    if( !CfgReady || (sector >= CfgAreaSectors) || (offset + len > CfgSectorSize) )
+        return( FALSE );
+
+    _lwsem_wait( &CfgLock );
+
+    fseek( CfgFile, (CFG_AREA_FIRST_SECTOR + sector) * CfgSectorSize + offset, IO_SEEK_SET );
+    ok = (write( CfgFile, (void *) data, len ) == len);
+
+    _lwsem_post( &CfgLock );
+
+    return( ok );
+}
+
+
+//
+//  cfg_area_erase() - Erase one sector of the area.
+//
+bool
+cfg_area_erase( uint16_t sector )
+{
+    _mqx_int  result;
+
+    if( !CfgReady || (sector >= CfgAreaSectors) )
+        return( FALSE );
+
+    _lwsem_wait( &CfgLock );
+
+    fseek( CfgFile, (CFG_AREA_FIRST_SECTOR + sector) * CfgSectorSize, IO_SEEK_SET );
+    result = ioctl( CfgFile, FLASH_IOCTL_ERASE_SECTOR, NULL );
+
+    _lwsem_post( &CfgLock );
+
+    return( result == MQX_OK );
+}
+
+
+//
+//  cfg_store_record() - Append a new record for an item, moving on to
+//                       the next sector if the active one is full.
+//                       Called with CfgLock held.
+//
+bool
+cfg_store_record( CFG_KEY key, const void * data, uint16_t size )
+{
+    uint8_t * item = (uint8_t *) CfgBuffer + CFG_HEADER_SIZE;
+
+    if( size )
+        memcpy( item, data, size );
+
+    if( !cfg_append( key, size, CfgRecordSeq ) )
+    {
+        // The active sector is full, or the record did not program
+        //    correctly. Move on to the next sector and try once more.
+        //    The compaction uses the buffer, so the item is copied
+        //    again.
+        //
+        if( !cfg_advance() )
+            return( FALSE );
+
+        if( size )
+            memcpy( item, data, size );
+
+        if( !cfg_append( key, size, CfgRecordSeq ) )
+            return( FALSE );
+    }
+
+    CfgRecordSeq++;
+
+    CfgStoreStats.writes++;
+    CfgStoreStats.data_bytes += size;
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_append() - Append a record to the active sector. The item must
+//                 already be in CfgBuffer, after the header. Returns
+//                 FALSE if there is no room, or if the record does not
+//                 read back correctly; the sector is then treated as
+//                 full.
+//
+bool
+cfg_append( uint8_t key, uint16_t length, uint32_t seq )
+{
+    CFG_RECORD_HEADER * header = (CFG_RECORD_HEADER *) CfgBuffer;
+    uint32_t            size;
+
+    size = CFG_ALIGN_UP( CFG_HEADER_SIZE + length );
+
+    if( CfgFreeOffset + size > CfgSectorSize )
+        return( FALSE );
+
+    header->magic  = CFG_RECORD_MAGIC;
+    header->key    = key;
+    header->flags  = 0xFF;
+    header->length = length;
+    header->crc    = 0;
+    header->seq    = seq;
+
+    memset( (uint8_t *) CfgBuffer + CFG_HEADER_SIZE + length, 0xFF,
+            size - CFG_HEADER_SIZE - length );
+
+    header->crc = calc_crc16( 0xFFFF, (uint8_t *) CfgBuffer, CFG_HEADER_SIZE + length );
+
+    if( !cfg_flash_write( CfgActiveSector, CfgFreeOffset, CfgBuffer, size ) ||
+        !cfg_flash_equal( CfgActiveSector, CfgFreeOffset, CfgBuffer, size ) )
+    {
+        CfgStoreStats.write_errors++;
+        CfgFreeOffset = CfgSectorSize;
+        return( FALSE );
+    }
+
+    if( key < MAX_CFG_KEY )
+    {
+        CfgIndex[ key ].seq    = seq;
+        CfgIndex[ key ].sector = CfgActiveSector;
+        CfgIndex[ key ].offset = CfgFreeOffset;
+        CfgIndex[ key ].length = length;
+    }
+
+    CfgFreeOffset += size;
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_advance() - Make the spare sector the active sector, then
+//                  compact the oldest sector so that it becomes the
+//                  next spare.
+//
+bool
+cfg_advance( void )
+{
+    uint16_t  next;
+
+    next = (CfgActiveSector + 1) % CFG_STORE_SECTORS;
+
+    if( !cfg_sector_open( next ) )
+        return( FALSE );
+
+    return( cfg_compact( (next + 1) % CFG_STORE_SECTORS ) );
+}
+
+
+//
+//  cfg_compact() - Copy the current records in "sector" to the active
+//                  sector, then erase it.
+//
+bool
+cfg_compact( uint16_t sector )
+{
+    CFG_INDEX * index;
+    int         k;
+
+    if( !CfgSectorUsed[ sector ] )
+        return( TRUE );
+
+    for( k=0; k<MAX_CFG_KEY; k++ )
+    {
+        index = &CfgIndex[k];
+
+        if( (index->seq != 0) && (index->sector == sector) )
+        {
+            if( !cfg_flash_read( sector, index->offset + CFG_HEADER_SIZE,
+                                 (uint8_t *) CfgBuffer + CFG_HEADER_SIZE, index->length ) ||
+                !cfg_append( k, index->length, index->seq ) )
+            {
+                return( FALSE );
+            }
+        }
+    }
+
+    CfgStoreStats.compactions++;
+
+    return( cfg_sector_erase( sector ) );
+}
+
+
+//
+//  cfg_sector_scan() - Read the records in a sector and update the
+//                      index. Returns the offset of the first free
+//                      byte, or the sector size if the sector is full
+//                      or ends in a damaged record.
+//
+uint32_t
+cfg_sector_scan( uint16_t sector )
+{
+    CFG_RECORD_HEADER * header = (CFG_RECORD_HEADER *) CfgBuffer;
+    CFG_INDEX *         index;
+    uint32_t            offset, size;
+    uint16_t            crc;
+
+    offset = sizeof( CFG_SECTOR_HEADER );
+
+    while( offset + CFG_HEADER_SIZE <= CfgSectorSize )
+    {
+        if( !cfg_flash_read( sector, offset, CfgBuffer, CFG_HEADER_SIZE ) )
+            return( CfgSectorSize );
+
+        if( (header->magic == CFG_ERASED_MAGIC) && (header->length == 0xFFFF) )
+            return( offset );                 // End of the log
+
+        size = CFG_ALIGN_UP( CFG_HEADER_SIZE + header->length );
+
+        if( (header->magic != CFG_RECORD_MAGIC) || (header->length > CFG_MAX_DATA) ||
+            (offset + size > CfgSectorSize) )
+        {
+            CfgStoreStats.crc_errors++;
+            return( CfgSectorSize );          // Damaged, append no more here
+        }
+
+        if( !cfg_flash_read( sector, offset + CFG_HEADER_SIZE,
+                             (uint8_t *) CfgBuffer + CFG_HEADER_SIZE, header->length ) )
+            return( CfgSectorSize );
+
+        crc = header->crc;
+        header->crc = 0;
+
+        if( crc != calc_crc16( 0xFFFF, (uint8_t *) CfgBuffer, CFG_HEADER_SIZE + header->length ) )
+        {
+            CfgStoreStats.crc_errors++;
+        }
+        else
+        {
+            if( header->key < MAX_CFG_KEY )
+            {
+                index = &CfgIndex[ header->key ];
+
+                if( header->seq >= index->seq )
+                {
+                    index->seq    = header->seq;
+                    index->sector = sector;
+                    index->offset = offset;
+                    index->length = header->length;
+                }
+            }
+
+            if( header->seq >= CfgRecordSeq )
+                CfgRecordSeq = header->seq + 1;
+        }
+
+        offset += size;
+    }
+
+    return( CfgSectorSize );
+}
+
+
+//
+//  cfg_sector_open() - Erase a sector, if need be, and write its header
+//                      so that it becomes the active sector.
+//
+bool
+cfg_sector_open( uint16_t sector )
+{
+    CFG_SECTOR_HEADER  header;
+
+    if( CfgSectorUsed[ sector ] || !cfg_sector_blank( sector ) )
+    {
+        if( !cfg_sector_erase( sector ) )
+            return( FALSE );
+    }
+
+    header.magic = CFG_SECTOR_MAGIC;
+    header.seq   = ++CfgSectorSeq;
+
+    if( !cfg_flash_write( sector, 0, &header, sizeof( header ) ) )
+        return( FALSE );
+
+    CfgSectorUsed[ sector ] = TRUE;
+    CfgActiveSector = sector;
+    CfgFreeOffset   = sizeof( header );
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_sector_erase() - Erase one sector of the store.
+//
+bool
+cfg_sector_erase( uint16_t sector )
+{
+    _mqx_int  result;
+
+    fseek( CfgFile, (CFG_STORE_FIRST_SECTOR + sector) * CfgSectorSize, IO_SEEK_SET );
+    result = ioctl( CfgFile, FLASH_IOCTL_ERASE_SECTOR, NULL );
+
+    CfgSectorUsed[ sector ] = FALSE;
+    CfgSectorErases[ sector ]++;
+    CfgStoreStats.erases++;
+
+    return( result == MQX_OK );
+}
+
+
+//
+//  cfg_sector_blank() - Returns TRUE if every byte of a sector is erased.
+//
+bool
+cfg_sector_blank( uint16_t sector )
+{
+    uint8_t   chunk[ CFG_CHUNK ];
+    uint32_t  offset;
+    int       k;
+
+    for( offset = 0; offset < CfgSectorSize; offset += CFG_CHUNK )
+    {
+        if( !cfg_flash_read( sector, offset, chunk, CFG_CHUNK ) )
+            return( FALSE );
+
+        for( k=0; k<CFG_CHUNK; k++ )
+        {
+            if( chunk[k] != 0xFF )
+                return( FALSE );
+        }
+    }
+
+    return( TRUE );
+}
+
+
+//
+//  cfg_flash_read() - Read from a sector of the store.
+//
+bool
+cfg_flash_read( uint16_t sector, uint32_t offset, void * data, uint32_t len )
+{
+    if( len == 0 )
+        return( TRUE );
+
+    fseek( CfgFile, (CFG_STORE_FIRST_SECTOR + sector) * CfgSectorSize + offset, IO_SEEK_SET );
+
+    return( read( CfgFile, data, len ) == len );
+}
+
+
+//
+//  cfg_flash_write() - Program erased bytes of a sector of the store.
+//
+bool
+cfg_flash_write( uint16_t sector, uint32_t offset, const void * data, uint32_t len )
+{
+    fseek( CfgFile, (CFG_STORE_FIRST_SECTOR + sector) * CfgSectorSize + offset, IO_SEEK_SET );
+
+    CfgStoreStats.flash_bytes += len;
+
+    return( write( CfgFile, (void *) data, len ) == len );
+}
+
+
+//
+//  cfg_flash_equal() - Returns TRUE if the flash holds "data".
+//
+bool
+cfg_flash_equal( uint16_t sector, uint32_t offset, const void * data, uint32_t len )
+{
+    uint8_t          chunk[ CFG_CHUNK ];
+    const uint8_t *  bytes = data;
+    uint32_t         n;
+
+    while( len )
+    {
+        n = (len < CFG_CHUNK) ? len : CFG_CHUNK;
+
+        if( !cfg_flash_read( sector, offset, chunk, n ) || memcmp( chunk, bytes, n ) )
+            return( FALSE );
+
+        offset += n;
+        bytes  += n;
+        len    -= n;
+    }
+
+    return( TRUE );
+}
+
@@ -0,0 +1,108 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : config_store.h
+
+PURPOSE   : Definitions and function prototypes for the "config_store.c"
+            module; the persistent configuration, kept as a log of
+            CRC protected records in the internal flash.
+
+            A change to one item appends one small record. Sectors are
+            only erased when the log wraps around, and then in turn, so
+            that they wear evenly.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __config_store_inc
+#define  __config_store_inc
+
+#include <mqx.h>
+
+// Sector 0 of the "flashx:" file holds the Wi-Fi parameters as written
+//    by earlier firmware. The store uses the sectors that follow it.
+//
+#define  CFG_STORE_FIRST_SECTOR    1
+#define  CFG_STORE_SECTORS         4     // One of these is always erased
+
+#define  CFG_MAX_DATA            256     // Largest item, in bytes
+
+// The sectors after the store are the "area", for logs that are not
+//    configuration items; see journal.h. They are programmed through
+//    cfg_area_write() and cfg_area_erase(), so that all programming of
+//    the flash is done under the one lock.
+//
+#define  CFG_AREA_FIRST_SECTOR   (CFG_STORE_FIRST_SECTOR + CFG_STORE_SECTORS)
+
+// The items in the store. These values are saved in flash; add new keys
+//    at the end and never reuse a value.
+//
+typedef enum
+{
+    CFG_KEY_CALIBRATION   = 0,   // CalData, as saved before the setup image
+    CFG_KEY_ENET_SETUP    = 1,   // coreDB.enet_setup
+    CFG_KEY_SENSOR_SETUP  = 2,   // Sn-1..Sn-3 setup, before the setup image
+    CFG_KEY_OUTPUT_SETUP  = 3,   // coreDB.output[].setup, before the image
+    CFG_KEY_WIFI_PARAMS   = 4,   // *gp_WIFI_Params
+    CFG_KEY_CONTROL_STATE = 5,   // WARM_CONTROL, see warm_restart.h
+    CFG_KEY_SETUP_IMAGE   = 6    // Calibration, sensor and output setup,
+                                 //   see config_image.h
+
+}  CFG_KEY;
+
+#define  MAX_CFG_KEY    CFG_KEY_SETUP_IMAGE + 1
+
+// CFG_STORE_STATS - Counts since reset. The write amplification is
+//   flash_bytes / data_bytes.
+//
+typedef struct
+{
+    uint32_t  writes;          // Records written for callers
+    uint32_t  unchanged;       // Writes skipped, the data was already stored
+    uint32_t  data_bytes;      // Item bytes written for callers
+    uint32_t  flash_bytes;     // Bytes programmed, with headers, padding
+                               //   and records moved by compaction
+    uint32_t  erases;          // Sector erases
+    uint32_t  compactions;     // Sectors compacted when the log wrapped
+    uint32_t  crc_errors;      // Records found with a bad CRC
+    uint32_t  write_errors;    // Records that did not read back correctly
+
+}  CFG_STORE_STATS;
+
+// CFG_INDEX - Where the current record for a key is.
+//
+typedef struct
+{
+    uint32_t  seq;             // Record sequence number, 0 = no record
+    uint16_t  sector;          // Sector in the store, 0 .. CFG_STORE_SECTORS-1
+    uint16_t  offset;          // Offset of the record in the sector
+    uint16_t  length;          // Item length, 0 = erased
+
+}  CFG_INDEX;
+
+extern CFG_STORE_STATS  CfgStoreStats;
+extern CFG_INDEX        CfgIndex[ MAX_CFG_KEY ];
+extern const char *     CfgKeyName[ MAX_CFG_KEY ];
+extern uint32_t         CfgSectorSize;
+extern uint16_t         CfgActiveSector;
+extern uint32_t         CfgFreeOffset;
+extern uint32_t         CfgSectorErases[ CFG_STORE_SECTORS ];
+extern uint32_t         CfgAreaSectors;     // Sectors in the area, 0 = none
+
+//
+//    Function Prototypes
+//
+bool      cfg_store_init( void );
+bool      cfg_store_read( CFG_KEY key, void * data, uint16_t size );
+bool      cfg_store_write( CFG_KEY key, const void * data, uint16_t size );
+bool      cfg_store_erase( CFG_KEY key );
+const void * cfg_store_map( CFG_KEY key, uint16_t * length );
+
+const void * cfg_area_map( uint16_t sector );
+bool      cfg_area_write( uint16_t sector, uint32_t offset, const void * data, uint32_t len );
+bool      cfg_area_erase( uint16_t sector );
+
+#endif
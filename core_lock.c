@@ -0,0 +1,291 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : core_lock.c
+
+PURPOSE   : Instrumented lock and unlock of mutexCore.
+
+            mutexCore is locked by tasks of very different priority;
+            Sensor_Task runs at 9 while the web server and shell run
+            below it. mutexCore is therefore created with priority
+            inheritance, so a low priority task holding it is raised to
+            the priority of the highest task waiting for it.
+            core_lock_init() checks that the attribute took effect, and
+            the result is reported by the "lock" shell command.
+
+            For each call site the wait and hold times are measured with
+            the DWT cycle counter. When a task has to wait, the task
+            that owned the mutex and the site it was locked from are
+            recorded, so "lock" shows which code is blocking which.
+
+            Hold time is checked against CoreLockHoldLimitUs when the
+            mutex is released, and the overrun is counted then by the
+            owner, with the mutex held. A task about to lock the mutex
+            also checks how long it has been held, and marks the hold
+            if it is already too long, so a holder that is stuck is
+            shown by "lock" before it ever unlocks.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+#include <mutex.h>
+
+#include "defines.h"
+#include "global.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+#include "core_lock.h"
+
+#define  CYCLES_PER_USEC   (BSP_CORE_CLOCK / 1000000)
+
+CORE_LOCK_STATS     CoreLockStats[ MAX_CORE_SITE ];
+uint32_t            CoreLockHoldLimitUs = CORE_LOCK_HOLD_LIMIT_US;
+bool                CoreLockInheritOk;
+
+const char *        CoreLockSiteName[ MAX_CORE_SITE ] =
+{
+    "sensor_update",      // CORE_SITE_SENSOR_UPDATE
+    "cgi_adc_data",       // CORE_SITE_CGI_ADC
+    "control",            // CORE_SITE_CONTROL
+    "config_save"         // CORE_SITE_CONFIG_SAVE
+};
+
+// The current owner. Written only by the owner while it holds mutexCore,
+//   read without the lock by tasks about to wait for it.
+//
+volatile uint16_t   CoreLockOwner;       // Task number, 0 = not owned
+volatile uint8_t    CoreLockOwnerSite;
+volatile uint32_t   CoreLockStart;       // Cycle count when locked
+volatile uint32_t   CoreLockOverrunStart;  // CoreLockStart of a hold found
+                                           //   too long by a waiter
+
+
+// Function Prototypes - used by this module only
+//
+void    core_lock_check_owner( uint32_t now );
+void    core_lock_acquired( CORE_LOCK_SITE site, uint32_t start, uint32_t owner, uint32_t owner_site );
+
+
+//
+//  core_lock_init() - Create mutexCore with priority inheritance and
+//                     priority ordered waiting, and check that the
+//                     attributes took effect.
+//
+void
+core_lock_init( void )
+{
+    MUTEX_ATTR_STRUCT  attr;
+
+    if( _mutatr_init( &attr ) != MQX_OK )
+        _mqx_exit( 0 );
+
+    _mutatr_set_sched_protocol( &attr, MUTEX_PRIO_INHERIT );
+    _mutatr_set_wait_protocol( &attr, MUTEX_PRIORITY_QUEUEING );
+
+    if( _mutex_init( &mutexCore, &attr ) != MQX_OK )
+    {
+        _mqx_exit( 0 );   // "0" is the error code
+    }
+
+    _mutatr_destroy( &attr );
+
+    // MQX quietly ignores the inheritance attribute if it was built
+    //    without support for it, so check the mutex itself.
+    //
+    CoreLockInheritOk = (mutexCore.PROTOCOLS & MUTEX_PRIO_INHERIT) != 0;
+
+    core_lock_clear();
+}
+
+
+//
+//  core_lock() - Lock mutexCore on behalf of "site". Returns the result
+//                of _mutex_lock(); the caller may only access coreDB and
+//                must call core_unlock() if this returns MQX_OK.
+//
+_mqx_uint
+core_lock( CORE_LOCK_SITE site )
+{
+    uint32_t          start, owner, owner_site;
+    _mqx_uint         result;
+
+    start      = TMON_CYCLE_COUNT();
+    owner      = CoreLockOwner;
+    owner_site = CoreLockOwnerSite;
+
+    core_lock_check_owner( start );
+
+    TRACE_MUTEX( TRACE_MUTEX_REQUEST );
+
+    result = _mutex_lock( &mutexCore );
+
+    if( result != MQX_OK )
+        return( result );
+
+    core_lock_acquired( site, start, owner, owner_site );
+
+    return( MQX_OK );
+}
+
+
+//
+//  core_try_lock() - As core_lock(), but returns MQX_EBUSY at once if
+//                    mutexCore is owned by another task. Used by tasks
+//                    that must not wait and can work from their own
+//                    copy of the database until the next try.
+//
+_mqx_uint
+core_try_lock( CORE_LOCK_SITE site )
+{
+    uint32_t          start, owner, owner_site;
+    _mqx_uint         result;
+
+    start      = TMON_CYCLE_COUNT();
+    owner      = CoreLockOwner;
+    owner_site = CoreLockOwnerSite;
+
+    core_lock_check_owner( start );
+
+    result = _mutex_try_lock( &mutexCore );
+
+    if( result != MQX_OK )
+    {
+        CoreLockStats[ site ].busy++;
+        return( result );
+    }
+
+    TRACE_MUTEX( TRACE_MUTEX_REQUEST );
+    core_lock_acquired( site, start, owner, owner_site );
+
+    return( MQX_OK );
+}
+
+
+//
+//  core_lock_check_owner() - Watchdog; mark the current hold if it has
+//                            already gone on too long. Nothing else is
+//                            written, as the mutex is not held here; the
+//                            mark is tagged with the start of the hold,
+//                            so one left by a waiter that was preempted
+//                            is not taken for a later hold.
+//
+void
+core_lock_check_owner( uint32_t now )
+{
+    uint32_t  start = CoreLockStart;
+
+    if( CoreLockOwner &&
+        ((int32_t)(now - start) > (int32_t)(CoreLockHoldLimitUs * CYCLES_PER_USEC)) )
+    {
+        CoreLockOverrunStart = start;
+    }
+}
+
+
+//
+//  core_lock_acquired() - Record a successful lock. "owner" and
+//                         "owner_site" are the owner seen before the
+//                         lock was requested, 0 if there was none.
+//
+void
+core_lock_acquired( CORE_LOCK_SITE site, uint32_t start, uint32_t owner, uint32_t owner_site )
+{
+    CORE_LOCK_STATS * stats = &CoreLockStats[ site ];
+    uint32_t          now;
+
+    TRACE_MUTEX( TRACE_MUTEX_LOCK );
+
+    now = TMON_CYCLE_COUNT();
+
+    CoreLockStart     = now;
+    CoreLockOwnerSite = site;
+    CoreLockOwner     = (uint16_t) _task_get_id();
+
+    // The statistics are only written while mutexCore is held.
+    //
+    stats->count++;
+    stats->last_owner = CoreLockOwner;
+
+    if( owner )
+    {
+        stats->contended++;
+        stats->last_contender = owner;
+        stats->contender_site = owner_site;
+    }
+
+    now -= start;
+    stats->wait_cycles += now;
+
+    if( now > stats->wait_max )
+        stats->wait_max = now;
+}
+
+
+//
+//  core_unlock() - Unlock mutexCore, locked by core_lock() for "site".
+//
+void
+core_unlock( CORE_LOCK_SITE site )
+{
+    CORE_LOCK_STATS * stats = &CoreLockStats[ site ];
+    uint32_t          hold;
+
+    hold = TMON_CYCLE_COUNT() - CoreLockStart;
+
+    stats->hold_cycles += hold;
+
+    if( hold > stats->hold_max )
+        stats->hold_max = hold;
+
+    if( hold > CoreLockHoldLimitUs * CYCLES_PER_USEC )
+        stats->overruns++;
+
+    CoreLockOwner = 0;
+
+    TRACE_MUTEX( TRACE_MUTEX_UNLOCK );
+
+    _mutex_unlock( &mutexCore );
+}
+
+
+//
+//  core_lock_overrun_site() - The site of the current hold if a waiter has
+//                             found it too long, MAX_CORE_SITE if not. The
+//                             hold is counted when it is released.
+//
+uint32_t
+core_lock_overrun_site( void )
+{
+    uint32_t  site = CoreLockOwnerSite;
+
+    if( CoreLockOwner && (CoreLockOverrunStart == CoreLockStart) )
+        return( site );
+
+    return( MAX_CORE_SITE );
+}
+
+
+//
+//  core_lock_clear() - Reset the statistics of all call sites.
+//
+void
+core_lock_clear( void )
+{
+    memset( CoreLockStats, 0, sizeof( CoreLockStats ) );
+}
+
+
+//
+//  core_lock_cycles_to_us() - Convert a cycle count to microseconds.
+//
+uint32_t
+core_lock_cycles_to_us( uint32_t cycles )
+{
+    return( cycles / CYCLES_PER_USEC );
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : core_lock.h
+
+PURPOSE   : Definitions and function prototypes for the "core_lock.c"
+            module. All access to mutexCore goes through core_lock()
+            and core_unlock(), which record for each call site how long
+            the caller waited for the mutex, how long it held it, and
+            which task it had to wait for.
+
+            A hold longer than CoreLockHoldLimitUs is counted as an
+            overrun against the site that held the mutex. The limit is
+            set with the "lock" shell command.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __core_lock_inc
+#define  __core_lock_inc
+
+#include <mqx.h>
+#include <mutex.h>
+
+#define  CORE_LOCK_HOLD_LIMIT_US    500    // Default maximum hold time
+
+// Places in the code that lock mutexCore. These values are used to
+//   index into CoreLockStats[].
+//
+typedef enum
+{
+    CORE_SITE_SENSOR_UPDATE = 0,   // Sensor_Task, sensor setup
+    CORE_SITE_CGI_ADC       = 1,   // cgi_adc_data(), sensor setup
+    CORE_SITE_CONTROL       = 2,   // Control_Task, output state and setup
+    CORE_SITE_CONFIG_SAVE   = 3    // Flash_Task and warm restart snapshot,
+                                   //   copy of what is saved
+
+}  CORE_LOCK_SITE;
+
+#define  MAX_CORE_SITE   CORE_SITE_CONFIG_SAVE + 1
+
+// CORE_LOCK_STATS - Statistics for one call site. Times are in core
+//   clock cycles.
+//
+typedef struct
+{
+    uint32_t   count;           // Times the mutex was locked here
+    uint32_t   contended;       // Times the mutex was already owned
+    uint32_t   busy;            // core_try_lock() calls that gave up
+    uint32_t   wait_cycles;     // Total time spent waiting
+    uint32_t   wait_max;
+    uint32_t   hold_cycles;     // Total time the mutex was held
+    uint32_t   hold_max;
+    uint32_t   overruns;        // Holds longer than CoreLockHoldLimitUs
+    uint16_t   last_owner;      // Task number that last locked here
+    uint16_t   last_contender;  // Task number that owned it when we waited
+    uint8_t    contender_site;  // Site the contender locked it from
+}  CORE_LOCK_STATS;
+
+extern CORE_LOCK_STATS  CoreLockStats[ MAX_CORE_SITE ];
+extern const char *     CoreLockSiteName[ MAX_CORE_SITE ];
+extern uint32_t         CoreLockHoldLimitUs;
+extern bool             CoreLockInheritOk;
+
+//
+//    Function Prototypes
+//
+void      core_lock_init( void );
+_mqx_uint core_lock( CORE_LOCK_SITE site );
+_mqx_uint core_try_lock( CORE_LOCK_SITE site );
+void      core_unlock( CORE_LOCK_SITE site );
+void      core_lock_clear( void );
+uint32_t  core_lock_overrun_site( void );
+uint32_t  core_lock_cycles_to_us( uint32_t cycles );
+
+#endif
@@ -0,0 +1,169 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : db_notify.c
+
+PURPOSE   : Change notification for the database. Each group of fields
+            has a version number that db_publish() increments, and a
+            list of subscribers that are told which groups changed.
+
+            A subscriber is notified once, then collects all of the
+            groups that changed since with db_changes() and copies only
+            those. Further changes before it does so are merged into the
+            pending set rather than waking it again.
+
+            Subscriber counts are shown by the "notify" shell command.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <mqx.h>
+#include <bsp.h>
+#include <lwevent.h>
+
+#include "defines.h"
+#include "work_queue.h"
+#include "db_notify.h"
+
+uint32_t         DbVersion[ MAX_DB_GROUP ];
+DB_SUBSCRIBER *  DbSubscribers;           // Linked list, newest first
+
+const char *     DbGroupName[ MAX_DB_GROUP ] =
+{
+    "sensor_status",      // DB_GROUP_SENSOR_STATUS
+    "relay",              // DB_GROUP_RELAY
+    "hvac_params"         // DB_GROUP_HVAC_PARAMS
+};
+
+
+// Function Prototypes - used by this module only
+//
+void      db_notify( DB_SUBSCRIBER * sub, uint32_t now );
+uint32_t  db_time_ms( void );
+
+
+//
+//  db_subscribe() - Add a subscriber. The structure must remain valid
+//                   for as long as the firmware runs.
+//
+void
+db_subscribe( DB_SUBSCRIBER * sub )
+{
+    sub->pending       = 0;
+    sub->notified      = FALSE;
+    sub->last_ms       = 0;
+    sub->notifications = 0;
+    sub->coalesced     = 0;
+    sub->limited       = 0;
+
+    _int_disable();
+    sub->next     = DbSubscribers;
+    DbSubscribers = sub;
+    _int_enable();
+}
+
+
+//
+//  db_publish() - Called by a producer after it has changed the fields
+//                 of one or more groups. Notifies every subscriber to
+//                 those groups, and any subscriber whose notification
+//                 was held back by its rate limit.
+//
+void
+db_publish( uint32_t groups )
+{
+    DB_SUBSCRIBER * sub;
+    uint32_t        now;
+    int             k;
+
+    now = db_time_ms();
+
+    _int_disable();
+
+    for( k = 0; k < MAX_DB_GROUP; k++ )
+    {
+        if( groups & DB_BIT( k ) )
+            DbVersion[k]++;
+    }
+
+    for( sub = DbSubscribers; sub != NULL; sub = sub->next )
+    {
+        if( sub->groups & groups )
+        {
+            if( sub->notified )
+                sub->coalesced++;
+
+            sub->pending |= sub->groups & groups;
+        }
+
+        if( sub->pending && !sub->notified )
+            db_notify( sub, now );
+    }
+
+    _int_enable();
+}
+
+
+//
+//  db_changes() - Returns the groups that have changed since the last
+//                 call, and allows the subscriber to be notified again.
+//
+uint32_t
+db_changes( DB_SUBSCRIBER * sub )
+{
+    uint32_t  changed;
+
+    _int_disable();
+    changed       = sub->pending;
+    sub->pending  = 0;
+    sub->notified = FALSE;
+    _int_enable();
+
+    return( changed );
+}
+
+
+//
+//  db_notify() - Notify one subscriber, unless its rate limit does not
+//                allow it yet. Called with interrupts disabled.
+//
+void
+db_notify( DB_SUBSCRIBER * sub, uint32_t now )
+{
+    if( sub->min_interval_ms && sub->notifications &&
+        (now - sub->last_ms < sub->min_interval_ms) )
+    {
+        sub->limited++;
+        return;
+    }
+
+    sub->notified = TRUE;
+    sub->last_ms  = now;
+    sub->notifications++;
+
+    if( sub->event != NULL )
+        _lwevent_set( sub->event, sub->event_mask );
+
+    if( sub->callback != NULL )
+    {
+        if( !work_queue_post( WORK_PRIO_LOW, sub->callback, sub->ctx, sub->pending ) )
+            sub->notified = FALSE;      // Try again on the next publish
+    }
+}
+
+
+//
+//  db_time_ms() - Milliseconds since reset.
+//
+uint32_t
+db_time_ms( void )
+{
+    TIME_STRUCT  time;
+
+    _time_get_elapsed( &time );
+
+    return( time.SECONDS * 1000 + time.MILLISECONDS );
+}
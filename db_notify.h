@@ -0,0 +1,83 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : db_notify.h
+
+PURPOSE   : Definitions and function prototypes for the "db_notify.c"
+            module. Producers call db_publish() when a group of fields
+            in the database changes. Tasks that need to know subscribe
+            to the groups they use, and are woken by an lwevent or get
+            a callback in the Work_Task, instead of polling.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __db_notify_inc
+#define  __db_notify_inc
+
+#include <mqx.h>
+#include <lwevent.h>
+#include "work_queue.h"
+
+// Groups of database fields that are published together.
+//
+typedef enum
+{
+    DB_GROUP_SENSOR_STATUS = 0,   // Live sensor status, see live_status.h
+    DB_GROUP_RELAY         = 1,   // gRelayState
+    DB_GROUP_HVAC_PARAMS   = 2    // HVAC_Params; mode, fan, set point, scale
+
+}  DB_GROUP;
+
+#define  MAX_DB_GROUP   DB_GROUP_HVAC_PARAMS + 1
+
+#define  DB_BIT( group )    (1 << (group))
+
+// DB_SUBSCRIBER - One subscriber. The subscriber owns the structure and
+//   fills in the first part before calling db_subscribe(). Either
+//   "event" or "callback" is used to notify it.
+//
+//   Changes are coalesced; a subscriber that has not yet called
+//   db_changes() since it was last notified is not notified again, the
+//   new groups are simply added to those pending. With "min_interval_ms"
+//   set, notifications are also spaced at least that far apart. A
+//   change held back by the rate limit is delivered by the next call
+//   to db_publish() after the interval, at most about one second later
+//   since the sensor status is published every second.
+//
+typedef struct db_subscriber
+{
+    const char *    name;
+    uint32_t        groups;            // DB_BIT()s of interest
+    LWEVENT_STRUCT * event;            // Set "event_mask" in this event, or
+    _mqx_uint       event_mask;
+    WORK_FUNC       callback;          //   post this to the Work_Task, with
+    void *          ctx;               //   ctx and the changed groups.
+    uint32_t        min_interval_ms;   // 0 = no rate limit
+
+    // Maintained by db_notify.c
+    //
+    volatile uint32_t  pending;        // Groups changed, not yet collected
+    volatile bool      notified;       // Notified, db_changes() not called
+    uint32_t        last_ms;           // Time of the last notification
+    uint32_t        notifications;
+    uint32_t        coalesced;         // Changes merged into a pending one
+    uint32_t        limited;           // Notifications held back by rate
+    struct db_subscriber * next;
+}  DB_SUBSCRIBER;
+
+extern uint32_t       DbVersion[ MAX_DB_GROUP ];
+extern const char *   DbGroupName[ MAX_DB_GROUP ];
+extern DB_SUBSCRIBER * DbSubscribers;
+
+//
+//    Function Prototypes
+//
+void      db_subscribe( DB_SUBSCRIBER * sub );
+void      db_publish( uint32_t groups );
+uint32_t  db_changes( DB_SUBSCRIBER * sub );
+
+#endif
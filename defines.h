@@ -45,6 +45,8 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 #define WMICONFIG_TASK2  14
 #define BUTTON_TASK      15
 #define RCONTROL_TASK    16
+#define WORK_TASK        17
+#define FLASH_TASK       18
 
 
 
@@ -640,6 +642,93 @@ typedef struct                  // Output Setup data structure
 }    OUTPUT_SETUP;
 
 
+//
+//  SETPOINT_LIMITS - The limits that apply to the setpoints of an output,
+//                    for one sensor type. They are gathered from the
+//                    per sensor type tables by init_setpoint_limits(),
+//                    so that a setup is validated with one lookup.
+//
+enum{  LIMITS_SENSOR,          // Output references Sn-1..3, HI-2, HI-3
+       LIMITS_DIFF_SENSOR,     // Output references Sn-d
+       NUM_LIMITS_KIND  };
+
+typedef struct
+{
+    int16_t   min_sp;          // Lowest setpoint (ON, OFF, SP, EP)
+    int16_t   max_sp;          // Highest setpoint
+    int16_t   min_diff;        // Smallest ON\OFF or SP\EP difference
+    uint8_t   increment;       // Up\Down step
+    uint8_t   decimal_pt;      // See get_sensor_decimal_pt()
+
+}    SETPOINT_LIMITS;
+
+
+//
+//  VALID_ERROR - One error found in a setup by the check_xxx_setup()
+//                functions. Only the code and the limits that apply
+//                are kept; render_valid_errors() makes the text when
+//                there is somewhere to show it.
+//
+enum{  VALID_SENSOR_TYPE,      // Sensor setup, "item" is the sensor ID
+       VALID_OFFSET,
+       VALID_OFFSET_TENTHS,
+
+       VALID_SENSOR_ID,        // Output setup, "item" is the output ID
+       VALID_ON_POINT,
+       VALID_OFF_POINT,
+       VALID_ON_OFF_DIFF,
+       VALID_ON_DELAY,
+       VALID_OFF_DELAY,
+       VALID_MIN_ON_TIME,
+       VALID_MIN_OFF_TIME,
+       VALID_SP,
+       VALID_EP,
+       VALID_SP_EP_DIFF,
+       VALID_SP_OUTPUT,
+       VALID_EP_OUTPUT,
+       VALID_INT_CONSTANT,
+       VALID_UPDATE_RATE,
+       VALID_OUTPUT_BAND,
+       VALID_FAIL_MODE,
+       NUM_VALID_CODES  };
+
+enum{  VALID_FORMAT_NONE,      // How the limits are shown: not at all,
+       VALID_FORMAT_RANGE,     //   "min to max",
+       VALID_FORMAT_TENTHS,    //   "min to max" with one decimal place,
+       VALID_FORMAT_SETPOINT,  //   "min to max" as setpoints, or
+       VALID_FORMAT_DIFF  };   //   "min" as a setpoint difference.
+
+#define  MAX_VALID_ERRORS   16  // Errors kept in one VALID_RESULT
+#define  MAX_VALID_MESSAGE 1024  // Text of one setup's errors, see valid_xxx_setup()
+
+typedef struct
+{
+    uint8_t   code;            // VALID_xxx
+    uint8_t   item;            // Sensor or output ID the error is in
+    uint8_t   sensor_type;     // Used to show setpoint limits
+    int16_t   min;
+    int16_t   max;
+
+}    VALID_ERROR;
+
+typedef struct
+{
+    uint8_t      count;        // Entries used in error[]
+    uint8_t      dropped;      // Errors found once error[] was full
+    bool         show_item;    // Name the sensor or output in the text
+
+    VALID_ERROR  error[ MAX_VALID_ERRORS ];
+
+}    VALID_RESULT;
+
+typedef struct
+{
+    const char *  text;        // printf() format of the message
+    uint8_t       format;      // VALID_FORMAT_xxx
+
+}    VALID_TEXT;
+
+
 //
 //  CALIBRATION - This data structure is used to hold calibration data
 //                for resistive and voltage type sensor inputs. The gain
@@ -794,8 +883,17 @@ typedef struct
 //             are rules which govern the validity of the core data
 //             as it relates to sensor and output setup values.
 //
+//             Only coreDB is a full DATABASE. Each task keeps a view
+//             holding just the fields it uses, see SENSOR_VIEW and
+//             ENET_VIEW; the relay engine keeps a table of the relay
+//             setup, see relay_control.h. "config_version" is
+//             incremented whenever the setup in coreDB changes, so a
+//             task only copies the setup when its view is out of date.
+//
 typedef struct
 {  
+    uint32_t          config_version;         // Incremented on setup change
+
     OUTPUT            output[ MAX_OUTPUTS ];  // Output Status and Setup params
     SENSOR            sensor[ MAX_SENSORS ];  // Sensor Status and Setup params
 
@@ -811,6 +909,38 @@ typedef struct
 }   DATABASE;
 
 
+//
+//  SENSOR_VIEW - The part of the database used by the Sensor Task. The
+//                sensors are calculated here and the status is published
+//                from here, see live_status.h.
+//
+typedef struct
+{
+    uint32_t          config_version;         // coreDB setup last copied
+
+    SENSOR            sensor[ MAX_SENSORS ];  // Sensor Status and Setup params
+
+    float             cpu_temp;               // CPU Temp, in degrees F
+    float             five_volt_ext;          // 5 volt external
+    float             ten_volt_ref;           // 10 volt reference
+
+}   SENSOR_VIEW;
+
+
+//
+//  ENET_VIEW - The part of the database used by the Web Server. The
+//              sensor status is read with live_status_read(), only the
+//              sensor setup is copied.
+//
+typedef struct
+{
+    uint32_t          config_version;         // coreDB setup last copied
+
+    SENSOR_SETUP      sensor_setup[ MAX_SENSORS ];
+
+}   ENET_VIEW;
+
+
 //
 //  SCREEN_TYPE.. - A screen type describes the basic funcitionality of
 //                  a given display screen. The enums defined here are
@@ -36,12 +36,14 @@
 A_BOOL reg_query_bool = A_FALSE;
 pointer pQuery;
 
+/* Milliseconds since boot. 16 bits would wrap after 65 s, before the
+   later application stages are recorded. */
 struct event_profile {
    A_UINT8 event_id; 
-   A_UINT16 timestamp;
+   A_UINT32 timestamp;
 };
 
-#define MAX_PROFILE_SIZE	20
+#define MAX_PROFILE_SIZE	32
 
 struct event_profile profiles[MAX_PROFILE_SIZE];
 A_UINT8 profile_head = 0, profile_trail = 0;
@@ -58,6 +60,16 @@ A_UINT8 *event_str [] =
     "end scan",             // BOOT_PROFILE_DONE_SCAN
     "power up",             // BOOT_PROFILE_POWER_UP
     "boot param",           // BOOT_PROFILE_BOOT_PARAMETER
+    "app core",             // BOOT_PROFILE_APP_BASE + BOOT_STAGE_CORE
+    "app monitor",          // BOOT_PROFILE_APP_BASE + BOOT_STAGE_MONITOR
+    "app work",             // BOOT_PROFILE_APP_BASE + BOOT_STAGE_WORK
+    "app scheduler",        // BOOT_PROFILE_APP_BASE + BOOT_STAGE_SCHEDULER
+    "app sensing",          // BOOT_PROFILE_APP_BASE + BOOT_STAGE_SENSING
+    "app control",          // BOOT_PROFILE_APP_BASE + BOOT_STAGE_CONTROL
+    "app shell",            // BOOT_PROFILE_APP_BASE + BOOT_STAGE_SHELL
+    "app network",          // BOOT_PROFILE_APP_BASE + BOOT_STAGE_NETWORK
+    "app wifi",             // BOOT_PROFILE_APP_BASE + BOOT_STAGE_WIFI
+    "app http",             // BOOT_PROFILE_APP_BASE + BOOT_STAGE_HTTP
 };
 
 #define CUSTOM_DELAY_TMR 0
@@ -384,28 +396,42 @@ void LED_SetOutput(uint_32 signal)
 
 #define CYCLE_QUEUE_INC(ndx) {ndx = (ndx + 1) % MAX_PROFILE_SIZE;}
 
-void add_one_profile(A_UINT8 event_id, A_UINT16  timestamp)
+/* Called from the driver and from the application tasks through
+   boot_stage_ready(), so the ring is updated with interrupts disabled. */
+void add_one_profile(A_UINT8 event_id, A_UINT32  timestamp)
 {
+    _int_disable();
+
     profiles[profile_head].event_id = event_id;
     profiles[profile_head].timestamp = timestamp;
 
     CYCLE_QUEUE_INC(profile_head);
     if (profile_head == profile_trail)
         CYCLE_QUEUE_INC(profile_trail);		
+
+    _int_enable();
 }
 
 int_32 print_perf(int_32 argc, char_ptr argv[])
 {
     int_32 ret = 0;
-    A_UINT8   ndx;
+    A_UINT8   ndx, head, trail;
+    struct event_profile copy[MAX_PROFILE_SIZE];
+
+    /* Print from a copy, taken with interrupts disabled */
+    _int_disable();
+    _mem_copy(profiles, copy, sizeof(copy));
+    head = profile_head;
+    trail = profile_trail;
+    _int_enable();
 
-    if (profile_trail == profile_head)
+    if (trail == head)
         return ret;
 
     printf ("       Event        TIME STAMP\n");
-    ndx = profile_trail;
-    while (ndx !=  profile_head) {
-        printf("% 15s   % 6d\n", event_str[profiles[ndx].event_id], profiles[ndx].timestamp);
+    ndx = trail;
+    while (ndx !=  head) {
+        printf("% 15s   % 6lu\n", event_str[copy[ndx].event_id], (unsigned long) copy[ndx].timestamp);
         CYCLE_QUEUE_INC(ndx);	
     }
 
@@ -415,7 +441,7 @@ int_32 print_perf(int_32 argc, char_ptr argv[])
 void boot_profile_output(uint_32 signal) 
 {
     int		i;
-    A_INT32	  timestamp;
+    A_UINT32	  timestamp;
    TIME_STRUCT    time;
 
    _time_get_elapsed(&time);
@@ -32,6 +32,8 @@
 #include "softap.h"
 #include <string.h>
 #include <stdlib.h>
+#include "event_trace.h"
+#include "boot_stage.h"
 
 //#include "throughput.h"
 
@@ -194,7 +196,9 @@ static void DoWork(void)
 {
 #if USE_ATH_CHANGES
 	if(strcmp(task_argv[0], "wmiconfig") == 0){
+		TRACE_BEGIN(TRACE_MARK_WMICONFIG);
 		wmiconfig_handler(task_argc, task_argv);
+		TRACE_END(TRACE_MARK_WMICONFIG);
 	}else if(strcmp(task_argv[0], "iwconfig") == 0){
 		wmi_iwconfig(task_argc, task_argv);
 	}
@@ -282,6 +286,7 @@ void wmiconfig_Task2(uint_32 temp)
 	power_mode = REC_POWER;
 	
 	hvac_init = 1;
+	boot_stage_ready(BOOT_STAGE_NETWORK);
 
 	_lwevent_create(&task_event, 1/* autoclear */);
 		
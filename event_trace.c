@@ -0,0 +1,605 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : event_trace.c
+
+PURPOSE   : Binary event trace recorder. Tasks and ISRs record small
+            time stamped events into a ring buffer; the oldest records
+            are overwritten once the buffer is full.
+
+            The buffer is read out as text (shell) or as Chrome trace
+            JSON (CGI). While it is being read, recording is paused so
+            that the records being formatted are not overwritten. Readers
+            may overlap, so the pause is a count of open readers, kept
+            apart from TraceEnabled, which is only set by the user.
+
+            Time stamps are the DWT cycle counter, which is enabled by
+            task_monitor_init(). The counter wraps every 35 seconds at
+            120 MHz, so the reader accumulates the difference between
+            consecutive records rather than using absolute values.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <intrinsics.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+
+#define  CYCLES_PER_USEC   (BSP_CORE_CLOCK / 1000000)
+
+#define  TRACE_PID_TASKS   1     // Chrome "process" holding task tracks
+#define  TRACE_PID_CPU     2     // Chrome "process" holding sampled CPU
+#define  TRACE_TID_ISR     0     // Track used for ISRs and events
+
+// Reader states, see TRACE_CURSOR.state
+//
+enum{  TRACE_READ_HEADER,
+       TRACE_READ_NAMES,
+       TRACE_READ_RECORDS,
+       TRACE_READ_FOOTER,
+       TRACE_READ_DONE };
+
+TRACE_RECORD       TraceBuffer[ TRACE_BUFFER_SIZE ];
+volatile uint32_t  TraceHead;          // Total records written, not wrapped
+volatile bool      TraceEnabled;
+volatile uint32_t  TraceReaders;       // Open cursors, recording paused if > 0
+volatile uint32_t  TraceClassMask;
+
+// Class of each record type, used with TraceClassMask.
+//
+const uint8_t TraceTypeClass[ MAX_TRACE_TYPE ] =
+{
+    TRACE_CLASS_TASK,       // TRACE_TASK_SWITCH
+    TRACE_CLASS_ISR,        // TRACE_ISR_ENTER
+    TRACE_CLASS_ISR,        // TRACE_ISR_EXIT
+    TRACE_CLASS_LWEVENT,    // TRACE_LWEVENT_SET
+    TRACE_CLASS_LWEVENT,    // TRACE_LWEVENT_WAIT
+    TRACE_CLASS_MUTEX,      // TRACE_MUTEX_REQUEST
+    TRACE_CLASS_MUTEX,      // TRACE_MUTEX_LOCK
+    TRACE_CLASS_MUTEX,      // TRACE_MUTEX_UNLOCK
+    TRACE_CLASS_MARK,       // TRACE_MARK_BEGIN
+    TRACE_CLASS_MARK        // TRACE_MARK_END
+};
+
+const char * TraceTypeName[ MAX_TRACE_TYPE ] =
+{
+    "task",  "isr+",   "isr-",   "ev-set", "ev-wait",
+    "mtx-req", "mtx-lock", "mtx-unlock", "begin", "end"
+};
+
+const char * TraceEventName[ MAX_TRACE_EVENT ] =
+{
+    "sensor", "control", "ui", "wifi"
+};
+
+const char * TraceMarkName[ MAX_TRACE_MARK ] =
+{
+    "sensor_convert",
+    "sensor_update",
+    "cgi_status_data",
+    "cgi_web_data",
+    "cgi_adc_data",
+    "cgi_write_relay",
+    "cgi_hvac_data",
+    "cgi_hvac_output",
+    "cgi_task_data",
+    "wmiconfig",
+    "wait_connect",
+    "work_item",
+    "control_pass"
+};
+
+
+// Function Prototypes - used by this module only
+//
+int     trace_format_text( TRACE_CURSOR * cur, TRACE_RECORD * rec, char * str, int len );
+int     trace_format_chrome( TRACE_CURSOR * cur, TRACE_RECORD * rec, char * str, int len );
+void    span_update( TRACE_SPAN_STATS * span, uint32_t cycles );
+
+
+//
+//  trace_init() - Clear the trace buffer and start recording.
+//
+void
+trace_init( void )
+{
+    TraceClassMask = TRACE_CLASS_DEFAULT;
+    trace_clear();
+    TraceEnabled   = TRUE;
+}
+
+
+//
+//  trace_clear() - Discard all of the recorded events.
+//
+void
+trace_clear( void )
+{
+    memset( TraceBuffer, 0, sizeof( TraceBuffer ) );
+    TraceHead = 0;
+}
+
+
+//
+//  trace_record() - Record one event. Safe to call from any task or ISR.
+//
+//  A slot is reserved by incrementing TraceHead with LDREX/STREX, so an
+//  ISR that interrupts a task half way through a record simply takes the
+//  next slot. If the ISR stamps its record first, the two records are
+//  out of time order by a few cycles; the reader allows for this.
+//
+void
+trace_record( uint8_t type, uint8_t id, uint16_t arg )
+{
+    TRACE_RECORD * rec;
+    uint32_t       idx;
+
+    if( !TraceEnabled || TraceReaders || !(TraceClassMask & TraceTypeClass[ type ]) )
+        return;
+
+    do
+    {
+        idx = __LDREX( (unsigned long *) &TraceHead );
+    }
+    while( __STREX( idx + 1, (unsigned long *) &TraceHead ) );
+
+    rec = &TraceBuffer[ idx & (TRACE_BUFFER_SIZE - 1) ];
+
+    rec->cycles = TMON_CYCLE_COUNT();
+    rec->arg    = arg;
+    rec->id     = id;
+    rec->type   = type;
+}
+
+
+//
+//  trace_isr_enter() - Record the start of an ISR, and return the cycle
+//                      counter for use by TMON_ISR_EXIT().
+//
+uint32_t
+trace_isr_enter( uint8_t isr_idx )
+{
+    trace_record( TRACE_ISR_ENTER, isr_idx, 0 );
+
+    return( TMON_CYCLE_COUNT() );
+}
+
+
+//
+//  trace_count() - Returns the number of records held in the buffer.
+//
+uint32_t
+trace_count( void )
+{
+    uint32_t  head = TraceHead;
+
+    return( (head > TRACE_BUFFER_SIZE) ? TRACE_BUFFER_SIZE : head );
+}
+
+
+//
+//  trace_open() - Pause recording and prepare to read out all of the
+//                 records in the buffer, oldest first. Each call must
+//                 be matched by a trace_close().
+//
+void
+trace_open( TRACE_CURSOR * cur, bool chrome )
+{
+    _int_disable();
+    TraceReaders++;
+    _int_enable();
+
+    cur->end         = TraceHead;
+    cur->next        = cur->end - trace_count();
+    cur->last_cycles = TraceBuffer[ cur->next & (TRACE_BUFFER_SIZE - 1) ].cycles;
+    cur->time_us     = 0;
+    cur->frac_cycles = 0;
+    cur->state       = TRACE_READ_HEADER;
+    cur->meta        = 0;
+    cur->cpu_open    = FALSE;
+    cur->chrome      = chrome;
+    cur->pending_len = 0;
+}
+
+
+//
+//  trace_close() - End a read begun by trace_open(). Recording resumes,
+//                  if it is enabled, once the last reader has closed.
+//
+void
+trace_close( TRACE_CURSOR * cur )
+{
+    _int_disable();
+    if( TraceReaders )
+        TraceReaders--;
+    _int_enable();
+}
+
+
+//
+//  trace_read() - Format as many whole records as will fit into "str",
+//                 of at most "len" bytes including the terminator.
+//                 Returns the length of the string, 0 when done.
+//
+//  A line that does not fit is held in the cursor and output first on
+//  the next call.
+//
+int
+trace_read( TRACE_CURSOR * cur, char * str, int len )
+{
+    TASK_STATS     stats[ MAX_MONITORED_TASKS ];
+    TRACE_RECORD * rec;
+    uint32_t       delta;
+    int            pos, num, size;
+
+    pos    = 0;
+    str[0] = 0;
+    size   = sizeof( cur->pending );
+
+    while( TRUE )
+    {
+        if( cur->pending_len == 0 )
+        {
+            switch( cur->state )
+            {
+                case TRACE_READ_HEADER:
+                    if( cur->chrome )
+                    {
+                        cur->pending_len = snprintf( cur->pending, size,
+                            "{\"traceEvents\":[\n"
+                            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"ISR / events\"}},\n"
+                            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"CPU (sampled)\"}}",
+                            TRACE_PID_TASKS, TRACE_TID_ISR, TRACE_PID_CPU );
+                        cur->state = TRACE_READ_NAMES;
+                    }
+                    else
+                    {
+                        cur->pending_len = snprintf( cur->pending, size, "%lu records\n",
+                                                     (unsigned long) (cur->end - cur->next) );
+                        cur->state = TRACE_READ_RECORDS;
+                    }
+                break;
+
+                case TRACE_READ_NAMES:
+                    num = task_monitor_get_stats( stats, MAX_MONITORED_TASKS );
+
+                    if( cur->meta < num )
+                    {
+                        cur->pending_len = snprintf( cur->pending, size,
+                            ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                            TRACE_PID_TASKS,
+                            (unsigned int) (uint16_t) stats[ cur->meta ].task_id,
+                            stats[ cur->meta ].name );
+                        cur->meta++;
+                    }
+                    else
+                        cur->state = TRACE_READ_RECORDS;
+                break;
+
+                case TRACE_READ_RECORDS:
+                    if( cur->next == cur->end )
+                    {
+                        cur->state = TRACE_READ_FOOTER;
+                        break;
+                    }
+
+                    rec = &TraceBuffer[ cur->next & (TRACE_BUFFER_SIZE - 1) ];
+                    cur->next++;
+
+                    // Records may be a few cycles out of order, see
+                    //    trace_record(). Treat a negative step as zero.
+                    //
+                    delta = rec->cycles - cur->last_cycles;
+
+                    if( (int32_t) delta < 0 )
+                        delta = 0;
+                    else
+                        cur->last_cycles = rec->cycles;
+
+                    cur->frac_cycles += delta;
+                    cur->time_us     += cur->frac_cycles / CYCLES_PER_USEC;
+                    cur->frac_cycles %= CYCLES_PER_USEC;
+
+                    if( cur->chrome )
+                        cur->pending_len = trace_format_chrome( cur, rec, cur->pending, size );
+                    else
+                        cur->pending_len = trace_format_text( cur, rec, cur->pending, size );
+                break;
+
+                case TRACE_READ_FOOTER:
+                    if( cur->chrome )
+                        cur->pending_len = snprintf( cur->pending, size, "\n]}\n" );
+
+                    cur->state = TRACE_READ_DONE;
+                break;
+
+                default:
+                    return( pos );          // TRACE_READ_DONE
+            }
+
+            if( cur->pending_len >= size )  // Truncated by snprintf
+                cur->pending_len = size - 1;
+
+            continue;
+        }
+
+        if( pos + cur->pending_len >= len )
+        {
+            if( pos > 0 )
+                break;                      // Output it on the next call
+
+            cur->pending_len = len - 1;     // Will never fit, truncate it
+        }
+
+        memcpy( &str[pos], cur->pending, cur->pending_len );
+        pos += cur->pending_len;
+        str[pos] = 0;
+
+        cur->pending_len = 0;
+    }
+
+    return( pos );
+}
+
+
+//
+//  trace_format_text() - Format one record as a line of text;
+//
+//       time (usec)  type       name            arg
+//
+int
+trace_format_text( TRACE_CURSOR * cur, TRACE_RECORD * rec, char * str, int len )
+{
+    const char * name;
+
+    switch( rec->type )
+    {
+        case TRACE_ISR_ENTER:
+        case TRACE_ISR_EXIT:
+            name = (rec->id < MAX_TMON_ISR) ? IsrMonitorName[ rec->id ] : "?";
+        break;
+
+        case TRACE_LWEVENT_SET:
+        case TRACE_LWEVENT_WAIT:
+            name = (rec->id < MAX_TRACE_EVENT) ? TraceEventName[ rec->id ] : "?";
+        break;
+
+        case TRACE_MARK_BEGIN:
+        case TRACE_MARK_END:
+            name = (rec->id < MAX_TRACE_MARK) ? TraceMarkName[ rec->id ] : "?";
+        break;
+
+        case TRACE_TASK_SWITCH:
+            name = task_monitor_task_name( rec->arg );
+        break;
+
+        default:
+            name = "mutexCore";
+        break;
+    }
+
+    return( snprintf( str, len, "%10lu  %-10s %-16s %u\n",
+                      (unsigned long) cur->time_us,
+                      (rec->type < MAX_TRACE_TYPE) ? TraceTypeName[ rec->type ] : "?",
+                      name,
+                      (unsigned int) rec->arg ) );
+}
+
+
+//
+//  trace_format_chrome() - Format one record as one or two Chrome trace
+//                          events, each preceded by ",\n".
+//
+//  Markers and mutexCore wait/hold are "B"/"E" spans on the track of
+//  the task that recorded them. ISRs are spans, and lightweight events
+//  are instants, on the "ISR / events" track. Sampled task switches are
+//  spans on the single track of the "CPU (sampled)" process.
+//
+int
+trace_format_chrome( TRACE_CURSOR * cur, TRACE_RECORD * rec, char * str, int len )
+{
+    unsigned long  ts = cur->time_us;
+    int            n  = 0;
+
+    switch( rec->type )
+    {
+        case TRACE_TASK_SWITCH:
+            if( cur->cpu_open )
+                n = snprintf( str, len, ",\n{\"ph\":\"E\",\"ts\":%lu,\"pid\":%d,\"tid\":0}",
+                              ts, TRACE_PID_CPU );
+
+            n += snprintf( &str[n], len-n, ",\n{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%lu,\"pid\":%d,\"tid\":0}",
+                           task_monitor_task_name( rec->arg ), ts, TRACE_PID_CPU );
+            cur->cpu_open = TRUE;
+        break;
+
+        case TRACE_ISR_ENTER:
+        case TRACE_ISR_EXIT:
+            n = snprintf( str, len, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lu,\"pid\":%d,\"tid\":%d}",
+                          (rec->id < MAX_TMON_ISR) ? IsrMonitorName[ rec->id ] : "?",
+                          (rec->type == TRACE_ISR_ENTER) ? "B" : "E",
+                          ts, TRACE_PID_TASKS, TRACE_TID_ISR );
+        break;
+
+        case TRACE_LWEVENT_SET:
+        case TRACE_LWEVENT_WAIT:
+            n = snprintf( str, len, ",\n{\"name\":\"%s %s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,\"pid\":%d,\"tid\":%d,\"args\":{\"mask\":%u}}",
+                          (rec->type == TRACE_LWEVENT_SET) ? "set" : "wake",
+                          (rec->id < MAX_TRACE_EVENT) ? TraceEventName[ rec->id ] : "?",
+                          ts, TRACE_PID_TASKS, TRACE_TID_ISR, (unsigned int) rec->arg );
+        break;
+
+        case TRACE_MUTEX_REQUEST:
+            n = snprintf( str, len, ",\n{\"name\":\"mutexCore wait\",\"ph\":\"B\",\"ts\":%lu,\"pid\":%d,\"tid\":%u}",
+                          ts, TRACE_PID_TASKS, (unsigned int) rec->arg );
+        break;
+
+        case TRACE_MUTEX_LOCK:
+            n = snprintf( str, len, ",\n{\"ph\":\"E\",\"ts\":%lu,\"pid\":%d,\"tid\":%u}"
+                                    ",\n{\"name\":\"mutexCore held\",\"ph\":\"B\",\"ts\":%lu,\"pid\":%d,\"tid\":%u}",
+                          ts, TRACE_PID_TASKS, (unsigned int) rec->arg,
+                          ts, TRACE_PID_TASKS, (unsigned int) rec->arg );
+        break;
+
+        case TRACE_MUTEX_UNLOCK:
+            n = snprintf( str, len, ",\n{\"ph\":\"E\",\"ts\":%lu,\"pid\":%d,\"tid\":%u}",
+                          ts, TRACE_PID_TASKS, (unsigned int) rec->arg );
+        break;
+
+        case TRACE_MARK_BEGIN:
+        case TRACE_MARK_END:
+            n = snprintf( str, len, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lu,\"pid\":%d,\"tid\":%u}",
+                          (rec->id < MAX_TRACE_MARK) ? TraceMarkName[ rec->id ] : "?",
+                          (rec->type == TRACE_MARK_BEGIN) ? "B" : "E",
+                          ts, TRACE_PID_TASKS, (unsigned int) rec->arg );
+        break;
+    }
+
+    return( n );
+}
+
+
+//
+//  trace_span_stats() - Compute latency statistics from the records in
+//                       the buffer. Each marker, each ISR, and the
+//                       mutexCore wait and hold times are a "span".
+//                       Returns the number of entries filled in "stats".
+//
+//  Spans are matched by id only. If the same marker is open in two tasks
+//  at the same time, the later begin is used.
+//
+int
+trace_span_stats( TRACE_SPAN_STATS * stats, int max_stats )
+{
+    uint32_t       begin[ MAX_TRACE_SPANS ];
+    bool           open[ MAX_TRACE_SPANS ];
+    TRACE_RECORD * rec;
+    TRACE_CURSOR   cur;
+    int            k, num, idx;
+    int            isr_base, wait_idx, hold_idx;
+
+    isr_base = MAX_TRACE_MARK;
+    wait_idx = isr_base + MAX_TMON_ISR;
+    hold_idx = wait_idx + 1;
+    num      = hold_idx + 1;
+
+    if( (num > max_stats) || (num > MAX_TRACE_SPANS) )
+        return( 0 );
+
+    for( k=0; k<num; k++ )
+    {
+        stats[k].count    = 0;
+        stats[k].min_us   = 0xFFFFFFFF;
+        stats[k].max_us   = 0;
+        stats[k].total_us = 0;
+        open[k]           = FALSE;
+
+        if( k < isr_base )
+            stats[k].name = TraceMarkName[k];
+        else if( k < wait_idx )
+            stats[k].name = IsrMonitorName[ k - isr_base ];
+    }
+    stats[ wait_idx ].name = "mutexCore wait";
+    stats[ hold_idx ].name = "mutexCore hold";
+
+    trace_open( &cur, FALSE );
+
+    for( ; cur.next != cur.end; cur.next++ )
+    {
+        rec = &TraceBuffer[ cur.next & (TRACE_BUFFER_SIZE - 1) ];
+        idx = -1;
+
+        switch( rec->type )
+        {
+            case TRACE_MARK_BEGIN:
+            case TRACE_MARK_END:
+                if( rec->id < MAX_TRACE_MARK )
+                    idx = rec->id;
+            break;
+
+            case TRACE_ISR_ENTER:
+            case TRACE_ISR_EXIT:
+                if( rec->id < MAX_TMON_ISR )
+                    idx = isr_base + rec->id;
+            break;
+
+            case TRACE_MUTEX_REQUEST:
+                begin[ wait_idx ] = rec->cycles;
+                open[ wait_idx ]  = TRUE;
+            break;
+
+            case TRACE_MUTEX_LOCK:
+                if( open[ wait_idx ] )
+                    span_update( &stats[ wait_idx ], rec->cycles - begin[ wait_idx ] );
+
+                open[ wait_idx ]  = FALSE;
+                begin[ hold_idx ] = rec->cycles;
+                open[ hold_idx ]  = TRUE;
+            break;
+
+            case TRACE_MUTEX_UNLOCK:
+                if( open[ hold_idx ] )
+                    span_update( &stats[ hold_idx ], rec->cycles - begin[ hold_idx ] );
+
+                open[ hold_idx ] = FALSE;
+            break;
+        }
+
+        if( idx < 0 )
+            continue;
+
+        if( (rec->type == TRACE_MARK_BEGIN) || (rec->type == TRACE_ISR_ENTER) )
+        {
+            begin[ idx ] = rec->cycles;
+            open[ idx ]  = TRUE;
+        }
+        else if( open[ idx ] )
+        {
+            span_update( &stats[ idx ], rec->cycles - begin[ idx ] );
+            open[ idx ] = FALSE;
+        }
+    }
+
+    trace_close( &cur );
+
+    for( k=0; k<num; k++ )
+    {
+        if( stats[k].count == 0 )
+            stats[k].min_us = 0;
+    }
+
+    return( num );
+}
+
+
+//
+//  span_update() - Add one span of "cycles" length to the statistics.
+//
+void
+span_update( TRACE_SPAN_STATS * span, uint32_t cycles )
+{
+    uint32_t  usec;
+
+    if( (int32_t) cycles < 0 )
+        cycles = 0;
+
+    usec = cycles / CYCLES_PER_USEC;
+
+    span->count++;
+    span->total_us += usec;
+
+    if( usec < span->min_us )
+        span->min_us = usec;
+
+    if( usec > span->max_us )
+        span->max_us = usec;
+}
@@ -0,0 +1,182 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : event_trace.h
+
+PURPOSE   : Definitions and function prototypes for the "event_trace.c"
+            module. The event trace is a ring buffer of small binary
+            records, each stamped with the Cortex-M4 cycle counter. It
+            is used to find timing problems (missed sample cycles, slow
+            CGI responses, Wi-Fi stalls) that printf cannot show.
+
+            Records are written from tasks and ISRs without a lock; a
+            slot is reserved with LDREX/STREX and then filled in.
+
+            The trace is read back with the "trace" shell command, or
+            with the "trace_data" CGI which returns Chrome trace JSON
+            that can be opened directly in chrome://tracing or Perfetto.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __event_trace_inc
+#define  __event_trace_inc
+
+#include <mqx.h>
+
+// Set to 0 to compile all of the trace points out of the firmware.
+//
+#define  TRACE_ENABLE           1
+
+#define  TRACE_BUFFER_SIZE    512    // Records, must be a power of 2
+
+// Record types. Each type belongs to a class; the classes that are
+//   recorded are selected at run time with TraceClassMask.
+//
+typedef enum
+{
+    TRACE_TASK_SWITCH   = 0,   // arg = task now running (sampled)
+    TRACE_ISR_ENTER     = 1,   // id  = TMON_ISR_INDEX
+    TRACE_ISR_EXIT      = 2,   // id  = TMON_ISR_INDEX
+    TRACE_LWEVENT_SET   = 3,   // id  = TRACE_EVENT_ID, arg = mask
+    TRACE_LWEVENT_WAIT  = 4,   // id  = TRACE_EVENT_ID, arg = mask
+    TRACE_MUTEX_REQUEST = 5,   // arg = task requesting mutexCore
+    TRACE_MUTEX_LOCK    = 6,   // arg = task that now owns mutexCore
+    TRACE_MUTEX_UNLOCK  = 7,   // arg = task releasing mutexCore
+    TRACE_MARK_BEGIN    = 8,   // id  = TRACE_MARK_ID, arg = task
+    TRACE_MARK_END      = 9    // id  = TRACE_MARK_ID, arg = task
+
+}  TRACE_TYPE;
+
+#define  MAX_TRACE_TYPE   TRACE_MARK_END + 1
+
+#define  TRACE_CLASS_TASK       0x01
+#define  TRACE_CLASS_ISR        0x02
+#define  TRACE_CLASS_LWEVENT    0x04
+#define  TRACE_CLASS_MUTEX      0x08
+#define  TRACE_CLASS_MARK       0x10
+#define  TRACE_CLASS_ALL        0x1F
+
+// The ADC and PIT1 interrupts run about 1000 times per second and
+//   would fill the buffer in half a second, so ISR records are off
+//   by default. Enable them with "trace mask 1f".
+//
+#define  TRACE_CLASS_DEFAULT    (TRACE_CLASS_ALL & ~TRACE_CLASS_ISR)
+
+// Lightweight events that are traced.
+//
+typedef enum
+{
+    TRACE_EVENT_SENSOR  = 0,   // eventSensorTask
+    TRACE_EVENT_CONTROL = 1,   // eventControlTask
+    TRACE_EVENT_UI      = 2,   // eventUiTask
+    TRACE_EVENT_WIFI    = 3    // lwevent_wifi_connect
+
+}  TRACE_EVENT_ID;
+
+#define  MAX_TRACE_EVENT   TRACE_EVENT_WIFI + 1
+
+// User markers. A marker spans the code between TRACE_BEGIN and
+//   TRACE_END with the same id.
+//
+typedef enum
+{
+    TRACE_MARK_SENSOR_CONVERT = 0,   // Sensor_Task, raw -> eng units
+    TRACE_MARK_SENSOR_UPDATE  = 1,   // Sensor_Task, update coreDB
+    TRACE_MARK_CGI_STATUS     = 2,   // cgi_status_data()
+    TRACE_MARK_CGI_WEB        = 3,   // cgi_web_data()
+    TRACE_MARK_CGI_ADC        = 4,   // cgi_adc_data()
+    TRACE_MARK_CGI_RELAY      = 5,   // cgi_write_relay()
+    TRACE_MARK_CGI_HVAC_DATA  = 6,   // cgi_hvac_data()
+    TRACE_MARK_CGI_HVAC_OUT   = 7,   // cgi_hvac_output()
+    TRACE_MARK_CGI_TASK       = 8,   // cgi_task_data()
+    TRACE_MARK_WMICONFIG      = 9,   // wmiconfig_handler()
+    TRACE_MARK_WAIT_CONNECT   = 10,  // wait_connect()
+    TRACE_MARK_WORK_ITEM      = 11,  // Work_Task, one deferred work item
+    TRACE_MARK_CONTROL_PASS   = 12   // Control_Task, relay and analog outputs
+
+}  TRACE_MARK_ID;
+
+#define  MAX_TRACE_MARK   TRACE_MARK_CONTROL_PASS + 1
+
+// TRACE_RECORD - 8 bytes per record.
+//
+typedef struct
+{
+    uint32_t  cycles;     // DWT cycle counter when the event occurred
+    uint16_t  arg;        // Event specific, see TRACE_TYPE
+    uint8_t   type;       // TRACE_TYPE
+    uint8_t   id;         // ISR, event or marker id
+}  TRACE_RECORD;
+
+// TRACE_SPAN_STATS - Latency statistics of one kind of span, computed
+//   from the records currently held in the ring buffer.
+//
+typedef struct
+{
+    const char * name;
+    uint32_t     count;      // Number of complete spans
+    uint32_t     min_us;
+    uint32_t     max_us;
+    uint32_t     total_us;
+}  TRACE_SPAN_STATS;
+
+#define  MAX_TRACE_SPANS   24     // Markers, ISRs, mutexCore wait and hold
+
+// TRACE_CURSOR - State used to read the ring buffer out in pieces.
+//
+typedef struct
+{
+    uint32_t  next;          // Next record to format
+    uint32_t  end;           // One past the last record to format
+    uint32_t  last_cycles;   // Cycle count of the previous record
+    uint32_t  time_us;       // Time of the previous record, usec
+    uint32_t  frac_cycles;   // Cycles not yet counted in time_us
+    int       state;         // Header, names, records, footer, done
+    int       meta;          // Next task name to output (Chrome)
+    bool      cpu_open;      // A sampled task span is open (Chrome)
+    bool      chrome;        // TRUE = Chrome trace JSON, FALSE = text
+    int       pending_len;   // Length of a formatted line not yet output
+    char      pending[ 256 ];
+}  TRACE_CURSOR;
+
+extern volatile bool      TraceEnabled;
+extern volatile uint32_t  TraceReaders;
+extern volatile uint32_t  TraceClassMask;
+
+// The task argument recorded with an event; the low 16 bits of the MQX
+//   task ID are the task number.
+//
+#define  TRACE_TASK_ARG()   ((uint16_t) _task_get_id())
+
+#if TRACE_ENABLE
+    #define  TRACE_BEGIN( mark )         trace_record( TRACE_MARK_BEGIN, (mark), TRACE_TASK_ARG() )
+    #define  TRACE_END( mark )           trace_record( TRACE_MARK_END,   (mark), TRACE_TASK_ARG() )
+    #define  TRACE_EVENT_SET( ev, m )    trace_record( TRACE_LWEVENT_SET,  (ev), (uint16_t)(m) )
+    #define  TRACE_EVENT_WAIT( ev, m )   trace_record( TRACE_LWEVENT_WAIT, (ev), (uint16_t)(m) )
+    #define  TRACE_MUTEX( type )         trace_record( (type), 0, TRACE_TASK_ARG() )
+#else
+    #define  TRACE_BEGIN( mark )
+    #define  TRACE_END( mark )
+    #define  TRACE_EVENT_SET( ev, m )
+    #define  TRACE_EVENT_WAIT( ev, m )
+    #define  TRACE_MUTEX( type )
+#endif
+
+//
+//    Function Prototypes
+//
+void      trace_init( void );
+void      trace_clear( void );
+void      trace_record( uint8_t type, uint8_t id, uint16_t arg );
+uint32_t  trace_isr_enter( uint8_t isr_idx );
+uint32_t  trace_count( void );
+void      trace_open( TRACE_CURSOR * cur, bool chrome );
+int       trace_read( TRACE_CURSOR * cur, char * str, int len );
+void      trace_close( TRACE_CURSOR * cur );
+int       trace_span_stats( TRACE_SPAN_STATS * stats, int max_stats );
+
+#endif
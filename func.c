@@ -13,6 +13,7 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include "func.h" 
 #include "defines.h"
 #include "global.h"
@@ -27,6 +28,10 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 //
 #define ERROR_MESSAGE_PROMPT "<br/>&bull;  "
 
+// Function Prototypes - used by this module only
+//
+void  valid_error( VALID_RESULT * result, int code, int item, int sens_type, int min, int max );
+
 
 
 //
@@ -109,7 +114,7 @@ get_output_type_from_id( DATABASE * db, int output_id )
 //     
 //
 bool
-valid_sensor_id( DATABASE * db, int sensor_id )
+valid_sensor_id( const DATABASE * db, int sensor_id )
 {
     bool reply;
 
@@ -149,26 +154,149 @@ valid_sensor_id( DATABASE * db, int sensor_id )
 //
 //                           The error_msg parameter will be loaded with
 //                           an error message if one is found, and the
-//                           pointer is not NULL.
+//                           pointer is not NULL. It must have room for
+//                           MAX_VALID_MESSAGE characters.
 //
 bool  valid_sensor_setup( SENSOR_SETUP * sens, char * error_msg )
 {
-    char  str[100];
-    bool  reply = TRUE;
+    VALID_RESULT  result;
+    bool          reply;
+
+    if( error_msg == NULL )
+        reply = check_sensor_setup( sens, 0, NULL );
+    else
+    {
+        valid_result_init( &result, FALSE );
+        reply = check_sensor_setup( sens, 0, &result );
+        render_valid_errors( &result, error_msg, MAX_VALID_MESSAGE );
+    }
+
+    // The offset is 0 for all sensor types other than F, C, HI-F, HI-C
+    //
+    if(    (sens->sensor_type != SENSOR_TYPE_TEMP_F) && (sens->sensor_type != SENSOR_TYPE_TEMP_HI_F)
+        && (sens->sensor_type != SENSOR_TYPE_TEMP_C) && (sens->sensor_type != SENSOR_TYPE_TEMP_HI_C) )
+    {
+        sens->offset = 0;
+    }
+
+    return( reply );
+}
+
+
+//
+//    valid_relay_setup() - This function checks if the content of the
+//                          relay setup struct, passed as a parameter,
+//                          contains valid data. It replies with
+//                          a True / False value to indicate if the
+//                          setup data is valid.
+//
+//                          The error_msg parameter will be loaded with
+//                          an error message if one is found, and the
+//                          pointer is not NULL. It must have room for
+//                          MAX_VALID_MESSAGE characters.
+//
+bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char * error_msg )
+{
+    VALID_RESULT  result;
+    bool          reply;
+
+    if( error_msg == NULL )
+        return( check_relay_setup( db, relay, sens_type, 0, NULL ) );
+
+    valid_result_init( &result, FALSE );
+    reply = check_relay_setup( db, relay, sens_type, 0, &result );
+    render_valid_errors( &result, error_msg, MAX_VALID_MESSAGE );
+
+    return( reply );
+}
+
+
+//
+//   valid_analog_setup() - This function checks if the content of the
+//                          analog setup struct, passed as a parameter,
+//                          contains valid data. It replies with
+//                          a True / False value to indicate if the
+//                          setup data is valid.
+//
+//                          The error_msg parameter will be loaded with
+//                          an error message if one is found, and the
+//                          pointer is not NULL. It must have room for
+//                          MAX_VALID_MESSAGE characters.
+//
+bool  valid_analog_setup( DATABASE * db, ANALOG_SETUP * analog, int sens_type, char * error_msg )
+{
+    VALID_RESULT  result;
+    bool          reply;
+
+    if( error_msg == NULL )
+        return( check_analog_setup( db, analog, sens_type, 0, NULL ) );
+
+    valid_result_init( &result, FALSE );
+    reply = check_analog_setup( db, analog, sens_type, 0, &result );
+    render_valid_errors( &result, error_msg, MAX_VALID_MESSAGE );
+
+    return( reply );
+}
+
+
+//
+//    valid_result_init() - Empty a VALID_RESULT before the check_xxx_setup()
+//                          functions add to it. With show_item set, the
+//                          text of each error names the sensor or output.
+//
+void
+valid_result_init( VALID_RESULT * result, bool show_item )
+{
+    result->count     = 0;
+    result->dropped   = 0;
+    result->show_item = show_item;
+}
+
+
+//
+//    valid_error() - Add one error to a VALID_RESULT. Nothing is kept if
+//                    the result is NULL; the caller only wants to know
+//                    whether the setup is valid.
+//
+void
+valid_error( VALID_RESULT * result, int code, int item, int sens_type, int min, int max )
+{
+    VALID_ERROR * err;
+
+    if( result == NULL )
+        return;
+
+    if( result->count >= MAX_VALID_ERRORS )
+    {
+        result->dropped++;
+        return;
+    }
+
+    err              = &result->error[ result->count++ ];
+    err->code        = code;
+    err->item        = item;
+    err->sensor_type = sens_type;
+    err->min         = min;
+    err->max         = max;
+}
+
 
-    if( error_msg != NULL )   // Start with an empty error message string.
-        error_msg[0] = 0;     //   Errors will be added as necessary.
+//
+//    check_sensor_setup() - Check a sensor setup, and add any errors
+//                           found to "result", which may be NULL.
+//                           "item" is the sensor ID the errors are
+//                           reported against. Returns TRUE if valid.
+//
+bool
+check_sensor_setup( const SENSOR_SETUP * sens, int item, VALID_RESULT * result )
+{
+    bool  reply = TRUE;
 
     // Check for valid Sensor Type
     if( (sens->sensor_type < MIN_SENSOR_TYPE) || (sens->sensor_type > MAX_SENSOR_TYPE) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The Sensor Type must be in the range of %s to %s.<br/>\n", MIN_SENSOR_TYPE, MAX_SENSOR_TYPE );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_SENSOR_TYPE, item, SENSOR_TYPE_NONE, MIN_SENSOR_TYPE, MAX_SENSOR_TYPE );
     }
 
     // Check for valid Sensor Offset (temp sensors only)
@@ -177,12 +305,7 @@ bool  valid_sensor_setup( SENSOR_SETUP * sens, char * error_msg )
         if( (sens->offset < MIN_DEG_F_OFFSET) || (sens->offset > MAX_DEG_F_OFFSET) )
         {
             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                 sprintf( str, "The Offset must be in the range of %d to %d.<br/>\n", MIN_DEG_F_OFFSET, MAX_DEG_F_OFFSET );
-                 strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                 strcat( error_msg, str );
-            }
+            valid_error( result, VALID_OFFSET, item, sens->sensor_type, MIN_DEG_F_OFFSET, MAX_DEG_F_OFFSET );
         }
     }
     else if( (sens->sensor_type == SENSOR_TYPE_TEMP_C) || (sens->sensor_type == SENSOR_TYPE_TEMP_HI_C) )
@@ -190,79 +313,39 @@ bool  valid_sensor_setup( SENSOR_SETUP * sens, char * error_msg )
         if( (sens->offset < MIN_DEG_C_OFFSET) || (sens->offset > MAX_DEG_C_OFFSET) )
         {
             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                 sprintf( str, "The Offset must be in the range of -%d.%d to %d.%d.<br/>\n", 
-                               (-MIN_DEG_C_OFFSET) / 10, (-MIN_DEG_C_OFFSET) % 10, 
-                               MAX_DEG_C_OFFSET / 10, MAX_DEG_C_OFFSET % 10);
-
-                 strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                 strcat( error_msg, str );
-            }
+            valid_error( result, VALID_OFFSET_TENTHS, item, sens->sensor_type, MIN_DEG_C_OFFSET, MAX_DEG_C_OFFSET );
         }
     }
-    else  // Else offset = 0 for all sensor types other than F, C, HI-F, HI-C
-    {
-        sens->offset = 0;
-    }
 
     return( reply );
 }
 
 
 //
-//    valid_relay_setup() - This function checks if the content of the
-//                          relay setup struct, passed as a parameter,
-//                          contains valid data. It replies with
-//                          a True / False value to indicate if the
-//                          setup data is valid.
-//
-//                          The error_msg parameter will be loaded with
-//                          an error message if one is found, and the
-//                          pointer is not NULL.
+//    check_relay_setup() - Check a relay output setup, and add any errors
+//                          found to "result", which may be NULL. "item"
+//                          is the output ID the errors are reported
+//                          against. Returns TRUE if valid.
 //
-bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char * error_msg )
+bool
+check_relay_setup( const DATABASE * db, const RELAY_SETUP * relay, int sens_type, int item, VALID_RESULT * result )
 {
-    char  str[100], min_str[20], max_str[20], min_diff_str[20];
-    int   min_sp, max_sp, min_diff, diff;
+    int   diff;
     bool  reply = TRUE;
-
-    if( error_msg != NULL )   // Start with an empty error message string.
-        error_msg[0] = 0;     //   Errors will be added as necessary.
+    const SETPOINT_LIMITS * limits;
 
     // Check for a valid reference Sensor ID
     if( !valid_sensor_id( db, relay->sensor_id ) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, "Invalid sensor referenced.<br/>\n" );
-        }
+        valid_error( result, VALID_SENSOR_ID, item, sens_type, 0, 0 );
     }
 
     // Look up the min/max setpoint values. These are a function
     //    of the sensor type that is referenced, and whether
     //    or not the sensor is a differential sensor.
     //
-    if( relay->sensor_id == SENSOR_ID_DIFF )
-    {
-        min_sp = get_minimum_diff_setpoint( sens_type );
-        max_sp = get_maximum_diff_setpoint( sens_type );
-    }
-    else
-    {
-        min_sp = get_minimum_setpoint( sens_type );
-        max_sp = get_maximum_setpoint( sens_type );
-    }
-
-    min_diff = get_minimum_differential( sens_type );
-
-#ifdef ENET_HARDWARE
-    build_setpoint_string( min_sp,   sens_type, min_str );
-    build_setpoint_string( max_sp,   sens_type, max_str );
-    build_setpoint_string( min_diff, sens_type, min_diff_str );
-#endif
+    limits = get_setpoint_limits( sens_type, relay->sensor_id );
 
     // The Binary sensor is a special case. There are no On\Off points
     //    used with binary sensors, therefore, we do not check the
@@ -272,27 +355,17 @@ bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char
     if( sens_type != SENSOR_TYPE_BINARY )
     {
         // Check for valid ON sepoint
-        if( (relay->cut_on < min_sp) || (relay->cut_on > max_sp) )
+        if( (relay->cut_on < limits->min_sp) || (relay->cut_on > limits->max_sp) )
         {
             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                sprintf( str, "The ON point must be in the range of %s to %s.<br/>\n", min_str, max_str );
-                strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                strcat( error_msg, str );
-            }
+            valid_error( result, VALID_ON_POINT, item, sens_type, limits->min_sp, limits->max_sp );
         }
 
         // Check for valid OFF sepoint
-        if( (relay->cut_off < min_sp) || (relay->cut_off > max_sp) )
+        if( (relay->cut_off < limits->min_sp) || (relay->cut_off > limits->max_sp) )
         {
-             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                 sprintf( str, "The OFF point must be in the range of %s to %s.<br/>\n", min_str, max_str );
-                 strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                 strcat( error_msg, str );
-            }
+            reply = FALSE;
+            valid_error( result, VALID_OFF_POINT, item, sens_type, limits->min_sp, limits->max_sp );
         }
 
         // Check for valid Minimum Difference; ON <-> OFF
@@ -300,15 +373,10 @@ bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char
         if( diff < 0 )                       // Get the absolute value.
             diff = 0 - diff;
 
-        if( diff < min_diff )
+        if( diff < limits->min_diff )
         {
             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                sprintf( str, "A minimum difference between ON and OFF of %s must be maintained.<br/>\n", min_diff_str );
-                strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                strcat( error_msg, str );
-            }
+            valid_error( result, VALID_ON_OFF_DIFF, item, sens_type, limits->min_diff, 0 );
         }
     }
 
@@ -316,48 +384,28 @@ bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char
     if( (relay->on_delay < MIN_ON_DELAY) || (relay->on_delay > MAX_ON_DELAY) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The ON Delay must be in the range of %d to %d seconds.<br/>\n", MIN_ON_DELAY, MAX_ON_DELAY );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_ON_DELAY, item, sens_type, MIN_ON_DELAY, MAX_ON_DELAY );
     }
 
     // Check for a valid Off Delay
     if( (relay->off_delay < MIN_OFF_DELAY) || (relay->off_delay > MAX_OFF_DELAY) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The OFF Delay must be in the range of %d to %d seconds.<br/>\n", MIN_OFF_DELAY, MAX_OFF_DELAY );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_OFF_DELAY, item, sens_type, MIN_OFF_DELAY, MAX_OFF_DELAY );
     }
 
     // Check for a valid Minimum On Time
     if( (relay->min_on_time < MIN_ON_TIME) || (relay->min_on_time > MAX_ON_TIME) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The Minimum ON Time must be in the range of %d to %d seconds.<br/>\n", MIN_ON_TIME, MAX_ON_TIME );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_MIN_ON_TIME, item, sens_type, MIN_ON_TIME, MAX_ON_TIME );
     }
 
     // Check for a valid Minimum Off Time
     if( (relay->min_off_time < MIN_OFF_TIME) || (relay->min_off_time > MAX_OFF_TIME) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The Minimum OFF Time must be in the range of %d to %d seconds.<br/>\n", MIN_OFF_TIME, MAX_OFF_TIME );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_MIN_OFF_TIME, item, sens_type, MIN_OFF_TIME, MAX_OFF_TIME );
     }
 
     // The Binary sensor is a special case. There is no Sensor Fail Mode
@@ -370,93 +418,52 @@ bool  valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char
         if( (relay->sensor_fail_mode != SENSOR_FAIL_ON) && (relay->sensor_fail_mode != SENSOR_FAIL_OFF) )
         {
             reply = FALSE;
-            if( error_msg != NULL )
-            {
-                strcpy( str, "The SNF mode must be either Fail ON or Fail OFF.<br/>\n" );
-                strcat( error_msg, ERROR_MESSAGE_PROMPT );
-                strcat( error_msg, str );
-            }
+            valid_error( result, VALID_FAIL_MODE, item, sens_type, 0, 0 );
         }
     }
 
     return( reply );
 }
 
+
 //
-//   valid_analog_setup() - This function checks if the content of the
-//                          analog setup struct, passed as a parameter,
-//                          contains valid data. It replies with
-//                          a True / False value to indicate if the
-//                          setup data is valid.
-//
-//                          The error_msg parameter will be loaded with
-//                          an error message if one is found, and the
-//                          pointer is not NULL.
+//   check_analog_setup() - Check an analog output setup, and add any
+//                          errors found to "result", which may be NULL.
+//                          "item" is the output ID the errors are
+//                          reported against. Returns TRUE if valid.
 //
-bool  valid_analog_setup( DATABASE * db, ANALOG_SETUP * analog, int sens_type, char * error_msg )
+bool
+check_analog_setup( const DATABASE * db, const ANALOG_SETUP * analog, int sens_type, int item, VALID_RESULT * result )
 {
-    char  str[100], min_str[20], max_str[20], min_diff_str[20];
-    int   min_sp, max_sp, min_diff, diff;
+    int   diff;
     bool  reply = TRUE;
-
-    if( error_msg != NULL )   // Start with an empty error message string.
-        error_msg[0] = 0;     //   Errors will be added as necessary.
+    const SETPOINT_LIMITS * limits;
 
     // Check for a valid reference Sensor ID
     if( !valid_sensor_id( db, analog->sensor_id ) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, "Invalid sensor referenced.<br/>\n" );
-        }
+        valid_error( result, VALID_SENSOR_ID, item, sens_type, 0, 0 );
     }
 
     // Look up the min/max setpoint values. These are a function
     //    of the sensor type that is referenced, and whether
     //    or not the sensor is a differential sensor.
     //
-    if( analog->sensor_id == SENSOR_ID_DIFF )
-    {
-        min_sp = get_minimum_diff_setpoint( sens_type );
-        max_sp = get_maximum_diff_setpoint( sens_type );
-    }
-    else
-    {
-        min_sp = get_minimum_setpoint( sens_type );
-        max_sp = get_maximum_setpoint( sens_type );
-    }
-
-    min_diff = get_minimum_differential( sens_type );
+    limits = get_setpoint_limits( sens_type, analog->sensor_id );
 
-#ifdef ENET_HARDWARE
-    build_setpoint_string( min_sp,   sens_type, min_str );
-    build_setpoint_string( max_sp,   sens_type, max_str );
-    build_setpoint_string( min_diff, sens_type, min_diff_str );
-#endif
     // Check for valid SP sepoint
-    if( (analog->sp < min_sp) || (analog->sp > max_sp) )
+    if( (analog->sp < limits->min_sp) || (analog->sp > limits->max_sp) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The SP value must be in the range of %s to %s.<br/>\n", min_str, max_str );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_SP, item, sens_type, limits->min_sp, limits->max_sp );
     }
 
     // Check for valid EP sepoint
-    if( (analog->ep < min_sp) || (analog->ep > max_sp) )
+    if( (analog->ep < limits->min_sp) || (analog->ep > limits->max_sp) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The EP value must be in the range of %s to %s.<br/>\n", min_str, max_str );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_EP, item, sens_type, limits->min_sp, limits->max_sp );
     }
 
     // Check for valid Minimum Difference; SP <-> EP
@@ -464,86 +471,97 @@ bool  valid_analog_setup( DATABASE * db, ANALOG_SETUP * analog, int sens_type, c
     if( diff < 0 )                       // Get the absolute value.
         diff = 0 - diff;
 
-    if( diff < min_diff )
+    if( diff < limits->min_diff )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "A minimum difference between SP and EP of %s must be maintained.<br/>\n", min_diff_str );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_SP_EP_DIFF, item, sens_type, limits->min_diff, 0 );
     }
 
     // Check for a Output at Setpoint
     if( (analog->sp_output < MIN_SP_OUTPUT) || (analog->sp_output > MAX_SP_OUTPUT) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The OSP value must be in the range of %d to %d.<br/>\n", MIN_SP_OUTPUT, MAX_SP_OUTPUT );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_SP_OUTPUT, item, sens_type, MIN_SP_OUTPUT, MAX_SP_OUTPUT );
     }
 
-    // Check for a valid Minimum On Time
+    // Check for a Output at Endpoint
     if( ((int)analog->ep_output < MIN_EP_OUTPUT) || (analog->ep_output > MAX_EP_OUTPUT) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The OEP value must be in the range of %d to %d.<br/>\n", MIN_EP_OUTPUT, MAX_EP_OUTPUT );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_EP_OUTPUT, item, sens_type, MIN_EP_OUTPUT, MAX_EP_OUTPUT );
     }
 
     // Check for a valid Integration Constant
     if( ((int)analog->int_constant < MIN_I_TERM) || (analog->int_constant > MAX_I_TERM) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The I-C value must be in the range of %d to %d.<br/>\n", MIN_OFF_TIME, MAX_OFF_TIME );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_INT_CONSTANT, item, sens_type, MIN_I_TERM, MAX_I_TERM );
     }
 
     // Check for a valid Update Rate
     if( ((int)analog->update_rate < MIN_UPDATE_RATE) || (analog->update_rate > MAX_UPDATE_RATE) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The UP-R value must be in the range of %d to %d.<br/>\n", MIN_UPDATE_RATE, MAX_UPDATE_RATE );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_UPDATE_RATE, item, sens_type, MIN_UPDATE_RATE, MAX_UPDATE_RATE );
     }
 
     // Check for a valid Control Band
     if( ((int)analog->output_band < MIN_OUTPUT_BAND) || (analog->output_band > MAX_OUTPUT_BAND) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
-        {
-            sprintf( str, "The bND value must be in the range of %d to %d.<br/>\n", MIN_OUTPUT_BAND, MAX_OUTPUT_BAND );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
-        }
+        valid_error( result, VALID_OUTPUT_BAND, item, sens_type, MIN_OUTPUT_BAND, MAX_OUTPUT_BAND );
     }
 
     // Check for a valid Sensor Fail Mode
     if( (analog->sensor_fail_mode != SENSOR_FAIL_ON) && (analog->sensor_fail_mode != SENSOR_FAIL_OFF) )
     {
         reply = FALSE;
-        if( error_msg != NULL )
+        valid_error( result, VALID_FAIL_MODE, item, sens_type, 0, 0 );
+    }
+
+    return( reply );
+}
+
+
+//
+//    check_setup() - Check the whole of a proposed setup in one pass;
+//                    Sn-1..Sn-3 and every output, each against the
+//                    sensor types in the same setup. Errors are added
+//                    to "result", which may be NULL. Returns TRUE if
+//                    all of it is valid.
+//
+bool
+check_setup( const DATABASE * db, VALID_RESULT * result )
+{
+    const OUTPUT_SETUP * output;
+    int                  k, sensor_id, sens_type;
+    bool                 reply = TRUE;
+
+    for( k=SENSOR_ID_ONE; k<=SENSOR_ID_THREE; k++ )
+    {
+        if( !check_sensor_setup( &db->sensor[k].setup, k, result ) )
+            reply = FALSE;
+    }
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        output    = &db->output[k].setup;
+        sensor_id = output->output.relay.sensor_id;
+
+        if( sensor_id < MAX_SENSORS )
+            sens_type = db->sensor[ sensor_id ].setup.sensor_type;
+        else
+            sens_type = SENSOR_TYPE_NONE;
+
+        if( output->output_type == OUTPUT_TYPE_ANALOG )
+        {
+            if( !check_analog_setup( db, &output->output.analog, sens_type, k, result ) )
+                reply = FALSE;
+        }
+        else
         {
-            strcpy( str, "The SNF mode must be either Fail ON or Fail OFF.<br/>\n" );
-            strcat( error_msg, ERROR_MESSAGE_PROMPT );
-            strcat( error_msg, str );
+            if( !check_relay_setup( db, &output->output.relay, sens_type, k, result ) )
+                reply = FALSE;
         }
     }
 
@@ -551,6 +569,73 @@ bool  valid_analog_setup( DATABASE * db, ANALOG_SETUP * analog, int sens_type, c
 }
 
 
+//
+//    render_valid_errors() - Make the text of the errors in "result",
+//                            in the form used by the web pages. At most
+//                            "size" characters, with the terminator, are
+//                            put in "msg".
+//
+void
+render_valid_errors( const VALID_RESULT * result, char * msg, int size )
+{
+    const VALID_ERROR * err;
+    char                min_str[20], max_str[20];
+    int                 k, len = 0;
+
+    msg[0] = 0;
+
+    for( k=0; (k < result->count) && (len < size); k++ )
+    {
+        err = &result->error[k];
+
+        len += snprintf( &msg[len], size - len, ERROR_MESSAGE_PROMPT );
+
+        if( result->show_item && (len < size) )
+        {
+            if( err->code <= VALID_OFFSET_TENTHS )
+                len += snprintf( &msg[len], size - len, "Sn-%d: ", err->item );
+            else
+                len += snprintf( &msg[len], size - len, "Output %d: ", err->item + 1 );
+        }
+
+        if( len >= size )
+            break;
+
+        switch( ValidErrorText[ err->code ].format )
+        {
+            case VALID_FORMAT_RANGE:
+                len += snprintf( &msg[len], size - len, ValidErrorText[ err->code ].text, err->min, err->max );
+            break;
+
+            case VALID_FORMAT_TENTHS:
+                sprintf( min_str, "%s%d.%d", (err->min < 0) ? "-" : "", abs( err->min ) / 10, abs( err->min ) % 10 );
+                sprintf( max_str, "%s%d.%d", (err->max < 0) ? "-" : "", abs( err->max ) / 10, abs( err->max ) % 10 );
+                len += snprintf( &msg[len], size - len, ValidErrorText[ err->code ].text, min_str, max_str );
+            break;
+
+            case VALID_FORMAT_SETPOINT:
+            case VALID_FORMAT_DIFF:
+#ifdef ENET_HARDWARE
+                build_setpoint_string( err->min, err->sensor_type, min_str );
+                build_setpoint_string( err->max, err->sensor_type, max_str );
+#else
+                sprintf( min_str, "%d", err->min );
+                sprintf( max_str, "%d", err->max );
+#endif
+                len += snprintf( &msg[len], size - len, ValidErrorText[ err->code ].text, min_str, max_str );
+            break;
+
+            default:
+                len += snprintf( &msg[len], size - len, ValidErrorText[ err->code ].text );
+            break;
+        }
+
+        if( len < size )
+            len += snprintf( &msg[len], size - len, ".<br/>\n" );
+    }
+}
+
+
 //
 //    read_ethernet_reset_button()
 //
@@ -785,7 +870,8 @@ get_maximum_diff_setpoint( unsigned char sensor_type )
 //                           of 5 could relate to +/- 0.5 deg C or
 //                           +/- 0.005 INWC
 //
-// Global Vars Affected:  None
+// Global Vars Affected:  SensorIncrement[] - Referenced to load the
+//                                            increment.
 //
 //           Parameters:  sensor_type - indicates the sensor type.
 //
@@ -794,49 +880,10 @@ get_maximum_diff_setpoint( unsigned char sensor_type )
 int
 get_sensor_increment( unsigned char sensor_type )
 {
-    int  reply;
-    
-    switch( sensor_type )
-    {
-        case SENSOR_TYPE_NONE:    
-            reply = 0;           
-        break;
-        
-        case SENSOR_TYPE_TEMP_F:    // +/- 1    deg F    
-        case SENSOR_TYPE_TEMP_HI_F: // +/- 1    deg F    
-        case SENSOR_TYPE_RH:        // +/- 1    %rH
-        case SENSOR_TYPE_P_15:      // +/- 0.1  BAR
-        case SENSOR_TYPE_P_30:      // +/- 0.1  BAR
-        case SENSOR_TYPE_P200:      // +/- 1    PSI
-        case SENSOR_TYPE_P500:      // +/- 1    PSI
-        case SENSOR_TYPE_BINARY:    // +/- 1    no units
-            reply = 1;
-        break;        
-        
-        case SENSOR_TYPE_TEMP_C:    // +/- 0.5   deg C
-        case SENSOR_TYPE_TEMP_HI_C: // +/- 0.5   deg C
-        case SENSOR_TYPE_P_0pt25:   // +/- 0.005 INWC
-        case SENSOR_TYPE_P_0pt5:    // +/- 0.005 INWC
-        case SENSOR_TYPE_P_5:       // +/- 0.05  INWC
-        case SENSOR_TYPE_P__8:      // +/- 0.05  BAR
-        case SENSOR_TYPE_P_10:      // +/- 0.05  INWC
-        case SENSOR_TYPE_P100:      // +/- 0.5   PSI
-        case SENSOR_TYPE_P110:      // +/- 0.5   PSI
-            reply = 5;   
-        break;
-
-        case SENSOR_TYPE_P_2pt5:    // +/- 0.02  INWC
-        case SENSOR_TYPE_P_50:      // +/- 0.2   BAR
-        case SENSOR_TYPE_P750:      // +/- 2     PSI
-            reply = 2;
-        break;
+    if( sensor_type > MAX_SENSOR_TYPE )
+        return( 0 );
 
-        default:
-            reply = 0;
-        break;
-    }
-
-    return( reply );
+    return( SensorIncrement[ sensor_type ] );
 }
 
 
@@ -851,7 +898,8 @@ get_sensor_increment( unsigned char sensor_type )
 //                            The decimal point position is a function
 //                            of the type of sensor being used.
 //
-// Global Vars Affected:  None
+// Global Vars Affected:  SensorDecimalPt[] - Referenced to load the
+//                                            decimal point position.
 //
 //           Parameters:  sensor_type - indicates the sensor type.
 //
@@ -863,48 +911,65 @@ get_sensor_increment( unsigned char sensor_type )
 unsigned char
 get_sensor_decimal_pt( unsigned char sensor_type )
 {
-    unsigned char reply;
-    
-    switch( sensor_type )
-    {      
-        case SENSOR_TYPE_TEMP_F:
-        case SENSOR_TYPE_TEMP_HI_F:
-        case SENSOR_TYPE_RH:
-        case SENSOR_TYPE_P200:
-        case SENSOR_TYPE_P500:
-        case SENSOR_TYPE_P750:
-        case SENSOR_TYPE_BINARY:
-            reply = 0;
-        break;
+    if( sensor_type > MAX_SENSOR_TYPE )
+        return( 0 );
 
-        case SENSOR_TYPE_TEMP_C:
-        case SENSOR_TYPE_TEMP_HI_C:
-        case SENSOR_TYPE_P_15:
-        case SENSOR_TYPE_P_30:
-        case SENSOR_TYPE_P_50:
-        case SENSOR_TYPE_P100:
-        case SENSOR_TYPE_P110:
-            reply = 3;   
-        break;
+    return( SensorDecimalPt[ sensor_type ] );
+}
 
-        case SENSOR_TYPE_P_2pt5:
-        case SENSOR_TYPE_P_5:
-        case SENSOR_TYPE_P__8:
-        case SENSOR_TYPE_P_10:
-            reply = 2;   
-        break;
 
-        case SENSOR_TYPE_P_0pt25:    
-        case SENSOR_TYPE_P_0pt5:    
-            reply = 1;   
-        break;
+//
+//  init_setpoint_limits() - Gather the setpoint limits of each sensor
+//                           type, for outputs that reference a sensor
+//                           and for those that reference Sn-d, into
+//                           SetpointLimits[][]. Called once at start-up;
+//                           the limits depend only on the sensor type,
+//                           so they do not change with the setup.
+//
+// Global Vars Affected:  SetpointLimits[][] - Loaded.
+//
+void
+init_setpoint_limits( void )
+{
+    SETPOINT_LIMITS * limits;
+    int               type;
 
-        default:
-            reply = 0;
-        break;
+    for( type=0; type<NUM_SENSOR_TYPES; type++ )
+    {
+        limits = &SetpointLimits[ LIMITS_SENSOR ][ type ];
+
+        limits->min_sp     = get_minimum_setpoint( type );
+        limits->max_sp     = get_maximum_setpoint( type );
+        limits->min_diff   = get_minimum_differential( type );
+        limits->increment  = get_sensor_increment( type );
+        limits->decimal_pt = get_sensor_decimal_pt( type );
+
+        SetpointLimits[ LIMITS_DIFF_SENSOR ][ type ] = *limits;
+
+        limits = &SetpointLimits[ LIMITS_DIFF_SENSOR ][ type ];
+
+        limits->min_sp     = get_minimum_diff_setpoint( type );
+        limits->max_sp     = get_maximum_diff_setpoint( type );
     }
+}
 
-    return( reply );
+
+//
+//  get_setpoint_limits() - Returns the setpoint limits for an output
+//                          that references sensor "sensor_id", of type
+//                          "sensor_type". An unknown type has the limits
+//                          of SENSOR_TYPE_NONE.
+//
+const SETPOINT_LIMITS *
+get_setpoint_limits( unsigned char sensor_type, int sensor_id )
+{
+    if( sensor_type > MAX_SENSOR_TYPE )
+        sensor_type = SENSOR_TYPE_NONE;
+
+    if( sensor_id == SENSOR_ID_DIFF )
+        return( &SetpointLimits[ LIMITS_DIFF_SENSOR ][ sensor_type ] );
+
+    return( &SetpointLimits[ LIMITS_SENSOR ][ sensor_type ] );
 }
 
 
@@ -1131,3 +1196,25 @@ uint8_t calc_i2c_crc( uint8_t * data, uint8_t len )
 
     return( crc );                 // Return CRC value
 }
+
+
+//
+//  calc_crc16() - CRC-16/CCITT of a block of data. Pass 0xFFFF as "crc"
+//                 to start, or the result of a previous call to continue.
+//                 Used for the records kept in flash and no-init RAM.
+//
+uint16_t
+calc_crc16( uint16_t crc, const uint8_t * data, uint32_t len )
+{
+    int  k;
+
+    while( len-- )
+    {
+        crc ^= (uint16_t) *data++ << 8;
+
+        for( k=0; k<8; k++ )
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+
+    return( crc );
+}
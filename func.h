@@ -27,10 +27,17 @@ int            get_sensor_type_from_id( DATABASE * db, int sensor_id );
 int            get_output_type_from_id( DATABASE * db, int output_id );
 
 bool           valid_sensor_setup( SENSOR_SETUP * sens, char * error_msg );
-bool           valid_sensor_id( DATABASE * db, int sensor_id );
+bool           valid_sensor_id( const DATABASE * db, int sensor_id );
 bool           valid_relay_setup( DATABASE * db, RELAY_SETUP * relay, int sens_type, char * error_msg );
 bool           valid_analog_setup( DATABASE * db, ANALOG_SETUP * analog, int sens_type, char * error_msg );
 
+void           valid_result_init( VALID_RESULT * result, bool show_item );
+bool           check_sensor_setup( const SENSOR_SETUP * sens, int item, VALID_RESULT * result );
+bool           check_relay_setup( const DATABASE * db, const RELAY_SETUP * relay, int sens_type, int item, VALID_RESULT * result );
+bool           check_analog_setup( const DATABASE * db, const ANALOG_SETUP * analog, int sens_type, int item, VALID_RESULT * result );
+bool           check_setup( const DATABASE * db, VALID_RESULT * result );
+void           render_valid_errors( const VALID_RESULT * result, char * msg, int size );
+
 void           load_default_setup( OUTPUT * output, uint8_t sensor_type );
 void           load_default_diff_setup( OUTPUT * output, unsigned char sensor_type );
 
@@ -41,11 +48,14 @@ int            get_minimum_diff_setpoint( unsigned char sensor_type );
 int            get_maximum_diff_setpoint( unsigned char sensor_type );
 int            get_sensor_increment( unsigned char sensor_type );
 unsigned char  get_sensor_decimal_pt( unsigned char sensor_type );
+void           init_setpoint_limits( void );
+const SETPOINT_LIMITS * get_setpoint_limits( unsigned char sensor_type, int sensor_id );
 unsigned char  differential_sensor_used(  OUTPUT * output, int num_outputs );
 
 void           delay_msec( uint8_t  delay_msec );
 void           delay_usec( uint16_t delay_usec );
 
 uint8_t        calc_i2c_crc( uint8_t * data, uint8_t len );
+uint16_t       calc_crc16( uint16_t crc, const uint8_t * data, uint32_t len );
 
 #endif
\ No newline at end of file
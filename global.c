@@ -98,14 +98,12 @@ MODBUS_SETUP     ModbusSetup;  // Modbus Communication settings
 //   use to synchronize with the core. The Core Database is protected by a
 //   mutex. In cases where the Core Database is not immediately accessible,
 //   the tasks will use their copy until such time as they can syncrhonize
-//   with the core.
+//   with the core. A task's copy is a view that holds only the fields
+//   the task uses, and is refreshed when coreDB.config_version changes.
 //
 DATABASE         coreDB;        // Core Database - the gold standard
-DATABASE         sensorDB;      // Copy maintained by the Sensor Task
-DATABASE         controlDB;     // Copy maintained by the Control Task
-DATABASE         uiDB;          // Copy maintained by the UI Task
-DATABASE         modbusDB;      // Copy maintained by the Modbus Task
-DATABASE         enetDB;        // Copy maintained by the Web Server
+SENSOR_VIEW      sensorDB;      // View maintained by the Sensor Task
+ENET_VIEW        enetDB;        // View maintained by the Web Server
 
 
 // The SensorTypeList is an array of the available sensors
@@ -395,6 +393,17 @@ const ANALOG_SETUP  DefaultDiffAnalogSetup[] =
   {SENSOR_ID_NONE, SENSOR_FAIL_OFF,  25,   0, 0, 100, 0, 1, 0, 0}   // SENSOR_TYPE_P_0pt25
 };
 
+// IntegrationTime[] is the integration time, in seconds, for each of
+//    the "Integration Constant" settings of an Analog output.
+//
+const uint16_t  IntegrationTime[] = {    0,   // I_TERM_OFF, P only
+                                      3600,   // I_TERM_1
+                                      1800,   // I_TERM_2
+                                       900,   // I_TERM_3
+                                       300,   // I_TERM_4
+                                       120,   // I_TERM_5
+                                        60 }; // I_TERM_6
+
 // MinimumSetpoint[] is an array of setpoints, representing
 //    the lowest value permitted. There are unique values
 //    for each of the sensor types. Each element in the
@@ -503,6 +512,93 @@ const int16_t MinimumDifferential[] = { 0,   // SENSOR_TYPE_NONE,   0
                                        1,   // SENSOR_TYPE_BINARY,    1.0 n/a
                                       10 }; // SENSOR_TYPE_P_0pt25, 0.010 INWC 
 
+// SetpointLimits[][] gathers the values of the tables above, and the
+//    tables below, for each sensor type; see init_setpoint_limits().
+//
+SETPOINT_LIMITS SetpointLimits[ NUM_LIMITS_KIND ][ NUM_SENSOR_TYPES ];
+
+// SensorIncrement[] is the amount a setpoint changes by with each
+//    press of the Up\Down keys, in the integer units of the setpoint.
+//    Each element in the array corresponds to a specific sensor type.
+//
+const uint8_t SensorIncrement[] = { 0,   // SENSOR_TYPE_NONE
+                                   1,   // SENSOR_TYPE_TEMP_F,    +/- 1     deg F
+                                   5,   // SENSOR_TYPE_TEMP_C,    +/- 0.5   deg C
+                                   1,   // SENSOR_TYPE_RH,        +/- 1     %rH
+                                   5,   // SENSOR_TYPE_P_0pt5,    +/- 0.005 INWC
+                                   5,   // SENSOR_TYPE_P__8,      +/- 0.05  BAR
+                                   5,   // SENSOR_TYPE_P_10,      +/- 0.05  INWC
+                                   1,   // SENSOR_TYPE_P_15,      +/- 0.1   BAR
+                                   1,   // SENSOR_TYPE_P_30,      +/- 0.1   BAR
+                                   2,   // SENSOR_TYPE_P_50,      +/- 0.2   BAR
+                                   5,   // SENSOR_TYPE_P100,      +/- 0.5   PSI
+                                   1,   // SENSOR_TYPE_P500,      +/- 1     PSI
+                                   2,   // SENSOR_TYPE_P750,      +/- 2     PSI
+                                   1,   // SENSOR_TYPE_P200,      +/- 1     PSI
+                                   2,   // SENSOR_TYPE_P_2pt5,    +/- 0.02  INWC
+                                   5,   // SENSOR_TYPE_P_5,       +/- 0.05  INWC
+                                   1,   // SENSOR_TYPE_TEMP_HI_F, +/- 1     deg F
+                                   5,   // SENSOR_TYPE_TEMP_HI_C, +/- 0.5   deg C
+                                   5,   // SENSOR_TYPE_P110,      +/- 0.5   PSI
+                                   1,   // SENSOR_TYPE_BINARY,    +/- 1     n/a
+                                   5 }; // SENSOR_TYPE_P_0pt25,   +/- 0.005 INWC
+
+// SensorDecimalPt[] is the decimal point position used to show the
+//    integer sensor and setpoint values; 0 = none, 1 = 000.0,
+//    2 = 00.00, 3 = 0.000. Each element in the array corresponds to
+//    a specific sensor type.
+//
+const uint8_t SensorDecimalPt[] = { 0,   // SENSOR_TYPE_NONE
+                                   0,   // SENSOR_TYPE_TEMP_F
+                                   3,   // SENSOR_TYPE_TEMP_C
+                                   0,   // SENSOR_TYPE_RH
+                                   1,   // SENSOR_TYPE_P_0pt5
+                                   2,   // SENSOR_TYPE_P__8
+                                   2,   // SENSOR_TYPE_P_10
+                                   3,   // SENSOR_TYPE_P_15
+                                   3,   // SENSOR_TYPE_P_30
+                                   3,   // SENSOR_TYPE_P_50
+                                   3,   // SENSOR_TYPE_P100
+                                   0,   // SENSOR_TYPE_P500
+                                   0,   // SENSOR_TYPE_P750
+                                   0,   // SENSOR_TYPE_P200
+                                   2,   // SENSOR_TYPE_P_2pt5
+                                   2,   // SENSOR_TYPE_P_5
+                                   0,   // SENSOR_TYPE_TEMP_HI_F
+                                   3,   // SENSOR_TYPE_TEMP_HI_C
+                                   3,   // SENSOR_TYPE_P110
+                                   0,   // SENSOR_TYPE_BINARY
+                                   1 }; // SENSOR_TYPE_P_0pt25
+
+// ValidErrorText[] is the text of each setup error, VALID_xxx, found
+//    by the check_xxx_setup() functions. render_valid_errors() puts
+//    the limits in, and ends each one with ".<br/>".
+//
+const VALID_TEXT ValidErrorText[] =
+{
+  { "The Sensor Type must be in the range of %d to %d",                VALID_FORMAT_RANGE    },
+  { "The Offset must be in the range of %d to %d",                     VALID_FORMAT_RANGE    },
+  { "The Offset must be in the range of %s to %s",                     VALID_FORMAT_TENTHS   },
+
+  { "Invalid sensor referenced",                                        VALID_FORMAT_NONE     },
+  { "The ON point must be in the range of %s to %s",                   VALID_FORMAT_SETPOINT },
+  { "The OFF point must be in the range of %s to %s",                  VALID_FORMAT_SETPOINT },
+  { "A minimum difference between ON and OFF of %s must be maintained", VALID_FORMAT_DIFF     },
+  { "The ON Delay must be in the range of %d to %d seconds",           VALID_FORMAT_RANGE    },
+  { "The OFF Delay must be in the range of %d to %d seconds",          VALID_FORMAT_RANGE    },
+  { "The Minimum ON Time must be in the range of %d to %d seconds",    VALID_FORMAT_RANGE    },
+  { "The Minimum OFF Time must be in the range of %d to %d seconds",   VALID_FORMAT_RANGE    },
+  { "The SP value must be in the range of %s to %s",                   VALID_FORMAT_SETPOINT },
+  { "The EP value must be in the range of %s to %s",                   VALID_FORMAT_SETPOINT },
+  { "A minimum difference between SP and EP of %s must be maintained", VALID_FORMAT_DIFF     },
+  { "The OSP value must be in the range of %d to %d",                  VALID_FORMAT_RANGE    },
+  { "The OEP value must be in the range of %d to %d",                  VALID_FORMAT_RANGE    },
+  { "The I-C value must be in the range of %d to %d",                  VALID_FORMAT_RANGE    },
+  { "The UP-R value must be in the range of %d to %d",                 VALID_FORMAT_RANGE    },
+  { "The bND value must be in the range of %d to %d",                  VALID_FORMAT_RANGE    },
+  { "The SNF mode must be either Fail ON or Fail OFF",                 VALID_FORMAT_NONE     }
+};
+
 
 // Template[] is an array of values describe a "screen", a
 //    specific display, on the LCD. Contained in the template
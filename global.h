@@ -94,10 +94,15 @@ extern const RELAY_SETUP     DefaultRelaySetup[];      // Default Relay setup
 extern const RELAY_SETUP     DefaultDiffRelaySetup[];  // Default Diff-Relay setup
 extern const ANALOG_SETUP    DefaultAnalogSetup[];     // Default Analog setup
 extern const ANALOG_SETUP    DefaultDiffAnalogSetup[]; // Default Diff-Analog setup
+extern const uint16_t        IntegrationTime[];        // Seconds, per I_TERM_x
 extern const int16_t         MinimumSetpoint[];        // Min Setpt, per sensor type
 extern const int16_t         MinDiffSetpoint[];        // Min Differential Setpt, per sensor type
 extern const int16_t         MaximumSetpoint[];        // Max Setpt, per sensor type
 extern const int16_t         MinimumDifferential[];    // Min Diff, per sensor type
+extern const uint8_t         SensorIncrement[];        // Up\Down step, per sensor type
+extern const uint8_t         SensorDecimalPt[];        // Decimal point, per sensor type
+extern       SETPOINT_LIMITS SetpointLimits[ NUM_LIMITS_KIND ][ NUM_SENSOR_TYPES ];
+extern const VALID_TEXT      ValidErrorText[];         // Text, per VALID_xxx code
 
 // This global variable is used solely by LCD routines, so it is declared
 //     here. It is used to blink parameters available for edit.
@@ -120,12 +125,16 @@ extern       MODBUS_SETUP    ModbusSetup;       // Modbus setup data
 //   the tasks will use their copy until such time as they can syncrhonize
 //   with the core.
 //
+//   The sensor status that changes every sample cycle is not read from
+//   coreDB; it is published without the mutex, see live_status.h.
+//
+//   A task's copy is a view that holds only the fields it uses, see
+//   SENSOR_VIEW and ENET_VIEW. A task added later declares its own view
+//   rather than another full DATABASE.
+//
 extern       DATABASE        coreDB;
-extern       DATABASE        sensorDB;
-extern       DATABASE        controlDB;
-extern       DATABASE        uiDB;
-extern       DATABASE        modbusDB;
-extern       DATABASE        enetDB;
+extern       SENSOR_VIEW     sensorDB;
+extern       ENET_VIEW       enetDB;
 
 extern const uint8_t          SensorTypeList[];  // List of available sensor types
 extern       uint8_t          SensorList[];      // List of actual sensors
@@ -0,0 +1,530 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : journal.c
+
+PURPOSE   : Event and alarm journal. journal_record() stamps an event
+            with the next sequence number and the operating time, and
+            puts it in a ring of JOURNAL_RAM_SIZE records in RAM. It
+            takes a few dozen cycles, never blocks, and may be called
+            from any task or driver callback.
+
+            The Flash_Task then appends the new records to a ring of
+            JOURNAL_SECTORS flash sectors in the config store area. A
+            sector is erased only when the ring wraps around onto it,
+            so the flash holds the last few hundred events. At start-up
+            the sectors are scanned to find where to carry on.
+
+            The operating time is SecCounter plus a base found at
+            start-up, so that it carries on from the newest record in
+            flash rather than starting again at 0 after a power cycle.
+            The sequence numbers and the times therefore never go back,
+            and both are looked up with a binary search; first in the
+            RAM ring, then in each flash sector, which holds records in
+            order. A reader asks for the records from a sequence number
+            on, and pages through with the number after the last one it
+            was given.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "func.h"
+#include "task_monitor.h"
+#include "work_queue.h"
+#include "config_store.h"
+#include "warm_restart.h"
+#include "journal.h"
+
+#define  JOURNAL_RAM_MASK     (JOURNAL_RAM_SIZE - 1)
+#define  JOURNAL_ERASED       0xFFFFFFFF
+
+#define  JOURNAL_CRC( rec )   calc_crc16( 0xFFFF, (const uint8_t *)(rec), offsetof( JOURNAL_RECORD, crc ) )
+
+JOURNAL_STATS      JournalStats;
+
+const char *       JournalTypeName[ MAX_JOURNAL_TYPE ] =
+{
+    "boot",               // JOURNAL_BOOT
+    "sensor_fail",        // JOURNAL_SENSOR_FAIL
+    "sensor_power",       // JOURNAL_SENSOR_POWER
+    "supply_power",       // JOURNAL_SUPPLY_POWER
+    "wifi",               // JOURNAL_WIFI
+    "relay_request",      // JOURNAL_RELAY_REQUEST
+    "relay_output",       // JOURNAL_RELAY_OUTPUT
+    "sensor_failover"     // JOURNAL_SENSOR_FAILOVER
+};
+
+JOURNAL_RECORD     JournalRam[ JOURNAL_RAM_SIZE ];
+volatile uint32_t  JournalSeq;              // Newest record, 0 = none
+uint32_t           JournalRamFirst;         // First record made since reset
+uint32_t           JournalFlashed;          // Newest record in flash
+uint32_t           JournalTimeBase;         // Added to SecCounter
+bool               JournalReady;
+bool               JournalStarted;          // Flash_Task may be posted to
+volatile bool      JournalFlushPosted;
+
+bool               JournalFlashOk;          // The sectors are available
+uint32_t           JournalSectorSlots;      // Records per sector
+uint16_t           JournalSector;           // Sector being written
+uint32_t           JournalUsed[ JOURNAL_SECTORS ];  // Slots written, each sector
+
+
+// Function Prototypes - used by this module only
+//
+void      journal_flush_work( void * ctx, uint32_t arg );
+bool      journal_flash_append( JOURNAL_RECORD * rec );
+uint32_t  journal_scan_sector( uint16_t sector, const JOURNAL_RECORD ** newest );
+uint32_t  journal_ram_first( void );
+uint32_t  journal_search( const JOURNAL_RECORD * recs, uint32_t count, uint32_t key, bool by_time );
+uint32_t  journal_ram_search( uint32_t first, uint32_t time );
+
+
+//
+//  journal_init() - Find the newest record in flash and carry on from
+//                   it, then record the reset. Called by init_globals()
+//                   once the config store is open and SecCounter has
+//                   been restored.
+//
+void
+journal_init( void )
+{
+    const JOURNAL_RECORD * newest = NULL;
+    const JOURNAL_RECORD * last;
+    uint16_t               s;
+
+    JournalFlashOk = (CfgAreaSectors >= JOURNAL_SECTORS) && (CfgSectorSize >= sizeof( JOURNAL_RECORD ));
+
+    if( JournalFlashOk )
+    {
+        JournalSectorSlots = CfgSectorSize / sizeof( JOURNAL_RECORD );
+
+        for( s=0; s<JOURNAL_SECTORS; s++ )
+        {
+            last = NULL;
+            JournalUsed[s] = journal_scan_sector( s, &last );
+
+            if( (last != NULL) && ((newest == NULL) || (last->seq > newest->seq)) )
+            {
+                newest        = last;
+                JournalSector = s;
+            }
+        }
+    }
+
+    if( newest != NULL )
+    {
+        JournalSeq = newest->seq;
+
+        if( newest->time > SecCounter )
+            JournalTimeBase = newest->time - SecCounter;
+    }
+
+    JournalFlashed  = JournalSeq;
+    JournalRamFirst = JournalSeq + 1;
+    JournalReady    = TRUE;
+
+    journal_record( JOURNAL_BOOT, WarmRestartStats.source, (uint16_t) ResetStatusRegLow );
+}
+
+
+//
+//  journal_start() - Called once the Flash_Task is running. Records made
+//                    before this are written to flash now.
+//
+void
+journal_start( void )
+{
+    JournalStarted = TRUE;
+
+    JournalFlushPosted = TRUE;
+    if( !work_queue_post( WORK_PRIO_FLASH, journal_flush_work, NULL, 0 ) )
+        JournalFlushPosted = FALSE;
+}
+
+
+//
+//  journal_record() - Record one event. Safe to call from any task or
+//                     driver callback.
+//
+void
+journal_record( uint8_t type, uint8_t id, uint16_t arg )
+{
+    JOURNAL_RECORD * rec;
+    uint32_t         seq;
+
+    if( !JournalReady )
+        return;
+
+    _int_disable();
+
+    seq = ++JournalSeq;
+    rec = &JournalRam[ seq & JOURNAL_RAM_MASK ];
+
+    rec->seq      = seq;
+    rec->time     = JournalTimeBase + SecCounter;
+    rec->arg      = arg;
+    rec->type     = type;
+    rec->id       = id;
+    rec->reserved = 0xFFFF;
+    rec->crc      = 0;
+
+    JournalStats.records++;
+
+    _int_enable();
+
+    if( JournalStarted && !JournalFlushPosted )
+    {
+        JournalFlushPosted = TRUE;
+
+        if( !work_queue_post( WORK_PRIO_FLASH, journal_flush_work, NULL, 0 ) )
+            JournalFlushPosted = FALSE;     // Sent with the next record
+    }
+}
+
+
+//
+//  journal_last_seq() - Returns the sequence number of the newest record,
+//                       0 if there are none.
+//
+uint32_t
+journal_last_seq( void )
+{
+    return( JournalSeq );
+}
+
+
+//
+//  journal_first_seq() - Returns the sequence number of the oldest record
+//                        still held, in flash or RAM.
+//
+uint32_t
+journal_first_seq( void )
+{
+    const JOURNAL_RECORD * recs;
+    uint16_t               k, s;
+
+    if( JournalFlashOk )
+    {
+        // The sector after the one being written is the oldest
+        //
+        for( k=1; k<=JOURNAL_SECTORS; k++ )
+        {
+            s = (JournalSector + k) % JOURNAL_SECTORS;
+
+            if( JournalUsed[s] )
+            {
+                recs = cfg_area_map( s );
+                return( recs[0].seq );
+            }
+        }
+    }
+
+    return( journal_ram_first() );
+}
+
+
+//
+//  journal_seq_at_time() - Returns the sequence number of the first record
+//                          at or after "time", or one past the newest
+//                          record if there is none.
+//
+uint32_t
+journal_seq_at_time( uint32_t time )
+{
+    const JOURNAL_RECORD * recs;
+    uint32_t               first, k;
+    uint16_t               s;
+
+    first = journal_ram_first();
+
+    if( (first <= JournalSeq) && (JournalRam[ first & JOURNAL_RAM_MASK ].time <= time) )
+        return( journal_ram_search( first, time ) );
+
+    if( JournalFlashOk )
+    {
+        // The first sector, oldest first, with a record at or after "time"
+        //
+        for( k=1; k<=JOURNAL_SECTORS; k++ )
+        {
+            s    = (JournalSector + k) % JOURNAL_SECTORS;
+            recs = cfg_area_map( s );
+
+            if( JournalUsed[s] && (recs[ JournalUsed[s] - 1 ].time >= time) )
+                return( recs[ journal_search( recs, JournalUsed[s], time, TRUE ) ].seq );
+        }
+    }
+
+    return( (first <= JournalSeq) ? journal_ram_search( first, time ) : JournalSeq + 1 );
+}
+
+
+//
+//  journal_read() - Copy up to "max" records, from sequence number "seq"
+//                   on, oldest first. Returns the number copied; the
+//                   caller asks for the next page from the sequence
+//                   number after the last one.
+//
+int
+journal_read( uint32_t seq, JOURNAL_RECORD * rec, int max )
+{
+    const JOURNAL_RECORD * recs;
+    uint32_t               start, first, k, j;
+    uint16_t               s;
+    int                    n = 0;
+
+    start = TMON_CYCLE_COUNT();
+    first = journal_ram_first();
+
+    // Records made before the RAM ring are read from flash.
+    //
+    if( JournalFlashOk && (seq < first) )
+    {
+        for( k=1; (k<=JOURNAL_SECTORS) && (n < max); k++ )
+        {
+            s    = (JournalSector + k) % JOURNAL_SECTORS;
+            recs = cfg_area_map( s );
+
+            if( (JournalUsed[s] == 0) || (recs[ JournalUsed[s] - 1 ].seq < seq) )
+                continue;
+
+            for( j = journal_search( recs, JournalUsed[s], seq, FALSE );
+                 (j < JournalUsed[s]) && (n < max) && (recs[j].seq < first); j++ )
+            {
+                if( JOURNAL_CRC( &recs[j] ) == recs[j].crc )
+                    rec[ n++ ] = recs[j];
+            }
+        }
+    }
+
+    if( seq < first )
+        seq = first;
+
+    // A record may be overwritten while it is copied; it is then skipped.
+    //
+    for( ; (seq <= JournalSeq) && (n < max); seq++ )
+    {
+        _int_disable();
+        rec[n] = JournalRam[ seq & JOURNAL_RAM_MASK ];
+        _int_enable();
+
+        if( rec[n].seq == seq )
+            n++;
+    }
+
+    start = TMON_CYCLE_COUNT() - start;
+
+    JournalStats.queries++;
+
+    if( start > JournalStats.query_max )
+        JournalStats.query_max = start;
+
+    return( n );
+}
+
+
+//
+//  journal_format() - Format a record as one line of text, without a
+//                     new line. Returns the length.
+//
+int
+journal_format( const JOURNAL_RECORD * rec, char * str, int len )
+{
+    const char * name = (rec->type < MAX_JOURNAL_TYPE) ? JournalTypeName[ rec->type ] : "?";
+
+    return( snprintf( str, len, "%8u %9u  %-14s %3u %5u",
+                      rec->seq, rec->time, name, rec->id, rec->arg ) );
+}
+
+
+//
+//  journal_flush_work() - Flash_Task callback. Append the records not yet
+//                         in flash.
+//
+void
+journal_flush_work( void * ctx, uint32_t arg )
+{
+    JOURNAL_RECORD  rec;
+    uint32_t        next, oldest;
+
+    // Cleared first, so that a record made while this runs posts again
+    //
+    JournalFlushPosted = FALSE;
+
+    while( JournalFlashed != JournalSeq )
+    {
+        next = JournalFlashed + 1;
+
+        if( !JournalFlashOk )
+        {
+            JournalFlashed = next;
+            continue;
+        }
+
+        // Records overwritten in RAM before they were written are lost
+        //
+        oldest = journal_ram_first();
+
+        if( next < oldest )
+        {
+            JournalStats.lost += oldest - next;
+            JournalFlashed     = oldest - 1;
+            continue;
+        }
+
+        _int_disable();
+        rec = JournalRam[ next & JOURNAL_RAM_MASK ];
+        _int_enable();
+
+        if( rec.seq == next )
+        {
+            rec.crc = JOURNAL_CRC( &rec );
+
+            if( journal_flash_append( &rec ) )
+                JournalStats.flashed++;
+            else
+                JournalStats.flash_errors++;
+        }
+
+        JournalFlashed = next;
+    }
+}
+
+
+//
+//  journal_flash_append() - Append a record to the sector being written,
+//                           moving on to the next sector, and erasing it,
+//                           when it is full.
+//
+bool
+journal_flash_append( JOURNAL_RECORD * rec )
+{
+    const JOURNAL_RECORD * recs;
+    uint32_t               slot;
+
+    if( JournalUsed[ JournalSector ] >= JournalSectorSlots )
+    {
+        JournalSector = (JournalSector + 1) % JOURNAL_SECTORS;
+        JournalUsed[ JournalSector ] = 0;
+        JournalStats.erases++;
+
+        if( !cfg_area_erase( JournalSector ) )
+            return( FALSE );
+    }
+
+    slot = JournalUsed[ JournalSector ]++;
+    recs = cfg_area_map( JournalSector );
+
+    // A slot that does not read back is left used, and the record is
+    //    not retried.
+    //
+    return( cfg_area_write( JournalSector, slot * sizeof( JOURNAL_RECORD ), rec, sizeof( JOURNAL_RECORD ) ) &&
+            (memcmp( &recs[ slot ], rec, sizeof( JOURNAL_RECORD ) ) == 0) );
+}
+
+
+//
+//  journal_scan_sector() - Returns the number of slots written in a
+//                          sector, and the newest good record in it. A
+//                          sector holding anything else is erased.
+//
+uint32_t
+journal_scan_sector( uint16_t sector, const JOURNAL_RECORD ** newest )
+{
+    const JOURNAL_RECORD * recs = cfg_area_map( sector );
+    uint32_t               k;
+
+    for( k=0; k<JournalSectorSlots; k++ )
+    {
+        if( recs[k].seq == JOURNAL_ERASED )
+            break;
+
+        if( JOURNAL_CRC( &recs[k] ) == recs[k].crc )
+            *newest = &recs[k];
+    }
+
+    if( (k > 0) && (*newest == NULL) )
+    {
+        cfg_area_erase( sector );
+        JournalStats.erases++;
+        k = 0;
+    }
+
+    return( k );
+}
+
+
+//
+//  journal_ram_first() - Returns the sequence number of the oldest record
+//                        in the RAM ring.
+//
+uint32_t
+journal_ram_first( void )
+{
+    uint32_t  last = JournalSeq;
+
+    if( last - JournalRamFirst >= JOURNAL_RAM_SIZE )
+        return( last - JOURNAL_RAM_SIZE + 1 );
+
+    return( JournalRamFirst );
+}
+
+
+//
+//  journal_search() - Returns the index of the first of "count" records
+//                     in a flash sector with a sequence number (or time)
+//                     at or after "key", or "count" if there is none.
+//
+uint32_t
+journal_search( const JOURNAL_RECORD * recs, uint32_t count, uint32_t key, bool by_time )
+{
+    uint32_t  lo = 0, hi = count, mid;
+
+    while( lo < hi )
+    {
+        mid = (lo + hi) / 2;
+
+        if( (by_time ? recs[ mid ].time : recs[ mid ].seq) < key )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return( lo );
+}
+
+
+//
+//  journal_ram_search() - Returns the sequence number of the first record
+//                         in the RAM ring, from "first" on, at or after
+//                         "time", or one past the newest record.
+//
+uint32_t
+journal_ram_search( uint32_t first, uint32_t time )
+{
+    const JOURNAL_RECORD * rec;
+    uint32_t               lo = first, hi = JournalSeq + 1, mid;
+
+    while( lo < hi )
+    {
+        mid = lo + (hi - lo) / 2;
+        rec = &JournalRam[ mid & JOURNAL_RAM_MASK ];
+
+        if( rec->time < time )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return( lo );
+}
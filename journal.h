@@ -0,0 +1,110 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : journal.h
+
+PURPOSE   : Definitions and function prototypes for the "journal.c"
+            module. The journal is a record of the events and alarms
+            seen in the field; sensor failures, supply faults, Wi-Fi
+            connects and relay changes, so that the order in which
+            things went wrong can be worked out afterwards.
+
+            Each event is a small binary record with a sequence number
+            that is never reused and a time. The newest records are
+            kept in RAM, and all of them are copied to a ring of flash
+            sectors that survives a power cycle.
+
+            The journal is read with the "journal" shell command, or
+            with the "journal_data" CGI, a page at a time.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __journal_inc
+#define  __journal_inc
+
+#include <mqx.h>
+
+#define  JOURNAL_RAM_SIZE     128    // Records, must be a power of 2
+#define  JOURNAL_SECTORS        4    // Flash sectors, from the start of the
+                                     //   config store area
+
+// Event types. These values are saved in flash; add new types at the end
+//   and never reuse a value.
+//
+typedef enum
+{
+    JOURNAL_BOOT           = 0,   // id  = WARM_SOURCE, arg = RCM_SRS0
+    JOURNAL_SENSOR_FAIL    = 1,   // id  = sensor ID, arg = 1 failed, 0 OK
+    JOURNAL_SENSOR_POWER   = 2,   // arg = 1 ext. 5 vdc low, 0 OK
+    JOURNAL_SUPPLY_POWER   = 3,   // arg = 1 10 vdc reference low, 0 OK
+    JOURNAL_WIFI           = 4,   // arg = 1 connected, 0 disconnected
+    JOURNAL_RELAY_REQUEST  = 5,   // id  = JOURNAL_SOURCE, arg = state asked for
+    JOURNAL_RELAY_OUTPUT   = 6,   // arg = state the relay was driven to
+    JOURNAL_SENSOR_FAILOVER = 7   // id  = output, arg = sensor ID now used,
+                                  //   FAILOVER_AVERAGE, 0 = none
+
+}  JOURNAL_TYPE;
+
+#define  MAX_JOURNAL_TYPE   JOURNAL_SENSOR_FAILOVER + 1
+
+// Where a relay change came from, the "id" of JOURNAL_RELAY_REQUEST.
+//
+typedef enum
+{
+    JOURNAL_SOURCE_BUTTON  = 0,   // Button_Task
+    JOURNAL_SOURCE_WEB     = 1,   // cgi_write_relay()
+    JOURNAL_SOURCE_CONTROL = 2    // Control_Task, the relay engine
+
+}  JOURNAL_SOURCE;
+
+// JOURNAL_RECORD - 16 bytes, the same in RAM and flash. The CRC covers
+//   the record before it, and is only filled in when the record is
+//   written to flash.
+//
+typedef struct
+{
+    uint32_t  seq;        // 1, 2, 3 ... 0xFFFFFFFF = erased flash
+    uint32_t  time;       // Operating time, seconds; see journal.c
+    uint16_t  arg;        // Event specific, see JOURNAL_TYPE
+    uint8_t   type;       // JOURNAL_TYPE
+    uint8_t   id;
+    uint16_t  reserved;   // 0xFFFF
+    uint16_t  crc;
+
+}  JOURNAL_RECORD;
+
+// JOURNAL_STATS - Counts since reset, shown by the "journal" command.
+//
+typedef struct
+{
+    uint32_t  records;       // Events recorded
+    uint32_t  flashed;       // Records written to flash
+    uint32_t  lost;          // Records overwritten in RAM before they
+                             //   were written to flash
+    uint32_t  erases;        // Flash sectors erased
+    uint32_t  flash_errors;
+    uint32_t  queries;       // journal_read() calls
+    uint32_t  query_max;     // Longest journal_read(), cycles
+
+}  JOURNAL_STATS;
+
+extern JOURNAL_STATS   JournalStats;
+extern const char *    JournalTypeName[ MAX_JOURNAL_TYPE ];
+
+//
+//    Function Prototypes
+//
+void      journal_init( void );
+void      journal_start( void );
+void      journal_record( uint8_t type, uint8_t id, uint16_t arg );
+uint32_t  journal_last_seq( void );
+uint32_t  journal_first_seq( void );
+uint32_t  journal_seq_at_time( uint32_t time );
+int       journal_read( uint32_t seq, JOURNAL_RECORD * rec, int max );
+int       journal_format( const JOURNAL_RECORD * rec, char * str, int len );
+
+#endif
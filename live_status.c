@@ -0,0 +1,127 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : live_status.c
+
+PURPOSE   : Lock free publication of the live status.
+
+            There are two copies of the live status, each guarded by a
+            sequence count. The writer fills in the copy that is not
+            current, making its count odd while it does so, and then
+            makes that copy current. A reader copies the current copy
+            and then checks that its count did not change; if it did,
+            the writer reused the copy part way through and the read is
+            repeated.
+
+            Using two copies matters here because readers run at both
+            higher priority (Work_Task) and lower priority (web server,
+            shell) than the Sensor_Task. A higher priority reader that
+            interrupts the writer reads the other, complete copy, so it
+            never has to wait for the writer to run again. A reader can
+            only have to retry if the writer interrupted it, and the
+            writer runs once per second.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <intrinsics.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "task_monitor.h"
+#include "live_status.h"
+
+typedef struct
+{
+    volatile uint32_t  seq;     // Odd while the writer is filling it in
+    LIVE_STATUS        status;
+}  LIVE_STATUS_COPY;
+
+LIVE_STATUS_COPY    LiveStatusCopy[ 2 ];
+volatile uint32_t   LiveStatusCurrent;    // Index of the current copy
+uint32_t            LiveStatusVersion;
+
+LIVE_STATUS_STATS   LiveStatusStats;
+
+
+//
+//  live_status_publish() - Make "status" the current live status. Must
+//                          only be called by the Sensor_Task, or by
+//                          warm_restart_restore() before it is started.
+//
+void
+live_status_publish( const LIVE_STATUS * status )
+{
+    LIVE_STATUS_COPY * copy;
+    uint32_t           start, next;
+
+    start = TMON_CYCLE_COUNT();
+
+    next = LiveStatusCurrent ^ 1;
+    copy = &LiveStatusCopy[ next ];
+
+    copy->seq++;                  // Odd, being written
+    __DMB();
+
+    copy->status         = *status;
+    copy->status.version = ++LiveStatusVersion;
+
+    __DMB();
+    copy->seq++;                  // Even, complete
+
+    LiveStatusCurrent = next;
+
+    start = TMON_CYCLE_COUNT() - start;
+
+    LiveStatusStats.writes++;
+
+    if( start > LiveStatusStats.write_max )
+        LiveStatusStats.write_max = start;
+}
+
+
+//
+//  live_status_read() - Copy the current live status into "status".
+//                       Returns its version, 0 if no sample cycle has
+//                       completed yet. Safe to call from any task.
+//
+uint32_t
+live_status_read( LIVE_STATUS * status )
+{
+    LIVE_STATUS_COPY * copy;
+    uint32_t           start, seq;
+
+    start = TMON_CYCLE_COUNT();
+
+    while( TRUE )
+    {
+        copy = &LiveStatusCopy[ LiveStatusCurrent ];
+        seq  = copy->seq;
+        __DMB();
+
+        if( !(seq & 1) )
+        {
+            *status = copy->status;
+            __DMB();
+
+            if( copy->seq == seq )
+                break;
+        }
+
+        LiveStatusStats.retries++;
+    }
+
+    start = TMON_CYCLE_COUNT() - start;
+
+    LiveStatusStats.reads++;
+
+    if( start > LiveStatusStats.read_max )
+        LiveStatusStats.read_max = start;
+
+    return( status->version );
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : live_status.h
+
+PURPOSE   : Definitions and function prototypes for the "live_status.c"
+            module. The live status is the part of the database that
+            the Sensor_Task updates every sample cycle; sensor values,
+            supply voltages and CPU temperature.
+
+            It is published without mutexCore. The Sensor_Task (the only
+            writer) never waits, and a reader always gets a consistent
+            snapshot of one sample cycle, tagged with a version number.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __live_status_inc
+#define  __live_status_inc
+
+#include <mqx.h>
+#include "defines.h"
+
+// SENSOR_STATUS - The per sample status of one sensor, see SENSOR.
+//
+typedef struct
+{
+    int16_t   value_int;     // Engineering units, as an integer
+    float     value_float;   // Engineering units, floating point
+    bool      fail;          // TRUE = sensor has failed
+    double    signal;        // Resistance (ohms) or voltage (vdc)
+}  SENSOR_STATUS;
+
+// LIVE_STATUS - One consistent snapshot of the live status.
+//
+typedef struct
+{
+    uint32_t       version;     // Incremented by every publish, 0 = none yet
+    SENSOR_STATUS  sensor[ MAX_SENSORS ];
+    float          cpu_temp;        // CPU Temp, in degrees F
+    float          five_volt_ext;   // 5 volt external
+    float          ten_volt_ref;    // 10 volt reference
+}  LIVE_STATUS;
+
+// LIVE_STATUS_STATS - Cost of publishing and reading, in core clock
+//   cycles, for comparison with the mutexCore times shown by "lock".
+//
+typedef struct
+{
+    uint32_t  writes;
+    uint32_t  write_max;
+    uint32_t  reads;
+    uint32_t  retries;       // Reads repeated because the writer overlapped
+    uint32_t  read_max;
+}  LIVE_STATUS_STATS;
+
+extern LIVE_STATUS_STATS  LiveStatusStats;
+
+//
+//    Function Prototypes
+//
+void      live_status_publish( const LIVE_STATUS * status );
+uint32_t  live_status_read( LIVE_STATUS * status );
+
+#endif
@@ -0,0 +1,248 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : output_commit.c
+
+PURPOSE   : Output commit stage, run by the Control_Task after the relay
+            engine and the analog controller. It collects the value of
+            every expansion module output from the pass, and sends each
+            module that has a point differing from its last acknowledged
+            value one frame with all of its points and one CRC.
+
+            A module whose points all match what it acknowledged is not
+            written, however often the control pass runs. A frame that is
+            not acknowledged leaves the points unacknowledged, so the next
+            try sends the values current at that time; the tries back off
+            from 1 to OUTPUT_BACKOFF_MAX passes.
+
+            There is no expansion module driver in this build.
+            output_bus_write() checks each frame and acknowledges it. In
+            a test build, OUTPUT_BUS_TEST, it also fails OutputBusFailPct
+            percent of them, so that the retries can be tried; this is
+            never in a production build, where the failures would show
+            in i2c_error_count.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "func.h"
+#include "system450.h"
+#include "task_monitor.h"
+#include "output_commit.h"
+
+OUTPUT_COMMIT      OutputCommit;
+
+#if OUTPUT_BUS_TEST
+uint8_t            OutputBusFailPct = 0;     // Set by "control busfail"
+
+static uint32_t    OutputBusSeed = 1;
+#endif
+
+
+// Function Prototypes - used by this module only
+//
+_mqx_uint output_bus_write( uint8_t * frame, uint8_t len );
+
+
+//
+//  output_commit_setup() - Take the module and point of each output from
+//                          "db". An output that moved is sent again, and
+//                          one with a module or point that does not exist
+//                          is not sent. Called with mutexCore locked.
+//
+void
+output_commit_setup( OUTPUT_COMMIT * oc, const DATABASE * db )
+{
+    int             k;
+    uint8_t         module;
+    OUTPUT_POINT  * p;
+    const OUTPUT  * out;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        p      = &oc->point[k];
+        out    = &db->output[k];
+        module = out->module_addr;
+
+        if(    (out->setup.output_type == OUTPUT_TYPE_NONE) || (module > MAX_MODULES)
+            || (out->point_addr >= OUTPUT_POINTS) )
+            module = 0;
+
+        if( (p->module != module) || (p->point != out->point_addr) || (p->type != out->setup.output_type) )
+            p->flags = 0;
+
+        p->module = module;
+        p->point  = out->point_addr;
+        p->type   = out->setup.output_type;
+    }
+}
+
+
+//
+//  output_commit_run() - Send the outputs decided by one control pass.
+//
+void
+output_commit_run( OUTPUT_COMMIT * oc, const RELAY_ENGINE * relays, const ANALOG_ENGINE * analogs )
+{
+    uint8_t          frame[ MAX_MODULES + 1 ][ OUTPUT_FRAME_LEN ];
+    uint16_t         used  = 0;      // Bit per module with a point
+    uint16_t         dirty = 0;      // Bit per module with a point to send
+    uint8_t          value;
+    uint32_t         start;
+    int              k, m;
+    OUTPUT_POINT   * p;
+    OUTPUT_MODULE  * mod;
+
+    start = TMON_CYCLE_COUNT();
+    oc->passes++;
+
+    memset( frame, 0, sizeof( frame ) );
+
+    // The value of each point, and which modules have one to send.
+    //
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        p = &oc->point[k];
+        m = p->module;
+
+        if( m == 0 )
+            continue;
+
+        if( p->type == OUTPUT_TYPE_RELAY )
+            value = RELAY_OUTPUT( relays->relay[k].state );
+        else
+            value = (analogs->analog[k].flags & ANALOG_ACTIVE) ? analogs->analog[k].written : 0;
+
+        if( !(p->flags & OUTPUT_SEEN) || (p->value != value) )
+        {
+            oc->single_msgs++;
+            oc->single_bytes += OUTPUT_SINGLE_LEN;
+        }
+
+        p->value  = value;
+        p->flags |= OUTPUT_SEEN;
+
+        frame[m][2] |= 1 << p->point;
+        frame[m][3 + p->point] = value;
+        used |= 1 << m;
+
+        if( !(p->flags & OUTPUT_ACKED) || (p->acked != value) )
+            dirty |= 1 << m;
+    }
+
+    // One frame per module with a point to send.
+    //
+    for( m=1; m<=MAX_MODULES; m++ )
+    {
+        if( !(dirty & (1 << m)) )
+        {
+            if( used & (1 << m) )
+                oc->skipped++;
+            continue;
+        }
+
+        mod = &oc->module[m];
+
+        if( mod->retry_wait )
+        {
+            mod->retry_wait--;
+            oc->deferred++;
+            continue;
+        }
+
+        frame[m][0] = MODULE_BASE_ADDRESS + m - 1;
+        frame[m][1] = OUTPUT_CMD_WRITE;
+        frame[m][OUTPUT_FRAME_LEN - 1] = calc_i2c_crc( frame[m], OUTPUT_FRAME_LEN - 1 );
+
+        oc->frames++;
+        oc->bytes += OUTPUT_FRAME_LEN;
+
+        if( output_bus_write( frame[m], OUTPUT_FRAME_LEN ) == MQX_OK )
+        {
+            for( k=0; k<MAX_OUTPUTS; k++ )
+            {
+                p = &oc->point[k];
+                if( p->module == m )
+                {
+                    p->acked  = p->value;
+                    p->flags |= OUTPUT_ACKED;
+                }
+            }
+
+            mod->errors  = 0;
+            mod->backoff = 1;
+        }
+        else
+        {
+            oc->failures++;
+
+            if( ++mod->errors == I2C_FAIL_COUNT )
+                oc->link_failures++;
+
+            if( mod->backoff == 0 )
+                mod->backoff = 1;
+
+            mod->retry_wait = mod->backoff;
+
+            if( mod->backoff < OUTPUT_BACKOFF_MAX )
+                mod->backoff *= 2;
+        }
+    }
+
+    start = TMON_CYCLE_COUNT() - start;
+    if( start > oc->pass_max )
+        oc->pass_max = start;
+}
+
+
+//
+//  output_commit_store() - Put the consecutive failures of each module into
+//                          the i2c_error_count of its outputs. Called with
+//                          mutexCore locked.
+//
+void
+output_commit_store( const OUTPUT_COMMIT * oc, DATABASE * db )
+{
+    int  k;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        if( oc->point[k].module )
+            db->output[k].i2c_error_count = (int16_t) oc->module[ oc->point[k].module ].errors;
+        else
+            db->output[k].i2c_error_count = 0;
+    }
+}
+
+
+//
+//  output_bus_write() - Send one frame to an expansion module. Stands in for
+//                       the expansion module driver, which is not part of
+//                       this build; a frame with a good CRC is taken as
+//                       acknowledged. A test build fails OutputBusFailPct
+//                       percent of them, picked at random.
+//
+_mqx_uint
+output_bus_write( uint8_t * frame, uint8_t len )
+{
+    if( calc_i2c_crc( frame, len - 1 ) != frame[ len - 1 ] )
+        return( MQX_INVALID_PARAMETER );
+
+#if OUTPUT_BUS_TEST
+    OutputBusSeed = OutputBusSeed * 1103515245 + 12345;
+
+    if( ((OutputBusSeed >> 16) % 100) < OutputBusFailPct )
+        return( MQX_IO_OPERATION_NOT_AVAILABLE );
+#endif
+
+    return( MQX_OK );
+}
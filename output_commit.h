@@ -0,0 +1,109 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : output_commit.h
+
+PURPOSE   : Definitions and function prototypes for the "output_commit.c"
+            module; the stage that takes the outputs decided by a control
+            pass to the expansion modules.
+
+            All of the points of one module are sent in one frame, with
+            one CRC, and only when one of them differs from what the
+            module last acknowledged:
+
+              address, OUTPUT_CMD_WRITE, point mask, value 1, value 2, CRC
+
+            A module that does not acknowledge is tried again after 1, 2,
+            4 ... up to OUTPUT_BACKOFF_MAX control passes.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __output_commit_inc
+#define  __output_commit_inc
+
+#include <mqx.h>
+#include "defines.h"
+#include "relay_control.h"
+#include "analog_control.h"
+
+#define  OUTPUT_CMD_WRITE      0x57    // Set the points of a module
+#define  OUTPUT_POINTS         2       // Points per module, see point_addr
+#define  OUTPUT_FRAME_LEN      (3 + OUTPUT_POINTS + 1)
+#define  OUTPUT_SINGLE_LEN     5       // address, command, point, value, CRC;
+                                       //   one output per message, counted
+                                       //   for comparison only
+#define  OUTPUT_BACKOFF_MAX    32      // Control passes
+
+#define  OUTPUT_BUS_TEST       0       // 1 = test build, frames can be failed
+                                       //   on purpose, "control busfail"
+
+// Flags in OUTPUT_POINT
+//
+#define  OUTPUT_SEEN           0x01    // "value" holds a value
+#define  OUTPUT_ACKED          0x02    // "acked" holds a value
+
+// OUTPUT_POINT - One output on an expansion module. "module" is 0 for an
+//   output on this module or with no module, which are not sent.
+//
+typedef struct
+{
+    uint8_t   module;            // module_addr, 1..MAX_MODULES
+    uint8_t   point;             // point_addr
+    uint8_t   type;              // OUTPUT_TYPE_xxx
+    uint8_t   flags;             // OUTPUT_xxx
+    uint8_t   value;             // Decided by the last control pass
+    uint8_t   acked;             // Last acknowledged by the module
+
+}  OUTPUT_POINT;
+
+// OUTPUT_MODULE - Retry state of one expansion module.
+//
+typedef struct
+{
+    uint8_t   retry_wait;        // Passes left before the next try
+    uint8_t   backoff;           // Passes to wait after the next failure
+    uint16_t  errors;            // Consecutive failures
+
+}  OUTPUT_MODULE;
+
+// OUTPUT_COMMIT - The stage, and counts since reset shown by the
+//   "control" shell command. The "single" counts are what one message per
+//   changed output would have cost.
+//
+typedef struct
+{
+    uint32_t       passes;
+    uint32_t       frames;           // Frames sent
+    uint32_t       bytes;
+    uint32_t       single_msgs;
+    uint32_t       single_bytes;
+    uint32_t       skipped;          // Module passes with nothing to send
+    uint32_t       deferred;         // Module passes waiting to retry
+    uint32_t       failures;         // Frames not acknowledged
+    uint32_t       link_failures;    // Modules reaching I2C_FAIL_COUNT
+    uint32_t       pass_max;         // Longest pass, cycles
+
+    OUTPUT_POINT   point[ MAX_OUTPUTS ];
+    OUTPUT_MODULE  module[ MAX_MODULES + 1 ];
+
+}  OUTPUT_COMMIT;
+
+extern OUTPUT_COMMIT   OutputCommit;
+
+#if OUTPUT_BUS_TEST
+extern uint8_t         OutputBusFailPct;
+#endif
+
+//
+//    Function Prototypes
+//
+void      output_commit_setup( OUTPUT_COMMIT * oc, const DATABASE * db );
+void      output_commit_run( OUTPUT_COMMIT * oc, const RELAY_ENGINE * relays,
+                             const ANALOG_ENGINE * analogs );
+void      output_commit_store( const OUTPUT_COMMIT * oc, DATABASE * db );
+
+#endif
@@ -21,6 +21,7 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 #include "global.h"
 #include "pit_defines.h"
 #include "periodic_events.h"
+#include "task_monitor.h"
 
 #define NUM_PIT_EVENTS   5
 
@@ -107,6 +108,7 @@ init_task_schedule_timer( void )
 void  pit_0_isr( uintptr_t /* pointer */ isr )
 {
     PIT_MemMapPtr  pit;
+    TMON_ISR_ENTER( TMON_ISR_PIT0 );
 
     // Get a pointer to the PIT registers
     pit = (PIT_MemMapPtr) PIT_BASE_PTR;
@@ -125,12 +127,14 @@ void  pit_0_isr( uintptr_t /* pointer */ isr )
     {
         case EVENT_START_SAMPLE:
             _lwevent_set( &eventSensorTask, (_mqx_uint) ADC_START_SAMPLE_CYCLE_MASK );
+            TRACE_EVENT_SET( TRACE_EVENT_SENSOR, ADC_START_SAMPLE_CYCLE_MASK );
             ActiveEvent = EVENT_UI_1;
             pit->CHANNEL[0].LDVAL = PitEventTime[ ActiveEvent ];
         break;
 
         case EVENT_UI_1:
             _lwevent_set( &eventUiTask, (_mqx_uint) UI_LCD_UPDATE_EVENT );
+            TRACE_EVENT_SET( TRACE_EVENT_UI, UI_LCD_UPDATE_EVENT );
             ActiveEvent = EVENT_COMM;
             pit->CHANNEL[0].LDVAL = PitEventTime[ ActiveEvent ];
         break;
@@ -145,6 +149,7 @@ void  pit_0_isr( uintptr_t /* pointer */ isr )
 
         case EVENT_UI_2:
             _lwevent_set( &eventUiTask, (_mqx_uint) UI_LCD_UPDATE_EVENT );
+            TRACE_EVENT_SET( TRACE_EVENT_UI, UI_LCD_UPDATE_EVENT );
             ActiveEvent = EVENT_CONTROL;
             pit->CHANNEL[0].LDVAL = PitEventTime[ ActiveEvent ];
         break;
@@ -155,6 +160,7 @@ void  pit_0_isr( uintptr_t /* pointer */ isr )
                             //   measure time durations in seconds.
 
             _lwevent_set( &eventControlTask, (_mqx_uint) CTRL_ALGORITHM_EVENT );
+            TRACE_EVENT_SET( TRACE_EVENT_CONTROL, CTRL_ALGORITHM_EVENT );
             ActiveEvent = EVENT_START_SAMPLE;
             pit->CHANNEL[0].LDVAL = PitEventTime[ ActiveEvent ];
         break;
@@ -164,6 +170,8 @@ void  pit_0_isr( uintptr_t /* pointer */ isr )
             pit->CHANNEL[0].LDVAL = PitEventTime[ ActiveEvent ];
         break;
     }
+
+    TMON_ISR_EXIT( TMON_ISR_PIT0 );
 }
 
 
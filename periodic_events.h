@@ -29,6 +29,8 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 
 #define  CTRL_ALGORITHM_EVENT            0x0001
 #define  CTRL_CORE_UPDATE_EVENT          0x0002
+#define  CTRL_SENSOR_CYCLE_EVENT         0x0004   // Set by Sensor_Task when a
+                                                  //   sample cycle is published
 
 #define  MODBUS_MSG_COMPLETE_EVENT       0x0001
 #define  MODBUS_SETUP_CHANGE_EVENT       0x0002
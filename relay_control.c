@@ -0,0 +1,434 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : relay_control.c
+
+PURPOSE   : Relay control engine. relay_control_setup() copies what the
+            engine needs from the setup of each output into RelayEngine,
+            and works out once how the sensor value is to be compared.
+            relay_control_run() then evaluates every output in one pass
+            over that table, using the integer sensor values. The value
+            of each output is the one the sensor failover stage picked
+            for it, see sensor_failover.h.
+
+            For each output the sensor value is turned into a demand;
+            On, Off, or Hold when it is between the cut-on and cut-off.
+            RelayNext[][] gives the next state for the current state and
+            the demand. A delay state is left for On or Off once both its
+            delay and the minimum Off or On time have expired.
+
+            When the sensor has failed the demand comes from the sensor
+            fail mode and the On\Off delays are skipped. The minimum
+            On\Off times still apply, they protect the equipment.
+
+            An output whose On delay and minimum Off time are over does
+            not start in the pass itself. It is put in the start queue,
+            and relay_start_queued() then starts as many outputs from the
+            front of the queue as the stagger allows. The queue is built
+            again every pass from the outputs still ready, ordered by the
+            time each became ready, so an output whose demand goes away
+            simply drops out of it.
+
+            The engine uses nothing but the table, the sensor values and
+            the time it is given, so a pass is the same every time it is
+            run with the same inputs. The Control_Task stores the results
+            back into coreDB with relay_control_store().
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "task_monitor.h"
+#include "relay_control.h"
+
+// TRUE once "now" has reached the deadline. Correct across the SecCounter
+//   roll over, for deadlines less than 68 years away.
+//
+#define  RELAY_DUE( now, deadline )   ((int32_t)((now) - (deadline)) >= 0)
+
+RELAY_ENGINE       RelayEngine;
+
+
+// Function Prototypes - used by this module only
+//
+void      relay_queue( RELAY_ENGINE * engine, uint8_t k );
+uint16_t  relay_start_queued( RELAY_ENGINE * engine, uint32_t now );
+
+const char *       RelayStateName[ NUM_RELAY_STATES ] =
+{
+    "off",                // RELAY_OFF
+    "off_delay",          // RELAY_OFF_DELAY
+    "on_delay",           // RELAY_ON_DELAY
+    "on"                  // RELAY_ON
+};
+
+// The next state, indexed by the current state and the demand. A delay
+//   that is under way is cancelled when the demand no longer calls for
+//   it; the condition must hold for the whole of the delay.
+//
+const uint8_t      RelayNext[ NUM_RELAY_STATES ][ NUM_DEMANDS ] =
+{
+    //  DEMAND_HOLD       DEMAND_ON         DEMAND_OFF
+    {   RELAY_OFF,        RELAY_ON_DELAY,   RELAY_OFF        },   // RELAY_OFF
+    {   RELAY_ON,         RELAY_ON,         RELAY_OFF_DELAY  },   // RELAY_OFF_DELAY
+    {   RELAY_OFF,        RELAY_ON_DELAY,   RELAY_OFF        },   // RELAY_ON_DELAY
+    {   RELAY_ON,         RELAY_ON,         RELAY_OFF_DELAY  }    // RELAY_ON
+};
+
+
+//
+//  relay_control_setup() - Rebuild the table from the output and sensor
+//                          setup in "db". The state and deadlines of each
+//                          output are kept. Called with mutexCore locked.
+//
+void
+relay_control_setup( RELAY_ENGINE * engine, const DATABASE * db )
+{
+    int                  k;
+    uint8_t              id;
+    RELAY_ENTRY        * e;
+    const RELAY_SETUP  * relay;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        e     = &engine->relay[k];
+        relay = &db->output[k].setup.output.relay;
+        id    = relay->sensor_id;
+
+        e->cut_on       = relay->cut_on;
+        e->cut_off      = relay->cut_off;
+        e->on_delay     = relay->on_delay;
+        e->off_delay    = relay->off_delay;
+        e->min_on_time  = relay->min_on_time;
+        e->min_off_time = relay->min_off_time;
+        e->sensor_id    = id;
+        e->fail_demand  = (relay->sensor_fail_mode == SENSOR_FAIL_ON) ? DEMAND_ON : DEMAND_OFF;
+
+        if(    (db->output[k].setup.output_type != OUTPUT_TYPE_RELAY)
+            || (id == SENSOR_ID_NONE) || (id > MAX_SENSOR_ID)
+            || (db->sensor[id].setup.sensor_type == SENSOR_TYPE_NONE) )
+            e->mode = RELAY_MODE_NONE;
+        else if( db->sensor[id].setup.sensor_type == SENSOR_TYPE_BINARY )
+            e->mode = RELAY_MODE_BINARY;
+        else if( relay->cut_on >= relay->cut_off )
+            e->mode = RELAY_MODE_DIRECT;
+        else
+            e->mode = RELAY_MODE_REVERSE;
+    }
+
+    if( engine->setups == 0 )
+        relay_control_starts( engine, RELAY_MAX_STARTS, RELAY_STAGGER );
+
+    engine->config_version = db->config_version;
+    engine->setups++;
+}
+
+
+//
+//  relay_control_starts() - Set how many outputs may start in each stagger
+//                           time. "max_starts" 0 starts every output as
+//                           soon as it is ready.
+//
+void
+relay_control_starts( RELAY_ENGINE * engine, uint8_t max_starts, uint8_t stagger )
+{
+    engine->max_starts       = max_starts;
+    engine->stagger          = stagger;
+    engine->starts_left      = max_starts;
+    engine->stagger_deadline = 0;
+}
+
+
+//
+//  relay_control_restore() - Take the state of each output, and the time
+//                            left on its timers, from the OUTPUT fields
+//                            in "db", as restored after a warm reset.
+//
+void
+relay_control_restore( RELAY_ENGINE * engine, const DATABASE * db, uint32_t now )
+{
+    int             k;
+    uint8_t         state;
+    RELAY_ENTRY   * e;
+    const OUTPUT  * out;
+
+    engine->on_mask = 0;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        e   = &engine->relay[k];
+        out = &db->output[k];
+
+        state = (out->desired_state ? 2 : 0) | (out->output_state ? 1 : 0);
+
+        if( e->mode == RELAY_MODE_NONE )
+            state = RELAY_OFF;
+
+        e->state = state;
+
+        if( state == RELAY_ON_DELAY )
+            e->delay_deadline = now + out->on_delay_timer;
+        else
+            e->delay_deadline = now + out->off_delay_timer;
+
+        if( RELAY_OUTPUT( state ) )
+        {
+            e->min_deadline = now + out->min_on_timer;
+            engine->on_mask |= 1 << k;
+        }
+        else
+            e->min_deadline = now + out->min_off_timer;
+    }
+}
+
+
+//
+//  relay_control_run() - One pass over all of the outputs, from the value
+//                        "input" of each. Returns a mask with a bit set
+//                        for each output that is On.
+//
+uint16_t
+relay_control_run( RELAY_ENGINE * engine, const SENSOR_STATUS * input, uint32_t now )
+{
+    int                    k;
+    uint8_t                demand;
+    uint8_t                state;
+    bool                   fail;
+    bool                   ready;
+    uint16_t               on_mask;
+    uint32_t               start;
+    RELAY_ENTRY          * e;
+    const SENSOR_STATUS  * sensor;
+
+    start   = TMON_CYCLE_COUNT();
+    on_mask = 0;
+    engine->queued = 0;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        e = &engine->relay[k];
+
+        if( e->mode == RELAY_MODE_NONE )
+        {
+            e->state   = RELAY_OFF;
+            e->waiting = FALSE;
+            continue;
+        }
+
+        sensor = &input[k];
+        fail   = FALSE;
+        ready  = FALSE;
+
+        if( e->mode == RELAY_MODE_BINARY )
+        {
+            demand = (sensor->value_int == BIN_SENSOR_CLOSED) ? DEMAND_ON : DEMAND_OFF;
+        }
+        else if( sensor->fail )
+        {
+            demand = e->fail_demand;
+            fail   = TRUE;
+            engine->fail_demands++;
+        }
+        else if( e->mode == RELAY_MODE_DIRECT )
+        {
+            if( sensor->value_int >= e->cut_on )
+                demand = DEMAND_ON;
+            else if( sensor->value_int <= e->cut_off )
+                demand = DEMAND_OFF;
+            else
+                demand = DEMAND_HOLD;
+        }
+        else
+        {
+            if( sensor->value_int <= e->cut_on )
+                demand = DEMAND_ON;
+            else if( sensor->value_int >= e->cut_off )
+                demand = DEMAND_OFF;
+            else
+                demand = DEMAND_HOLD;
+        }
+
+        state = RelayNext[ e->state ][ demand ];
+
+        // Start the delay when a delay state is entered.
+        //
+        if( state != e->state )
+        {
+            if( state == RELAY_ON_DELAY )
+                e->delay_deadline = now + e->on_delay;
+            else if( state == RELAY_OFF_DELAY )
+                e->delay_deadline = now + e->off_delay;
+        }
+
+        if(    ((state == RELAY_ON_DELAY) || (state == RELAY_OFF_DELAY))
+            && (fail || RELAY_DUE( now, e->delay_deadline ))
+            && RELAY_DUE( now, e->min_deadline ) )
+        {
+            if( state == RELAY_ON_DELAY )
+            {
+                if( !e->waiting )
+                    e->ready_since = now;
+
+                relay_queue( engine, k );
+                ready = TRUE;
+            }
+            else
+            {
+                state = RELAY_OFF;
+                e->min_deadline = now + e->min_off_time;
+                engine->switches++;
+            }
+        }
+
+        e->waiting = ready;
+        e->state   = state;
+
+        if( RELAY_OUTPUT( state ) )
+            on_mask |= 1 << k;
+    }
+
+    on_mask |= relay_start_queued( engine, now );
+
+    engine->on_mask = on_mask;
+    engine->passes++;
+
+    start = TMON_CYCLE_COUNT() - start;
+    if( start > engine->pass_max )
+        engine->pass_max = start;
+
+    return( on_mask );
+}
+
+
+//
+//  relay_control_store() - Put the state of each relay output, and the
+//                          time left on its timers, into the OUTPUT
+//                          fields of "db" for the display, the web pages
+//                          and the warm restart snapshot. Called with
+//                          mutexCore locked.
+//
+void
+relay_control_store( const RELAY_ENGINE * engine, DATABASE * db, uint32_t now )
+{
+    int                  k;
+    int32_t              left;
+    uint8_t              state;
+    OUTPUT             * out;
+    const RELAY_ENTRY  * e;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        e     = &engine->relay[k];
+        out   = &db->output[k];
+        state = e->state;
+
+        if( out->setup.output_type != OUTPUT_TYPE_RELAY )
+            continue;
+
+        out->desired_state = RELAY_DESIRED( state );
+        out->output_state  = RELAY_OUTPUT( state );
+
+        out->on_delay_timer_running  = (state == RELAY_ON_DELAY);
+        out->off_delay_timer_running = (state == RELAY_OFF_DELAY);
+
+        left = (int32_t)(e->delay_deadline - now);
+        if( left < 0 )
+            left = 0;
+
+        out->on_delay_timer  = (state == RELAY_ON_DELAY)  ? left : 0;
+        out->off_delay_timer = (state == RELAY_OFF_DELAY) ? left : 0;
+
+        left = (int32_t)(e->min_deadline - now);
+        if( left < 0 )
+            left = 0;
+
+        out->min_on_timer  = RELAY_OUTPUT( state ) ? left : 0;
+        out->min_off_timer = RELAY_OUTPUT( state ) ? 0 : left;
+    }
+}
+
+
+//
+//  relay_queue() - Put output "k" in the start queue, behind the outputs
+//                  that became ready before it or at the same time.
+//
+void
+relay_queue( RELAY_ENGINE * engine, uint8_t k )
+{
+    uint32_t  since = engine->relay[k].ready_since;
+    int       n     = engine->queued;
+
+    while( (n > 0) && ((int32_t)(since - engine->relay[ engine->queue[n-1] ].ready_since) < 0) )
+    {
+        engine->queue[n] = engine->queue[n-1];
+        n--;
+    }
+
+    engine->queue[n] = k;
+    engine->queued++;
+}
+
+
+//
+//  relay_start_queued() - Start outputs from the front of the start queue,
+//                         as many as are left in this stagger time. Once
+//                         "max_starts" have started, the next start waits
+//                         "stagger" seconds. Returns a mask of the outputs
+//                         started; the rest stay queued.
+//
+uint16_t
+relay_start_queued( RELAY_ENGINE * engine, uint32_t now )
+{
+    int            n;
+    uint8_t        k;
+    uint32_t       waited;
+    uint16_t       mask = 0;
+    RELAY_ENTRY  * e;
+
+    if( (engine->starts_left == 0) && RELAY_DUE( now, engine->stagger_deadline ) )
+        engine->starts_left = engine->max_starts;
+
+    for( n=0; n<engine->queued; n++ )
+    {
+        if( engine->max_starts && (engine->starts_left == 0) )
+            break;
+
+        k = engine->queue[n];
+        e = &engine->relay[k];
+
+        e->state        = RELAY_ON;
+        e->min_deadline = now + e->min_on_time;
+        e->waiting      = FALSE;
+        mask           |= 1 << k;
+
+        waited = now - e->ready_since;
+        if( waited )
+        {
+            engine->deferred++;
+            engine->deferral_total += waited;
+            if( waited > engine->deferral_max )
+                engine->deferral_max = waited;
+        }
+
+        engine->switches++;
+        engine->starts++;
+
+        if( engine->max_starts && (--engine->starts_left == 0) )
+            engine->stagger_deadline = now + engine->stagger;
+    }
+
+    if( n > engine->peak_starts )
+        engine->peak_starts = n;
+
+    memmove( engine->queue, &engine->queue[n], engine->queued - n );
+    engine->queued -= n;
+
+    return( mask );
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : relay_control.h
+
+PURPOSE   : Definitions and function prototypes for the "relay_control.c"
+            module; the engine that turns the relay outputs On and Off
+            from their RELAY_SETUP and the sensor values.
+
+            The setup of every relay output is kept in one small table,
+            rebuilt only when coreDB.config_version changes, and all of
+            the outputs are evaluated in a single pass per control event.
+            Each output is in one of four states, and moves between them
+            by a table indexed by state and demand.
+
+            The delays and minimum On\Off times are kept as deadlines,
+            SecCounter values, rather than as counters decremented once
+            a second.
+
+            Outputs are not all started at once. An output that is ready
+            to turn On waits in a queue, oldest first, and no more than
+            "max_starts" are started in each "stagger" seconds, so that
+            equipment does not all start together after a power failure
+            or a change of setup. Outputs are always turned Off at once.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __relay_control_inc
+#define  __relay_control_inc
+
+#include <mqx.h>
+#include "defines.h"
+#include "live_status.h"
+
+// Relay states. Bit 0 is the state of the output, bit 1 is the state the
+//   conditions call for, so an output in a delay is driven as it was.
+//
+enum{  RELAY_OFF       = 0,    // Off
+       RELAY_OFF_DELAY = 1,    // On, timing the Off delay
+       RELAY_ON_DELAY  = 2,    // Off, timing the On delay
+       RELAY_ON        = 3,    // On
+       NUM_RELAY_STATES  };
+
+#define  RELAY_OUTPUT( s )     ((s) & 1)
+#define  RELAY_DESIRED( s )    ((s) >> 1)
+
+#define  RELAY_MAX_STARTS      1       // Default starts per stagger time,
+                                       //   0 = no limit
+#define  RELAY_STAGGER         3       // Default stagger time, seconds
+
+// What the sensor value calls for.
+//
+enum{  DEMAND_HOLD,            // Between the cut-on and cut-off
+       DEMAND_ON,
+       DEMAND_OFF,
+       NUM_DEMANDS  };
+
+// How the sensor value is compared with the setup.
+//
+enum{  RELAY_MODE_NONE,        // Not a relay, or no sensor; held Off
+       RELAY_MODE_DIRECT,      // On at or above cut-on (cut-on > cut-off)
+       RELAY_MODE_REVERSE,     // On at or below cut-on (cut-on < cut-off)
+       RELAY_MODE_BINARY  };   // On when the binary input is closed
+
+// RELAY_ENTRY - One output. The setup fields are copied from coreDB by
+//   relay_control_setup(), the rest belong to the engine.
+//
+typedef struct
+{
+    int16_t   cut_on;
+    int16_t   cut_off;
+    int16_t   on_delay;          // Seconds
+    int16_t   off_delay;
+    int16_t   min_on_time;
+    int16_t   min_off_time;
+    uint8_t   sensor_id;
+    uint8_t   mode;              // RELAY_MODE_xxx
+    uint8_t   fail_demand;       // DEMAND_ON\OFF, when the sensor has failed
+    uint8_t   state;             // RELAY_xxx
+
+    uint32_t  delay_deadline;    // SecCounter when the On\Off delay ends
+    uint32_t  min_deadline;      // SecCounter when the minimum On\Off
+                                 //   time ends
+    uint32_t  ready_since;       // SecCounter when it was ready to start
+    bool      waiting;           // Ready to start, in the start queue
+
+}  RELAY_ENTRY;
+
+// RELAY_ENGINE - The table of all outputs, and counts since reset shown
+//   by the "control" shell command.
+//
+typedef struct
+{
+    uint32_t     config_version;     // coreDB setup last copied
+    uint16_t     on_mask;            // Bit per output that is On
+
+    uint32_t     passes;
+    uint32_t     switches;           // Outputs turned On or Off
+    uint32_t     fail_demands;       // Outputs run from the fail mode
+    uint32_t     pass_max;           // Longest pass, cycles
+    uint32_t     setups;             // Times the table was rebuilt
+
+    uint8_t      max_starts;         // Start scheduler setup, see above
+    uint8_t      stagger;
+    uint8_t      starts_left;        // Starts left in this stagger time
+    uint32_t     stagger_deadline;   // SecCounter when the next one begins
+
+    uint8_t      queued;             // Outputs waiting to start, oldest
+    uint8_t      queue[ MAX_OUTPUTS ];  //   first, then lowest output
+
+    uint32_t     starts;             // Outputs started
+    uint32_t     deferred;           // Starts that had to wait
+    uint32_t     deferral_total;     // Seconds waited, all starts
+    uint32_t     deferral_max;
+    uint8_t      peak_starts;        // Most started in one pass
+
+    RELAY_ENTRY  relay[ MAX_OUTPUTS ];
+
+}  RELAY_ENGINE;
+
+extern RELAY_ENGINE     RelayEngine;
+extern const char *     RelayStateName[ NUM_RELAY_STATES ];
+
+//
+//    Function Prototypes
+//
+void      relay_control_setup( RELAY_ENGINE * engine, const DATABASE * db );
+void      relay_control_restore( RELAY_ENGINE * engine, const DATABASE * db, uint32_t now );
+uint16_t  relay_control_run( RELAY_ENGINE * engine, const SENSOR_STATUS * input, uint32_t now );
+void      relay_control_starts( RELAY_ENGINE * engine, uint8_t max_starts, uint8_t stagger );
+void      relay_control_store( const RELAY_ENGINE * engine, DATABASE * db, uint32_t now );
+
+#endif
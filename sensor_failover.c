@@ -0,0 +1,397 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : sensor_failover.c
+
+PURPOSE   : Sensor failover stage, run by the Control_Task on each sample
+            cycle before the relay engine and the analog controller. It
+            works out the health of every sensor from its fail bit and
+            how noisy it is, picks the source of each output from its
+            list, and fills in SENSOR_STATUS "input" for each output, which
+            is what the engines are run from.
+
+            A switch happens in the same pass as the sample cycle that
+            caused it, and is recorded in the journal. The health steps
+            and the hold before going back to an earlier source keep an
+            output from switching to and fro on a sensor that comes and
+            goes.
+
+            Faults can be injected into a sensor from the shell; the
+            latency from the fault to the switch, the switches away from
+            a sensor with no fault, and the switches soon after the last
+            one are counted.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "task_monitor.h"
+#include "journal.h"
+#include "sensor_failover.h"
+
+SENSOR_FAILOVER    SensorFailover;
+
+
+// Function Prototypes - used by this module only
+//
+void      failover_health( SENSOR_FAILOVER * fo, SENSOR_STATUS * sensor, uint8_t id );
+uint8_t   failover_source( const SENSOR_FAILOVER * fo, const FAILOVER_ENTRY * f, uint8_t i,
+                           const SENSOR_STATUS * sensor, SENSOR_STATUS * value );
+void      failover_switch( SENSOR_FAILOVER * fo, FAILOVER_ENTRY * f, int k, uint8_t to,
+                           const SENSOR_STATUS * sensor, uint32_t now );
+
+
+//
+//  sensor_failover_setup() - Rebuild the source list of each output from
+//                            its setup in "db" and its backups. A backup
+//                            must be of the type of the setup sensor, and
+//                            an average is not taken of binary inputs.
+//                            Called with mutexCore locked.
+//
+void
+sensor_failover_setup( SENSOR_FAILOVER * fo, const DATABASE * db )
+{
+    int                    k, i;
+    uint8_t                id, b, type, n;
+    uint8_t                list[ FAILOVER_SOURCES ];
+    FAILOVER_ENTRY       * f;
+    const OUTPUT_SETUP   * setup;
+
+    if( fo->noise_limit == 0 )
+    {
+        fo->noise_limit = FAILOVER_NOISE_LIMIT;
+        memset( fo->health, FAILOVER_HEALTH_MAX, sizeof( fo->health ) );
+    }
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        f     = &fo->entry[k];
+        setup = &db->output[k].setup;
+
+        if( setup->output_type == OUTPUT_TYPE_RELAY )
+            id = setup->output.relay.sensor_id;
+        else if( setup->output_type == OUTPUT_TYPE_ANALOG )
+            id = setup->output.analog.sensor_id;
+        else
+            id = SENSOR_ID_NONE;
+
+        if( id > MAX_SENSOR_ID )
+            id = SENSOR_ID_NONE;
+
+        type = db->sensor[id].setup.sensor_type;
+        n    = 0;
+
+        if( (id != SENSOR_ID_NONE) && (type != SENSOR_TYPE_NONE) )
+        {
+            list[ n++ ] = id;
+
+            for( i=0; i<FAILOVER_SOURCES-1; i++ )
+            {
+                b = f->backup[i];
+
+                if( b == FAILOVER_AVERAGE )
+                {
+                    if( type != SENSOR_TYPE_BINARY )
+                        list[ n++ ] = b;
+                }
+                else if(    (b != SENSOR_ID_NONE) && (b <= MAX_SENSOR_ID) && (b != id)
+                         && (db->sensor[b].setup.sensor_type == type) )
+                {
+                    list[ n++ ] = b;
+                }
+            }
+        }
+        else
+        {
+            list[0] = id;
+        }
+
+        // Start again from the setup sensor when the list changed.
+        //
+        if( (n != f->sources) || (type != f->type) || memcmp( list, f->source, n ) )
+        {
+            f->active = 0;
+            f->ok     = 0;
+        }
+
+        memcpy( f->source, list, sizeof( list ) );
+        f->sources = n;
+        f->type    = type;
+    }
+
+    for( id=SENSOR_ID_NONE; id<=MAX_SENSOR_ID; id++ )
+        fo->sensor_type[id] = db->sensor[id].setup.sensor_type;
+
+    fo->rebuild = FALSE;
+}
+
+
+//
+//  sensor_failover_run() - One pass, on the sample cycle in "status".
+//
+void
+sensor_failover_run( SENSOR_FAILOVER * fo, const LIVE_STATUS * status, uint32_t now )
+{
+    SENSOR_STATUS     sensor[ MAX_SENSORS ];
+    SENSOR_STATUS     value[ FAILOVER_SOURCES ];
+    FAILOVER_ENTRY  * f;
+    uint32_t          start;
+    uint8_t           health, chosen, bit;
+    int               k, i;
+
+    start = TMON_CYCLE_COUNT();
+
+    memcpy( sensor, status->sensor, sizeof( sensor ) );
+
+    for( i=SENSOR_ID_ONE; i<=MAX_SENSOR_ID; i++ )
+        failover_health( fo, &sensor[i], i );
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        f = &fo->entry[k];
+
+        if( f->sources == 0 )
+        {
+            fo->input[k] = sensor[ f->source[0] ];
+            continue;
+        }
+
+        // The first healthy source; the one in use while it is above
+        //    HEALTH_LOW, an earlier one once it has held HEALTH_OK.
+        //
+        chosen = f->sources;
+
+        for( i=0; i<f->sources; i++ )
+        {
+            health = failover_source( fo, f, i, sensor, &value[i] );
+            bit    = 1 << i;
+
+            if( health < FAILOVER_HEALTH_OK )
+            {
+                f->ok &= ~bit;
+            }
+            else if( !(f->ok & bit) )
+            {
+                f->ok |= bit;
+                f->ok_since[i] = now;
+            }
+
+            if( chosen < f->sources )
+                continue;
+
+            if( (i < f->active) && (f->active < f->sources) )
+            {
+                if( (f->ok & bit) && ((now - f->ok_since[i]) >= FAILOVER_RETURN_HOLD) )
+                    chosen = i;
+            }
+            else if( health >= FAILOVER_HEALTH_LOW )
+            {
+                chosen = i;
+            }
+        }
+
+        if( chosen != f->active )
+            failover_switch( fo, f, k, chosen, sensor, now );
+
+        if( chosen < f->sources )
+        {
+            fo->input[k] = value[ chosen ];
+        }
+        else
+        {
+            fo->input[k]      = sensor[ f->source[0] ];
+            fo->input[k].fail = TRUE;
+            fo->no_source++;
+        }
+    }
+
+    fo->passes++;
+
+    start = TMON_CYCLE_COUNT() - start;
+    if( start > fo->pass_max )
+        fo->pass_max = start;
+}
+
+
+//
+//  sensor_failover_inject() - Inject "fault", FAILOVER_INJECT_xxx, into
+//                             sensor "id" from the next sample cycle on.
+//
+void
+sensor_failover_inject( SENSOR_FAILOVER * fo, uint8_t id, uint8_t fault )
+{
+    if( (id == SENSOR_ID_NONE) || (id > MAX_SENSOR_ID) || (fault >= NUM_FAILOVER_INJECTS) )
+        return;
+
+    fo->inject_pass[id] = fo->passes;
+    fo->inject[id]      = fault;
+}
+
+
+//
+//  sensor_failover_clear() - Start the counts again.
+//
+void
+sensor_failover_clear( SENSOR_FAILOVER * fo )
+{
+    int  k;
+
+    fo->failovers      = 0;
+    fo->returns        = 0;
+    fo->flaps          = 0;
+    fo->false_switches = 0;
+    fo->no_source      = 0;
+    fo->latency_last   = 0;
+    fo->latency_max    = 0;
+    fo->pass_max       = 0;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+        fo->entry[k].switches = 0;
+}
+
+
+//
+//  failover_health() - Apply any injected fault to "sensor", then update
+//                      the noise and health of sensor "id" from it.
+//
+void
+failover_health( SENSOR_FAILOVER * fo, SENSOR_STATUS * sensor, uint8_t id )
+{
+    int32_t  step;
+    int32_t  delta;
+
+    if( fo->inject[id] == FAILOVER_INJECT_FAIL )
+    {
+        sensor->fail = TRUE;
+    }
+    else if( fo->inject[id] == FAILOVER_INJECT_NOISE )
+    {
+        step = fo->noise_limit * 2 + 1;
+        sensor->value_int   += (fo->passes & 1) ? step : -step;
+        sensor->value_float += (fo->passes & 1) ? step : -step;
+    }
+
+    if( fo->passes == 0 )
+        fo->last[id] = sensor->value_int;
+
+    delta = sensor->value_int - fo->last[id];
+    if( delta < 0 )
+        delta = -delta;
+
+    if( delta > 0xFFF )
+        delta = 0xFFF;
+
+    fo->last[id]   = sensor->value_int;
+    fo->noise[id] += ((int32_t)(delta * 16) - (int32_t)fo->noise[id]) / 8;
+
+    if( sensor->fail )
+        fo->health[id] = 0;
+    else if( fo->noise[id] > fo->noise_limit * 16 )
+        fo->health[id] = (fo->health[id] > FAILOVER_HEALTH_STEP) ? fo->health[id] - FAILOVER_HEALTH_STEP : 0;
+    else if( fo->health[id] < FAILOVER_HEALTH_MAX - FAILOVER_HEALTH_STEP )
+        fo->health[id] += FAILOVER_HEALTH_STEP;
+    else
+        fo->health[id] = FAILOVER_HEALTH_MAX;
+}
+
+
+//
+//  failover_source() - The value of source "i" of output "f" in "value".
+//                      Returns its health; for an average, that of its
+//                      healthiest sensor.
+//
+uint8_t
+failover_source( const SENSOR_FAILOVER * fo, const FAILOVER_ENTRY * f, uint8_t i,
+                 const SENSOR_STATUS * sensor, SENSOR_STATUS * value )
+{
+    uint8_t   id = f->source[i];
+    uint8_t   health = 0;
+    int32_t   sum = 0;
+    float     sum_float = 0;
+    int       n = 0;
+
+    if( id != FAILOVER_AVERAGE )
+    {
+        *value = sensor[id];
+        return( fo->health[id] );
+    }
+
+    for( id=SENSOR_ID_ONE; id<=SENSOR_ID_THREE; id++ )
+    {
+        if(    (fo->sensor_type[id] != f->type) || sensor[id].fail
+            || (fo->health[id] < FAILOVER_HEALTH_LOW) )
+            continue;
+
+        sum       += sensor[id].value_int;
+        sum_float += sensor[id].value_float;
+        n++;
+
+        if( fo->health[id] > health )
+            health = fo->health[id];
+    }
+
+    memset( value, 0, sizeof( SENSOR_STATUS ) );
+
+    if( n == 0 )
+    {
+        value->fail = TRUE;
+        return( 0 );
+    }
+
+    value->value_int   = (int16_t)(sum / n);
+    value->value_float = sum_float / n;
+
+    return( health );
+}
+
+
+//
+//  failover_switch() - Move output "k" to source "to", "sources" for none,
+//                      and count the switch.
+//
+void
+failover_switch( SENSOR_FAILOVER * fo, FAILOVER_ENTRY * f, int k, uint8_t to,
+                 const SENSOR_STATUS * sensor, uint32_t now )
+{
+    uint8_t  from = (f->active < f->sources) ? f->source[ f->active ] : SENSOR_ID_NONE;
+
+    if( f->switches && ((now - f->switched) < FAILOVER_FLAP_TIME) )
+        fo->flaps++;
+
+    if( to > f->active )
+    {
+        fo->failovers++;
+
+        if( (from != SENSOR_ID_NONE) && (from != FAILOVER_AVERAGE) )
+        {
+            if( fo->inject[from] != FAILOVER_INJECT_NONE )
+            {
+                fo->latency_last = fo->passes - fo->inject_pass[from];
+                if( fo->latency_last > fo->latency_max )
+                    fo->latency_max = fo->latency_last;
+            }
+            else if( !sensor[from].fail )
+            {
+                fo->false_switches++;
+            }
+        }
+    }
+    else
+    {
+        fo->returns++;
+    }
+
+    f->active   = to;
+    f->switched = now;
+    f->switches++;
+
+    journal_record( JOURNAL_SENSOR_FAILOVER, k, (to < f->sources) ? f->source[to] : SENSOR_ID_NONE );
+}
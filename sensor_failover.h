@@ -0,0 +1,120 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : sensor_failover.h
+
+PURPOSE   : Definitions and function prototypes for the "sensor_failover.c"
+            module; the stage that picks the sensor each output is run
+            from, ahead of the relay engine and the analog controller.
+
+            Each output has a list of sources, in order: the sensor of its
+            setup, then up to two backups; another sensor of the same type,
+            or FAILOVER_AVERAGE, the average of the healthy sensors 1 to 3
+            of that type. The output is run from the first source that is
+            healthy, and from the fail mode of its setup when none is.
+
+            Each sensor has a health, 0 to FAILOVER_HEALTH_MAX. A failed
+            sensor drops to 0 at once; otherwise the health moves by
+            FAILOVER_HEALTH_STEP each sample cycle, down while the sensor
+            is noisy and up while it is not. An output leaves its source
+            below FAILOVER_HEALTH_LOW, in the pass of the sample cycle that
+            showed the failure, and only goes back to an earlier source
+            once that has been at FAILOVER_HEALTH_OK or more for
+            FAILOVER_RETURN_HOLD seconds.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __sensor_failover_inc
+#define  __sensor_failover_inc
+
+#include <mqx.h>
+#include "defines.h"
+#include "live_status.h"
+
+#define  FAILOVER_SOURCES        3       // Per output, the setup sensor first
+#define  FAILOVER_AVERAGE        0x80    // Source, see above
+
+#define  FAILOVER_HEALTH_MAX     100
+#define  FAILOVER_HEALTH_OK      90      // A source may be gone back to
+#define  FAILOVER_HEALTH_LOW     50      // A source is left below this
+#define  FAILOVER_HEALTH_STEP    10      // Per sample cycle
+
+#define  FAILOVER_NOISE_LIMIT    5       // Default, mean change of value_int
+                                         //   per sample cycle
+#define  FAILOVER_RETURN_HOLD    30      // Seconds
+#define  FAILOVER_FLAP_TIME      60      // Seconds, a switch this soon after
+                                         //   the last one is counted as a flap
+
+// Faults injected into a sensor by "failover inject", to try the failover
+//   without disconnecting a sensor.
+//
+enum{  FAILOVER_INJECT_NONE,
+       FAILOVER_INJECT_FAIL,             // Fail bit set
+       FAILOVER_INJECT_NOISE,            // Value stepped up and down
+       NUM_FAILOVER_INJECTS  };
+
+// FAILOVER_ENTRY - The sources of one output. "backup" is kept from the
+//   shell; "source" is rebuilt from it and the setup by
+//   sensor_failover_setup(), without the backups that do not fit.
+//
+typedef struct
+{
+    uint8_t   backup[ FAILOVER_SOURCES - 1 ];  // SENSOR_ID_xxx, FAILOVER_AVERAGE
+                                               //   or SENSOR_ID_NONE
+    uint8_t   sources;                   // 0 = not a relay or analog output
+    uint8_t   source[ FAILOVER_SOURCES ];
+    uint8_t   type;                      // SENSOR_TYPE_xxx of the setup sensor
+    uint8_t   active;                    // Index into "source", "sources"
+                                         //   when none is healthy
+    uint8_t   ok;                        // Bit per source at HEALTH_OK or more
+    uint32_t  ok_since[ FAILOVER_SOURCES ];  // SecCounter
+    uint32_t  switched;                  // SecCounter of the last switch
+    uint32_t  switches;
+
+}  FAILOVER_ENTRY;
+
+// SENSOR_FAILOVER - The stage, and counts since reset shown by the
+//   "failover" shell command. The latency is in sample cycles, from the
+//   fault being injected to the output leaving the sensor.
+//
+typedef struct
+{
+    bool            rebuild;             // Backups changed, see setup
+    uint8_t         noise_limit;
+    uint8_t         sensor_type[ MAX_SENSORS ];  // SENSOR_TYPE_xxx, from setup
+    uint8_t         health[ MAX_SENSORS ];
+    uint16_t        noise[ MAX_SENSORS ];    // Mean change per cycle, 1/16
+    int16_t         last[ MAX_SENSORS ];     // value_int of the last cycle
+    uint8_t         inject[ MAX_SENSORS ];   // FAILOVER_INJECT_xxx
+    uint32_t        inject_pass[ MAX_SENSORS ];
+
+    uint32_t        passes;
+    uint32_t        failovers;           // Switches to a later source
+    uint32_t        returns;             // Switches to an earlier source
+    uint32_t        flaps;
+    uint32_t        false_switches;      // Left a source with no fault
+    uint32_t        no_source;           // Output passes in the fail mode
+    uint32_t        latency_last;
+    uint32_t        latency_max;
+    uint32_t        pass_max;            // Longest pass, cycles
+
+    FAILOVER_ENTRY  entry[ MAX_OUTPUTS ];
+    SENSOR_STATUS   input[ MAX_OUTPUTS ];    // What each output is run from
+
+}  SENSOR_FAILOVER;
+
+extern SENSOR_FAILOVER   SensorFailover;
+
+//
+//    Function Prototypes
+//
+void      sensor_failover_setup( SENSOR_FAILOVER * fo, const DATABASE * db );
+void      sensor_failover_run( SENSOR_FAILOVER * fo, const LIVE_STATUS * status, uint32_t now );
+void      sensor_failover_inject( SENSOR_FAILOVER * fo, uint8_t id, uint8_t fault );
+void      sensor_failover_clear( SENSOR_FAILOVER * fo );
+
+#endif
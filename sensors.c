@@ -58,6 +58,27 @@ Date        Author     Rel      EC#    Prob#  Task# Reason for change
 #define  P_15_FAIL_LOW      1000    // Fail low point, ADC counts
 #define  P_15_FAIL_HIGH    28000    // Fail high point, ADC counts
 
+// SENSOR_SAVE - The fields of a sensor that are compared, before and
+//    after an update, to maintain the dirty bitmaps. value_float and
+//    signal change with the noise on every sample, so they are not
+//    compared; they are copied with value_int when it changes.
+//
+typedef struct
+{
+    SENSOR_SETUP  setup;
+    int16_t       value_int;
+    uint8_t       fail;
+
+}  SENSOR_SAVE;
+
+uint32_t  SensorStatusDirty = SENSOR_ALL_BITS;   // All are copied the first time
+uint32_t  SensorSetupDirty  = SENSOR_ALL_BITS;
+
+// Function Prototypes - used by this module only
+//
+void  sensor_save( const SENSOR * sensor, SENSOR_SAVE * save );
+void  sensor_mark_dirty( const SENSOR * sensor, const SENSOR_SAVE * save, int sensor_id );
+
 #define  P_30_FAIL_LOW      1000    // Fail low point, ADC counts
 #define  P_30_FAIL_HIGH    28000    // Fail high point, ADC counts
 
@@ -213,6 +234,9 @@ sensor_eng_units( SENSOR * sensor, CALIBRATION * cal, uint16_t raw_adc, int sens
     uint16_t                adc_low, adc_high;
     uint8_t                 res_input;
     float                   ftemp;
+    SENSOR_SAVE             save;
+
+    sensor_save( sensor, &save );
 
     res_input = resistive_input( sensor->setup.sensor_type );
 
@@ -476,6 +500,8 @@ sensor_eng_units( SENSOR * sensor, CALIBRATION * cal, uint16_t raw_adc, int sens
         //
         limit_sensor_range( sensor );
     }
+
+    sensor_mark_dirty( sensor, &save, sensor_id );
 }                        
 
 
@@ -567,6 +593,10 @@ calc_reference_voltage( uint16_t raw_adc )
 void  
 update_differential_sensor( SENSOR * sensor )
 {
+    SENSOR_SAVE  save;
+
+    sensor_save( &sensor[SENSOR_ID_DIFF], &save );
+
     // Determine the sensor type for sensor Sn-d
     if(    (sensor[SENSOR_ID_ONE].setup.sensor_type == sensor[SENSOR_ID_TWO].setup.sensor_type)
         && (sensor[SENSOR_ID_ONE].setup.sensor_type != SENSOR_TYPE_BINARY) )
@@ -601,6 +631,8 @@ update_differential_sensor( SENSOR * sensor )
      	sensor[SENSOR_ID_DIFF].value_int   = 0; 
         sensor[SENSOR_ID_DIFF].fail	   = FALSE;
     }
+
+    sensor_mark_dirty( &sensor[SENSOR_ID_DIFF], &save, SENSOR_ID_DIFF );
 }
 
 
@@ -630,6 +662,10 @@ update_differential_sensor( SENSOR * sensor )
 void update_high_signal_sensor( SENSOR * sensor )
 {
     int value, sensor_id, k;
+    SENSOR_SAVE  save_hi2, save_hi3;
+
+    sensor_save( &sensor[SENSOR_ID_HIGH_SIGNAL_2], &save_hi2 );
+    sensor_save( &sensor[SENSOR_ID_HIGH_SIGNAL_3], &save_hi3 );
 
     // Determine the sensor type for sensor HI-2
     if(    (sensor[SENSOR_ID_ONE].setup.sensor_type == sensor[SENSOR_ID_TWO].setup.sensor_type)
@@ -742,6 +778,43 @@ void update_high_signal_sensor( SENSOR * sensor )
      	sensor[ SENSOR_ID_HIGH_SIGNAL_3 ].value_int   = 0; 
         sensor[ SENSOR_ID_HIGH_SIGNAL_3 ].fail        = 0;
     }		
+
+    sensor_mark_dirty( &sensor[SENSOR_ID_HIGH_SIGNAL_2], &save_hi2, SENSOR_ID_HIGH_SIGNAL_2 );
+    sensor_mark_dirty( &sensor[SENSOR_ID_HIGH_SIGNAL_3], &save_hi3, SENSOR_ID_HIGH_SIGNAL_3 );
+}
+
+
+//
+//  sensor_save() - Save the fields of a sensor that are compared by
+//                  sensor_mark_dirty().
+//
+void
+sensor_save( const SENSOR * sensor, SENSOR_SAVE * save )
+{
+    save->setup       = sensor->setup;
+    save->value_int   = sensor->value_int;
+    save->fail        = sensor->fail;
+}
+
+
+//
+//  sensor_mark_dirty() - Set the sensor's bit in the dirty bitmaps if
+//                        its status or setup differs from "save".
+//
+void
+sensor_mark_dirty( const SENSOR * sensor, const SENSOR_SAVE * save, int sensor_id )
+{
+    if(    (sensor->value_int   != save->value_int)
+        || (sensor->fail        != save->fail) )
+    {
+        SensorStatusDirty |= SENSOR_BIT( sensor_id );
+    }
+
+    if(    (sensor->setup.sensor_type != save->setup.sensor_type)
+        || (sensor->setup.offset      != save->setup.offset) )
+    {
+        SensorSetupDirty |= SENSOR_BIT( sensor_id );
+    }
 }
 
 
@@ -56,6 +56,22 @@ typedef struct
 
 }  CONVERT_FACTORS;
 
+// Dirty bitmaps, one bit per sensor id. sensor_eng_units() and the
+//    virtual sensor updates set a sensor's bit when its status (value,
+//    fail, signal) or setup actually changed. The Sensor_Task clears a
+//    bit once it has copied that sensor, so only changed sensors are
+//    copied each sample cycle.
+//
+#define  SENSOR_BIT( id )       (1 << (id))
+#define  SENSOR_ALL_BITS        (SENSOR_BIT( MAX_SENSORS ) - 1)
+#define  SENSOR_VIRTUAL_BITS    (SENSOR_BIT( SENSOR_ID_DIFF ) | \
+                                 SENSOR_BIT( SENSOR_ID_HIGH_SIGNAL_2 ) | \
+                                 SENSOR_BIT( SENSOR_ID_HIGH_SIGNAL_3 ))
+#define  SENSOR_SUPPLY_BIT      SENSOR_BIT( MAX_SENSORS )   // Supplies, CPU temp
+
+extern uint32_t  SensorStatusDirty;
+extern uint32_t  SensorSetupDirty;
+
 //
 //    Function Prototypes
 //
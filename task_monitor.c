@@ -0,0 +1,485 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : task_monitor.c
+
+PURPOSE   : Run-time task monitor. Provides, without a debugger attached;
+
+              1. The stack high-water mark of each task, so that the
+                 stack sizes in MQX_template_list[] can be trimmed.
+
+              2. The share of CPU time used by each task over the last
+                 one second window.
+
+              3. The time spent in each of the application interrupt
+                 handlers, measured in core clock cycles.
+
+            MQX does not provide a context switch hook, so per-task CPU
+            time is measured statistically. PIT2 interrupts at
+            TMON_SAMPLE_RATE Hz and the ISR charges one sample to the
+            task that was running when the interrupt occurred. Once per
+            second the counts are latched for reporting. The cost is a
+            short table scan, roughly 100 cycles per sample, which is
+            well under 0.1% of the CPU.
+
+            The results are reported by the "top" shell command and by
+            the "task_data" CGI.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#if MQX_MONITOR_STACK
+    #include <klog.h>
+#endif
+
+#include "defines.h"
+#include "pit_defines.h"
+#include "task_monitor.h"
+
+// Number of PIT ticks between samples.
+//
+#define  PIT_TMON_SAMPLE_INTERVAL   (PIT_1_SEC / TMON_SAMPLE_RATE)
+
+extern const TASK_TEMPLATE_STRUCT MQX_template_list[];
+
+TASK_MONITOR   TaskMonitor[ MAX_MONITORED_TASKS ];
+int            NumMonitoredTasks;
+
+ISR_MONITOR    IsrMonitor[ MAX_TMON_ISR ];
+
+const char *   IsrMonitorName[ MAX_TMON_ISR ] =
+{
+    "PIT0",       // TMON_ISR_PIT0
+    "PIT1",       // TMON_ISR_PIT1
+    "ADC0",       // TMON_ISR_ADC0
+    "ADC1",       // TMON_ISR_ADC1
+    "PIT2"        // TMON_ISR_PIT2
+};
+
+uint32_t       OtherSamples;       // Samples not charged to a known task
+uint32_t       LastOtherSamples;
+uint32_t       WindowSamples;      // Samples taken in the current window
+_task_id       LastSampledTask;    // Task running at the previous sample
+
+
+// Function Prototypes - used by this module only
+//
+void    init_pit_2( void );
+void    pit_2_isr( uintptr_t /* pointer */ isr );
+
+
+//
+//  task_monitor_init() - Enable the cycle counter, register all of the
+//                        tasks that have been created from the
+//                        MQX_template_list[], and start the PIT2 sampler.
+//
+//  Tasks created after this must be added with task_monitor_add_task();
+//  see boot_create_task().
+//
+void
+task_monitor_init( void )
+{
+    const TASK_TEMPLATE_STRUCT * tmpl;
+    _task_id                     tid;
+
+    // Enable the DWT cycle counter. It is used to time ISRs.
+    //
+    TMON_DEMCR    |= TMON_DEMCR_TRCENA;
+    TMON_DWT_CYCCNT = 0;
+    TMON_DWT_CTRL |= TMON_DWT_CYCCNTENA;
+
+    memset( TaskMonitor, 0, sizeof( TaskMonitor ) );
+    memset( IsrMonitor,  0, sizeof( IsrMonitor ) );
+
+    NumMonitoredTasks = 0;
+    OtherSamples      = 0;
+    LastOtherSamples  = 0;
+    WindowSamples     = 0;
+
+    for( tmpl = MQX_template_list; tmpl->TASK_TEMPLATE_INDEX != 0; tmpl++ )
+    {
+        tid = _task_get_id_from_name( tmpl->TASK_NAME );
+
+        if( tid != MQX_NULL_TASK_ID )
+            task_monitor_add_task( tid );
+    }
+
+    // The idle task is created by MQX from its own template. Any
+    //    samples that are not charged to a registered task are
+    //    reported as "other".
+    //
+    tid = _task_get_id_from_name( "_mqx_idle_task" );
+
+    if( tid != MQX_NULL_TASK_ID )
+        task_monitor_add_task( tid );
+
+    _int_install_isr( INT_PIT2, (INT_ISR_FPTR) pit_2_isr, NULL );
+
+    // Priority 6, below the ADC (4) and the PIT0/PIT1 (5) interrupts, so
+    //    sampling never delays the sensor sample path.
+    //
+    _nvic_int_init( INT_PIT2, 6, TRUE );
+
+    init_pit_2();
+}
+
+
+//
+//  task_monitor_add_task() - Add a task to the table of monitored tasks.
+//                            The name, stack size and priority are taken
+//                            from the template the task was created from.
+//
+void
+task_monitor_add_task( _task_id tid )
+{
+    TASK_TEMPLATE_STRUCT_PTR  tmpl;
+    TASK_MONITOR *            mon;
+    int                       k;
+
+    for( k=0; k<NumMonitoredTasks; k++ )
+    {
+        if( TaskMonitor[k].task_id == tid )
+            return;                         // Already registered
+    }
+
+    if( NumMonitoredTasks >= MAX_MONITORED_TASKS )
+        return;
+
+    tmpl = _task_get_template_ptr( tid );
+
+    if( tmpl == NULL )
+        return;
+
+    mon = &TaskMonitor[ NumMonitoredTasks ];
+
+    mon->name         = tmpl->TASK_NAME;
+    mon->stack_size   = tmpl->TASK_STACKSIZE;
+    mon->priority     = tmpl->TASK_PRIORITY;
+    mon->samples      = 0;
+    mon->last_samples = 0;
+    mon->task_id      = tid;
+
+    // Publish the new entry only after it is complete, the PIT2 ISR
+    //    scans entries 0 .. NumMonitoredTasks-1.
+    //
+    NumMonitoredTasks++;
+}
+
+
+//
+//  task_monitor_get_stats() - Fill "stats" with a snapshot of up to
+//                             "max_stats" monitored tasks. Returns the
+//                             number of entries filled.
+//
+int
+task_monitor_get_stats( TASK_STATS * stats, int max_stats )
+{
+    int       k, num;
+#if MQX_MONITOR_STACK
+    _mem_size size, used;
+#endif
+
+    num = NumMonitoredTasks;
+
+    if( num > max_stats )
+        num = max_stats;
+
+    for( k=0; k<num; k++ )
+    {
+        stats[k].task_id    = TaskMonitor[k].task_id;
+        stats[k].name       = TaskMonitor[k].name;
+        stats[k].priority   = TaskMonitor[k].priority;
+        stats[k].stack_size = TaskMonitor[k].stack_size;
+        stats[k].stack_used = 0;
+        stats[k].cpu_tenths = (TaskMonitor[k].last_samples * 1000) / TMON_SAMPLE_RATE;
+
+#if MQX_MONITOR_STACK
+        // MQX fills the stack with a known pattern when the task is
+        //    created. The scan counts how much of that pattern has been
+        //    overwritten, which is the high-water mark.
+        //
+        if( _klog_get_task_stack_usage( stats[k].task_id, &size, &used ) == MQX_OK )
+        {
+            stats[k].stack_size = size;
+            stats[k].stack_used = used;
+        }
+#endif
+    }
+
+    return( num );
+}
+
+
+//
+//  task_monitor_isr_tenths() - Returns the CPU time used by an ISR over
+//                              the last window, in tenths of a percent.
+//
+uint32_t
+task_monitor_isr_tenths( int isr_idx )
+{
+    return( IsrMonitor[ isr_idx ].last_cycles / (BSP_CORE_CLOCK / 1000) );
+}
+
+
+//
+//  task_monitor_other_tenths() - Returns the CPU time not charged to a
+//                                monitored task, in tenths of a percent.
+//
+uint32_t
+task_monitor_other_tenths( void )
+{
+    return( (LastOtherSamples * 1000) / TMON_SAMPLE_RATE );
+}
+
+
+//
+//  task_monitor_int_stack() - Get the size and high-water mark of the
+//                             interrupt stack. Returns FALSE if stack
+//                             monitoring is not enabled in MQX.
+//
+bool
+task_monitor_int_stack( uint32_t * size, uint32_t * used )
+{
+#if MQX_MONITOR_STACK
+    _mem_size  s, u;
+
+    if( _klog_get_interrupt_stack_usage( &s, &u ) == MQX_OK )
+    {
+        *size = s;
+        *used = u;
+        return( TRUE );
+    }
+#endif
+
+    *size = 0;
+    *used = 0;
+    return( FALSE );
+}
+
+
+//
+//  task_monitor_task_name() - Returns the name of a monitored task given
+//                             the task number, the low 16 bits of the
+//                             task ID. Used by the event trace.
+//
+const char *
+task_monitor_task_name( uint16_t task_num )
+{
+    int  k;
+
+    for( k=0; k<NumMonitoredTasks; k++ )
+    {
+        if( (uint16_t) TaskMonitor[k].task_id == task_num )
+            return( TaskMonitor[k].name );
+    }
+
+    return( "other" );
+}
+
+
+//
+//  task_monitor_json_open() - Take the snapshot that is read out as JSON
+//                             by task_monitor_json_read().
+//
+void
+task_monitor_json_open( TMON_JSON_CURSOR * cur )
+{
+    cur->num  = task_monitor_get_stats( cur->stats, MAX_MONITORED_TASKS );
+    cur->item = 0;
+}
+
+
+//
+//  task_monitor_json_read() - Format as many whole items of the JSON
+//                             description as will fit into "str", of at
+//                             most "len" bytes including the terminator.
+//                             Returns the length of the string, 0 when
+//                             done. An item is never cut short; "len"
+//                             must be at least TMON_JSON_ITEM_MAX.
+//
+//  {"tasks":[{"name":"Sensor","id":65538,"pri":9,"cpu":1.2,
+//             "stack":1000,"used":640},...],
+//   "other":95.1,
+//   "isr":[{"name":"PIT0","cpu":0.0,"count":5,"max":310},...],
+//   "int_stack":{"size":1024,"used":300}}
+//
+int
+task_monitor_json_read( TMON_JSON_CURSOR * cur, char * str, int len )
+{
+    TASK_STATS * task;
+    uint32_t     tenths, size, used;
+    int          k, n, pos;
+
+    pos    = 0;
+    str[0] = 0;
+
+    while( cur->item <= cur->num + MAX_TMON_ISR + 2 )
+    {
+        k = cur->item;
+
+        if( k == 0 )
+        {
+            n = snprintf( &str[pos], len-pos, "{\"tasks\":[" );
+        }
+        else if( k <= cur->num )
+        {
+            task = &cur->stats[ k-1 ];
+            n = snprintf( &str[pos], len-pos,
+                          "%s{\"name\":\"%s\",\"id\":%lu,\"pri\":%lu,\"cpu\":%lu.%lu,\"stack\":%lu,\"used\":%lu}",
+                          (k > 1 ? "," : ""),
+                          task->name,
+                          (unsigned long) task->task_id,
+                          (unsigned long) task->priority,
+                          (unsigned long) task->cpu_tenths / 10,
+                          (unsigned long) task->cpu_tenths % 10,
+                          (unsigned long) task->stack_size,
+                          (unsigned long) task->stack_used );
+        }
+        else if( k == cur->num + 1 )
+        {
+            tenths = task_monitor_other_tenths();
+            n = snprintf( &str[pos], len-pos, "],\"other\":%lu.%lu,\"isr\":[",
+                          (unsigned long) tenths / 10, (unsigned long) tenths % 10 );
+        }
+        else if( k <= cur->num + 1 + MAX_TMON_ISR )
+        {
+            k     -= cur->num + 2;
+            tenths = task_monitor_isr_tenths( k );
+            n = snprintf( &str[pos], len-pos,
+                          "%s{\"name\":\"%s\",\"cpu\":%lu.%lu,\"count\":%lu,\"max\":%lu}",
+                          (k ? "," : ""),
+                          IsrMonitorName[k],
+                          (unsigned long) tenths / 10,
+                          (unsigned long) tenths % 10,
+                          (unsigned long) IsrMonitor[k].last_count,
+                          (unsigned long) IsrMonitor[k].max_cycles );
+        }
+        else
+        {
+            task_monitor_int_stack( &size, &used );
+            n = snprintf( &str[pos], len-pos, "],\"int_stack\":{\"size\":%lu,\"used\":%lu}}\n",
+                          (unsigned long) size, (unsigned long) used );
+        }
+
+        // An item that does not fit is taken out again, and formatted
+        //    first on the next call.
+        //
+        if( (n < 0) || (n >= len-pos) )
+        {
+            str[pos] = 0;
+            break;
+        }
+
+        pos += n;
+        cur->item++;
+    }
+
+    return( pos );
+}
+
+
+//
+//  pit_2_isr() - Interrupt service handler for Periodic Interval Timer 2.
+//                Charges one sample to the task that was interrupted.
+//                Once per window the counts are latched for reporting.
+//
+void  pit_2_isr( uintptr_t /* pointer */ isr )
+{
+    PIT_MemMapPtr  pit;
+    _task_id       tid;
+    int            k;
+    uint32_t       tmon_isr_start = TMON_CYCLE_COUNT();   // Not traced
+
+    // Get a pointer to the PIT registers
+    pit = (PIT_MemMapPtr) PIT_BASE_PTR;
+
+    pit->CHANNEL[2].TFLG = 0x01;  // Clear PIT2 Interrupt Flag
+                                  //   by writing a '1' to bit 0 (TIF)
+
+    // There is a glitch in the PIT in that in order for repeated,
+    // periodic interrupts to occur, either the LDVAL or CVAL
+    // register must be read.
+    //
+    pit->CHANNEL[2].LDVAL;
+
+    // While in an ISR, the "active" task is the one that was interrupted.
+    //
+    tid = _task_get_id();
+
+    // MQX has no context switch hook, so the event trace records a task
+    //    switch when the sampled task differs from the previous sample.
+    //
+    if( tid != LastSampledTask )
+    {
+        LastSampledTask = tid;
+        trace_record( TRACE_TASK_SWITCH, 0, (uint16_t) tid );
+    }
+
+    for( k=0; k<NumMonitoredTasks; k++ )
+    {
+        if( TaskMonitor[k].task_id == tid )
+        {
+            TaskMonitor[k].samples++;
+            break;
+        }
+    }
+
+    if( k == NumMonitoredTasks )
+        OtherSamples++;
+
+    if( ++WindowSamples >= TMON_SAMPLE_RATE )
+    {
+        WindowSamples = 0;
+
+        for( k=0; k<NumMonitoredTasks; k++ )
+        {
+            TaskMonitor[k].last_samples = TaskMonitor[k].samples;
+            TaskMonitor[k].samples      = 0;
+        }
+
+        LastOtherSamples = OtherSamples;
+        OtherSamples     = 0;
+
+        for( k=0; k<MAX_TMON_ISR; k++ )
+        {
+            IsrMonitor[k].last_cycles = IsrMonitor[k].cycles;
+            IsrMonitor[k].last_count  = IsrMonitor[k].count;
+            IsrMonitor[k].cycles      = 0;
+            IsrMonitor[k].count       = 0;
+        }
+    }
+
+    TMON_ISR_ACCOUNT( TMON_ISR_PIT2 );
+}
+
+
+//
+//  init_pit_2() - Start PIT channel 2, used by the task monitor to
+//                 sample the active task. The clock to the PIT is gated
+//                 on, and the module enabled, by init_pit_0().
+//
+void
+init_pit_2( void )
+{
+    PIT_MemMapPtr  pit;
+
+    SIM_SCGC6 |= SIM_SCGC6_PIT_MASK;    // Gate the clock to the PIT
+
+    // Get a pointer to the PIT registers
+    pit = (PIT_MemMapPtr) PIT_BASE_PTR;
+
+    pit->CHANNEL[2].LDVAL = PIT_TMON_SAMPLE_INTERVAL;
+
+    pit->CHANNEL[2].TFLG  = 0x01;  // Clear Timer Interrupt Flag
+
+    pit->CHANNEL[2].TCTRL = 0x03;  // bit 1, TIE, 1 = Interrupt Enabled
+                                   // bit 0, TEN, 1 = Timer Enabled
+}
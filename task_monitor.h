@@ -0,0 +1,161 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : task_monitor.h
+
+PURPOSE   : Definitions and function prototypes for the "task_monitor.c"
+            module. The task monitor reports, for each task in the
+            MQX_template_list[], the stack high-water mark and the share
+            of CPU time used over the last second. Time spent in the
+            application interrupt handlers is reported separately.
+
+            CPU time is accumulated by sampling the active task from
+            the PIT2 interrupt at TMON_SAMPLE_RATE Hz. ISR time is
+            measured with the Cortex-M4 cycle counter (DWT_CYCCNT) by
+            bracketing each handler with TMON_ISR_ENTER / TMON_ISR_EXIT.
+
+            Stack usage relies on MQX filling each task stack with a
+            known pattern when the task is created. That requires
+            MQX_MONITOR_STACK to be set in user_config.h.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __task_monitor_inc
+#define  __task_monitor_inc
+
+#include <mqx.h>
+#include "event_trace.h"
+
+#define  MAX_MONITORED_TASKS   16    // Max tasks tracked, incl. Idle
+
+// PIT2 sample rate. The rate is deliberately not a multiple of the
+//   kernel tick so that tasks which always wake on a tick boundary
+//   are not systematically missed (or always caught) by the sampler.
+//
+#define  TMON_SAMPLE_RATE     997    // Samples per second (Hz)
+
+// Interrupt handlers that are timed with the cycle counter. These values
+//   are used to index into IsrMonitor[].
+//
+typedef enum
+{
+    TMON_ISR_PIT0  = 0,   // pit_0_isr(), periodic event scheduler
+    TMON_ISR_PIT1  = 1,   // pit_1_isr(), ADC conversion pacing
+    TMON_ISR_ADC0  = 2,   // adc0_isr(), conversion complete
+    TMON_ISR_ADC1  = 3,   // adc1_isr(), conversion complete
+    TMON_ISR_PIT2  = 4    // pit_2_isr(), the task monitor sampler
+
+}  TMON_ISR_INDEX;
+
+#define  MAX_TMON_ISR   TMON_ISR_PIT2 + 1
+
+// Cortex-M4 Data Watchpoint and Trace unit. DWT_CYCCNT counts core
+//   clock cycles once TRCENA (DEMCR) and CYCCNTENA (DWT_CTRL) are set.
+//
+#define  TMON_DEMCR         (*(volatile uint32_t *) 0xE000EDFC)
+#define  TMON_DWT_CTRL      (*(volatile uint32_t *) 0xE0001000)
+#define  TMON_DWT_CYCCNT    (*(volatile uint32_t *) 0xE0001004)
+
+#define  TMON_DEMCR_TRCENA     0x01000000
+#define  TMON_DWT_CYCCNTENA    0x00000001
+
+#define  TMON_CYCLE_COUNT()    (TMON_DWT_CYCCNT)
+
+//
+//  TMON_ISR_ENTER / TMON_ISR_EXIT - Place ENTER after the local variable
+//    declarations of an ISR and EXIT as the last statement. The elapsed
+//    cycles include any higher priority interrupt that nested inside.
+//    When the event trace is compiled in, entry and exit are also
+//    recorded in the trace.
+//
+#if TRACE_ENABLE
+    #define  TMON_ISR_ENTER( idx )   uint32_t tmon_isr_start = trace_isr_enter( idx )
+    #define  TMON_ISR_EXIT( idx )                                          \
+             do {                                                          \
+                 TMON_ISR_ACCOUNT( idx );                                  \
+                 trace_record( TRACE_ISR_EXIT, (idx), 0 );                 \
+             } while( 0 )
+#else
+    #define  TMON_ISR_ENTER( idx )   uint32_t tmon_isr_start = TMON_CYCLE_COUNT()
+    #define  TMON_ISR_EXIT( idx )    TMON_ISR_ACCOUNT( idx )
+#endif
+
+#define  TMON_ISR_ACCOUNT( idx )                                           \
+         do {                                                              \
+             uint32_t tmon_cyc = TMON_CYCLE_COUNT() - tmon_isr_start;     \
+             IsrMonitor[ idx ].cycles += tmon_cyc;                         \
+             IsrMonitor[ idx ].count++;                                    \
+             if( tmon_cyc > IsrMonitor[ idx ].max_cycles )                 \
+                 IsrMonitor[ idx ].max_cycles = tmon_cyc;                  \
+         } while( 0 )
+
+// TASK_MONITOR - One entry per monitored task. "samples" is incremented
+//   by the PIT2 ISR, and copied to "last_samples" once per second.
+//
+typedef struct
+{
+    _task_id     task_id;        // MQX task ID, MQX_NULL_TASK_ID if unused
+    const char * name;           // Name from the task template
+    uint32_t     stack_size;     // Stack size from the task template
+    uint32_t     priority;       // Priority from the task template
+    uint32_t     samples;        // Samples in the current window
+    uint32_t     last_samples;   // Samples in the last complete window
+}  TASK_MONITOR;
+
+// ISR_MONITOR - Cycle counts for one interrupt handler. "cycles" and
+//   "count" accumulate over the current one second window.
+//
+typedef struct
+{
+    uint32_t     cycles;         // Cycles spent in the ISR, this window
+    uint32_t     count;          // Number of times the ISR ran
+    uint32_t     last_cycles;    // Cycles in the last complete window
+    uint32_t     last_count;     // Count in the last complete window
+    uint32_t     max_cycles;     // Longest single run since boot
+}  ISR_MONITOR;
+
+// TASK_STATS - A snapshot of one task as reported by the shell and CGI.
+//
+typedef struct
+{
+    _task_id     task_id;
+    const char * name;
+    uint32_t     priority;
+    uint32_t     cpu_tenths;     // CPU use in tenths of a percent
+    uint32_t     stack_size;     // Bytes
+    uint32_t     stack_used;     // Bytes, 0 if stack monitoring disabled
+}  TASK_STATS;
+
+#define  TMON_JSON_ITEM_MAX    160   // Longest item of the JSON, bytes
+
+// TMON_JSON_CURSOR - State used to read the JSON description out in
+//   pieces, see task_monitor_json_read().
+//
+typedef struct
+{
+    TASK_STATS   stats[ MAX_MONITORED_TASKS ];
+    int          num;            // Tasks in "stats"
+    int          item;           // Next item to format
+}  TMON_JSON_CURSOR;
+
+extern ISR_MONITOR   IsrMonitor[ MAX_TMON_ISR ];
+extern const char *  IsrMonitorName[ MAX_TMON_ISR ];
+
+//
+//    Function Prototypes
+//
+void      task_monitor_init( void );
+void      task_monitor_add_task( _task_id tid );
+int       task_monitor_get_stats( TASK_STATS * stats, int max_stats );
+uint32_t  task_monitor_isr_tenths( int isr_idx );
+uint32_t  task_monitor_other_tenths( void );
+bool      task_monitor_int_stack( uint32_t * size, uint32_t * used );
+const char * task_monitor_task_name( uint16_t task_num );
+void      task_monitor_json_open( TMON_JSON_CURSOR * cur );
+int       task_monitor_json_read( TMON_JSON_CURSOR * cur, char * str, int len );
+
+#endif
@@ -0,0 +1,401 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : warm_restart.c
+
+PURPOSE   : Warm restart. A snapshot of the run time state is written to
+            one of two slots in RAM that the start-up code does not
+            clear, each time the sensor status or the relay changes. At
+            reset the newest slot with a good magic, layout and CRC is
+            restored before any task runs, so control resumes with the
+            last sensor values, output timers and relay state instead of
+            waiting for the first sample cycle.
+
+            The RAM is not kept through a power on or low voltage reset.
+            For those, only the control state is restored, from the copy
+            in the config store. RControl_Task and the Control_Task ask
+            for the copy to be brought up to date, and the flash is
+            written later by a Flash_Task item, which runs below the
+            control tasks.
+
+            The source of the state and the cost of the snapshots are
+            shown by the "boot" shell command.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <stddef.h>
+#include <mqx.h>
+#include <bsp.h>
+
+#include "defines.h"
+#include "global.h"
+#include "func.h"
+#include "task_monitor.h"
+#include "live_status.h"
+#include "db_notify.h"
+#include "config_store.h"
+#include "core_lock.h"
+#include "work_queue.h"
+#include "warm_restart.h"
+
+__no_init WARM_SNAPSHOT  WarmSnapshot[ WARM_SLOTS ];
+
+WARM_RESTART_STATS  WarmRestartStats;
+
+const char *        WarmSourceName[] =
+{
+    "defaults",           // WARM_SOURCE_NONE
+    "RAM",                // WARM_SOURCE_RAM
+    "flash"               // WARM_SOURCE_FLASH
+};
+
+uint32_t            WarmSeq;            // Sequence of the last snapshot
+int                 WarmNext;           // Slot the next snapshot goes in
+WARM_CONTROL        WarmFlashControl;   // Control state last written to flash
+bool                WarmFlashValid;
+volatile bool       WarmControlPosted;  // warm_control_work() not yet run
+
+// Function Prototypes - used by this module only
+//
+void            warm_snapshot_work( void * ctx, uint32_t groups );
+void            warm_control_work( void * ctx, uint32_t arg );
+WARM_SNAPSHOT * warm_newest( void );
+void            warm_get_control( WARM_CONTROL * control );
+void            warm_set_control( const WARM_CONTROL * control );
+void            warm_set_state( const WARM_STATE * state );
+
+static DB_SUBSCRIBER  WarmSubscriber = {
+    "WarmRestart", DB_BIT( DB_GROUP_SENSOR_STATUS ) | DB_BIT( DB_GROUP_RELAY ),
+    NULL, 0, warm_snapshot_work, NULL, 0
+};
+
+
+//
+//  warm_restart_restore() - Called by init_globals() once coreDB and the
+//                           task views hold their defaults. Restores the
+//                           run time state from the newest good snapshot,
+//                           or the control state from flash.
+//
+void
+warm_restart_restore( void )
+{
+    WARM_SNAPSHOT * snap = NULL;
+    WARM_CONTROL    control;
+    TIME_STRUCT     time;
+
+    ResetStatusRegLow  = RCM_SRS0;
+    ResetStatusRegHigh = RCM_SRS1;
+
+    // After a power on or low voltage reset the RAM content is not valid,
+    //    even if it happens to look like it is.
+    //
+    WarmRestartStats.cold = (ResetStatusRegLow & (RCM_SRS0_POR_MASK | RCM_SRS0_LVD_MASK)) != 0;
+
+    if( WarmRestartStats.cold )
+    {
+        ResetCount = 0;
+        memset( WarmSnapshot, 0, sizeof( WarmSnapshot ) );
+    }
+    else
+    {
+        ResetCount++;
+        snap = warm_newest();
+    }
+
+    if( snap != NULL )
+    {
+        warm_set_state( &snap->state );
+
+        WarmRestartStats.source  = WARM_SOURCE_RAM;
+        WarmRestartStats.seq     = snap->seq;
+        WarmRestartStats.age_sec = snap->state.sec_counter;
+        WarmSeq                  = snap->seq;
+        WarmNext                 = (snap == &WarmSnapshot[0]) ? 1 : 0;
+    }
+    else if( cfg_store_read( CFG_KEY_CONTROL_STATE, &control, sizeof( control ) ) )
+    {
+        warm_set_control( &control );
+
+        WarmRestartStats.source = WARM_SOURCE_FLASH;
+        WarmFlashControl        = control;
+        WarmFlashValid          = TRUE;
+    }
+    else
+    {
+        WarmRestartStats.source = WARM_SOURCE_NONE;
+    }
+
+    _time_get_elapsed( &time );
+    WarmRestartStats.restore_ms = time.SECONDS * 1000 + time.MILLISECONDS;
+
+    db_subscribe( &WarmSubscriber );
+}
+
+
+//
+//  warm_restart_save() - Write a snapshot of the run time state to the
+//                        older slot. Called only from the Work_Task, so
+//                        there is a single writer. The control state and
+//                        the outputs are copied with mutexCore locked, so
+//                        that they are from one control pass.
+//
+void
+warm_restart_save( void )
+{
+    WARM_SNAPSHOT * snap;
+    WARM_STATE *    state;
+    uint32_t        start;
+    int             k;
+
+    if( core_lock( CORE_SITE_CONFIG_SAVE ) != MQX_OK )
+        return;
+
+    start = TMON_CYCLE_COUNT();
+
+    snap  = &WarmSnapshot[ WarmNext ];
+    state = &snap->state;
+
+    state->sec_counter = SecCounter;
+    warm_get_control( &state->control );
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        state->output[k].desired_state           = coreDB.output[k].desired_state;
+        state->output[k].output_state            = coreDB.output[k].output_state;
+        state->output[k].on_delay_timer_running  = coreDB.output[k].on_delay_timer_running;
+        state->output[k].off_delay_timer_running = coreDB.output[k].off_delay_timer_running;
+        state->output[k].i_term                  = coreDB.output[k].i_term;
+        state->output[k].on_delay_timer          = coreDB.output[k].on_delay_timer;
+        state->output[k].off_delay_timer         = coreDB.output[k].off_delay_timer;
+        state->output[k].min_on_timer            = coreDB.output[k].min_on_timer;
+        state->output[k].min_off_timer           = coreDB.output[k].min_off_timer;
+        state->output[k].update_timer            = coreDB.output[k].update_timer;
+    }
+
+    core_unlock( CORE_SITE_CONFIG_SAVE );
+
+    live_status_read( &state->status );
+
+    for( k=0; k<MAX_ANA_INPUTS; k++ )
+        state->raw[k] = Sample[k].raw;
+
+    // A reset before the CRC is written leaves this slot bad, and the
+    //    other slot is restored.
+    //
+    snap->magic  = WARM_MAGIC;
+    snap->layout = WARM_LAYOUT;
+    snap->size   = sizeof( WARM_STATE );
+    snap->seq    = ++WarmSeq;
+    snap->crc    = calc_crc16( 0xFFFF, (uint8_t *) snap, offsetof( WARM_SNAPSHOT, crc ) );
+
+    WarmNext ^= 1;
+
+    start = TMON_CYCLE_COUNT() - start;
+
+    WarmRestartStats.saves++;
+
+    if( start > WarmRestartStats.save_max )
+        WarmRestartStats.save_max = start;
+}
+
+
+//
+//  warm_restart_request_control() - Ask for the copy of the control state
+//                                   in the config store to be brought up
+//                                   to date. Called by the control tasks
+//                                   when an output may have switched; the
+//                                   flash is written by the Flash_Task, so
+//                                   they are not stalled by it. Returns
+//                                   FALSE if the request could not be
+//                                   queued.
+//
+bool
+warm_restart_request_control( void )
+{
+    if( WarmControlPosted )
+        return( TRUE );
+
+    WarmControlPosted = TRUE;
+
+    if( !work_queue_post( WORK_PRIO_FLASH, warm_control_work, NULL, 0 ) )
+    {
+        WarmControlPosted = FALSE;
+        return( FALSE );
+    }
+
+    return( TRUE );
+}
+
+
+//
+//  warm_control_work() - Flash_Task callback. Take a copy of the control
+//                        state with mutexCore locked, and write it to the
+//                        config store if it changed.
+//
+void
+warm_control_work( void * ctx, uint32_t arg )
+{
+    WARM_CONTROL  control;
+
+    // A change after this point posts another request.
+    //
+    WarmControlPosted = FALSE;
+
+    if( core_lock( CORE_SITE_CONFIG_SAVE ) != MQX_OK )
+    {
+        WarmRestartStats.flash_errors++;
+        return;
+    }
+
+    warm_get_control( &control );
+    core_unlock( CORE_SITE_CONFIG_SAVE );
+
+    if( WarmFlashValid && (memcmp( &control, &WarmFlashControl, sizeof( control ) ) == 0) )
+        return;
+
+    if( cfg_store_write( CFG_KEY_CONTROL_STATE, &control, sizeof( control ) ) )
+    {
+        WarmFlashControl = control;
+        WarmFlashValid   = TRUE;
+        WarmRestartStats.flash_saves++;
+    }
+    else
+    {
+        WarmRestartStats.flash_errors++;
+    }
+}
+
+
+//
+//  warm_snapshot_work() - Work_Task callback for the WarmRestart
+//                         subscriber.
+//
+void
+warm_snapshot_work( void * ctx, uint32_t groups )
+{
+    db_changes( &WarmSubscriber );
+    warm_restart_save();
+}
+
+
+//
+//  warm_newest() - Returns the newest good snapshot, or NULL.
+//
+WARM_SNAPSHOT *
+warm_newest( void )
+{
+    WARM_SNAPSHOT * snap;
+    WARM_SNAPSHOT * newest = NULL;
+    int             k;
+
+    for( k=0; k<WARM_SLOTS; k++ )
+    {
+        snap = &WarmSnapshot[k];
+
+        if(    (snap->magic  != WARM_MAGIC)
+            || (snap->layout != WARM_LAYOUT)
+            || (snap->size   != sizeof( WARM_STATE ))
+            || (snap->crc    != calc_crc16( 0xFFFF, (uint8_t *) snap, offsetof( WARM_SNAPSHOT, crc ) )) )
+        {
+            WarmRestartStats.rejected++;
+            continue;
+        }
+
+        if( (newest == NULL) || ((int32_t)(snap->seq - newest->seq) > 0) )
+            newest = snap;
+    }
+
+    return( newest );
+}
+
+
+//
+//  warm_get_control() - Copy the control state out of coreDB.
+//
+void
+warm_get_control( WARM_CONTROL * control )
+{
+    int  k;
+
+    control->relay_state = gRelayState;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        control->desired_state[k] = coreDB.output[k].desired_state;
+        control->output_state[k]  = coreDB.output[k].output_state;
+    }
+}
+
+
+//
+//  warm_set_control() - Put the control state back into coreDB.
+//
+void
+warm_set_control( const WARM_CONTROL * control )
+{
+    int  k;
+
+    gRelayState = control->relay_state ? 1 : 0;
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        coreDB.output[k].desired_state = control->desired_state[k];
+        coreDB.output[k].output_state  = control->output_state[k];
+    }
+}
+
+
+//
+//  warm_set_state() - Put a whole snapshot back. The sensor status goes
+//                     into coreDB, the Sensor_Task's view and the live
+//                     status, so every reader sees it before the first
+//                     sample cycle completes.
+//
+void
+warm_set_state( const WARM_STATE * state )
+{
+    int  k;
+
+    SecCounter = state->sec_counter;
+    warm_set_control( &state->control );
+
+    for( k=0; k<MAX_OUTPUTS; k++ )
+    {
+        coreDB.output[k].on_delay_timer_running  = state->output[k].on_delay_timer_running;
+        coreDB.output[k].off_delay_timer_running = state->output[k].off_delay_timer_running;
+        coreDB.output[k].i_term                  = state->output[k].i_term;
+        coreDB.output[k].on_delay_timer          = state->output[k].on_delay_timer;
+        coreDB.output[k].off_delay_timer         = state->output[k].off_delay_timer;
+        coreDB.output[k].min_on_timer            = state->output[k].min_on_timer;
+        coreDB.output[k].min_off_timer           = state->output[k].min_off_timer;
+        coreDB.output[k].update_timer            = state->output[k].update_timer;
+    }
+
+    for( k=0; k<MAX_SENSORS; k++ )
+    {
+        coreDB.sensor[k].value_int     = state->status.sensor[k].value_int;
+        coreDB.sensor[k].value_float   = state->status.sensor[k].value_float;
+        coreDB.sensor[k].fail          = state->status.sensor[k].fail;
+        coreDB.sensor[k].signal        = state->status.sensor[k].signal;
+
+        sensorDB.sensor[k].value_int   = coreDB.sensor[k].value_int;
+        sensorDB.sensor[k].value_float = coreDB.sensor[k].value_float;
+        sensorDB.sensor[k].fail        = coreDB.sensor[k].fail;
+        sensorDB.sensor[k].signal      = coreDB.sensor[k].signal;
+    }
+
+    sensorDB.cpu_temp      = state->status.cpu_temp;
+    sensorDB.five_volt_ext = state->status.five_volt_ext;
+    sensorDB.ten_volt_ref  = state->status.ten_volt_ref;
+
+    for( k=0; k<MAX_ANA_INPUTS; k++ )
+        Sample[k].raw = state->raw[k];
+
+    if( state->status.version != 0 )
+        live_status_publish( &state->status );
+}
@@ -0,0 +1,121 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : warm_restart.h
+
+PURPOSE   : Definitions and function prototypes for the "warm_restart.c"
+            module. The run time state is kept in RAM that is not cleared
+            at reset, so that after a watchdog or software reset the
+            sensor values, output timers and relay state are back at once
+            rather than after the first sample cycle.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __warm_restart_inc
+#define  __warm_restart_inc
+
+#include <mqx.h>
+#include "system450.h"
+#include "defines.h"
+#include "Sensor_Task.h"
+#include "live_status.h"
+
+#define  WARM_MAGIC            0x574D5253   // "WMRS"
+#define  WARM_LAYOUT           1            // Change when WARM_STATE changes
+#define  WARM_SLOTS            2            // Written alternately
+
+typedef enum
+{
+    WARM_SOURCE_NONE  = 0,      // Cold start, defaults
+    WARM_SOURCE_RAM   = 1,      // Full snapshot from no-init RAM
+    WARM_SOURCE_FLASH = 2       // Control state only, from the config store
+
+}  WARM_SOURCE;
+
+// WARM_OUTPUT - The run time part of one OUTPUT.
+//
+typedef struct
+{
+    uint8_t   desired_state;
+    uint8_t   output_state;
+    bool      on_delay_timer_running;
+    bool      off_delay_timer_running;
+    float     i_term;
+    int16_t   on_delay_timer;
+    int16_t   off_delay_timer;
+    int16_t   min_on_timer;
+    int16_t   min_off_timer;
+    int16_t   update_timer;
+
+}  WARM_OUTPUT;
+
+// WARM_CONTROL - The state of the outputs. This part is also saved in
+//   the config store, which survives a power cycle.
+//
+typedef struct
+{
+    int32_t   relay_state;                   // gRelayState
+    uint8_t   desired_state[ MAX_OUTPUTS ];
+    uint8_t   output_state[ MAX_OUTPUTS ];
+
+}  WARM_CONTROL;
+
+// WARM_STATE - Everything that is restored after a warm restart.
+//
+typedef struct
+{
+    uint32_t      sec_counter;                  // SecCounter
+    WARM_CONTROL  control;
+    WARM_OUTPUT   output[ MAX_OUTPUTS ];        // Timers and PI state
+    LIVE_STATUS   status;                       // Sensor values and supplies
+    uint16_t      raw[ MAX_ANA_INPUTS ];        // Sample[].raw, filtered ADC
+
+}  WARM_STATE;
+
+// WARM_SNAPSHOT - One slot in no-init RAM. "crc" covers everything
+//   before it.
+//
+typedef struct
+{
+    uint32_t    magic;          // WARM_MAGIC
+    uint16_t    layout;         // WARM_LAYOUT
+    uint16_t    size;           // sizeof( WARM_STATE )
+    uint32_t    seq;            // Higher is newer
+    WARM_STATE  state;
+    uint16_t    crc;
+
+}  WARM_SNAPSHOT;
+
+// WARM_RESTART_STATS - What happened at the last reset, and the cost
+//   of taking snapshots since. Times are in core clock cycles.
+//
+typedef struct
+{
+    WARM_SOURCE  source;            // Where the state came from
+    bool         cold;              // Power on or low voltage reset
+    uint32_t     seq;               // Snapshot restored
+    uint32_t     age_sec;           // SecCounter of the snapshot restored
+    uint32_t     rejected;          // Slots with a bad magic, layout or CRC
+    uint32_t     restore_ms;        // Time after reset the state was back
+    uint32_t     saves;             // Snapshots taken since reset
+    uint32_t     save_max;
+    uint32_t     flash_saves;       // Control state written to flash
+    uint32_t     flash_errors;
+
+}  WARM_RESTART_STATS;
+
+extern WARM_RESTART_STATS  WarmRestartStats;
+extern const char *        WarmSourceName[];
+
+//
+//    Function Prototypes
+//
+void      warm_restart_restore( void );
+void      warm_restart_save( void );
+bool      warm_restart_request_control( void );
+
+#endif
@@ -526,21 +526,12 @@ void
 build_setpoint_range_string( int sensor_id, int sensor_type, char * str  )
 {
     char min_str[20], max_str[20];
-    int  min_sp, max_sp;
+    const SETPOINT_LIMITS * limits;
 
-    if( sensor_id == SENSOR_ID_DIFF )
-    {
-        min_sp = get_minimum_diff_setpoint( sensor_type );
-        max_sp = get_maximum_diff_setpoint( sensor_type );
-    }
-    else
-    {
-        min_sp = get_minimum_setpoint( sensor_type );
-        max_sp = get_maximum_setpoint( sensor_type );
-    }
+    limits = get_setpoint_limits( sensor_type, sensor_id );
 
-    build_setpoint_string( min_sp, sensor_type, min_str );
-    build_setpoint_string( max_sp, sensor_type, max_str );
+    build_setpoint_string( limits->min_sp, sensor_type, min_str );
+    build_setpoint_string( limits->max_sp, sensor_type, max_str );
 
     sprintf( str, "%s to %s", min_str, max_str );
 
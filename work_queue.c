@@ -0,0 +1,260 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : work_queue.c
+
+PURPOSE   : Deferred work ("bottom half") queue. ISRs and driver
+            callbacks post small work items, and the Work_Task runs
+            them at task level. This keeps the interrupt handlers, and
+            in particular the ADC sample path, to a few instructions.
+
+            Items that write the flash are run by the Flash_Task
+            instead, at a priority below the control tasks, so that a
+            flash erase does not hold up control or the Work_Task.
+
+            There is one queue per priority class. Each queue is a
+            fixed array of WORK_ITEMs; a slot is reserved by advancing
+            the tail with LDREX/STREX, so posting never disables
+            interrupts and never blocks. If a queue is full the post
+            is refused and counted; the caller may then do the work
+            itself.
+
+            Queue depth, dropped posts, deadline misses and the cost of
+            work_queue_post() are reported by the "top" shell command.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#include <string.h>
+#include <intrinsics.h>
+#include <mqx.h>
+#include <bsp.h>
+#include <lwevent.h>
+
+#include "defines.h"
+#include "task_monitor.h"
+#include "event_trace.h"
+#include "work_queue.h"
+
+#define  CYCLES_PER_USEC      (BSP_CORE_CLOCK / 1000000)
+
+#define  WORK_EVENT_POSTED    0x01     // Work_Task, high or low item
+#define  WORK_EVENT_FLASH     0x02     // Flash_Task, flash item
+
+WORK_QUEUE          WorkQueue[ MAX_WORK_PRIO ];
+LWEVENT_STRUCT      eventWorkTask;
+uint32_t            WorkPostMaxCycles;     // Longest work_queue_post()
+
+const uint32_t      WorkDeadlineUs[ MAX_WORK_PRIO ] =
+{
+    WORK_HIGH_DEADLINE_US,      // WORK_PRIO_HIGH
+    WORK_LOW_DEADLINE_US,       // WORK_PRIO_LOW
+    WORK_FLASH_DEADLINE_US      // WORK_PRIO_FLASH
+};
+
+
+// Function Prototypes - used by this module only
+//
+bool    work_queue_run_one( int first, int last );
+
+
+//
+//  work_queue_init() - Empty the queues and create the event used to
+//                      wake the Work_Task and the Flash_Task. This
+//                      must be called before any ISR or callback that
+//                      posts work is enabled.
+//
+void
+work_queue_init( void )
+{
+    WORK_QUEUE * q;
+    int          prio, k;
+
+    memset( WorkQueue, 0, sizeof( WorkQueue ) );
+    WorkPostMaxCycles = 0;
+
+    for( prio = 0; prio < MAX_WORK_PRIO; prio++ )
+    {
+        q = &WorkQueue[ prio ];
+
+        // Slot k is free for the producer that reserves position k.
+        //
+        for( k = 0; k < WORK_QUEUE_SIZE; k++ )
+            q->item[k].seq = k;
+
+        q->deadline = WorkDeadlineUs[ prio ] * CYCLES_PER_USEC;
+    }
+
+    if( _lwevent_create( &eventWorkTask, LWEVENT_AUTO_CLEAR ) != MQX_OK ) { _mqx_exit( 1L ); }
+}
+
+
+//
+//  work_queue_post() - Queue "func" to be called by the Work_Task, or
+//                      for the flash class the Flash_Task, with "ctx"
+//                      and "arg". Safe to call from any task or ISR.
+//                      Returns FALSE if the queue is full.
+//
+bool
+work_queue_post( WORK_PRIO prio, WORK_FUNC func, void * ctx, uint32_t arg )
+{
+    WORK_QUEUE * q;
+    WORK_ITEM  * slot;
+    uint32_t     start, pos, depth;
+
+    start = TMON_CYCLE_COUNT();
+    q     = &WorkQueue[ prio ];
+
+    // Reserve the slot at the tail. The slot is free only if the
+    //    consumer has run the item that was in it one lap ago.
+    //
+    do
+    {
+        pos  = __LDREX( (unsigned long *) &q->tail );
+        slot = &q->item[ pos & (WORK_QUEUE_SIZE - 1) ];
+
+        if( slot->seq != pos )
+        {
+            __CLREX();
+            q->dropped++;
+            return( FALSE );
+        }
+    }
+    while( __STREX( pos + 1, (unsigned long *) &q->tail ) );
+
+    slot->func   = func;
+    slot->ctx    = ctx;
+    slot->arg    = arg;
+    slot->posted = start;
+
+    __DMB();                    // Item is complete before it is published
+    slot->seq = pos + 1;
+
+    depth = pos + 1 - q->head;
+
+    if( depth > q->max_depth )
+        q->max_depth = depth;
+
+    _lwevent_set( &eventWorkTask, (prio == WORK_PRIO_FLASH) ? WORK_EVENT_FLASH : WORK_EVENT_POSTED );
+
+    start = TMON_CYCLE_COUNT() - start;
+
+    if( start > WorkPostMaxCycles )
+        WorkPostMaxCycles = start;
+
+    return( TRUE );
+}
+
+
+//
+//  work_queue_get_stats() - Return a snapshot of one queue's statistics.
+//
+void
+work_queue_get_stats( WORK_PRIO prio, WORK_QUEUE_STATS * stats )
+{
+    WORK_QUEUE * q = &WorkQueue[ prio ];
+
+    stats->depth           = q->tail - q->head;
+    stats->max_depth       = q->max_depth;
+    stats->run             = q->run;
+    stats->dropped         = q->dropped;
+    stats->missed          = q->missed;
+    stats->max_latency_us  = q->max_latency / CYCLES_PER_USEC;
+    stats->max_post_cycles = WorkPostMaxCycles;
+}
+
+
+//
+//  Work_Task() - Waits for high or low priority work to be posted and
+//                runs it, highest priority class first.
+//
+void
+Work_Task( uint32_t param )
+{
+    while( TRUE )
+    {
+        _lwevent_wait_ticks( &eventWorkTask, WORK_EVENT_POSTED, FALSE, 0 );
+
+        while( work_queue_run_one( WORK_PRIO_HIGH, WORK_PRIO_LOW ) )
+            ;
+    }
+}
+
+
+//
+//  Flash_Task() - Waits for flash work to be posted and runs it. This
+//                 task is below the control tasks, so it only runs
+//                 when they are idle.
+//
+void
+Flash_Task( uint32_t param )
+{
+    while( TRUE )
+    {
+        _lwevent_wait_ticks( &eventWorkTask, WORK_EVENT_FLASH, FALSE, 0 );
+
+        while( work_queue_run_one( WORK_PRIO_FLASH, WORK_PRIO_FLASH ) )
+            ;
+    }
+}
+
+
+//
+//  work_queue_run_one() - Run the oldest item of the highest priority
+//                         class, from "first" to "last", that has one
+//                         ready. Returns FALSE if there was nothing to
+//                         run.
+//
+//  A slot that has been reserved but not yet filled in stops its queue.
+//  The producer sets the event once it has filled the slot, which
+//  wakes the calling task again.
+//
+bool
+work_queue_run_one( int first, int last )
+{
+    WORK_QUEUE * q;
+    WORK_ITEM  * slot;
+    WORK_FUNC    func;
+    void *       ctx;
+    uint32_t     arg, latency;
+    int          prio;
+
+    for( prio = first; prio <= last; prio++ )
+    {
+        q    = &WorkQueue[ prio ];
+        slot = &q->item[ q->head & (WORK_QUEUE_SIZE - 1) ];
+
+        if( slot->seq != q->head + 1 )
+            continue;
+
+        func    = slot->func;
+        ctx     = slot->ctx;
+        arg     = slot->arg;
+        latency = TMON_CYCLE_COUNT() - slot->posted;
+
+        // Release the slot for the producer one lap ahead.
+        //
+        __DMB();
+        slot->seq = q->head + WORK_QUEUE_SIZE;
+        q->head++;
+
+        q->run++;
+
+        if( latency > q->max_latency )
+            q->max_latency = latency;
+
+        if( latency > q->deadline )
+            q->missed++;
+
+        TRACE_BEGIN( TRACE_MARK_WORK_ITEM );
+        func( ctx, arg );
+        TRACE_END( TRACE_MARK_WORK_ITEM );
+
+        return( TRUE );
+    }
+
+    return( FALSE );
+}
@@ -0,0 +1,114 @@
+/***************************************************************************
+(C)Copyright Johnson Controls, Inc. Use or copying of all or any part of
+the document, except as permitted by the License Agreement, is prohibited.
+
+FILENAME  : work_queue.h
+
+PURPOSE   : Definitions and function prototypes for the "work_queue.c"
+            module. The work queue lets an ISR or driver callback hand
+            work off to the Work_Task ("bottom half") instead of doing
+            it at interrupt level.
+
+            An ISR posts a function and its arguments with
+            work_queue_post(), which takes a few dozen cycles and never
+            blocks. Work_Task runs the function shortly afterwards at
+            task level, where it may call printf, lock mutexCore, etc.
+
+            Items that program or erase the flash are posted to the
+            flash class instead. They are run by the Flash_Task, which
+            is below the control tasks, so a page erase never delays
+            the control loop or a high priority item.
+
+History:
+Date        Author     Rel      EC#    Prob#  Task# Reason for change
+---------   --------- ------- ------- ------- ----- -------------------------
+*****************************************************************************/
+
+#ifndef  __work_queue_inc
+#define  __work_queue_inc
+
+#include <mqx.h>
+
+#define  WORK_QUEUE_SIZE      16    // Items per priority, must be a power of 2
+
+// Priority classes. All queued high priority items are run before the
+//   next low priority item. Each class has a deadline; an item that is
+//   run later than this after being posted counts as a deadline miss.
+//
+//   The high and low classes are run by the Work_Task and are for short
+//   items that do not block. The flash class is run by the Flash_Task.
+//
+typedef enum
+{
+    WORK_PRIO_HIGH  = 0,
+    WORK_PRIO_LOW   = 1,
+    WORK_PRIO_FLASH = 2
+
+}  WORK_PRIO;
+
+#define  MAX_WORK_PRIO   WORK_PRIO_FLASH + 1
+
+#define  WORK_HIGH_DEADLINE_US       2000
+#define  WORK_LOW_DEADLINE_US       50000
+#define  WORK_FLASH_DEADLINE_US   1000000
+
+// WORK_FUNC - A deferred work function. "ctx" and "arg" are the values
+//   passed to work_queue_post().
+//
+typedef void (* WORK_FUNC)( void * ctx, uint32_t arg );
+
+// WORK_ITEM - One slot in a work queue.
+//
+//   "seq" tells the consumer whether the slot has been filled in. A
+//   producer that is interrupted between reserving a slot and filling
+//   it leaves "seq" unchanged, and the consumer waits for it.
+//
+typedef struct
+{
+    volatile uint32_t  seq;      // Slot number + 1 when full
+    WORK_FUNC          func;
+    void *             ctx;
+    uint32_t           arg;
+    uint32_t           posted;   // Cycle count when posted
+}  WORK_ITEM;
+
+// WORK_QUEUE - A bounded, lock free, multiple producer single consumer
+//   queue. "tail" is advanced by producers with LDREX/STREX; "head" is
+//   only written by the task that runs the queue.
+//
+typedef struct
+{
+    WORK_ITEM          item[ WORK_QUEUE_SIZE ];
+    volatile uint32_t  tail;          // Next slot to reserve
+    uint32_t           head;          // Next slot to run
+    uint32_t           deadline;      // Deadline, cycles
+    uint32_t           run;           // Items run since boot
+    uint32_t           dropped;       // Posts refused, queue full
+    uint32_t           missed;        // Items run after their deadline
+    uint32_t           max_depth;     // Deepest the queue has been
+    uint32_t           max_latency;   // Longest post to run time, cycles
+}  WORK_QUEUE;
+
+// WORK_QUEUE_STATS - A snapshot of one queue as reported by the shell.
+//
+typedef struct
+{
+    uint32_t  depth;             // Items waiting now
+    uint32_t  max_depth;
+    uint32_t  run;
+    uint32_t  dropped;
+    uint32_t  missed;
+    uint32_t  max_latency_us;
+    uint32_t  max_post_cycles;   // Longest work_queue_post(), all queues
+}  WORK_QUEUE_STATS;
+
+//
+//    Function Prototypes
+//
+void      work_queue_init( void );
+bool      work_queue_post( WORK_PRIO prio, WORK_FUNC func, void * ctx, uint32_t arg );
+void      work_queue_get_stats( WORK_PRIO prio, WORK_QUEUE_STATS * stats );
+void      Work_Task( uint32_t param );
+void      Flash_Task( uint32_t param );
+
+#endif